@@ -26,9 +26,206 @@ freely, subject to the following restrictions:
 
 #include "uSynergy.h"
 
-// TODO: implement callbacks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* A recorded server stream played back to the client instead of a connection */
+typedef struct
+{
+	uint8_t*	m_data;
+	size_t		m_size;
+	size_t		m_offset;
+	int			m_connects;
+	int			m_sends;
+	int			m_mouseCallbacks;
+	int			m_keyCallbacks;
+} Replay;
+
+static uSynergyBool replayConnect(uSynergyCookie cookie)
+{
+	Replay* replay = (Replay*)cookie;
+	return ++replay->m_connects == 1;
+}
+
+static uSynergyBool replaySend(uSynergyCookie cookie, const uint8_t *buffer, int length)
+{
+	Replay* replay = (Replay*)cookie;
+	(void)buffer;
+	(void)length;
+	++replay->m_sends;
+	return USYNERGY_TRUE;
+}
+
+static uSynergyBool replayReceive(uSynergyCookie cookie, uint8_t *buffer, int maxLength, int* outLength)
+{
+	Replay* replay = (Replay*)cookie;
+	size_t n = replay->m_size - replay->m_offset;
+	if (n > (size_t)maxLength)
+		n = (size_t)maxLength;
+	memcpy(buffer, replay->m_data + replay->m_offset, n);
+	replay->m_offset += n;
+	*outLength = (int)n;
+	return USYNERGY_TRUE;
+}
+
+static void replaySleep(uSynergyCookie cookie, int timeMs)
+{
+	(void)cookie;
+	(void)timeMs;
+}
+
+static uint32_t getTime()
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return (uint32_t)(now.tv_sec * 1000 + now.tv_usec / 1000);
+}
+
+static void replayMouse(uSynergyCookie cookie, uint16_t x, uint16_t y, int16_t wheelX, int16_t wheelY,
+	uSynergyBool buttonLeft, uSynergyBool buttonRight, uSynergyBool buttonMiddle)
+{
+	(void)x; (void)y; (void)wheelX; (void)wheelY;
+	(void)buttonLeft; (void)buttonRight; (void)buttonMiddle;
+	++((Replay*)cookie)->m_mouseCallbacks;
+}
+
+static void replayKeyboard(uSynergyCookie cookie, uint16_t key, uint16_t modifiers, uSynergyBool down, uSynergyBool repeat)
+{
+	(void)key; (void)modifiers; (void)down; (void)repeat;
+	++((Replay*)cookie)->m_keyCallbacks;
+}
+
+/* Append a message to a synthetic stream, the length is filled in for the caller */
+static uint8_t* addMessage(uint8_t* out, const char* code, const uint8_t* body, uint32_t size)
+{
+	uint32_t length = 4 + size;
+	out[0] = (uint8_t)(length >> 24);
+	out[1] = (uint8_t)(length >> 16);
+	out[2] = (uint8_t)(length >> 8);
+	out[3] = (uint8_t)length;
+	memcpy(out + 4, code, 4);
+	memcpy(out + 8, body, size);
+	return out + 8 + size;
+}
+
+/* What a server sends while the user drags the mouse around and now and then types a key */
+static void makeStream(Replay* replay)
+{
+	static const int kMoves = 200000;
+	static const uint8_t hello[] = { 'r', 'g', 'y', 0, 1, 0, 4 };
+	static const uint8_t enter[] = { 0, 0, 0, 0, 0, 0, 0, 1, 0, 0 };
+	static const uint8_t options[] = { 0, 0, 0, 0 };
+	uint8_t* out;
+	int i;
+
+	replay->m_data = (uint8_t*)malloc(64 + kMoves * 12 + (kMoves / 50) * 28);
+	out = addMessage(replay->m_data, "Syne", hello, sizeof(hello));
+	out = addMessage(out, "QINF", NULL, 0);
+	out = addMessage(out, "CIAK", NULL, 0);
+	out = addMessage(out, "DSOP", options, sizeof(options));
+	out = addMessage(out, "CINN", enter, sizeof(enter));
+	for (i = 0; i < kMoves; ++i)
+	{
+		uint8_t move[4];
+		move[0] = (uint8_t)((i % 1920) >> 8);
+		move[1] = (uint8_t)(i % 1920);
+		move[2] = (uint8_t)((i % 1080) >> 8);
+		move[3] = (uint8_t)(i % 1080);
+		out = addMessage(out, "DMMV", move, sizeof(move));
+		if (i % 50 == 49)
+		{
+			uint8_t key[6] = { 0, 'a', 0, 0, 0, 38 };
+			out = addMessage(out, "DKDN", key, sizeof(key));
+			out = addMessage(out, "DKUP", key, sizeof(key));
+		}
+	}
+	replay->m_size = (size_t)(out - replay->m_data);
+}
+
+static int loadStream(Replay* replay, const char* filename)
+{
+	FILE* file = fopen(filename, "rb");
+	long size;
+	if (file == NULL)
+		return 0;
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	replay->m_data = (uint8_t*)malloc(size > 0 ? (size_t)size : 1);
+	replay->m_size = fread(replay->m_data, 1, (size_t)size, file);
+	fclose(file);
+	return 1;
+}
+
+/* Play the stream to a fresh client, either through uSynergyUpdate or uSynergyPoll */
+static void replayStream(Replay* replay, uSynergyBool poll)
+{
+	static uSynergyContext context;
+	struct timeval begin, end;
+
+	replay->m_offset = 0;
+	replay->m_connects = 0;
+	replay->m_sends = 0;
+	replay->m_mouseCallbacks = 0;
+	replay->m_keyCallbacks = 0;
+
+	uSynergyInit(&context);
+	context.m_connectFunc = &replayConnect;
+	context.m_sendFunc = &replaySend;
+	context.m_receiveFunc = &replayReceive;
+	context.m_sleepFunc = &replaySleep;
+	context.m_getTimeFunc = &getTime;
+	context.m_clientName = "replay";
+	context.m_clientWidth = 1920;
+	context.m_clientHeight = 1080;
+	context.m_cookie = (uSynergyCookie)replay;
+	context.m_mouseCallback = &replayMouse;
+	context.m_keyboardCallback = &replayKeyboard;
+
+	gettimeofday(&begin, NULL);
+	while (replay->m_offset < replay->m_size && replay->m_connects <= 1)
+	{
+		if (poll)
+			uSynergyPoll(&context);
+		else
+			uSynergyUpdate(&context);
+	}
+	gettimeofday(&end, NULL);
+
+	printf("%-6s %8.3f ms, %d mouse callbacks, %d key callbacks, %d sends%s\n",
+		poll ? "poll" : "update",
+		(end.tv_sec - begin.tv_sec) * 1000.0 + (end.tv_usec - begin.tv_usec) / 1000.0,
+		replay->m_mouseCallbacks, replay->m_keyCallbacks, replay->m_sends,
+		replay->m_connects > 1 ? " (disconnected)" : "");
+}
+
 int main(int argc, char** argv) {
 	uSynergyContext context;
+
+	/* usynergy --replay [file]: benchmark the client on a recorded (or made up) server stream */
+	if (argc >= 2 && strcmp(argv[1], "--replay") == 0)
+	{
+		Replay replay;
+		memset(&replay, 0, sizeof(replay));
+		if (argc >= 3)
+		{
+			if (!loadStream(&replay, argv[2]))
+			{
+				fprintf(stderr, "can't read %s\n", argv[2]);
+				return 1;
+			}
+		}
+		else
+			makeStream(&replay);
+		printf("replaying %lu bytes\n", (unsigned long)replay.m_size);
+		replayStream(&replay, USYNERGY_FALSE);
+		replayStream(&replay, USYNERGY_TRUE);
+		free(replay.m_data);
+		return 0;
+	}
+
 	uSynergyInit(&context);
 	
 	for(;;) {
@@ -34,6 +34,7 @@ enum qIpcClientType {
 	kIpcClientUnknown,
 	kIpcClientGui,
 	kIpcClientNode,
+	kIpcClientTool,
 };
 
 extern const char*		kIpcMsgHello;
@@ -20,6 +20,7 @@
 
 #include "common/IInterface.h"
 #include "common/stdstring.h"
+#include "common/stdvector.h"
 
 class CArchThreadImpl;
 typedef CArchThreadImpl* CArchThread;
@@ -64,6 +65,7 @@ public:
 	enum EAddressFamily {
 		kUNKNOWN,
 		kINET,
+		kUNIX,
 	};
 
 	//! Supported socket types
@@ -236,6 +238,14 @@ public:
 	*/
 	virtual bool		setReuseAddrOnSocket(CArchSocket, bool reuse) = 0;
 
+	//! Check the user on the other end of a local socket
+	/*!
+	Returns true if the peer of the connected \c kUNIX socket \c s runs
+	as the same user as this process or as the superuser.  Returns false
+	for any other socket or if the platform can't tell.
+	*/
+	virtual bool		isPeerTrusted(CArchSocket s) = 0;
+
 	//! Return local host's name
 	virtual std::string		getHostName() = 0;
 
@@ -248,6 +258,24 @@ public:
 	//! Convert a name to a network address
 	virtual CArchNetAddress	nameToAddr(const std::string&) = 0;
 
+	//! Convert a file system path to a local address
+	/*!
+	Returns a \c kUNIX address for \c path.  Binding a listening socket
+	to it creates the socket file, which is removed again when the
+	socket is closed.  Throws XArchNetworkSupport if the platform has no
+	local sockets.
+	*/
+	virtual CArchNetAddress	pathToAddr(const std::string& path) = 0;
+
+	//! Convert a name to all of its network addresses
+	/*!
+	Like nameToAddr() but returns every address the name resolves to,
+	in the order the resolver prefers them.  The caller must close each
+	of the returned addresses.  Safe to call from any thread.
+	*/
+	virtual std::vector<CArchNetAddress>
+							nameToAddrs(const std::string&) = 0;
+
 	//! Destroy a network address
 	virtual void			closeAddr(CArchNetAddress) = 0;
 
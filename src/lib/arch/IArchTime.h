@@ -37,5 +37,14 @@ public:
 	*/
 	virtual double		time() = 0;
 
+	//! Get the current time for measuring durations
+	/*!
+	Returns the number of seconds since some arbitrary starting time,
+	from a clock that setting the system time doesn't move.  Use this
+	rather than time() when a duration must never come out negative or
+	jump, such as a latency.
+	*/
+	virtual double		monotonicTime() = 0;
+
 	//@}
 };
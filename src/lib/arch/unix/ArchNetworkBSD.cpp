@@ -31,6 +31,7 @@
 #	include <netinet/tcp.h>
 #endif
 #include <arpa/inet.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
@@ -52,7 +53,8 @@
 
 static const int s_family[] = {
 	PF_UNSPEC,
-	PF_INET
+	PF_INET,
+	PF_UNIX
 };
 static const int s_type[] = {
 	SOCK_DGRAM,
@@ -149,6 +151,17 @@ CArchNetworkBSD::closeSocket(CArchSocket s)
 
 	// close the socket if necessary
 	if (doClose) {
+		// a listening local socket takes its socket file with it
+		std::string path;
+		int listening = 0;
+		socklen_t size = (socklen_t)sizeof(listening);
+		if (!isUnixSocket(s->m_fd, &path) ||
+			getsockopt(s->m_fd, SOL_SOCKET, SO_ACCEPTCONN,
+							(optval_t*)&listening, &size) == -1 ||
+			listening == 0) {
+			path.clear();
+		}
+
 		if (close(s->m_fd) == -1) {
 			// close failed.  restore the last ref and throw.
 			int err = errno;
@@ -157,6 +170,9 @@ CArchNetworkBSD::closeSocket(CArchSocket s)
 			ARCH->unlockMutex(m_mutex);
 			throwError(err);
 		}
+		if (!path.empty()) {
+			unlink(path.c_str());
+		}
 		delete s;
 	}
 }
@@ -192,7 +208,28 @@ CArchNetworkBSD::bindSocket(CArchSocket s, CArchNetAddress addr)
 	assert(addr != NULL);
 
 	if (bind(s->m_fd, &addr->m_addr, addr->m_len) == -1) {
-		throwError(errno);
+		int err = errno;
+
+		// a local socket file may have been left behind by a process
+		// that died.  if nobody is listening on it then replace it.
+		if (err == EADDRINUSE && addr->m_addr.sa_family == AF_UNIX) {
+			struct stat info;
+			bool stale = false;
+			if (lstat(addr->m_unixAddr.sun_path, &info) == 0 &&
+				S_ISSOCK(info.st_mode)) {
+				int fd = socket(PF_UNIX, SOCK_STREAM, 0);
+				if (fd != -1) {
+					stale = (connect(fd, &addr->m_addr, addr->m_len) == -1 &&
+								errno == ECONNREFUSED);
+					close(fd);
+				}
+			}
+			if (stale && unlink(addr->m_unixAddr.sun_path) == 0 &&
+				bind(s->m_fd, &addr->m_addr, addr->m_len) == 0) {
+				return;
+			}
+		}
+		throwError(err);
 	}
 }
 
@@ -201,8 +238,9 @@ CArchNetworkBSD::listenOnSocket(CArchSocket s)
 {
 	assert(s != NULL);
 
-	// hardcoding backlog
-	if (listen(s->m_fd, 3) == -1) {
+	// a backlog deep enough that a burst of reconnecting clients isn't
+	// dropped and left to retry after the SYN timeout
+	if (listen(s->m_fd, SOMAXCONN) == -1) {
 		throwError(errno);
 	}
 }
@@ -222,21 +260,32 @@ CArchNetworkBSD::acceptSocket(CArchSocket s, CArchNetAddress* addr)
 	CArchSocketImpl* newSocket = new CArchSocketImpl;
 	*addr                      = new CArchNetAddressImpl;
 
-	// accept on socket
-	ACCEPT_TYPE_ARG3 len = (ACCEPT_TYPE_ARG3)((*addr)->m_len);
-	int fd = accept(s->m_fd, &(*addr)->m_addr, &len);
+	// accept on socket.  a connection that was reset while it waited
+	// in the backlog isn't an error, just move on to the next one.
+	int fd;
+	ACCEPT_TYPE_ARG3 len;
+	do {
+		len = (ACCEPT_TYPE_ARG3)((*addr)->m_len);
+#if defined(SOCK_NONBLOCK)
+		// saves the fcntl() calls to make the socket non-blocking
+		fd  = accept4(s->m_fd, &(*addr)->m_addr, &len, SOCK_NONBLOCK);
+#else
+		fd  = accept(s->m_fd, &(*addr)->m_addr, &len);
+#endif
+	} while (fd == -1 && (errno == EINTR || errno == ECONNABORTED));
 	(*addr)->m_len = (socklen_t)len;
 	if (fd == -1) {
 		int err = errno;
 		delete newSocket;
 		delete *addr;
 		*addr = NULL;
-		if (err == EAGAIN) {
+		if (err == EAGAIN || err == EWOULDBLOCK) {
 			return NULL;
 		}
 		throwError(err);
 	}
 
+#if !defined(SOCK_NONBLOCK)
 	try {
 		setBlockingOnSocket(fd, false);
 	}
@@ -247,6 +296,7 @@ CArchNetworkBSD::acceptSocket(CArchSocket s, CArchNetAddress* addr)
 		*addr = NULL;
 		throw;
 	}
+#endif
 
 	// initialize socket
 	newSocket->m_fd       = fd;
@@ -582,6 +632,11 @@ CArchNetworkBSD::setNoDelayOnSocket(CArchSocket s, bool noDelay)
 {
 	assert(s != NULL);
 
+	// local sockets don't coalesce writes in the first place
+	if (isUnixSocket(s->m_fd)) {
+		return noDelay;
+	}
+
 	// get old state
 	int oflag;
 	socklen_t size = (socklen_t)sizeof(oflag);
@@ -623,6 +678,36 @@ CArchNetworkBSD::setReuseAddrOnSocket(CArchSocket s, bool reuse)
 	return (oflag != 0);
 }
 
+bool
+CArchNetworkBSD::isPeerTrusted(CArchSocket s)
+{
+	assert(s != NULL);
+
+	if (!isUnixSocket(s->m_fd)) {
+		return false;
+	}
+
+	uid_t uid;
+#if defined(SO_PEERCRED)
+	struct ucred cred;
+	socklen_t size = (socklen_t)sizeof(cred);
+	if (getsockopt(s->m_fd, SOL_SOCKET, SO_PEERCRED,
+							(optval_t*)&cred, &size) == -1) {
+		return false;
+	}
+	uid = cred.uid;
+#elif HAVE_GETPEEREID
+	gid_t gid;
+	if (getpeereid(s->m_fd, &uid, &gid) == -1) {
+		return false;
+	}
+#else
+	return false;
+#endif
+
+	return (uid == geteuid() || uid == 0);
+}
+
 std::string
 CArchNetworkBSD::getHostName()
 {
@@ -674,52 +759,81 @@ CArchNetworkBSD::copyAddr(CArchNetAddress addr)
 CArchNetAddress
 CArchNetworkBSD::nameToAddr(const std::string& name)
 {
-	// allocate address
+	std::vector<CArchNetAddress> addrs = nameToAddrs(name);
+	for (size_t i = 1; i < addrs.size(); ++i) {
+		delete addrs[i];
+	}
+	return addrs[0];
+}
+
+CArchNetAddress
+CArchNetworkBSD::pathToAddr(const std::string& path)
+{
 	CArchNetAddressImpl* addr = new CArchNetAddressImpl;
+	if (path.empty() || path.size() >= sizeof(addr->m_unixAddr.sun_path)) {
+		delete addr;
+		throw XArchNetworkNoAddress("invalid local socket path");
+	}
+
+	memset(&addr->m_unixAddr, 0, sizeof(addr->m_unixAddr));
+	addr->m_unixAddr.sun_family = AF_UNIX;
+	memcpy(addr->m_unixAddr.sun_path, path.c_str(), path.size());
+	addr->m_len = (socklen_t)sizeof(addr->m_unixAddr);
+	return addr;
+}
+
+std::vector<CArchNetAddress>
+CArchNetworkBSD::nameToAddrs(const std::string& name)
+{
+	std::vector<CArchNetAddress> addrs;
 
 	// try to convert assuming an IPv4 dot notation address
 	struct sockaddr_in inaddr;
 	memset(&inaddr, 0, sizeof(inaddr));
 	if (inet_aton(name.c_str(), &inaddr.sin_addr) != 0) {
 		// it's a dot notation address
+		CArchNetAddressImpl* addr = new CArchNetAddressImpl;
 		addr->m_len       = (socklen_t)sizeof(struct sockaddr_in);
 		inaddr.sin_family = AF_INET;
 		inaddr.sin_port   = 0;
 		memcpy(&addr->m_addr, &inaddr, addr->m_len);
+		addrs.push_back(addr);
+		return addrs;
 	}
 
-	else {
-		// mutexed address lookup (ugh)
-		ARCH->lockMutex(m_mutex);
-		struct hostent* info = gethostbyname(name.c_str());
-		if (info == NULL) {
-			ARCH->unlockMutex(m_mutex);
-			delete addr;
-			throwNameError(h_errno);
-		}
+	// getaddrinfo() is reentrant so, unlike gethostbyname(), a slow
+	// lookup doesn't have to hold m_mutex and stall every other thread
+	// (only IPv4 currently supported)
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	struct addrinfo* info = NULL;
+	int err = getaddrinfo(name.c_str(), NULL, &hints, &info);
+	if (err != 0) {
+		throwAddrInfoError(err);
+	}
 
-		// copy over address (only IPv4 currently supported)
-		if (info->h_addrtype == AF_INET) {
-			addr->m_len       = (socklen_t)sizeof(struct sockaddr_in);
-			inaddr.sin_family = info->h_addrtype;
-			inaddr.sin_port   = 0;
-			memcpy(&inaddr.sin_addr, info->h_addr_list[0],
-								sizeof(inaddr.sin_addr));
-			memcpy(&addr->m_addr, &inaddr, addr->m_len);
-		}
-		else {
-			ARCH->unlockMutex(m_mutex);
-			delete addr;
-			throw XArchNetworkNameUnsupported(
-					"The requested name is valid but "
-					"does not have a supported address family");
+	for (struct addrinfo* i = info; i != NULL; i = i->ai_next) {
+		if (i->ai_family != AF_INET ||
+			i->ai_addrlen != (socklen_t)sizeof(struct sockaddr_in)) {
+			continue;
 		}
-
-		// done with static buffer
-		ARCH->unlockMutex(m_mutex);
+		CArchNetAddressImpl* addr = new CArchNetAddressImpl;
+		addr->m_len = (socklen_t)sizeof(struct sockaddr_in);
+		memcpy(&inaddr, i->ai_addr, addr->m_len);
+		inaddr.sin_port = 0;
+		memcpy(&addr->m_addr, &inaddr, addr->m_len);
+		addrs.push_back(addr);
 	}
+	freeaddrinfo(info);
 
-	return addr;
+	if (addrs.empty()) {
+		throw XArchNetworkNameUnsupported(
+				"The requested name is valid but "
+				"does not have a supported address family");
+	}
+	return addrs;
 }
 
 void
@@ -769,6 +883,12 @@ CArchNetworkBSD::addrToString(CArchNetAddress addr)
 		return s;
 	}
 
+	case kUNIX:
+		// an unnamed (client) socket has an empty path
+		return std::string(addr->m_unixAddr.sun_path,
+					strnlen(addr->m_unixAddr.sun_path,
+							sizeof(addr->m_unixAddr.sun_path)));
+
 	default:
 		assert(0 && "unknown address family");
 		return "";
@@ -784,6 +904,9 @@ CArchNetworkBSD::getAddrFamily(CArchNetAddress addr)
 	case AF_INET:
 		return kINET;
 
+	case AF_UNIX:
+		return kUNIX;
+
 	default:
 		return kUNKNOWN;
 	}
@@ -839,6 +962,9 @@ CArchNetworkBSD::isAnyAddr(CArchNetAddress addr)
 				addr->m_len == (socklen_t)sizeof(struct sockaddr_in));
 	}
 
+	case kUNIX:
+		return false;
+
 	default:
 		assert(0 && "unknown address family");
 		return true;
@@ -852,6 +978,23 @@ CArchNetworkBSD::isEqualAddr(CArchNetAddress a, CArchNetAddress b)
 			memcmp(&a->m_addr, &b->m_addr, a->m_len) == 0);
 }
 
+bool
+CArchNetworkBSD::isUnixSocket(int fd, std::string* path)
+{
+	struct sockaddr_un addr;
+	socklen_t len = (socklen_t)sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	if (getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) == -1 ||
+		addr.sun_family != AF_UNIX) {
+		return false;
+	}
+	if (path != NULL) {
+		path->assign(addr.sun_path,
+					strnlen(addr.sun_path, sizeof(addr.sun_path)));
+	}
+	return true;
+}
+
 const int*
 CArchNetworkBSD::getUnblockPipe()
 {
@@ -987,3 +1130,34 @@ CArchNetworkBSD::throwNameError(int err)
 		throw XArchNetworkName(s_msg[4]);
 	}
 }
+
+void
+CArchNetworkBSD::throwAddrInfoError(int err)
+{
+	switch (err) {
+	case EAI_NONAME:
+		throw XArchNetworkNameUnknown(gai_strerror(err));
+
+#if defined(EAI_NODATA) && EAI_NODATA != EAI_NONAME
+	case EAI_NODATA:
+		throw XArchNetworkNameNoAddress(gai_strerror(err));
+#endif
+
+#if defined(EAI_ADDRFAMILY)
+	case EAI_ADDRFAMILY:
+		throw XArchNetworkNameNoAddress(gai_strerror(err));
+#endif
+
+	case EAI_FAIL:
+		throw XArchNetworkNameFailure(gai_strerror(err));
+
+	case EAI_AGAIN:
+		throw XArchNetworkNameUnavailable(gai_strerror(err));
+
+	case EAI_FAMILY:
+		throw XArchNetworkNameUnsupported(gai_strerror(err));
+
+	default:
+		throw XArchNetworkName(gai_strerror(err));
+	}
+}
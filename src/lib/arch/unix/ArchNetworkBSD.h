@@ -27,6 +27,7 @@
 #if HAVE_SYS_SOCKET_H
 #	include <sys/socket.h>
 #endif
+#include <sys/un.h>
 
 #if !HAVE_SOCKLEN_T
 typedef int socklen_t;
@@ -47,10 +48,14 @@ public:
 
 class CArchNetAddressImpl {
 public:
-	CArchNetAddressImpl() : m_len(sizeof(m_addr)) { }
+	CArchNetAddressImpl() : m_len(sizeof(m_unixAddr)) { }
 
 public:
-	struct sockaddr		m_addr;
+	// a plain sockaddr is too small for a local socket's path
+	union {
+		struct sockaddr		m_addr;
+		struct sockaddr_un	m_unixAddr;
+	};
 	socklen_t			m_len;
 };
 
@@ -79,10 +84,14 @@ public:
 	virtual void		throwErrorOnSocket(CArchSocket);
 	virtual bool		setNoDelayOnSocket(CArchSocket, bool noDelay);
 	virtual bool		setReuseAddrOnSocket(CArchSocket, bool reuse);
+	virtual bool		isPeerTrusted(CArchSocket);
 	virtual std::string		getHostName();
 	virtual CArchNetAddress	newAnyAddr(EAddressFamily);
 	virtual CArchNetAddress	copyAddr(CArchNetAddress);
 	virtual CArchNetAddress	nameToAddr(const std::string&);
+	virtual CArchNetAddress	pathToAddr(const std::string&);
+	virtual std::vector<CArchNetAddress>
+							nameToAddrs(const std::string&);
 	virtual void			closeAddr(CArchNetAddress);
 	virtual std::string		addrToName(CArchNetAddress);
 	virtual std::string		addrToString(CArchNetAddress);
@@ -96,8 +105,10 @@ private:
 	const int*			getUnblockPipe();
 	const int*			getUnblockPipeForThread(CArchThread);
 	void				setBlockingOnSocket(int fd, bool blocking);
+	bool				isUnixSocket(int fd, std::string* path = NULL);
 	void				throwError(int);
 	void				throwNameError(int);
+	void				throwAddrInfoError(int);
 
 private:
 	CArchMutex			m_mutex;
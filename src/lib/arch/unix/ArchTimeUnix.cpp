@@ -50,3 +50,15 @@ CArchTimeUnix::time()
 	gettimeofday(&t, NULL);
 	return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
 }
+
+double
+CArchTimeUnix::monotonicTime()
+{
+#if HAVE_CLOCK_GETTIME
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + 1.0e-9 * (double)t.tv_nsec;
+#else
+	return time();
+#endif
+}
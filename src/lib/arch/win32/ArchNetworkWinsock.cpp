@@ -26,7 +26,8 @@
 
 static const int s_family[] = {
 	PF_UNSPEC,
-	PF_INET
+	PF_INET,
+	PF_UNSPEC	// no local sockets
 };
 static const int s_type[] = {
 	SOCK_DGRAM,
@@ -301,8 +302,9 @@ CArchNetworkWinsock::listenOnSocket(CArchSocket s)
 {
 	assert(s != NULL);
 
-	// hardcoding backlog
-	if (listen_winsock(s->m_socket, 3) == SOCKET_ERROR) {
+	// a backlog deep enough that a burst of reconnecting clients isn't
+	// dropped and left to retry after the SYN timeout
+	if (listen_winsock(s->m_socket, SOMAXCONN) == SOCKET_ERROR) {
 		throwError(getsockerror_winsock());
 	}
 }
@@ -651,6 +653,13 @@ CArchNetworkWinsock::setReuseAddrOnSocket(CArchSocket s, bool reuse)
 	return (oflag != 0);
 }
 
+bool
+CArchNetworkWinsock::isPeerTrusted(CArchSocket)
+{
+	// no local sockets
+	return false;
+}
+
 std::string
 CArchNetworkWinsock::getHostName()
 {
@@ -697,8 +706,23 @@ CArchNetworkWinsock::copyAddr(CArchNetAddress addr)
 CArchNetAddress
 CArchNetworkWinsock::nameToAddr(const std::string& name)
 {
-	// allocate address
-	CArchNetAddressImpl* addr = NULL;
+	std::vector<CArchNetAddress> addrs = nameToAddrs(name);
+	for (size_t i = 1; i < addrs.size(); ++i) {
+		free(addrs[i]);
+	}
+	return addrs[0];
+}
+
+CArchNetAddress
+CArchNetworkWinsock::pathToAddr(const std::string&)
+{
+	throw XArchNetworkSupport("local sockets are not supported");
+}
+
+std::vector<CArchNetAddress>
+CArchNetworkWinsock::nameToAddrs(const std::string& name)
+{
+	std::vector<CArchNetAddress> addrs;
 
 	// try to convert assuming an IPv4 dot notation address
 	struct sockaddr_in inaddr;
@@ -708,32 +732,38 @@ CArchNetworkWinsock::nameToAddr(const std::string& name)
 	inaddr.sin_addr.s_addr = inet_addr_winsock(name.c_str());
 	if (inaddr.sin_addr.s_addr != INADDR_NONE) {
 		// it's a dot notation address
-		addr = CArchNetAddressImpl::alloc(sizeof(struct sockaddr_in));
+		CArchNetAddressImpl* addr =
+			CArchNetAddressImpl::alloc(sizeof(struct sockaddr_in));
 		memcpy(TYPED_ADDR(void, addr), &inaddr, addr->m_len);
+		addrs.push_back(addr);
 	}
 
 	else {
-		// address lookup
+		// address lookup.  winsock keeps the result per thread so this
+		// is safe to call from any thread.
 		struct hostent* info = gethostbyname_winsock(name.c_str());
 		if (info == NULL) {
 			throwNameError(getsockerror_winsock());
 		}
 
-		// copy over address (only IPv4 currently supported)
+		// copy over addresses (only IPv4 currently supported)
 		if (info->h_addrtype == AF_INET) {
-			addr = CArchNetAddressImpl::alloc(sizeof(struct sockaddr_in));
-			memcpy(&inaddr.sin_addr, info->h_addr_list[0],
-								sizeof(inaddr.sin_addr));
-			memcpy(TYPED_ADDR(void, addr), &inaddr, addr->m_len);
+			for (char** i = info->h_addr_list; *i != NULL; ++i) {
+				CArchNetAddressImpl* addr =
+					CArchNetAddressImpl::alloc(sizeof(struct sockaddr_in));
+				memcpy(&inaddr.sin_addr, *i, sizeof(inaddr.sin_addr));
+				memcpy(TYPED_ADDR(void, addr), &inaddr, addr->m_len);
+				addrs.push_back(addr);
+			}
 		}
-		else {
+		if (addrs.empty()) {
 			throw XArchNetworkNameUnsupported(
 					"The requested name is valid but "
 					"does not have a supported address family");
 		}
 	}
 
-	return addr;
+	return addrs;
 }
 
 void
@@ -77,10 +77,14 @@ public:
 	virtual void		throwErrorOnSocket(CArchSocket);
 	virtual bool		setNoDelayOnSocket(CArchSocket, bool noDelay);
 	virtual bool		setReuseAddrOnSocket(CArchSocket, bool reuse);
+	virtual bool		isPeerTrusted(CArchSocket);
 	virtual std::string		getHostName();
 	virtual CArchNetAddress	newAnyAddr(EAddressFamily);
 	virtual CArchNetAddress	copyAddr(CArchNetAddress);
 	virtual CArchNetAddress	nameToAddr(const std::string&);
+	virtual CArchNetAddress	pathToAddr(const std::string&);
+	virtual std::vector<CArchNetAddress>
+							nameToAddrs(const std::string&);
 	virtual void			closeAddr(CArchNetAddress);
 	virtual std::string		addrToName(CArchNetAddress);
 	virtual std::string		addrToString(CArchNetAddress);
@@ -87,3 +87,10 @@ CArchTimeWindows::time()
 		return 0.001 * static_cast<double>(GetTickCount());
 	}
 }
+
+double
+CArchTimeWindows::monotonicTime()
+{
+	// none of the clocks time() uses follow the system time
+	return time();
+}
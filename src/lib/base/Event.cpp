@@ -18,6 +18,7 @@
 
 #include "base/Event.h"
 #include "base/EventQueue.h"
+#include "base/EventDataPool.h"
 
 //
 // CEvent
@@ -85,7 +86,7 @@ CEvent::deleteData(const CEvent& event)
 
 	default:
 		if ((event.getFlags() & kDontFreeData) == 0) {
-			free(event.getData());
+			CEventDataPool::free(event.getData());
 			delete event.getDataObject();
 		}
 		break;
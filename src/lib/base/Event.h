@@ -53,8 +53,8 @@ public:
 
 	//! Create \c CEvent with data (POD)
 	/*!
-	The \p data must be POD (plain old data) allocated by malloc(),
-	which means it cannot have a constructor, destructor or be
+	The \p data must be POD (plain old data) allocated by malloc() or
+	CEventDataPool::alloc(), which means it cannot have a constructor, destructor or be
 	composed of any types that do. For non-POD (normal C++ objects
 	use \c setDataObject().
 	\p target is the intended recipient of the event.
@@ -68,7 +68,7 @@ public:
 
 	//! Release event data
 	/*!
-	Deletes event data for the given event (using free()).
+	Deletes event data for the given event (using CEventDataPool::free()).
 	*/
 	static void			deleteData(const CEvent&);
 	
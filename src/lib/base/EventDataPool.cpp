@@ -0,0 +1,143 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventDataPool.h"
+#include "mt/Atomic.h"
+
+#include <cstdlib>
+
+// block sizes are kSmallestBlock, twice that and so on, one pool each.
+// every input event's data fits in the smallest, a key with the names
+// of a few screens in the next.  a few hundred of each is far more
+// than are ever waiting in the event queue.
+static const size_t		kNumPools      = 4;
+static const size_t		kSmallestBlock = 16;
+static const size_t		kBlocksPerPool = 256;
+static const size_t		kArenaSize     =
+							kSmallestBlock * kBlocksPerPool * ((1 << kNumPools) - 1);
+
+// every pool's blocks, pool after pool.  it's static so it's there
+// before anyone posts an event, and so free() can tell pooled data
+// by its address.  doubles align the blocks for any event data.
+static double			s_arena[kArenaSize / sizeof(double)];
+
+// a pool hands out blocks from its freelist, which is threaded through
+// the free blocks, then blocks it never handed out.  the lock is held
+// for a few instructions at most so waiting for it just spins.
+class CPool {
+public:
+	void*				m_free;
+	size_t				m_used;
+	volatile long		m_lock;
+};
+static CPool			s_pools[kNumPools];
+
+#ifndef NDEBUG
+static volatile long	s_heapAllocations = 0;
+#endif
+
+static inline
+char*
+getPoolStart(size_t pool)
+{
+	return reinterpret_cast<char*>(s_arena) +
+			kSmallestBlock * kBlocksPerPool * ((1 << pool) - 1);
+}
+
+static inline
+void
+lockPool(CPool& pool)
+{
+	while (!atomicCompareAndSwap(&pool.m_lock, 0, 1)) {
+		// spin
+	}
+}
+
+static inline
+void
+unlockPool(CPool& pool)
+{
+	atomicBarrier();
+	pool.m_lock = 0;
+}
+
+//
+// CEventDataPool
+//
+
+void*
+CEventDataPool::alloc(size_t size)
+{
+	for (size_t i = 0; i < kNumPools; ++i) {
+		size_t blockSize = (kSmallestBlock << i);
+		if (size > blockSize) {
+			continue;
+		}
+
+		CPool& pool = s_pools[i];
+		void* data  = NULL;
+		lockPool(pool);
+		if (pool.m_free != NULL) {
+			data        = pool.m_free;
+			pool.m_free = *static_cast<void**>(data);
+		}
+		else if (pool.m_used < kBlocksPerPool) {
+			data = getPoolStart(i) + blockSize * pool.m_used++;
+		}
+		unlockPool(pool);
+		if (data != NULL) {
+			return data;
+		}
+		break;
+	}
+
+#ifndef NDEBUG
+	atomicAdd(&s_heapAllocations, 1);
+#endif
+	return malloc(size);
+}
+
+void
+CEventDataPool::free(void* data)
+{
+	char* block = static_cast<char*>(data);
+	char* arena = reinterpret_cast<char*>(s_arena);
+	if (block < arena || block >= arena + kArenaSize) {
+		::free(data);
+		return;
+	}
+
+	// find the block's pool
+	size_t i = 0;
+	while (i + 1 < kNumPools && block >= getPoolStart(i + 1)) {
+		++i;
+	}
+
+	CPool& pool = s_pools[i];
+	lockPool(pool);
+	*reinterpret_cast<void**>(block) = pool.m_free;
+	pool.m_free = block;
+	unlockPool(pool);
+}
+
+#ifndef NDEBUG
+UInt32
+CEventDataPool::getHeapAllocations()
+{
+	return static_cast<UInt32>(s_heapAllocations);
+}
+#endif
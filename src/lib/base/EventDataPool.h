@@ -0,0 +1,56 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+#include <stddef.h>
+
+//! Event data allocator
+/*!
+Hands out event data (see CEvent) from freelists of 16, 32, 64 and 128
+byte blocks in a static arena, so posting an input event doesn't go to
+the heap.  Larger data, or data allocated when a size's blocks are all
+in use, comes from malloc().  free() takes either, and data allocated
+by malloc() elsewhere, so any event's data can be released with it.
+Any thread may allocate and free.
+*/
+class CEventDataPool {
+public:
+	//! Allocate event data
+	/*!
+	Returns \p size bytes, aligned for any event data.
+	*/
+	static void*		alloc(size_t size);
+
+	//! Release event data
+	/*!
+	Releases \p data, which is NULL or was returned by alloc() or
+	malloc().
+	*/
+	static void			free(void* data);
+
+#ifndef NDEBUG
+	//! Get the number of heap allocations
+	/*!
+	Returns how many times alloc() has used malloc().  Only in debug
+	builds.
+	*/
+	static UInt32		getHeapAllocations();
+#endif
+};
@@ -35,6 +35,7 @@ EVENT_TYPE_ACCESSOR(CIpcClientProxy)
 EVENT_TYPE_ACCESSOR(CIpcServer)
 EVENT_TYPE_ACCESSOR(CIpcServerProxy)
 EVENT_TYPE_ACCESSOR(IDataSocket)
+EVENT_TYPE_ACCESSOR(CAddressResolver)
 EVENT_TYPE_ACCESSOR(IListenSocket)
 EVENT_TYPE_ACCESSOR(ISocket)
 EVENT_TYPE_ACCESSOR(COSXScreen)
@@ -71,6 +72,7 @@ CEventQueue::CEventQueue() :
 	m_typesForCIpcServer(NULL),
 	m_typesForCIpcServerProxy(NULL),
 	m_typesForIDataSocket(NULL),
+	m_typesForCAddressResolver(NULL),
 	m_typesForIListenSocket(NULL),
 	m_typesForISocket(NULL),
 	m_typesForCOSXScreen(NULL),
@@ -175,16 +177,17 @@ CEventQueue::adoptBuffer(IEventQueueBuffer* buffer)
 
 	LOG((CLOG_DEBUG "adopting new buffer"));
 
-	if (m_events.size() != 0) {
+	int saved = static_cast<int>(m_events.size() - m_oldEventIDs.size());
+	if (saved != 0) {
 		// this can come as a nasty surprise to programmers expecting
 		// their events to be raised, only to have them deleted.
-		LOG((CLOG_DEBUG "discarding %d event(s)", m_events.size()));
+		LOG((CLOG_DEBUG "discarding %d event(s)", saved));
 	}
 
 	// discard old buffer and old events
 	delete m_buffer;
 	for (CEventTable::iterator i = m_events.begin(); i != m_events.end(); ++i) {
-		CEvent::deleteData(i->second);
+		CEvent::deleteData(*i);
 	}
 	m_events.clear();
 	m_oldEventIDs.clear();
@@ -451,14 +454,13 @@ CEventQueue::saveEvent(const CEvent& event)
 		// reuse an id
 		id = m_oldEventIDs.back();
 		m_oldEventIDs.pop_back();
+		m_events[id] = event;
 	}
 	else {
 		// make a new id
 		id = static_cast<UInt32>(m_events.size());
+		m_events.push_back(event);
 	}
-
-	// save data
-	m_events[id] = event;
 	return id;
 }
 
@@ -466,14 +468,14 @@ CEvent
 CEventQueue::removeEvent(UInt32 eventID)
 {
 	// look up id
-	CEventTable::iterator index = m_events.find(eventID);
-	if (index == m_events.end()) {
+	if (eventID >= m_events.size() ||
+		m_events[eventID].getType() == CEvent::kUnknown) {
 		return CEvent();
 	}
 
 	// get data
-	CEvent event = index->second;
-	m_events.erase(index);
+	CEvent event      = m_events[eventID];
+	m_events[eventID] = CEvent();
 
 	// save old id for reuse
 	m_oldEventIDs.push_back(eventID);
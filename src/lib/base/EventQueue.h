@@ -26,6 +26,7 @@
 #include "base/Stopwatch.h"
 #include "common/stdmap.h"
 #include "common/stdset.h"
+#include "common/stdvector.h"
 
 #include <queue>
 
@@ -104,7 +105,7 @@ private:
 
 	typedef std::set<CEventQueueTimer*> CTimers;
 	typedef CPriorityQueue<CTimer> CTimerQueue;
-	typedef std::map<UInt32, CEvent> CEventTable;
+	typedef std::vector<CEvent> CEventTable;
 	typedef std::vector<UInt32> CEventIDList;
 	typedef std::map<CEvent::Type, const char*> CTypeMap;
 	typedef std::map<CString, CEvent::Type> CNameMap;
@@ -122,7 +123,9 @@ private:
 	// buffer of events
 	IEventQueueBuffer*	m_buffer;
 
-	// saved events
+	// saved events, by id.  ids are reused so the table stays as big as
+	// the most events ever waiting at once and saving an event doesn't
+	// allocate.  unused entries are kUnknown events.
 	CEventTable			m_events;
 	CEventIDList		m_oldEventIDs;
 
@@ -146,6 +149,7 @@ public:
 	CIpcServerEvents&			forCIpcServer();
 	CIpcServerProxyEvents&		forCIpcServerProxy();
 	IDataSocketEvents&			forIDataSocket();
+	CAddressResolverEvents&		forCAddressResolver();
 	IListenSocketEvents&		forIListenSocket();
 	ISocketEvents&				forISocket();
 	COSXScreenEvents&			forCOSXScreen();
@@ -166,6 +170,7 @@ private:
 	CIpcServerEvents*			m_typesForCIpcServer;
 	CIpcServerProxyEvents*		m_typesForCIpcServerProxy;
 	IDataSocketEvents*			m_typesForIDataSocket;
+	CAddressResolverEvents*		m_typesForCAddressResolver;
 	IListenSocketEvents*		m_typesForIListenSocket;
 	ISocketEvents*				m_typesForISocket;
 	COSXScreenEvents*			m_typesForCOSXScreen;
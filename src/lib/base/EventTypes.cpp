@@ -84,6 +84,12 @@ REGISTER_EVENT(CIpcServerProxy, messageReceived)
 REGISTER_EVENT(IDataSocket, connected)
 REGISTER_EVENT(IDataSocket, connectionFailed)
 
+//
+// CAddressResolver
+//
+
+REGISTER_EVENT(CAddressResolver, resolved)
+
 //
 // IListenSocket
 //
@@ -115,6 +121,7 @@ REGISTER_EVENT(CClientListener, connected)
 REGISTER_EVENT(CClientProxy, ready)
 REGISTER_EVENT(CClientProxy, disconnected)
 REGISTER_EVENT(CClientProxy, clipboardChanged)
+REGISTER_EVENT(CClientProxy, inputFlush)
 
 //
 // CClientProxyUnknown
@@ -135,6 +142,7 @@ REGISTER_EVENT(CServer, switchInDirection)
 REGISTER_EVENT(CServer, keyboardBroadcast)
 REGISTER_EVENT(CServer, lockCursorToScreen)
 REGISTER_EVENT(CServer, screenSwitched)
+REGISTER_EVENT(CServer, motionFlush)
 
 //
 // CServerApp
@@ -167,6 +175,7 @@ REGISTER_EVENT(IPrimaryScreen, hotKeyDown)
 REGISTER_EVENT(IPrimaryScreen, hotKeyUp)
 REGISTER_EVENT(IPrimaryScreen, fakeInputBegin)
 REGISTER_EVENT(IPrimaryScreen, fakeInputEnd)
+REGISTER_EVENT(IPrimaryScreen, inputReady)
 
 //
 // IScreen
@@ -257,6 +257,28 @@ private:
 	CEvent::Type		m_connectionFailed;
 };
 
+class CAddressResolverEvents : public CEventTypes {
+public:
+	CAddressResolverEvents() :
+		m_resolved(CEvent::kUnknown) { }
+
+	//! @name accessors
+	//@{
+
+	//! Get resolved event type
+	/*!
+	Returns the resolved event type.  This is sent, with the request as
+	the target, when an asynchronous lookup started by
+	CAddressResolver::resolve() has finished, successfully or not.
+	*/
+	CEvent::Type		resolved();
+
+	//@}
+
+private:
+	CEvent::Type		m_resolved;
+};
+
 class IListenSocketEvents : public CEventTypes {
 public:
 	IListenSocketEvents() :
@@ -342,7 +364,8 @@ public:
 	CClientProxyEvents() :
 		m_ready(CEvent::kUnknown),
 		m_disconnected(CEvent::kUnknown),
-		m_clipboardChanged(CEvent::kUnknown) { }
+		m_clipboardChanged(CEvent::kUnknown),
+		m_inputFlush(CEvent::kUnknown) { }
 
 	//! @name accessors
 	//@{
@@ -370,12 +393,21 @@ public:
 	*/
 	CEvent::Type		clipboardChanged();
 
+	//! Get input flush event type
+	/*!
+	Returns the input flush event type.  A proxy that batches input
+	posts this to itself to send the batch once the events ahead of it
+	in the queue have been dispatched.
+	*/
+	CEvent::Type		inputFlush();
+
 	//@}
 
 private:
 	CEvent::Type		m_ready;
 	CEvent::Type		m_disconnected;
 	CEvent::Type		m_clipboardChanged;
+	CEvent::Type		m_inputFlush;
 };
 
 class CClientProxyUnknownEvents : public CEventTypes {
@@ -418,7 +450,8 @@ public:
 		m_switchInDirection(CEvent::kUnknown),
 		m_keyboardBroadcast(CEvent::kUnknown),
 		m_lockCursorToScreen(CEvent::kUnknown),
-		m_screenSwitched(CEvent::kUnknown) { }
+		m_screenSwitched(CEvent::kUnknown),
+		m_motionFlush(CEvent::kUnknown) { }
 
 	//! @name accessors
 	//@{
@@ -484,6 +517,14 @@ public:
 	*/
 	CEvent::Type		screenSwitched();
 
+	//! Get motion flush event type
+	/*!
+	Returns the motion flush event type.  The server posts this to
+	itself to send mouse motion that was coalesced while the events
+	ahead of it in the queue were dispatched.
+	*/
+	CEvent::Type		motionFlush();
+
 	//@}
 		
 private:
@@ -495,6 +536,7 @@ private:
 	CEvent::Type		m_keyboardBroadcast;
 	CEvent::Type		m_lockCursorToScreen;
 	CEvent::Type		m_screenSwitched;
+	CEvent::Type		m_motionFlush;
 };
 
 class CServerAppEvents : public CEventTypes {
@@ -559,7 +601,8 @@ public:
 		m_hotKeyDown(CEvent::kUnknown),
 		m_hotKeyUp(CEvent::kUnknown),
 		m_fakeInputBegin(CEvent::kUnknown),
-		m_fakeInputEnd(CEvent::kUnknown) { }
+		m_fakeInputEnd(CEvent::kUnknown),
+		m_inputReady(CEvent::kUnknown) { }
 
 	//! @name accessors
 	//@{
@@ -604,6 +647,13 @@ public:
 	//!  end of fake input event type
 	CEvent::Type		fakeInputEnd();
 
+	//!  input channel ready event type
+	/*!
+	Sent to a CInputChannel when it has input to receive.  Event data
+	is NULL, or a CInputChannel::CInput* that didn't fit in the channel.
+	*/
+	CEvent::Type		inputReady();
+
 	//@}
 
 private:
@@ -618,6 +668,7 @@ private:
 	CEvent::Type		m_hotKeyUp;
 	CEvent::Type		m_fakeInputBegin;
 	CEvent::Type		m_fakeInputEnd;
+	CEvent::Type		m_inputReady;
 };
 
 class IScreenEvents : public CEventTypes {
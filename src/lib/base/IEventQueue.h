@@ -37,6 +37,7 @@ class CIpcClientProxyEvents;
 class CIpcServerEvents;
 class CIpcServerProxyEvents;
 class IDataSocketEvents;
+class CAddressResolverEvents;
 class IListenSocketEvents;
 class ISocketEvents;
 class COSXScreenEvents;
@@ -233,6 +234,7 @@ public:
 	virtual CIpcServerEvents&			forCIpcServer() = 0;
 	virtual CIpcServerProxyEvents&		forCIpcServerProxy() = 0;
 	virtual IDataSocketEvents&			forIDataSocket() = 0;
+	virtual CAddressResolverEvents&		forCAddressResolver() = 0;
 	virtual IListenSocketEvents&		forIListenSocket() = 0;
 	virtual ISocketEvents&				forISocket() = 0;
 	virtual COSXScreenEvents&			forCOSXScreen() = 0;
@@ -0,0 +1,205 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LatencyStats.h"
+#include "mt/Atomic.h"
+#include "arch/Arch.h"
+
+// longest duration that gets its own bucket, about four seconds.
+// anything longer isn't a latency worth knowing more about.
+static const UInt32		kMaxNanoseconds = 0xffffffffu;
+
+// percentiles in the formatted stats
+static const double		kPercentiles[] = { 50.0, 90.0, 99.0, 99.9, 100.0 };
+
+//
+// CLatencyHistogram
+//
+
+CLatencyHistogram::CLatencyHistogram()
+{
+	reset();
+}
+
+void
+CLatencyHistogram::record(double seconds)
+{
+	// a duration taken off any clock but ARCH->monotonicTime() can come
+	// out negative
+	UInt32 ns = 0;
+	if (seconds >= 1.0e-9 * static_cast<double>(kMaxNanoseconds)) {
+		ns = kMaxNanoseconds;
+	}
+	else if (seconds > 0.0) {
+		ns = static_cast<UInt32>(1.0e+9 * seconds);
+	}
+	atomicAdd(&m_counts[getBucket(ns)], 1);
+}
+
+void
+CLatencyHistogram::reset()
+{
+	for (UInt32 i = 0; i < kBuckets; ++i) {
+		m_counts[i] = 0;
+	}
+}
+
+UInt32
+CLatencyHistogram::getCount() const
+{
+	UInt32 count = 0;
+	for (UInt32 i = 0; i < kBuckets; ++i) {
+		count += static_cast<UInt32>(m_counts[i]);
+	}
+	return count;
+}
+
+double
+CLatencyHistogram::getPercentile(double percent) const
+{
+	UInt32 count = getCount();
+	if (count == 0) {
+		return 0.0;
+	}
+
+	// the rank of the duration we want, counting from 1
+	UInt32 rank = static_cast<UInt32>(0.01 * percent *
+							static_cast<double>(count) + 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	else if (rank > count) {
+		rank = count;
+	}
+
+	// the counts may go up while we look;  anything past the total we
+	// started with just ends up in the last bucket we find
+	UInt32 bucket = 0;
+	for (UInt32 seen = 0; bucket < kBuckets; ++bucket) {
+		seen += static_cast<UInt32>(m_counts[bucket]);
+		if (seen >= rank) {
+			break;
+		}
+	}
+	if (bucket == kBuckets) {
+		--bucket;
+	}
+	return 1.0e-9 * static_cast<double>(getBucketTop(bucket));
+}
+
+UInt32
+CLatencyHistogram::getBucket(UInt32 ns)
+{
+	// values below 32 are exact.  above that keep the top five bits:
+	// the leading one and which sixteenth of its power of two.
+	UInt32 shift = 0;
+	while (ns >= 2 * kSubBuckets) {
+		ns >>= 1;
+		++shift;
+	}
+	return kSubBuckets * shift + ns;
+}
+
+UInt32
+CLatencyHistogram::getBucketTop(UInt32 bucket)
+{
+	// in the top bucket (value + 1) << shift wraps around to 0
+	UInt32 shift = (bucket < 2 * kSubBuckets) ? 0 : bucket / kSubBuckets - 1;
+	UInt32 value = bucket - kSubBuckets * shift;
+	return ((value + 1) << shift) - 1;
+}
+
+
+//
+// CLatencyStats
+//
+
+CLatencyHistogram		CLatencyStats::s_stages[kNumStages];
+
+void
+CLatencyStats::record(EStage stage, double seconds)
+{
+	s_stages[stage].record(seconds);
+}
+
+void
+CLatencyStats::reset()
+{
+	for (int i = 0; i < kNumStages; ++i) {
+		s_stages[i].reset();
+	}
+}
+
+const CLatencyHistogram&
+CLatencyStats::get(EStage stage)
+{
+	return s_stages[stage];
+}
+
+const char*
+CLatencyStats::getName(EStage stage)
+{
+	static const char* s_names[] = {
+		"capture",
+		"queue",
+		"routing",
+		"encode",
+		"socket write",
+		"decode",
+		"inject"
+	};
+	return s_names[stage];
+}
+
+CString
+CLatencyStats::format()
+{
+	CString result = synergy::string::sprintf(
+							"%-14s %10s %9s %9s %9s %9s %9s\n",
+							"stage (us)", "count",
+							"p50", "p90", "p99", "p99.9", "max");
+	for (int i = 0; i < kNumStages; ++i) {
+		EStage stage = static_cast<EStage>(i);
+		const CLatencyHistogram& histogram = s_stages[stage];
+		result += synergy::string::sprintf("%-14s %10u", getName(stage),
+							histogram.getCount());
+		for (size_t j = 0; j < sizeof(kPercentiles) /
+							sizeof(kPercentiles[0]); ++j) {
+			result += synergy::string::sprintf(" %9.1f",
+							1.0e+6 * histogram.getPercentile(kPercentiles[j]));
+		}
+		result += "\n";
+	}
+	return result;
+}
+
+
+//
+// CLatencyTimer
+//
+
+CLatencyTimer::CLatencyTimer(CLatencyStats::EStage stage) :
+	m_stage(stage),
+	m_start(ARCH->monotonicTime())
+{
+	// do nothing
+}
+
+CLatencyTimer::~CLatencyTimer()
+{
+	CLatencyStats::record(m_stage, ARCH->monotonicTime() - m_start);
+}
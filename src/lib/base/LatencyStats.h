@@ -0,0 +1,144 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+
+//! Latency histogram
+/*!
+Counts durations in buckets that are exact up to 31 ns and then 1/16th
+of a power of two wide, so every value is known to within about 6%
+from a nanosecond up to four seconds, in under 4 KB.  Recording is a
+bucket lookup and an atomic increment, so any thread may record at
+any time.
+*/
+class CLatencyHistogram {
+public:
+	CLatencyHistogram();
+
+	//! @name manipulators
+	//@{
+
+	//! Count a duration
+	/*!
+	Counts a duration of \p seconds.
+	*/
+	void				record(double seconds);
+
+	//! Forget all durations
+	void				reset();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get the number of durations
+	UInt32				getCount() const;
+
+	//! Get a percentile
+	/*!
+	Returns the duration, in seconds, that \p percent of the durations
+	didn't exceed, rounded up to the top of its bucket.  Returns 0 if
+	there are none.
+	*/
+	double				getPercentile(double percent) const;
+
+	//@}
+
+private:
+	enum {
+		kSubBuckets = 16,
+		kMaxShift   = 27,
+		kBuckets    = kSubBuckets * (kMaxShift + 2)
+	};
+
+	static UInt32		getBucket(UInt32 ns);
+	static UInt32		getBucketTop(UInt32 bucket);
+
+private:
+	volatile long		m_counts[kBuckets];
+};
+
+//! Hot path latencies
+/*!
+One CLatencyHistogram for each stage input goes through between the
+server's screen and the client's screen.  They're always on;  use a
+CLatencyTimer or record() where a stage starts and ends, timing with
+ARCH->monotonicTime().
+*/
+class CLatencyStats {
+public:
+	enum EStage {
+		kCapture,		//!< primary screen, from input to handing it on
+		kQueueDwell,	//!< waiting for the server to take the input
+		kRouting,		//!< server, from taking input to relaying it
+		kEncode,		//!< a batch through the client proxy's streams
+		kSocketWrite,	//!< socket, from write to the kernel having it
+		kDecode,		//!< client, parsing a packet of messages
+		kInject,		//!< client, handing faked input to the screen
+		kNumStages
+	};
+
+	//! @name manipulators
+	//@{
+
+	//! Count a duration
+	static void			record(EStage, double seconds);
+
+	//! Forget all durations
+	static void			reset();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get a stage's histogram
+	static const CLatencyHistogram&
+						get(EStage);
+
+	//! Get a stage's name
+	static const char*	getName(EStage);
+
+	//! Format the stats
+	/*!
+	Returns a table with the number of durations and some percentiles
+	for each stage, one stage per line.
+	*/
+	static CString		format();
+
+	//@}
+
+private:
+	static CLatencyHistogram	s_stages[kNumStages];
+};
+
+//! Stage timer
+/*!
+Records the time from construction to destruction under a stage, as
+ARCH->monotonicTime() measures it.
+*/
+class CLatencyTimer {
+public:
+	CLatencyTimer(CLatencyStats::EStage);
+	~CLatencyTimer();
+
+private:
+	CLatencyStats::EStage	m_stage;
+	double				m_start;
+};
@@ -20,6 +20,9 @@
 #include "base/Unicode.h"
 
 #include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 //
 // local utility functions
@@ -69,6 +72,23 @@ decode32(const UInt8* n, bool byteSwapped)
 	return c.n32;
 }
 
+inline
+static
+void
+encode16(UInt8* n, UInt32 c)
+{
+	UInt16 c16 = static_cast<UInt16>(c);
+	memcpy(n, &c16, 2);
+}
+
+inline
+static
+void
+encode32(UInt8* n, UInt32 c)
+{
+	memcpy(n, &c, 4);
+}
+
 inline
 static
 void
@@ -89,6 +109,221 @@ setError(bool* errors)
 	}
 }
 
+// resizes dst to size bytes and returns its data for writing
+inline
+static
+UInt8*
+getBuffer(CString& dst, UInt32 size)
+{
+	dst.resize(size);
+	return (size == 0) ? NULL : reinterpret_cast<UInt8*>(&dst[0]);
+}
+
+// returns the number of bytes needed to encode c in UTF-8 by
+// CUnicode::toUTF8(), including substituting the (3 byte)
+// replacement character for characters outside the valid range
+inline
+static
+UInt32
+getUTF8Length(UInt32 c)
+{
+	if (c < 0x00000080) {
+		return 1;
+	}
+	else if (c < 0x00000800) {
+		return 2;
+	}
+	else if (c < 0x00010000 || (c >= 0x0000d800 && c <= 0x0000dfff)) {
+		return 3;
+	}
+	else if (c < 0x00200000) {
+		return 4;
+	}
+	else if (c < 0x04000000) {
+		return 5;
+	}
+	else if (c < 0x80000000) {
+		return 6;
+	}
+	else {
+		return 3;
+	}
+}
+
+//
+// ASCII runs.  most text is mostly ASCII so the converters hand off
+// runs of it to these, which use SSE2 where available and otherwise
+// stick to simple loops the compiler can unroll.  each returns the
+// number of characters at the start of src that are ASCII.
+//
+
+// count ASCII bytes
+static
+UInt32
+countASCII8(const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+#if defined(__SSE2__)
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		if (_mm_movemask_epi8(v) != 0) {
+			break;
+		}
+	}
+#else
+	for (; i + 4 <= n; i += 4) {
+		UInt32 v;
+		memcpy(&v, src + i, 4);
+		if ((v & 0x80808080u) != 0) {
+			break;
+		}
+	}
+#endif
+	while (i < n && src[i] < 0x80) {
+		++i;
+	}
+	return i;
+}
+
+// count ASCII 16-bit characters
+static
+UInt32
+countASCII16(const UInt8* src, UInt32 n, bool byteSwapped)
+{
+	UInt32 i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(
+							static_cast<short>(byteSwapped ? 0x80ff : 0xff80));
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128(
+							reinterpret_cast<const __m128i*>(src + 2 * i));
+		v = _mm_cmpeq_epi16(_mm_and_si128(v, mask), zero);
+		if (_mm_movemask_epi8(v) != 0xffff) {
+			break;
+		}
+	}
+#endif
+	while (i < n && decode16(src + 2 * i, byteSwapped) < 0x80) {
+		++i;
+	}
+	return i;
+}
+
+// count ASCII 32-bit characters
+static
+UInt32
+countASCII32(const UInt8* src, UInt32 n, bool byteSwapped)
+{
+	UInt32 i = 0;
+	while (i < n && decode32(src + 4 * i, byteSwapped) < 0x80) {
+		++i;
+	}
+	return i;
+}
+
+// copy ASCII bytes to native 16-bit characters
+static
+UInt32
+widenASCII16(UInt8* dst, const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		if (_mm_movemask_epi8(v) != 0) {
+			break;
+		}
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 2 * i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi8(v, zero));
+	}
+#endif
+	for (; i < n && src[i] < 0x80; ++i) {
+		encode16(dst + 2 * i, src[i]);
+	}
+	return i;
+}
+
+// copy ASCII bytes to native 32-bit characters
+static
+UInt32
+widenASCII32(UInt8* dst, const UInt8* src, UInt32 n)
+{
+	UInt32 i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		if (_mm_movemask_epi8(v) != 0) {
+			break;
+		}
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 4 * i);
+		_mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+	}
+#endif
+	for (; i < n && src[i] < 0x80; ++i) {
+		encode32(dst + 4 * i, src[i]);
+	}
+	return i;
+}
+
+// copy ASCII 16-bit characters to bytes
+static
+UInt32
+narrowASCII16(UInt8* dst, const UInt8* src, UInt32 n, bool byteSwapped)
+{
+	UInt32 i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i mask = _mm_set1_epi16(
+							static_cast<short>(byteSwapped ? 0x80ff : 0xff80));
+	for (; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128(
+							reinterpret_cast<const __m128i*>(src + 2 * i));
+		__m128i t = _mm_cmpeq_epi16(_mm_and_si128(v, mask), zero);
+		if (_mm_movemask_epi8(t) != 0xffff) {
+			break;
+		}
+		if (byteSwapped) {
+			v = _mm_srli_epi16(v, 8);
+		}
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i),
+							_mm_packus_epi16(v, v));
+	}
+#endif
+	for (; i < n; ++i) {
+		UInt16 c = decode16(src + 2 * i, byteSwapped);
+		if (c >= 0x80) {
+			break;
+		}
+		dst[i] = static_cast<UInt8>(c);
+	}
+	return i;
+}
+
+// copy ASCII 32-bit characters to bytes
+static
+UInt32
+narrowASCII32(UInt8* dst, const UInt8* src, UInt32 n, bool byteSwapped)
+{
+	UInt32 i = 0;
+	for (; i < n; ++i) {
+		UInt32 c = decode32(src + 4 * i, byteSwapped);
+		if (c >= 0x80) {
+			break;
+		}
+		dst[i] = static_cast<UInt8>(c);
+	}
+	return i;
+}
+
 
 //
 // CUnicode
@@ -100,10 +335,15 @@ UInt32					CUnicode::s_replacement = 0x0000fffd;
 bool
 CUnicode::isUTF8(const CString& src)
 {
-	// convert and test each character
+	// convert and test each character, skipping over runs of ASCII
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	for (UInt32 n = (UInt32)src.size(); n > 0; ) {
-		if (fromUTF8(data, n) == s_invalid) {
+		if (*data < 0x80) {
+			UInt32 ascii = countASCII8(data, n);
+			data += ascii;
+			n    -= ascii;
+		}
+		else if (fromUTF8(data, n) == s_invalid) {
 			return false;
 		}
 	}
@@ -116,14 +356,24 @@ CUnicode::UTF8ToUCS2(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// get size of input string and make space for the output.  each
+	// byte of input yields at most one character so this is exact for ASCII.
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(2 * n);
+	UInt8* begin = getBuffer(dst, 2 * n);
+	UInt8* out   = begin;
 
 	// convert each character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
+		if (*data < 0x80) {
+			UInt32 ascii = widenASCII16(out, data, n);
+			out  += 2 * ascii;
+			data += ascii;
+			n    -= ascii;
+			continue;
+		}
+
 		UInt32 c = fromUTF8(data, n);
 		if (c == s_invalid) {
 			c = s_replacement;
@@ -132,10 +382,11 @@ CUnicode::UTF8ToUCS2(const CString& src, bool* errors)
 			setError(errors);
 			c = s_replacement;
 		}
-		UInt16 ucs2 = static_cast<UInt16>(c);
-		dst.append(reinterpret_cast<const char*>(&ucs2), 2);
+		encode16(out, c);
+		out += 2;
 	}
 
+	dst.resize(out - begin);
 	return dst;
 }
 
@@ -145,21 +396,33 @@ CUnicode::UTF8ToUCS4(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// get size of input string and make space for the output.  each
+	// byte of input yields at most one character so this is exact for ASCII.
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(4 * n);
+	UInt8* begin = getBuffer(dst, 4 * n);
+	UInt8* out   = begin;
 
 	// convert each character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
+		if (*data < 0x80) {
+			UInt32 ascii = widenASCII32(out, data, n);
+			out  += 4 * ascii;
+			data += ascii;
+			n    -= ascii;
+			continue;
+		}
+
 		UInt32 c = fromUTF8(data, n);
 		if (c == s_invalid) {
 			c = s_replacement;
 		}
-		dst.append(reinterpret_cast<const char*>(&c), 4);
+		encode32(out, c);
+		out += 4;
 	}
 
+	dst.resize(out - begin);
 	return dst;
 }
 
@@ -169,14 +432,24 @@ CUnicode::UTF8ToUTF16(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// get size of input string and make space for the output.  each
+	// byte of input yields at most one UTF-16 word so this is exact for ASCII.
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(2 * n);
+	UInt8* begin = getBuffer(dst, 2 * n);
+	UInt8* out   = begin;
 
 	// convert each character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
+		if (*data < 0x80) {
+			UInt32 ascii = widenASCII16(out, data, n);
+			out  += 2 * ascii;
+			data += ascii;
+			n    -= ascii;
+			continue;
+		}
+
 		UInt32 c = fromUTF8(data, n);
 		if (c == s_invalid) {
 			c = s_replacement;
@@ -186,18 +459,18 @@ CUnicode::UTF8ToUTF16(const CString& src, bool* errors)
 			c = s_replacement;
 		}
 		if (c < 0x00010000) {
-			UInt16 ucs2 = static_cast<UInt16>(c);
-			dst.append(reinterpret_cast<const char*>(&ucs2), 2);
+			encode16(out, c);
+			out += 2;
 		}
 		else {
 			c -= 0x00010000;
-			UInt16 utf16h = static_cast<UInt16>((c >> 10) + 0xd800);
-			UInt16 utf16l = static_cast<UInt16>((c & 0x03ff) + 0xdc00);
-			dst.append(reinterpret_cast<const char*>(&utf16h), 2);
-			dst.append(reinterpret_cast<const char*>(&utf16l), 2);
+			encode16(out + 0, (c >> 10) + 0xd800);
+			encode16(out + 2, (c & 0x03ff) + 0xdc00);
+			out += 4;
 		}
 	}
 
+	dst.resize(out - begin);
 	return dst;
 }
 
@@ -207,14 +480,24 @@ CUnicode::UTF8ToUTF32(const CString& src, bool* errors)
 	// default to success
 	resetError(errors);
 
-	// get size of input string and reserve some space in output
+	// get size of input string and make space for the output.  each
+	// byte of input yields at most one character so this is exact for ASCII.
 	UInt32 n = (UInt32)src.size();
 	CString dst;
-	dst.reserve(4 * n);
+	UInt8* begin = getBuffer(dst, 4 * n);
+	UInt8* out   = begin;
 
 	// convert each character
 	const UInt8* data = reinterpret_cast<const UInt8*>(src.c_str());
 	while (n > 0) {
+		if (*data < 0x80) {
+			UInt32 ascii = widenASCII32(out, data, n);
+			out  += 4 * ascii;
+			data += ascii;
+			n    -= ascii;
+			continue;
+		}
+
 		UInt32 c = fromUTF8(data, n);
 		if (c == s_invalid) {
 			c = s_replacement;
@@ -223,9 +506,11 @@ CUnicode::UTF8ToUTF32(const CString& src, bool* errors)
 			setError(errors);
 			c = s_replacement;
 		}
-		dst.append(reinterpret_cast<const char*>(&c), 4);
+		encode32(out, c);
+		out += 4;
 	}
 
+	dst.resize(out - begin);
 	return dst;
 }
 
@@ -381,10 +666,6 @@ CUnicode::wideCharToUTF8(const wchar_t* src, UInt32 size, bool* errors)
 CString
 CUnicode::doUCS2ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
-	CString dst;
-	dst.reserve(n);
-
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
 	if (n >= 1) {
@@ -405,10 +686,37 @@ CUnicode::doUCS2ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
+	// compute the size of the output
+	UInt32 size = 0;
+	for (UInt32 i = 0; i < n; ) {
+		UInt32 c = decode16(data + 2 * i, byteSwapped);
+		if (c < 0x80) {
+			UInt32 ascii = countASCII16(data + 2 * i, n - i, byteSwapped);
+			size += ascii;
+			i    += ascii;
+		}
+		else {
+			size += getUTF8Length(c);
+			++i;
+		}
+	}
+
 	// convert each character
-	for (; n > 0; data += 2, --n) {
+	CString dst;
+	UInt8* out = getBuffer(dst, size);
+	while (n > 0) {
 		UInt32 c = decode16(data, byteSwapped);
-		toUTF8(dst, c, errors);
+		if (c < 0x80) {
+			UInt32 ascii = narrowASCII16(out, data, n, byteSwapped);
+			out  += ascii;
+			data += 2 * ascii;
+			n    -= ascii;
+			continue;
+		}
+
+		out  += toUTF8(out, c, errors);
+		data += 2;
+		--n;
 	}
 
 	return dst;
@@ -417,10 +725,6 @@ CUnicode::doUCS2ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 CString
 CUnicode::doUCS4ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
-	CString dst;
-	dst.reserve(n);
-
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
 	if (n >= 1) {
@@ -441,10 +745,37 @@ CUnicode::doUCS4ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
+	// compute the size of the output
+	UInt32 size = 0;
+	for (UInt32 i = 0; i < n; ) {
+		UInt32 c = decode32(data + 4 * i, byteSwapped);
+		if (c < 0x80) {
+			UInt32 ascii = countASCII32(data + 4 * i, n - i, byteSwapped);
+			size += ascii;
+			i    += ascii;
+		}
+		else {
+			size += getUTF8Length(c);
+			++i;
+		}
+	}
+
 	// convert each character
-	for (; n > 0; data += 4, --n) {
+	CString dst;
+	UInt8* out = getBuffer(dst, size);
+	while (n > 0) {
 		UInt32 c = decode32(data, byteSwapped);
-		toUTF8(dst, c, errors);
+		if (c < 0x80) {
+			UInt32 ascii = narrowASCII32(out, data, n, byteSwapped);
+			out  += ascii;
+			data += 4 * ascii;
+			n    -= ascii;
+			continue;
+		}
+
+		out  += toUTF8(out, c, errors);
+		data += 4;
+		--n;
 	}
 
 	return dst;
@@ -453,10 +784,6 @@ CUnicode::doUCS4ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 CString
 CUnicode::doUTF16ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
-	CString dst;
-	dst.reserve(n);
-
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
 	if (n >= 1) {
@@ -477,35 +804,64 @@ CUnicode::doUTF16ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
+	// compute the size of the output.  surrogates that don't form a
+	// pair are replaced, consuming the same words as conversion below.
+	UInt32 size = 0;
+	for (UInt32 i = 0; i < n; ) {
+		UInt32 c = decode16(data + 2 * i, byteSwapped);
+		if (c < 0x80) {
+			UInt32 ascii = countASCII16(data + 2 * i, n - i, byteSwapped);
+			size += ascii;
+			i    += ascii;
+		}
+		else if (c >= 0x0000d800 && c <= 0x0000dbff && i + 1 < n) {
+			UInt32 c2 = decode16(data + 2 * i + 2, byteSwapped);
+			size += (c2 >= 0x0000dc00 && c2 <= 0x0000dfff) ? 4 : 3;
+			i    += 2;
+		}
+		else {
+			size += getUTF8Length(c);
+			++i;
+		}
+	}
+
 	// convert each character
+	CString dst;
+	UInt8* out = getBuffer(dst, size);
 	for (; n > 0; data += 2, --n) {
 		UInt32 c = decode16(data, byteSwapped);
-		if (c < 0x0000d800 || c > 0x0000dfff) {
-			toUTF8(dst, c, errors);
+		if (c < 0x80) {
+			UInt32 ascii = narrowASCII16(out, data, n, byteSwapped);
+			out  += ascii;
+			data += 2 * (ascii - 1);
+			n    -= ascii - 1;
+		}
+		else if (c < 0x0000d800 || c > 0x0000dfff) {
+			out += toUTF8(out, c, errors);
 		}
 		else if (n == 1) {
 			// error -- missing second word
 			setError(errors);
-			toUTF8(dst, s_replacement, NULL);
+			out += toUTF8(out, s_replacement, NULL);
 		}
 		else if (c >= 0x0000d800 && c <= 0x0000dbff) {
-			UInt32 c2 = decode16(data, byteSwapped);
+			UInt32 c2 = decode16(data + 2, byteSwapped);
 			data += 2;
 			--n;
 			if (c2 < 0x0000dc00 || c2 > 0x0000dfff) {
 				// error -- [d800,dbff] not followed by [dc00,dfff]
 				setError(errors);
-				toUTF8(dst, s_replacement, NULL);
+				out += toUTF8(out, s_replacement, NULL);
 			}
 			else {
 				c = (((c - 0x0000d800) << 10) | (c2 - 0x0000dc00)) + 0x00010000;
-				toUTF8(dst, c, errors);
+				out += toUTF8(out, c, errors);
 			}
 		}
 		else {
 			// error -- [dc00,dfff] without leading [d800,dbff]
 			setError(errors);
-			toUTF8(dst, s_replacement, NULL);
+			out += toUTF8(out, s_replacement, NULL);
 		}
 	}
 
@@ -515,10 +871,6 @@ CUnicode::doUTF16ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 CString
 CUnicode::doUTF32ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 {
-	// make some space
-	CString dst;
-	dst.reserve(n);
-
 	// check if first character is 0xfffe or 0xfeff
 	bool byteSwapped = false;
 	if (n >= 1) {
@@ -539,14 +891,40 @@ CUnicode::doUTF32ToUTF8(const UInt8* data, UInt32 n, bool* errors)
 		}
 	}
 
+	// compute the size of the output
+	UInt32 size = 0;
+	for (UInt32 i = 0; i < n; ) {
+		UInt32 c = decode32(data + 4 * i, byteSwapped);
+		if (c < 0x80) {
+			UInt32 ascii = countASCII32(data + 4 * i, n - i, byteSwapped);
+			size += ascii;
+			i    += ascii;
+		}
+		else {
+			size += getUTF8Length(c < 0x00110000 ? c : s_replacement);
+			++i;
+		}
+	}
+
 	// convert each character
-	for (; n > 0; data += 4, --n) {
+	CString dst;
+	UInt8* out = getBuffer(dst, size);
+	while (n > 0) {
 		UInt32 c = decode32(data, byteSwapped);
+		if (c < 0x80) {
+			UInt32 ascii = narrowASCII32(out, data, n, byteSwapped);
+			out  += ascii;
+			data += 4 * ascii;
+			n    -= ascii;
+			continue;
+		}
 		if (c >= 0x00110000) {
 			setError(errors);
 			c = s_replacement;
 		}
-		toUTF8(dst, c, errors);
+		out  += toUTF8(out, c, errors);
+		data += 4;
+		--n;
 	}
 
 	return dst;
@@ -628,25 +1006,25 @@ CUnicode::fromUTF8(const UInt8*& data, UInt32& n)
 	case 4:
 		c = ((static_cast<UInt32>(data[0]) & 0x07) << 18) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[3]) & 0x3f)      );
 		break;
 
 	case 5:
 		c = ((static_cast<UInt32>(data[0]) & 0x03) << 24) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 18) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) << 12) |
+			((static_cast<UInt32>(data[3]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[4]) & 0x3f)      );
 		break;
 
 	case 6:
 		c = ((static_cast<UInt32>(data[0]) & 0x01) << 30) |
 			((static_cast<UInt32>(data[1]) & 0x3f) << 24) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 18) |
-			((static_cast<UInt32>(data[1]) & 0x3f) << 12) |
-			((static_cast<UInt32>(data[1]) & 0x3f) <<  6) |
-			((static_cast<UInt32>(data[1]) & 0x3f)      );
+			((static_cast<UInt32>(data[2]) & 0x3f) << 18) |
+			((static_cast<UInt32>(data[3]) & 0x3f) << 12) |
+			((static_cast<UInt32>(data[4]) & 0x3f) <<  6) |
+			((static_cast<UInt32>(data[5]) & 0x3f)      );
 		break;
 
 	default:
@@ -727,11 +1105,9 @@ CUnicode::fromUTF8(const UInt8*& data, UInt32& n)
 	return c;
 }
 
-void
-CUnicode::toUTF8(CString& dst, UInt32 c, bool* errors)
+UInt32
+CUnicode::toUTF8(UInt8* data, UInt32 c, bool* errors)
 {
-	UInt8 data[6];
-
 	// handle characters outside the valid range
 	if ((c >= 0x0000d800 && c <= 0x0000dfff) || c >= 0x80000000) {
 		setError(errors);
@@ -741,25 +1117,25 @@ CUnicode::toUTF8(CString& dst, UInt32 c, bool* errors)
 	// convert to UTF-8
 	if (c < 0x00000080) {
 		data[0] = static_cast<UInt8>(c);
-		dst.append(reinterpret_cast<char*>(data), 1);
+		return 1;
 	}
 	else if (c < 0x00000800) {
 		data[0] = static_cast<UInt8>(((c >>  6) & 0x0000001f) + 0xc0);
 		data[1] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 2);
+		return 2;
 	}
 	else if (c < 0x00010000) {
 		data[0] = static_cast<UInt8>(((c >> 12) & 0x0000000f) + 0xe0);
 		data[1] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
 		data[2] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 3);
+		return 3;
 	}
 	else if (c < 0x00200000) {
 		data[0] = static_cast<UInt8>(((c >> 18) & 0x00000007) + 0xf0);
 		data[1] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
 		data[2] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
 		data[3] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 4);
+		return 4;
 	}
 	else if (c < 0x04000000) {
 		data[0] = static_cast<UInt8>(((c >> 24) & 0x00000003) + 0xf8);
@@ -767,18 +1143,15 @@ CUnicode::toUTF8(CString& dst, UInt32 c, bool* errors)
 		data[2] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
 		data[3] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
 		data[4] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 5);
+		return 5;
 	}
-	else if (c < 0x80000000) {
+	else {
 		data[0] = static_cast<UInt8>(((c >> 30) & 0x00000001) + 0xfc);
 		data[1] = static_cast<UInt8>(((c >> 24) & 0x0000003f) + 0x80);
 		data[2] = static_cast<UInt8>(((c >> 18) & 0x0000003f) + 0x80);
 		data[3] = static_cast<UInt8>(((c >> 12) & 0x0000003f) + 0x80);
 		data[4] = static_cast<UInt8>(((c >>  6) & 0x0000003f) + 0x80);
 		data[5] = static_cast<UInt8>((c         & 0x0000003f) + 0x80);
-		dst.append(reinterpret_cast<char*>(data), 6);
-	}
-	else {
-		assert(0 && "character out of range");
+		return 6;
 	}
 }
@@ -134,9 +134,10 @@ private:
 	static CString		doUTF16ToUTF8(const UInt8* src, UInt32 n, bool* errors);
 	static CString		doUTF32ToUTF8(const UInt8* src, UInt32 n, bool* errors);
 
-	// convert characters to/from UTF8
+	// convert characters to/from UTF8.  toUTF8() writes up to 6 bytes
+	// to dst and returns the number written.
 	static UInt32		fromUTF8(const UInt8*& src, UInt32& size);
-	static void			toUTF8(CString& dst, UInt32 c, bool* errors);
+	static UInt32		toUTF8(UInt8* dst, UInt32 c, bool* errors);
 
 private:
 	static UInt32		s_invalid;
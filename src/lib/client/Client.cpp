@@ -45,6 +45,10 @@
 #include <sstream>
 #include <fstream>
 
+// how long to give a connection attempt before racing it against the
+// next address, as recommended by RFC 6555 ("happy eyeballs")
+static const double		kConnectRaceDelay = 0.25;
+
 //
 // CClient
 //
@@ -65,6 +69,11 @@ CClient::CClient(
 	m_screen(screen),
 	m_stream(NULL),
 	m_timer(NULL),
+	m_resolver(NULL),
+	m_resolveRequest(NULL),
+	m_nextCandidate(0),
+	m_raceTimer(NULL),
+	m_sessionSeqNum(0),
 	m_server(NULL),
 	m_ready(false),
 	m_active(false),
@@ -80,6 +89,8 @@ CClient::CClient(
 	assert(m_socketFactory != NULL);
 	assert(m_screen        != NULL);
 
+	m_resolver = new CAddressResolver(m_events);
+
 	// register suspend/resume event handlers
 	m_events->adoptHandler(m_events->forIScreen().suspend(),
 							getEventTarget(),
@@ -117,6 +128,7 @@ CClient::~CClient()
 	cleanupScreen();
 	cleanupConnecting();
 	cleanupConnection();
+	delete m_resolver;
 	delete m_socketFactory;
 	delete m_streamFilterFactory;
 }
@@ -124,7 +136,7 @@ CClient::~CClient()
 void
 CClient::connect()
 {
-	if (m_stream != NULL) {
+	if (m_stream != NULL || isConnecting()) {
 		return;
 	}
 	if (m_suspended) {
@@ -132,54 +144,20 @@ CClient::connect()
 		return;
 	}
 
-	try {
-		// resolve the server hostname.  do this every time we connect
-		// in case we couldn't resolve the address earlier or the address
-		// has changed (which can happen frequently if this is a laptop
-		// being shuttled between various networks).  patch by Brent
-		// Priddy.
-		m_serverAddress.resolve();
-		
-		// m_serverAddress will be null if the hostname address is not reolved
-		if (m_serverAddress.getAddress() != NULL) {
-		  // to help users troubleshoot, show server host name (issue: 60)
-		  LOG((CLOG_NOTE "connecting to '%s': %s:%i", 
-		  m_serverAddress.getHostname().c_str(),
-		  ARCH->addrToString(m_serverAddress.getAddress()).c_str(),
-		  m_serverAddress.getPort()));
-		}
-
-		// create the socket
-		IDataSocket* socket = m_socketFactory->create();
-
-		// filter socket messages, including a packetizing filter
-		m_stream = socket;
-		if (m_streamFilterFactory != NULL) {
-			m_stream = m_streamFilterFactory->create(m_stream, true);
-		}
-		m_stream = new CPacketStreamFilter(m_events, m_stream, true);
-
-		if (m_crypto.m_mode != kDisabled) {
-			m_cryptoStream = new CCryptoStream(
-				m_events, m_stream, m_crypto, true);
-			m_stream = m_cryptoStream;
-		}
-
-		// connect
-		LOG((CLOG_DEBUG1 "connecting to server"));
-		setupConnecting();
-		setupTimer();
-		socket->connect(m_serverAddress);
-	}
-	catch (XBase& e) {
-		cleanupTimer();
-		cleanupConnecting();
-		delete m_stream;
-		m_stream = NULL;
-		LOG((CLOG_DEBUG1 "connection failed"));
-		sendConnectionFailedEvent(e.what());
-		return;
-	}
+	// resolve the server hostname.  do this every time we connect
+	// in case we couldn't resolve the address earlier or the address
+	// has changed (which can happen frequently if this is a laptop
+	// being shuttled between various networks).  patch by Brent
+	// Priddy.  the lookup runs on the resolver's thread so a slow name
+	// server doesn't stall the event loop;  the connect timeout covers
+	// the lookup too.
+	LOG((CLOG_DEBUG1 "resolving '%s'", m_serverAddress.getHostname().c_str()));
+	setupTimer();
+	m_resolveRequest = m_resolver->resolve(m_serverAddress);
+	m_events->adoptHandler(m_events->forCAddressResolver().resolved(),
+							m_resolveRequest,
+							new TMethodEventJob<CClient>(this,
+								&CClient::handleResolved));
 }
 
 void
@@ -214,6 +192,13 @@ CClient::setDecryptIv(const UInt8* iv)
 	}
 }
 
+void
+CClient::setSession(const CString& token, UInt32 seqNum)
+{
+	m_sessionToken  = token;
+	m_sessionSeqNum = seqNum;
+}
+
 bool
 CClient::isConnected() const
 {
@@ -437,18 +422,70 @@ CClient::sendFileChunk(const void* data)
 }
 
 void
-CClient::setupConnecting()
+CClient::startConnectAttempt()
 {
-	assert(m_stream != NULL);
+	cleanupRaceTimer();
 
-	m_events->adoptHandler(m_events->forIDataSocket().connected(),
-							m_stream->getEventTarget(),
+	// race the server's addresses:  start on the next one if the last
+	// attempt hasn't connected after a short delay or has failed.  the
+	// first to connect wins.
+	while (m_nextCandidate < m_candidates.size()) {
+		const CNetworkAddress& address = m_candidates[m_nextCandidate++];
+
+		// to help users troubleshoot, show server host name (issue: 60)
+		LOG((CLOG_NOTE "connecting to '%s': %s:%i",
+			address.getHostname().c_str(),
+			ARCH->addrToString(address.getAddress()).c_str(),
+			address.getPort()));
+
+		IDataSocket* socket = m_socketFactory->create();
+		m_connectAttempts.insert(std::make_pair(socket, address));
+		m_events->adoptHandler(m_events->forIDataSocket().connected(),
+							socket->getEventTarget(),
 							new TMethodEventJob<CClient>(this,
-								&CClient::handleConnected));
-	m_events->adoptHandler(m_events->forIDataSocket().connectionFailed(),
-							m_stream->getEventTarget(),
+								&CClient::handleConnected, socket));
+		m_events->adoptHandler(m_events->forIDataSocket().connectionFailed(),
+							socket->getEventTarget(),
+							new TMethodEventJob<CClient>(this,
+								&CClient::handleConnectionFailed, socket));
+		try {
+			socket->connect(address);
+		}
+		catch (XBase& e) {
+			m_connectError = e.what();
+			removeConnectAttempt(socket);
+			delete socket;
+			continue;
+		}
+
+		if (m_nextCandidate < m_candidates.size()) {
+			m_raceTimer = m_events->newOneShotTimer(kConnectRaceDelay, NULL);
+			m_events->adoptHandler(CEvent::kTimer, m_raceTimer,
 							new TMethodEventJob<CClient>(this,
-								&CClient::handleConnectionFailed));
+								&CClient::handleRaceTimeout));
+		}
+		return;
+	}
+
+	// every address has been tried.  forget them in case the server
+	// has moved.
+	if (m_connectAttempts.empty()) {
+		m_resolver->invalidate(m_serverAddress.getHostname());
+		cleanupTimer();
+		cleanupConnecting();
+		LOG((CLOG_DEBUG1 "connection failed"));
+		sendConnectionFailedEvent(m_connectError.c_str());
+	}
+}
+
+void
+CClient::removeConnectAttempt(IDataSocket* socket)
+{
+	m_events->removeHandler(m_events->forIDataSocket().connected(),
+							socket->getEventTarget());
+	m_events->removeHandler(m_events->forIDataSocket().connectionFailed(),
+							socket->getEventTarget());
+	m_connectAttempts.erase(socket);
 }
 
 void
@@ -509,12 +546,20 @@ CClient::setupTimer()
 void
 CClient::cleanupConnecting()
 {
-	if (m_stream != NULL) {
-		m_events->removeHandler(m_events->forIDataSocket().connected(),
-							m_stream->getEventTarget());
-		m_events->removeHandler(m_events->forIDataSocket().connectionFailed(),
-							m_stream->getEventTarget());
+	if (m_resolveRequest != NULL) {
+		m_events->removeHandler(m_events->forCAddressResolver().resolved(),
+							m_resolveRequest);
+		m_resolver->cancel(m_resolveRequest);
+		m_resolveRequest = NULL;
+	}
+	cleanupRaceTimer();
+	while (!m_connectAttempts.empty()) {
+		IDataSocket* socket = m_connectAttempts.begin()->first;
+		removeConnectAttempt(socket);
+		delete socket;
 	}
+	m_candidates.clear();
+	m_nextCandidate = 0;
 }
 
 void
@@ -564,10 +609,72 @@ CClient::cleanupTimer()
 }
 
 void
-CClient::handleConnected(const CEvent&, void*)
+CClient::cleanupRaceTimer()
+{
+	if (m_raceTimer != NULL) {
+		m_events->removeHandler(CEvent::kTimer, m_raceTimer);
+		m_events->deleteTimer(m_raceTimer);
+		m_raceTimer = NULL;
+	}
+}
+
+void
+CClient::handleResolved(const CEvent&, void*)
+{
+	std::vector<CNetworkAddress> addresses;
+	CString error;
+	if (!m_resolver->takeResult(m_resolveRequest, addresses, error)) {
+		// stale event for an earlier, cancelled request
+		return;
+	}
+	m_events->removeHandler(m_events->forCAddressResolver().resolved(),
+							m_resolveRequest);
+	m_resolveRequest = NULL;
+
+	if (addresses.empty()) {
+		cleanupTimer();
+		LOG((CLOG_DEBUG1 "connection failed"));
+		sendConnectionFailedEvent(error.c_str());
+		return;
+	}
+
+	LOG((CLOG_DEBUG1 "connecting to server"));
+	m_candidates.swap(addresses);
+	m_nextCandidate = 0;
+	startConnectAttempt();
+}
+
+void
+CClient::handleRaceTimeout(const CEvent&, void*)
 {
+	startConnectAttempt();
+}
+
+void
+CClient::handleConnected(const CEvent&, void* vsocket)
+{
+	IDataSocket* socket = reinterpret_cast<IDataSocket*>(vsocket);
 	LOG((CLOG_DEBUG1 "connected;  wait for hello"));
+
+	// keep the winner and drop the other attempts
+	m_serverAddress = m_connectAttempts[socket];
+	removeConnectAttempt(socket);
 	cleanupConnecting();
+
+	// filter socket messages, including a packetizing filter
+	socket->setRecordWriteLatency(true);
+	m_stream = socket;
+	if (m_streamFilterFactory != NULL) {
+		m_stream = m_streamFilterFactory->create(m_stream, true);
+	}
+	m_stream = new CPacketStreamFilter(m_events, m_stream, true);
+
+	if (m_crypto.m_mode != kDisabled) {
+		m_cryptoStream = new CCryptoStream(
+			m_events, m_stream, m_crypto, true);
+		m_stream = m_cryptoStream;
+	}
+
 	setupConnection();
 
 	// reset clipboard state
@@ -579,18 +686,22 @@ CClient::handleConnected(const CEvent&, void*)
 }
 
 void
-CClient::handleConnectionFailed(const CEvent& event, void*)
+CClient::handleConnectionFailed(const CEvent& event, void* vsocket)
 {
+	IDataSocket* socket = reinterpret_cast<IDataSocket*>(vsocket);
 	IDataSocket::CConnectionFailedInfo* info =
 		reinterpret_cast<IDataSocket::CConnectionFailedInfo*>(event.getData());
 
-	cleanupTimer();
-	cleanupConnecting();
-	delete m_stream;
-	m_stream = NULL;
-	LOG((CLOG_DEBUG1 "connection failed"));
-	sendConnectionFailedEvent(info->m_what.c_str());
+	LOG((CLOG_DEBUG1 "connection attempt failed: %s", info->m_what.c_str()));
+	m_connectError = info->m_what;
 	delete info;
+	removeConnectAttempt(socket);
+	delete socket;
+
+	// go straight on to the next address, if any
+	if (m_nextCandidate < m_candidates.size() || m_connectAttempts.empty()) {
+		startConnectAttempt();
+	}
 }
 
 void
@@ -680,6 +791,13 @@ CClient::handleHello(const CEvent&, void*)
 							kProtocolMajorVersion,
 							kProtocolMinorVersion, &m_name);
 
+	// ask to resume the session we had before the connection dropped
+	if (!m_sessionToken.empty()) {
+		LOG((CLOG_DEBUG1 "resuming session"));
+		CProtocolUtil::writef(m_stream, kMsgDSession,
+							&m_sessionToken, m_sessionSeqNum);
+	}
+
 	// now connected but waiting to complete handshake
 	setupScreen();
 	cleanupTimer();
@@ -835,3 +953,9 @@ CClient::mouseWarp(SInt16 x, SInt16 y)
 	m_screen->getPlatformScreen()->mouseWarp(x, y);
 }
 
+void
+CClient::flushFakeInput()
+{
+	m_screen->flushFakeInput();
+}
+
@@ -24,8 +24,11 @@
 #include "synergy/DragInformation.h"
 #include "synergy/INode.h"
 #include "net/NetworkAddress.h"
+#include "net/AddressResolver.h"
 #include "io/CryptoOptions.h"
 #include "base/EventTypes.h"
+#include "common/stdmap.h"
+#include "common/stdvector.h"
 
 class CEventQueueTimer;
 class CScreen;
@@ -67,7 +70,8 @@ public:
 	~CClient();
 	
 #ifdef TEST_ENV
-	CClient() : m_mock(true) { }
+	CClient() : m_mock(true), m_screen(NULL), m_enableDragDrop(false) { }
+	void setResolver(CAddressResolver* resolver) { delete m_resolver; m_resolver = resolver; }
 #endif
 
 	//! @name manipulators
@@ -95,6 +99,14 @@ public:
 	//! Set crypto IV for decryption
 	virtual void		setDecryptIv(const UInt8* iv);
 
+	//! Set session
+	/*!
+	Remembers the token the server handed out and the sequence number
+	of the latest state it sent so the next connection can resume this
+	session instead of starting from scratch.
+	*/
+	void				setSession(const CString& token, UInt32 seqNum);
+
 	//! Clears the file buffer
 	void				clearReceivedFileData();
 
@@ -119,6 +131,9 @@ public:
 	//! Received mouse warp information from server
 	void				mouseWarp(SInt16 x, SInt16 y);
 
+	//! Send buffered fake input to the screen
+	virtual void		flushFakeInput();
+
 	//! Send screen (un)lock request to server
 	void				lockScreen(bool lock);
 
@@ -184,13 +199,16 @@ public:
 	virtual CString		getName() const;
 
 private:
+	typedef std::map<IDataSocket*, CNetworkAddress> CConnectAttempts;
+
 	void				sendClipboard(ClipboardID);
 	void				sendEvent(CEvent::Type, void*);
 	void				sendConnectionFailedEvent(const char* msg);
 	void				sendFileChunk(const void* data);
 	void				sendFileThread(void*);
 	void				writeToDropDirThread(void*);
-	void				setupConnecting();
+	void				startConnectAttempt();
+	void				removeConnectAttempt(IDataSocket*);
 	void				setupConnection();
 	void				setupScreen();
 	void				setupTimer();
@@ -198,6 +216,9 @@ private:
 	void				cleanupConnection();
 	void				cleanupScreen();
 	void				cleanupTimer();
+	void				cleanupRaceTimer();
+	void				handleResolved(const CEvent&, void*);
+	void				handleRaceTimeout(const CEvent&, void*);
 	void				handleConnected(const CEvent&, void*);
 	void				handleConnectionFailed(const CEvent&, void*);
 	void				handleConnectTimeout(const CEvent&, void*);
@@ -223,6 +244,15 @@ private:
 	CScreen*				m_screen;
 	synergy::IStream*		m_stream;
 	CEventQueueTimer*		m_timer;
+	CAddressResolver*		m_resolver;
+	CAddressResolver::CRequest*	m_resolveRequest;
+	std::vector<CNetworkAddress>	m_candidates;
+	size_t					m_nextCandidate;
+	CConnectAttempts		m_connectAttempts;
+	CEventQueueTimer*		m_raceTimer;
+	CString					m_connectError;
+	CString					m_sessionToken;
+	UInt32					m_sessionSeqNum;
 	CServerProxy*			m_server;
 	bool					m_ready;
 	bool					m_active;
@@ -20,12 +20,14 @@
 
 #include "client/Client.h"
 #include "synergy/Clipboard.h"
+#include "synergy/PacketStreamFilter.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/option_types.h"
 #include "synergy/protocol_types.h"
 #include "io/IStream.h"
 #include "io/CryptoStream.h"
 #include "base/Log.h"
+#include "base/LatencyStats.h"
 #include "base/IEventQueue.h"
 #include "base/TMethodEventJob.h"
 #include "base/XBase.h"
@@ -41,6 +43,8 @@ const UInt16 CServerProxy::m_intervalThreshold = 1;
 CServerProxy::CServerProxy(CClient* client, synergy::IStream* stream, IEventQueue* events) :
 	m_client(client),
 	m_stream(stream),
+	m_packetStream(dynamic_cast<CPacketStreamFilter*>(stream)),
+	m_inPlace(false),
 	m_seqNum(0),
 	m_compressMouse(false),
 	m_compressMouseRelative(false),
@@ -48,6 +52,8 @@ CServerProxy::CServerProxy(CClient* client, synergy::IStream* stream, IEventQueu
 	m_yMouse(0),
 	m_dxMouse(0),
 	m_dyMouse(0),
+	m_xCompact(0),
+	m_yCompact(0),
 	m_ignoreMouse(false),
 	m_keepAliveAlarm(0.0),
 	m_keepAliveAlarmTimer(NULL),
@@ -102,7 +108,7 @@ void
 CServerProxy::mouseWarp()
 {
 	SInt16 x, y;
-	CProtocolUtil::readf(m_stream, kMsgDMouseWarp + 4, &x, &y);
+	readf(kMsgDMouseWarp + 4, &x, &y);
 	LOG((CLOG_DEBUG1 "CServerProxy::mouseWarp(): received mouse warp %d, %d", x, y));
 	m_client->mouseWarp(x, y);
 }
@@ -116,16 +122,69 @@ CServerProxy::setKeepAliveRate(double rate)
 
 void
 CServerProxy::handleData(const CEvent&, void*)
+{
+	bool compact = false;
+	if (m_packetStream != NULL) {
+		// parse each packet where it lies in the stream's buffer
+		// instead of reading it out field by field
+		UInt32 size;
+		const UInt8* data;
+		while ((data = m_packetStream->peekPacket(size)) != NULL) {
+			CLatencyTimer timer(CLatencyStats::kDecode);
+			m_packet  = CPacketReader(data, size);
+			m_inPlace = true;
+			bool okay = parseMessages(compact);
+			m_inPlace = false;
+			if (!okay) {
+				return;
+			}
+			m_packetStream->popPacket();
+		}
+	}
+	else {
+		CLatencyTimer timer(CLatencyStats::kDecode);
+		if (!parseMessages(compact)) {
+			return;
+		}
+	}
+
+	// one reply for all the records, see parseMessage()
+	if (compact) {
+		CProtocolUtil::writef(m_stream, kMsgCNoop);
+	}
+
+	// hand everything the messages above faked to the screen in one go
+	CLatencyTimer timer(CLatencyStats::kInject);
+	flushCompressedMouse();
+	m_client->flushFakeInput();
+}
+
+bool
+CServerProxy::parseMessages(bool& compact)
 {
 	// handle messages until there are no more.  first read message code.
+	// compact input records have a one byte code.
 	UInt8 code[4];
-	UInt32 n = m_stream->read(code, 4);
+	UInt32 n = read(code, 1);
 	while (n != 0) {
+		if (code[0] < kCompactCodeLimit) {
+			LOG((CLOG_DEBUG2 "compact msg from server: %d", code[0]));
+			if (!parseCompactMessage(code[0])) {
+				LOG((CLOG_ERR "invalid message from server: %d", code[0]));
+				m_client->disconnect("invalid message from server");
+				return false;
+			}
+			compact = true;
+			n = read(code, 1);
+			continue;
+		}
+
 		// verify we got an entire code
+		n += read(code + 1, 3);
 		if (n != 4) {
 			LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
 			m_client->disconnect("incomplete message from server");
-			return;
+			return false;
 		}
 
 		// parse message
@@ -137,17 +196,42 @@ CServerProxy::handleData(const CEvent&, void*)
 		case kUnknown:
 			LOG((CLOG_ERR "invalid message from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
 			m_client->disconnect("invalid message from server");
-			return;
+			return false;
 
 		case kDisconnect:
-			return;
+			return false;
 		}
 
 		// next message
-		n = m_stream->read(code, 4);
+		n = read(code, 1);
 	}
+	return true;
+}
 
-	flushCompressedMouse();
+UInt32
+CServerProxy::read(void* buffer, UInt32 n)
+{
+	return m_inPlace ? m_packet.read(buffer, n) : m_stream->read(buffer, n);
+}
+
+bool
+CServerProxy::readf(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = m_inPlace ? m_packet.vreadf(fmt, args) :
+						CProtocolUtil::vreadf(m_stream, fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool
+CServerProxy::isMoreInput() const
+{
+	if (m_inPlace) {
+		return (m_packet.getSize() != 0 || m_packetStream->isMoreBuffered());
+	}
+	return m_stream->isReady();
 }
 
 CServerProxy::EResult
@@ -161,6 +245,10 @@ CServerProxy::parseHandshakeMessage(const UInt8* code)
 		infoAcknowledgment();
 	}
 
+	else if (memcmp(code, kMsgDSession, 4) == 0) {
+		session();
+	}
+
 	else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
 		setOptions();
 
@@ -192,7 +280,7 @@ CServerProxy::parseHandshakeMessage(const UInt8* code)
 
 	else if (memcmp(code, kMsgEIncompatible, 4) == 0) {
 		SInt32 major, minor;
-		CProtocolUtil::readf(m_stream,
+		readf(
 						kMsgEIncompatible + 4, &major, &minor);
 		LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
 		m_client->disconnect("server has incompatible version");
@@ -312,6 +400,10 @@ CServerProxy::parseMessage(const UInt8* code)
 		cryptoIv();
 	}
 
+	else if (memcmp(code, kMsgDSession, 4) == 0) {
+		session();
+	}
+
 	else if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
 		fileChunkReceived();
 	}
@@ -346,6 +438,91 @@ CServerProxy::parseMessage(const UInt8* code)
 	return kOkay;
 }
 
+bool
+CServerProxy::parseCompactMessage(UInt8 code)
+{
+	// the code byte has been read already, so skip it in the formats
+	UInt32 id, mask, count, button;
+	SInt32 x, y;
+	SInt8 buttonID;
+	switch (code) {
+	case 1:
+		if (!readf(kMsgIMouseMove + 1, &x, &y)) {
+			return false;
+		}
+		m_xCompact = x;
+		m_yCompact = y;
+		mouseMove(x, y);
+		break;
+
+	case 2:
+		if (!readf(kMsgIMouseDelta + 1, &x, &y)) {
+			return false;
+		}
+		m_xCompact += x;
+		m_yCompact += y;
+		mouseMove(m_xCompact, m_yCompact);
+		break;
+
+	case 3:
+		if (!readf(kMsgIMouseRelMove + 1, &x, &y)) {
+			return false;
+		}
+		mouseRelativeMove(x, y);
+		break;
+
+	case 4:
+		if (!readf(kMsgIMouseWheel + 1, &x, &y)) {
+			return false;
+		}
+		mouseWheel(x, y);
+		break;
+
+	case 5:
+		if (!readf(kMsgIKeyDown + 1,
+								&id, &mask, &button)) {
+			return false;
+		}
+		keyDown(id, mask, static_cast<KeyButton>(button));
+		break;
+
+	case 6:
+		if (!readf(kMsgIKeyRepeat + 1,
+								&id, &mask, &count, &button)) {
+			return false;
+		}
+		keyRepeat(id, mask, static_cast<SInt32>(count),
+								static_cast<KeyButton>(button));
+		break;
+
+	case 7:
+		if (!readf(kMsgIKeyUp + 1,
+								&id, &mask, &button)) {
+			return false;
+		}
+		keyUp(id, mask, static_cast<KeyButton>(button));
+		break;
+
+	case 8:
+		if (!readf(kMsgIMouseDown + 1, &buttonID)) {
+			return false;
+		}
+		mouseDown(static_cast<ButtonID>(buttonID));
+		break;
+
+	case 9:
+		if (!readf(kMsgIMouseUp + 1, &buttonID)) {
+			return false;
+		}
+		mouseUp(static_cast<ButtonID>(buttonID));
+		break;
+
+	default:
+		return false;
+	}
+	return true;
+}
+
 void
 CServerProxy::handleKeepAliveAlarm(const CEvent&, void*)
 {
@@ -532,7 +709,7 @@ CServerProxy::enter()
 	SInt16 x, y;
 	UInt16 mask;
 	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+	readf(kMsgCEnter + 4, &x, &y, &seqNum, &mask);
 	LOG((CLOG_DEBUG1 "recv enter, %d,%d %d %04x", x, y, seqNum, mask));
 
 	// discard old compressed mouse motion, if any
@@ -562,11 +739,19 @@ CServerProxy::leave()
 void
 CServerProxy::setClipboard()
 {
-	// parse
+	// parse.  the data can be big so leave it in the packet if we can.
 	ClipboardID id;
 	UInt32 seqNum;
-	CString data;
-	CProtocolUtil::readf(m_stream, kMsgDClipboard + 4, &id, &seqNum, &data);
+	CStringRef data;
+	CString copy;
+	if (m_inPlace) {
+		// kMsgDClipboard with the data in place
+		m_packet.readf("%1i%4i%r", &id, &seqNum, &data);
+	}
+	else {
+		readf(kMsgDClipboard + 4, &id, &seqNum, &copy);
+		data = CStringRef(copy);
+	}
 	LOG((CLOG_DEBUG "recv clipboard %d size=%d", id, data.size()));
 
 	// validate
@@ -576,7 +761,7 @@ CServerProxy::setClipboard()
 
 	// forward
 	CClipboard clipboard;
-	clipboard.unmarshall(data, 0);
+	clipboard.unmarshall(data.data(), data.size(), 0);
 	m_client->setClipboard(id, &clipboard);
 }
 
@@ -586,7 +771,7 @@ CServerProxy::grabClipboard()
 	// parse
 	ClipboardID id;
 	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+	readf(kMsgCClipboard + 4, &id, &seqNum);
 	LOG((CLOG_DEBUG "recv grab clipboard %d", id));
 
 	// validate
@@ -600,21 +785,25 @@ CServerProxy::grabClipboard()
 
 void
 CServerProxy::keyDown()
+{
+	// parse
+	UInt16 id, mask, button;
+	readf(kMsgDKeyDown + 4, &id, &mask, &button);
+	keyDown(id, mask, button);
+}
+
+void
+CServerProxy::keyDown(KeyID id, KeyModifierMask mask, KeyButton button)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
-	// parse
-	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
 	LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
-	KeyID id2             = translateKey(static_cast<KeyID>(id));
-	KeyModifierMask mask2 = translateModifierMask(
-								static_cast<KeyModifierMask>(mask));
-	if (id2   != static_cast<KeyID>(id) ||
-		mask2 != static_cast<KeyModifierMask>(mask))
+	KeyID id2             = translateKey(id);
+	KeyModifierMask mask2 = translateModifierMask(mask);
+	if (id2 != id || mask2 != mask)
 		LOG((CLOG_DEBUG1 "key down translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
 	// forward
@@ -624,21 +813,26 @@ CServerProxy::keyDown()
 void
 CServerProxy::keyRepeat()
 {
-	// get mouse up to date
-	flushCompressedMouse();
-
 	// parse
 	UInt16 id, mask, count, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
+	readf(kMsgDKeyRepeat + 4,
 								&id, &mask, &count, &button);
+	keyRepeat(id, mask, count, button);
+}
+
+void
+CServerProxy::keyRepeat(KeyID id, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	// get mouse up to date
+	flushCompressedMouse();
+
 	LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
 	// translate
-	KeyID id2             = translateKey(static_cast<KeyID>(id));
-	KeyModifierMask mask2 = translateModifierMask(
-								static_cast<KeyModifierMask>(mask));
-	if (id2   != static_cast<KeyID>(id) ||
-		mask2 != static_cast<KeyModifierMask>(mask))
+	KeyID id2             = translateKey(id);
+	KeyModifierMask mask2 = translateModifierMask(mask);
+	if (id2 != id || mask2 != mask)
 		LOG((CLOG_DEBUG1 "key repeat translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
 	// forward
@@ -647,21 +841,25 @@ CServerProxy::keyRepeat()
 
 void
 CServerProxy::keyUp()
+{
+	// parse
+	UInt16 id, mask, button;
+	readf(kMsgDKeyUp + 4, &id, &mask, &button);
+	keyUp(id, mask, button);
+}
+
+void
+CServerProxy::keyUp(KeyID id, KeyModifierMask mask, KeyButton button)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
-	// parse
-	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
 	LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
-	KeyID id2             = translateKey(static_cast<KeyID>(id));
-	KeyModifierMask mask2 = translateModifierMask(
-								static_cast<KeyModifierMask>(mask));
-	if (id2   != static_cast<KeyID>(id) ||
-		mask2 != static_cast<KeyModifierMask>(mask))
+	KeyID id2             = translateKey(id);
+	KeyModifierMask mask2 = translateModifierMask(mask);
+	if (id2 != id || mask2 != mask)
 		LOG((CLOG_DEBUG1 "key up translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
 	// forward
@@ -670,47 +868,63 @@ CServerProxy::keyUp()
 
 void
 CServerProxy::mouseDown()
+{
+	// parse
+	SInt8 id;
+	readf(kMsgDMouseDown + 4, &id);
+	mouseDown(static_cast<ButtonID>(id));
+}
+
+void
+CServerProxy::mouseDown(ButtonID id)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
-	// parse
-	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
 	LOG((CLOG_DEBUG1 "recv mouse down id=%d", id));
 
 	// forward
-	m_client->mouseDown(static_cast<ButtonID>(id));
+	m_client->mouseDown(id);
 }
 
 void
 CServerProxy::mouseUp()
+{
+	// parse
+	SInt8 id;
+	readf(kMsgDMouseUp + 4, &id);
+	mouseUp(static_cast<ButtonID>(id));
+}
+
+void
+CServerProxy::mouseUp(ButtonID id)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
-	// parse
-	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseUp + 4, &id);
 	LOG((CLOG_DEBUG1 "recv mouse up id=%d", id));
 
 	// forward
-	m_client->mouseUp(static_cast<ButtonID>(id));
+	m_client->mouseUp(id);
 }
 
 void
 CServerProxy::mouseMove()
 {
 	// parse
-	bool ignore;
 	SInt16 x, y;
-	CProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+	readf(kMsgDMouseMove + 4, &x, &y);
+	mouseMove(x, y);
+}
 
+void
+CServerProxy::mouseMove(SInt32 x, SInt32 y)
+{
 	// note if we should ignore the move
-	ignore = m_ignoreMouse;
+	bool ignore = m_ignoreMouse;
 
 	// compress mouse motion events if more input follows
-	if (!ignore && !m_compressMouse && m_stream->isReady()) {
+	if (!ignore && !m_compressMouse && isMoreInput()) {
 		m_compressMouse = true;
 	}
 
@@ -735,15 +949,19 @@ void
 CServerProxy::mouseRelativeMove()
 {
 	// parse
-	bool ignore;
 	SInt16 dx, dy;
-	CProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+	readf(kMsgDMouseRelMove + 4, &dx, &dy);
+	mouseRelativeMove(dx, dy);
+}
 
+void
+CServerProxy::mouseRelativeMove(SInt32 dx, SInt32 dy)
+{
 	// note if we should ignore the move
-	ignore = m_ignoreMouse;
+	bool ignore = m_ignoreMouse;
 
 	// compress mouse motion events if more input follows
-	if (!ignore && !m_compressMouseRelative && m_stream->isReady()) {
+	if (!ignore && !m_compressMouseRelative && isMoreInput()) {
 		m_compressMouseRelative = true;
 	}
 
@@ -763,13 +981,19 @@ CServerProxy::mouseRelativeMove()
 
 void
 CServerProxy::mouseWheel()
+{
+	// parse
+	SInt16 xDelta, yDelta;
+	readf(kMsgDMouseWheel + 4, &xDelta, &yDelta);
+	mouseWheel(xDelta, yDelta);
+}
+
+void
+CServerProxy::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
-	// parse
-	SInt16 xDelta, yDelta;
-	CProtocolUtil::readf(m_stream, kMsgDMouseWheel + 4, &xDelta, &yDelta);
 	LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
 
 	// forward
@@ -781,19 +1005,32 @@ CServerProxy::cryptoIv()
 {
 	// parse
 	CString s;
-	CProtocolUtil::readf(m_stream, kMsgDCryptoIv + 4, &s);
+	readf(kMsgDCryptoIv + 4, &s);
 	LOG((CLOG_DEBUG2 "recv crypto iv size=%i", s.size()));
 
 	// forward
 	m_client->setDecryptIv(reinterpret_cast<const UInt8*>(s.c_str()));
 }
 
+void
+CServerProxy::session()
+{
+	// parse
+	CString token;
+	UInt32 seqNum;
+	readf(kMsgDSession + 4, &token, &seqNum);
+	LOG((CLOG_DEBUG1 "recv session seqnum=%d", seqNum));
+
+	// forward
+	m_client->setSession(token, seqNum);
+}
+
 void
 CServerProxy::screensaver()
 {
 	// parse
 	SInt8 on;
-	CProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+	readf(kMsgCScreenSaver + 4, &on);
 	LOG((CLOG_DEBUG1 "recv screen saver on=%d", on));
 
 	// forward
@@ -823,7 +1060,7 @@ CServerProxy::setOptions()
 {
 	// parse
 	COptionsList options;
-	CProtocolUtil::readf(m_stream, kMsgDSetOptions + 4, &options);
+	readf(kMsgDSetOptions + 4, &options);
 	LOG((CLOG_DEBUG1 "recv set options size=%d", options.size()));
 
 	// forward
@@ -884,7 +1121,7 @@ CServerProxy::fileChunkReceived()
 	// parse
 	UInt8 mark = 0;
 	CString content;
-	CProtocolUtil::readf(m_stream, kMsgDFileTransfer + 4, &mark, &content);
+	readf(kMsgDFileTransfer + 4, &mark, &content);
 
 	switch (mark) {
 	case kFileStart:
@@ -934,7 +1171,7 @@ CServerProxy::dragInfoReceived()
 	// parse
 	UInt32 fileNum = 0;
 	CString content;
-	CProtocolUtil::readf(m_stream, kMsgDDragInfo + 4, &fileNum, &content);
+	readf(kMsgDDragInfo + 4, &fileNum, &content);
 
 	m_client->dragInfoReceived(fileNum, content);
 }
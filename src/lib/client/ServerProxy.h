@@ -20,6 +20,8 @@
 
 #include "synergy/clipboard_types.h"
 #include "synergy/key_types.h"
+#include "synergy/mouse_types.h"
+#include "synergy/PacketReader.h"
 #include "base/Event.h"
 #include "base/Stopwatch.h"
 #include "base/String.h"
@@ -27,6 +29,7 @@
 class CClient;
 class CClientInfo;
 class CEventQueueTimer;
+class CPacketStreamFilter;
 class IClipboard;
 namespace synergy { class IStream; }
 class IEventQueue;
@@ -74,6 +77,7 @@ protected:
 	enum EResult { kOkay, kUnknown, kDisconnect };
 	EResult				parseHandshakeMessage(const UInt8* code);
 	EResult				parseMessage(const UInt8* code);
+	bool				parseCompactMessage(UInt8 code);
 
 private:
 	// if compressing mouse motion then send the last motion now
@@ -88,6 +92,18 @@ private:
 	KeyID				translateKey(KeyID) const;
 	KeyModifierMask			translateModifierMask(KeyModifierMask) const;
 
+	// parse all the messages in the current packet, or in the stream
+	// if we can't get at the packets.  returns false if we're done
+	// with the connection.
+	bool				parseMessages(bool& compact);
+
+	// read from the current packet or the stream
+	UInt32				read(void* buffer, UInt32 n);
+	bool				readf(const char* fmt, ...);
+
+	// check if more messages are waiting
+	bool				isMoreInput() const;
+
 	// event handlers
 	void				handleData(const CEvent&, void*);
 	void				handleKeepAliveAlarm(const CEvent&, void*);
@@ -105,8 +121,20 @@ private:
 	void				mouseMove();
 	void				mouseRelativeMove();
 	void				mouseWheel();
+
+	// input handlers shared by the regular and compact messages
+	void				keyDown(KeyID, KeyModifierMask, KeyButton);
+	void				keyRepeat(KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+	void				keyUp(KeyID, KeyModifierMask, KeyButton);
+	void				mouseDown(ButtonID);
+	void				mouseUp(ButtonID);
+	void				mouseMove(SInt32 x, SInt32 y);
+	void				mouseRelativeMove(SInt32 dx, SInt32 dy);
+	void				mouseWheel(SInt32 xDelta, SInt32 yDelta);
 	void				mouseWarp();
 	void				cryptoIv();
+	void				session();
 	void				screensaver();
 	void				resetOptions();
 	void				setOptions();
@@ -121,6 +149,12 @@ private:
 	CClient*			m_client;
 	synergy::IStream*	m_stream;
 
+	// the packet filter, if it's the stream itself, and the packet
+	// being parsed in place
+	CPacketStreamFilter*	m_packetStream;
+	CPacketReader		m_packet;
+	bool				m_inPlace;
+
 	UInt32				m_seqNum;
 
 	bool				m_compressMouse;
@@ -128,6 +162,9 @@ private:
 	SInt32				m_xMouse, m_yMouse;
 	SInt32				m_dxMouse, m_dyMouse;
 
+	// where the compact mouse deltas start from
+	SInt32				m_xCompact, m_yCompact;
+
 	bool				m_ignoreMouse;
 
 	KeyModifierID		m_modifierTranslationTable[kKeyModifierIDLast];
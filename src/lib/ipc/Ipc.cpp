@@ -22,3 +22,9 @@ const char*				kIpcMsgHello		= "IHEL%1i";
 const char*				kIpcMsgLogLine		= "ILOG%s";
 const char*				kIpcMsgCommand		= "ICMD%s%1i";
 const char*				kIpcMsgShutdown		= "ISDN";
+const char*				kIpcMsgLogRingRequest	= "IRRQ";
+const char*				kIpcMsgLogRing		= "IRNG%s";
+const char*				kIpcMsgLogRingAck	= "IRAK";
+const char*				kIpcMsgLogRingReady	= "IRDY";
+const char*				kIpcMsgStatsRequest	= "ISRQ";
+const char*				kIpcMsgStats		= "ISTA%s";
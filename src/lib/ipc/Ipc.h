@@ -21,21 +21,28 @@
 #define IPC_HOST "127.0.0.1"
 #define IPC_PORT 24801
 
+// the daemon's local socket, in the home directory of the user it runs as
+#define IPC_LOCAL_NAME ".synergy-ipc"
+
 enum EIpcMessage {
 	kIpcHello,
 	kIpcLogLine,
 	kIpcCommand,
 	kIpcShutdown,
+	kIpcStatsRequest,
+	kIpcStats,
 };
 
 enum EIpcClientType {
 	kIpcClientUnknown,
 	kIpcClientGui,
 	kIpcClientNode,
+	kIpcClientTool,
 };
 
 // handshake: node/gui -> daemon
-// $1 = type, the client identifies it's self as gui or node (synergyc/s).
+// $1 = type, the client identifies it's self as gui, node (synergyc/s)
+// or tool (syntool).
 extern const char*		kIpcMsgHello;
 
 // log line: daemon -> gui
@@ -50,3 +57,29 @@ extern const char*		kIpcMsgCommand;
 // shutdown: daemon -> node
 // the daemon tells synergys/c to shut down gracefully.
 extern const char*		kIpcMsgShutdown;
+
+// log ring request: gui -> daemon
+// asks for log lines through shared memory instead of the socket.  only
+// honoured on a local socket;  the daemon may silently ignore it.
+extern const char*		kIpcMsgLogRingRequest;
+
+// log ring: daemon -> gui
+// $1 = name of the shared memory ring offered for log lines.
+extern const char*		kIpcMsgLogRing;
+
+// log ring ack: gui -> daemon
+// the gui has mapped the ring;  log lines go there from now on.
+extern const char*		kIpcMsgLogRingAck;
+
+// log ring ready: daemon -> gui
+// the ring has new log lines and the gui said it was idle.
+extern const char*		kIpcMsgLogRingReady;
+
+// stats request: tool -> daemon -> node
+// asks synergys/c for its latency stats.  the daemon passes it on.
+extern const char*		kIpcMsgStatsRequest;
+
+// stats: node -> daemon -> tool
+// $1 = the latency stats of synergys/c as a table.  the daemon passes
+// it on.
+extern const char*		kIpcMsgStats;
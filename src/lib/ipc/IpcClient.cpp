@@ -29,6 +29,8 @@
 CIpcClient::CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer) :
 	m_serverAddress(CNetworkAddress(IPC_HOST, IPC_PORT)),
 	m_socket(events, socketMultiplexer),
+	m_logRing(false),
+	m_clientType(kIpcClientNode),
 	m_server(nullptr),
 	m_events(events)
 {
@@ -38,6 +40,20 @@ CIpcClient::CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexe
 CIpcClient::CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer, int port) :
 	m_serverAddress(CNetworkAddress(IPC_HOST, port)),
 	m_socket(events, socketMultiplexer),
+	m_logRing(false),
+	m_clientType(kIpcClientNode),
+	m_server(nullptr),
+	m_events(events)
+{
+	init();
+}
+
+CIpcClient::CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+				const CString& path, bool logRing) :
+	m_serverAddress(CNetworkAddress::localPath(path)),
+	m_socket(events, socketMultiplexer, IArchNetwork::kUNIX),
+	m_logRing(logRing),
+	m_clientType(kIpcClientNode),
 	m_server(nullptr),
 	m_events(events)
 {
@@ -54,6 +70,12 @@ CIpcClient::~CIpcClient()
 {
 }
 
+void
+CIpcClient::setClientType(EIpcClientType type)
+{
+	m_clientType = type;
+}
+
 void
 CIpcClient::connect()
 {
@@ -62,7 +84,15 @@ CIpcClient::connect()
 		new TMethodEventJob<CIpcClient>(
 		this, &CIpcClient::handleConnected));
 
-	m_socket.connect(m_serverAddress);
+	try {
+		m_socket.connect(m_serverAddress);
+	}
+	catch (...) {
+		// a local socket fails at once when there's nobody there
+		m_events->removeHandler(m_events->forIDataSocket().connected(),
+							m_socket.getEventTarget());
+		throw;
+	}
 	m_server = new CIpcServerProxy(m_socket, m_events);
 
 	m_events->adoptHandler(
@@ -89,14 +119,24 @@ CIpcClient::send(const CIpcMessage& message)
 	m_server->send(message);
 }
 
+bool
+CIpcClient::isLogRingOpen() const
+{
+	return (m_server != nullptr && m_server->m_logRing != nullptr);
+}
+
 void
 CIpcClient::handleConnected(const CEvent&, void*)
 {
 	m_events->addEvent(CEvent(
 		m_events->forCIpcClient().connected(), this, m_server, CEvent::kDontFreeData));
 
-	CIpcHelloMessage message(kIpcClientNode);
+	CIpcHelloMessage message(m_clientType);
 	send(message);
+
+	if (m_logRing) {
+		m_server->requestLogRing();
+	}
 }
 
 void
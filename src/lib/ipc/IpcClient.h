@@ -20,6 +20,7 @@
 
 #include "net/NetworkAddress.h"
 #include "net/TCPSocket.h"
+#include "ipc/Ipc.h"
 #include "base/EventTypes.h"
 
 class CIpcServerProxy;
@@ -35,12 +36,31 @@ class CIpcClient {
 public:
 	CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer);
 	CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer, int port);
+
+	//! Use a local socket
+	/*!
+	Connects to the server's local socket at \p path instead of TCP.
+	Unless \p logRing is false, log lines are then received through
+	shared memory if the server can offer it.
+	*/
+	CIpcClient(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+							const CString& path, bool logRing = true);
 	virtual ~CIpcClient();
 
 	//! @name manipulators
 	//@{
 
+	//! Set the client type
+	/*!
+	Sets what the client says it is when it connects.  The default is
+	kIpcClientNode.
+	*/
+	void				setClientType(EIpcClientType type);
+
 	//! Connects to the IPC server at localhost.
+	/*!
+	Throws XSocketConnect if a local socket has no server listening.
+	*/
 	void				connect();
 	
 	//! Disconnects from the IPC server.
@@ -50,6 +70,17 @@ public:
 	void				send(const CIpcMessage& message);
 
 	//@}
+	//! @name accessors
+	//@{
+
+	//! Check for the log ring
+	/*!
+	Returns true if log lines come through shared memory rather than the
+	socket.
+	*/
+	bool				isLogRingOpen() const;
+
+	//@}
 
 private:
 	void				init();
@@ -59,6 +90,8 @@ private:
 private:
 	CNetworkAddress		m_serverAddress;
 	CTCPSocket			m_socket;
+	bool				m_logRing;
+	EIpcClientType		m_clientType;
 	CIpcServerProxy*	m_server;
 	IEventQueue*		m_events;
 };
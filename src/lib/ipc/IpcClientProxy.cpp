@@ -20,11 +20,20 @@
 
 #include "ipc/Ipc.h"
 #include "ipc/IpcMessage.h"
+#include "ipc/IpcLogRing.h"
 #include "synergy/ProtocolUtil.h"
 #include "io/IStream.h"
 #include "arch/Arch.h"
 #include "base/TMethodEventJob.h"
 #include "base/Log.h"
+#include "base/Stopwatch.h"
+
+// size of the shared memory ring for log lines
+static const UInt32		kLogRingSize = 1024 * 1024;
+
+// how long to wait for the gui to make room in the ring before giving
+// up on it and going back to the socket
+static const double		kLogRingWait = 1.0;
 
 //
 // CIpcClientProxy
@@ -34,6 +43,9 @@ CIpcClientProxy::CIpcClientProxy(synergy::IStream& stream, IEventQueue* events)
 	m_stream(stream),
 	m_clientType(kIpcClientUnknown),
 	m_disconnecting(false),
+	m_local(false),
+	m_offeredLogRing(nullptr),
+	m_logRing(nullptr),
 	m_readMutex(ARCH->newMutex()),
 	m_writeMutex(ARCH->newMutex()),
 	m_events(events)
@@ -77,6 +89,9 @@ CIpcClientProxy::~CIpcClientProxy()
 	ARCH->unlockMutex(m_readMutex);
 	ARCH->unlockMutex(m_writeMutex);
 
+	delete m_offeredLogRing;
+	delete m_logRing;
+
 	ARCH->closeMutex(m_readMutex);
 	ARCH->closeMutex(m_writeMutex);
 }
@@ -117,15 +132,29 @@ CIpcClientProxy::handleData(const CEvent&, void*)
 		else if (memcmp(code, kIpcMsgCommand, 4) == 0) {
 			m = parseCommand();
 		}
+		else if (memcmp(code, kIpcMsgLogRingRequest, 4) == 0) {
+			offerLogRing();
+		}
+		else if (memcmp(code, kIpcMsgLogRingAck, 4) == 0) {
+			useLogRing();
+		}
+		else if (memcmp(code, kIpcMsgStatsRequest, 4) == 0) {
+			m = new CIpcStatsRequestMessage();
+		}
+		else if (memcmp(code, kIpcMsgStats, 4) == 0) {
+			m = parseStats();
+		}
 		else {
 			LOG((CLOG_ERR "invalid ipc message"));
 			disconnect();
 		}
 
-		// don't delete with this event; the data is passed to a new event.
-		CEvent e(m_events->forCIpcClientProxy().messageReceived(), this, NULL, CEvent::kDontFreeData);
-		e.setDataObject(m);
-		m_events->addEvent(e);
+		if (m != nullptr) {
+			// don't delete with this event; the data is passed to a new event.
+			CEvent e(m_events->forCIpcClientProxy().messageReceived(), this, NULL, CEvent::kDontFreeData);
+			e.setDataObject(m);
+			m_events->addEvent(e);
+		}
 
 		n = m_stream.read(code, 4);
 	}
@@ -146,8 +175,7 @@ CIpcClientProxy::send(const CIpcMessage& message)
 	switch (message.type()) {
 	case kIpcLogLine: {
 		const CIpcLogLineMessage& llm = static_cast<const CIpcLogLineMessage&>(message);
-		CString logLine = llm.logLine();
-		CProtocolUtil::writef(&m_stream, kIpcMsgLogLine, &logLine);
+		sendLogLine(llm.logLine());
 		break;
 	}
 			
@@ -155,6 +183,17 @@ CIpcClientProxy::send(const CIpcMessage& message)
 		CProtocolUtil::writef(&m_stream, kIpcMsgShutdown);
 		break;
 
+	case kIpcStatsRequest:
+		CProtocolUtil::writef(&m_stream, kIpcMsgStatsRequest);
+		break;
+
+	case kIpcStats: {
+		const CIpcStatsMessage& sm = static_cast<const CIpcStatsMessage&>(message);
+		CString stats = sm.stats();
+		CProtocolUtil::writef(&m_stream, kIpcMsgStats, &stats);
+		break;
+	}
+
 	default:
 		LOG((CLOG_ERR "ipc message not supported: %d", message.type()));
 		break;
@@ -184,6 +223,82 @@ CIpcClientProxy::parseCommand()
 	return new CIpcCommandMessage(command, elevate != 0);
 }
 
+CIpcStatsMessage*
+CIpcClientProxy::parseStats()
+{
+	CString stats;
+	CProtocolUtil::readf(&m_stream, kIpcMsgStats + 4, &stats);
+
+	// must be deleted by event handler.
+	return new CIpcStatsMessage(stats);
+}
+
+void
+CIpcClientProxy::offerLogRing()
+{
+	CArchMutexLock lock(m_writeMutex);
+
+	// only a local socket tells us who's on the other end.  otherwise
+	// just carry on using the socket, the client has to cope with that.
+	if (!m_local || m_offeredLogRing != nullptr || m_logRing != nullptr) {
+		return;
+	}
+
+	m_offeredLogRing = new CIpcLogRing;
+	if (!m_offeredLogRing->create(kLogRingSize)) {
+		delete m_offeredLogRing;
+		m_offeredLogRing = nullptr;
+		return;
+	}
+	CString name = m_offeredLogRing->getName();
+	CProtocolUtil::writef(&m_stream, kIpcMsgLogRing, &name);
+}
+
+void
+CIpcClientProxy::useLogRing()
+{
+	CArchMutexLock lock(m_writeMutex);
+
+	if (m_offeredLogRing == nullptr) {
+		return;
+	}
+
+	// the client has it mapped so nobody else needs to find it
+	m_offeredLogRing->unlink();
+	m_logRing        = m_offeredLogRing;
+	m_offeredLogRing = nullptr;
+	LOG((CLOG_DEBUG "sending ipc log lines through shared memory"));
+}
+
+void
+CIpcClientProxy::sendLogLine(const CString& logLine)
+{
+	if (m_logRing != nullptr) {
+		// the client is most likely busy with the lines we just gave it
+		// so wait a moment for it to make room.  if it doesn't then fall
+		// back to the socket;  the client reads what's left in the ring
+		// before any log line that arrives on the socket.
+		CStopwatch timer;
+		while (!m_logRing->write(logLine)) {
+			if (timer.getTime() >= kLogRingWait) {
+				delete m_logRing;
+				m_logRing = nullptr;
+				break;
+			}
+			ARCH->sleep(0.001);
+		}
+		if (m_logRing != nullptr) {
+			// only poke the client if it's stopped looking
+			if (m_logRing->takeWakeup()) {
+				CProtocolUtil::writef(&m_stream, kIpcMsgLogRingReady);
+			}
+			return;
+		}
+	}
+
+	CProtocolUtil::writef(&m_stream, kIpcMsgLogLine, &logLine);
+}
+
 void
 CIpcClientProxy::disconnect()
 {
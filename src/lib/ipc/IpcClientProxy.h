@@ -22,11 +22,14 @@
 #include "arch/IArchMultithread.h"
 #include "base/EventTypes.h"
 #include "base/Event.h"
+#include "base/String.h"
 
 namespace synergy { class IStream; }
 class CIpcMessage;
 class CIpcCommandMessage;
 class CIpcHelloMessage;
+class CIpcStatsMessage;
+class CIpcLogRing;
 class IEventQueue;
 
 class CIpcClientProxy {
@@ -43,12 +46,19 @@ private:
 	void				handleWriteError(const CEvent&, void*);
 	CIpcHelloMessage*	parseHello();
 	CIpcCommandMessage*	parseCommand();
+	CIpcStatsMessage*	parseStats();
+	void				offerLogRing();
+	void				useLogRing();
+	void				sendLogLine(const CString& logLine);
 	void				disconnect();
 	
 private:
 	synergy::IStream&	m_stream;
 	EIpcClientType		m_clientType;
 	bool				m_disconnecting;
+	bool				m_local;
+	CIpcLogRing*		m_offeredLogRing;
+	CIpcLogRing*		m_logRing;
 	CArchMutex			m_readMutex;
 	CArchMutex			m_writeMutex;
 	IEventQueue*		m_events;
@@ -0,0 +1,363 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ipc/IpcLogRing.h"
+
+#include "base/Log.h"
+
+#include <cstring>
+
+#if SYSAPI_UNIX
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <errno.h>
+#endif
+
+static const UInt32		kRingMagic   = 0x53594c52;	// "SYLR"
+static const UInt32		kMinRingSize = 4096;
+
+//
+// CIpcLogRing::CHeader
+//
+
+// lives at the start of the mapping.  the producer owns m_head and the
+// consumer owns m_tail;  they're kept on separate cache lines so the two
+// processes don't bounce a line between them for every record.  both
+// are running byte counts, the offset into the ring is the count modulo
+// the size.
+class CIpcLogRing::CHeader {
+public:
+	UInt32				m_magic;
+	UInt32				m_size;
+	UInt8				m_pad0[56];
+	volatile UInt32		m_head;
+	UInt8				m_pad1[60];
+	volatile UInt32		m_tail;
+	volatile UInt32		m_idle;
+	UInt8				m_pad2[56];
+};
+
+//
+// CIpcLogRing
+//
+
+CIpcLogRing::CIpcLogRing() :
+	m_owner(false),
+	m_mapping(NULL),
+	m_mappingSize(0),
+	m_header(NULL),
+	m_data(NULL),
+	m_mask(0)
+{
+	// do nothing
+}
+
+CIpcLogRing::~CIpcLogRing()
+{
+	close();
+}
+
+bool
+CIpcLogRing::create(UInt32 size)
+{
+	close();
+
+#if SYSAPI_UNIX
+	UInt32 ringSize = kMinRingSize;
+	while (ringSize < size && ringSize < 0x40000000u) {
+		ringSize <<= 1;
+	}
+
+	static UInt32 s_count = 0;
+	CString name = synergy::string::sprintf("/synergy-log-%d-%u",
+							static_cast<int>(getpid()),
+							__sync_fetch_and_add(&s_count, 1));
+
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd == -1) {
+		LOG((CLOG_DEBUG "can't create log ring %s: %s", name.c_str(), strerror(errno)));
+		return false;
+	}
+	m_name  = name;
+	m_owner = true;
+
+	size_t mappingSize = sizeof(CHeader) + ringSize;
+	void* mapping = MAP_FAILED;
+	if (ftruncate(fd, static_cast<off_t>(mappingSize)) == 0) {
+		mapping = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE,
+							MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		LOG((CLOG_DEBUG "can't map log ring %s: %s", name.c_str(), strerror(errno)));
+		close();
+		return false;
+	}
+
+	m_mapping     = mapping;
+	m_mappingSize = mappingSize;
+	m_header      = static_cast<CHeader*>(mapping);
+	m_data        = static_cast<UInt8*>(mapping) + sizeof(CHeader);
+	m_mask        = ringSize - 1;
+
+	// the reader starts out waiting for the first record
+	m_header->m_magic = kRingMagic;
+	m_header->m_size  = ringSize;
+	m_header->m_head  = 0;
+	m_header->m_tail  = 0;
+	m_header->m_idle  = 1;
+	__sync_synchronize();
+	return true;
+#else
+	(void)size;
+	return false;
+#endif
+}
+
+bool
+CIpcLogRing::open(const CString& name)
+{
+	close();
+
+#if SYSAPI_UNIX
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd == -1) {
+		LOG((CLOG_DEBUG "can't open log ring %s: %s", name.c_str(), strerror(errno)));
+		return false;
+	}
+
+	// don't trust the creator's header further than the file size
+	struct stat info;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &info) == 0 &&
+		info.st_size > static_cast<off_t>(sizeof(CHeader))) {
+		mapping = mmap(NULL, static_cast<size_t>(info.st_size),
+							PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		LOG((CLOG_DEBUG "can't map log ring %s", name.c_str()));
+		return false;
+	}
+
+	CHeader* header = static_cast<CHeader*>(mapping);
+	UInt32 ringSize = header->m_size;
+	if (header->m_magic != kRingMagic || ringSize < kMinRingSize ||
+		(ringSize & (ringSize - 1)) != 0 ||
+		sizeof(CHeader) + ringSize > static_cast<size_t>(info.st_size)) {
+		LOG((CLOG_DEBUG "log ring %s is invalid", name.c_str()));
+		munmap(mapping, static_cast<size_t>(info.st_size));
+		return false;
+	}
+
+	m_name        = name;
+	m_owner       = false;
+	m_mapping     = mapping;
+	m_mappingSize = static_cast<size_t>(info.st_size);
+	m_header      = header;
+	m_data        = static_cast<UInt8*>(mapping) + sizeof(CHeader);
+	m_mask        = ringSize - 1;
+	return true;
+#else
+	(void)name;
+	return false;
+#endif
+}
+
+void
+CIpcLogRing::unlink()
+{
+#if SYSAPI_UNIX
+	if (m_owner) {
+		shm_unlink(m_name.c_str());
+	}
+#endif
+	m_owner = false;
+}
+
+bool
+CIpcLogRing::write(const CString& text)
+{
+	if (m_header == NULL) {
+		return false;
+	}
+
+#if SYSAPI_UNIX
+	UInt32 n    = static_cast<UInt32>(text.size());
+	UInt32 head = m_header->m_head;
+	UInt32 tail = m_header->m_tail;
+
+	// don't touch the space until we've seen the reader let go of it
+	__sync_synchronize();
+	UInt32 used = head - tail;
+	if (used > m_mask + 1 || n > m_mask + 1 - used ||
+		4 > m_mask + 1 - used - n) {
+		return false;
+	}
+
+	copyIn(head, &n, 4);
+	copyIn(head + 4, text.data(), n);
+
+	// publish the record only once it's all there
+	__sync_synchronize();
+	m_header->m_head = head + 4 + n;
+	return true;
+#else
+	(void)text;
+	return false;
+#endif
+}
+
+bool
+CIpcLogRing::takeWakeup()
+{
+	if (m_header == NULL) {
+		return false;
+	}
+
+#if SYSAPI_UNIX
+	// the new head must be visible before we look at the idle flag or
+	// we could miss the reader going idle right after its last check
+	__sync_synchronize();
+	return (m_header->m_idle != 0 &&
+			__sync_bool_compare_and_swap(&m_header->m_idle, 1, 0));
+#else
+	return false;
+#endif
+}
+
+bool
+CIpcLogRing::read(CString& text)
+{
+	if (m_header == NULL) {
+		return false;
+	}
+
+#if SYSAPI_UNIX
+	UInt32 tail = m_header->m_tail;
+	UInt32 head = m_header->m_head;
+	if (head == tail) {
+		return false;
+	}
+
+	// don't look at the record before we've seen it published
+	__sync_synchronize();
+	UInt32 used = head - tail;
+	UInt32 n    = 0;
+	if (used >= 4 && used <= m_mask + 1) {
+		copyOut(tail, &n, 4);
+	}
+	if (used < 4 || used > m_mask + 1 || n > used - 4) {
+		LOG((CLOG_WARN "log ring is damaged, closing it"));
+		close();
+		return false;
+	}
+
+	text.resize(n);
+	if (n != 0) {
+		copyOut(tail + 4, &text[0], n);
+	}
+
+	// finish reading before handing the space back
+	__sync_synchronize();
+	m_header->m_tail = tail + 4 + n;
+	return true;
+#else
+	(void)text;
+	return false;
+#endif
+}
+
+bool
+CIpcLogRing::idle()
+{
+	if (m_header == NULL) {
+		return true;
+	}
+
+#if SYSAPI_UNIX
+	m_header->m_idle = 1;
+	__sync_synchronize();
+	if (m_header->m_head == m_header->m_tail) {
+		return true;
+	}
+
+	// a record slipped in.  take the wakeup back unless the producer
+	// already has, in which case we'll just get a spurious one.
+	__sync_bool_compare_and_swap(&m_header->m_idle, 1, 0);
+	return false;
+#else
+	return true;
+#endif
+}
+
+bool
+CIpcLogRing::isOpen() const
+{
+	return (m_header != NULL);
+}
+
+const CString&
+CIpcLogRing::getName() const
+{
+	return m_name;
+}
+
+void
+CIpcLogRing::close()
+{
+#if SYSAPI_UNIX
+	if (m_mapping != NULL) {
+		munmap(m_mapping, m_mappingSize);
+	}
+#endif
+	unlink();
+	m_name.clear();
+	m_owner       = false;
+	m_mapping     = NULL;
+	m_mappingSize = 0;
+	m_header      = NULL;
+	m_data        = NULL;
+	m_mask        = 0;
+}
+
+void
+CIpcLogRing::copyIn(UInt32 offset, const void* src, UInt32 n)
+{
+	// the record may wrap around the end of the ring
+	offset &= m_mask;
+	UInt32 first = m_mask + 1 - offset;
+	if (first > n) {
+		first = n;
+	}
+	memcpy(m_data + offset, src, first);
+	memcpy(m_data, static_cast<const UInt8*>(src) + first, n - first);
+}
+
+void
+CIpcLogRing::copyOut(UInt32 offset, void* dst, UInt32 n) const
+{
+	offset &= m_mask;
+	UInt32 first = m_mask + 1 - offset;
+	if (first > n) {
+		first = n;
+	}
+	memcpy(dst, m_data + offset, first);
+	memcpy(static_cast<UInt8*>(dst) + first, m_data, n - first);
+}
@@ -0,0 +1,120 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+
+//! Shared memory ring for log lines
+/*!
+A single producer, single consumer ring of log records in shared memory.
+The daemon copies log lines straight into the mapping and the reader
+copies them straight out again, so streaming the log costs no system
+calls.  The IPC socket only carries a wakeup when the reader has gone
+idle.  Only available on Unix;  elsewhere \c create() and \c open() fail.
+*/
+class CIpcLogRing {
+public:
+	CIpcLogRing();
+	~CIpcLogRing();
+
+	//! @name manipulators
+	//@{
+
+	//! Create a ring
+	/*!
+	Creates a new shared memory ring with room for \p size bytes of
+	records, readable only by this user.  The ring's name is removed
+	again by \c unlink() or when this object is destroyed.  Returns
+	false on failure.
+	*/
+	bool				create(UInt32 size);
+
+	//! Remove the ring's name
+	/*!
+	Call once the reader has mapped the ring.  Existing mappings stay
+	valid but nobody else can open it anymore.
+	*/
+	void				unlink();
+
+	//! Map an existing ring
+	/*!
+	Maps the ring called \p name, as returned by \c getName() of the
+	creator.  Returns false on failure.
+	*/
+	bool				open(const CString& name);
+
+	//! Append a record
+	/*!
+	Producer only.  Returns false, without writing anything, if the ring
+	doesn't have room for \p text right now.
+	*/
+	bool				write(const CString& text);
+
+	//! Take the reader's wakeup
+	/*!
+	Producer only.  Returns true if the reader went idle and must be
+	told, by other means, that there are new records.  Returns true at
+	most once per idle period.
+	*/
+	bool				takeWakeup();
+
+	//! Take the next record
+	/*!
+	Consumer only.  Moves the oldest record into \p text and returns
+	true, or returns false if the ring is empty.  A damaged ring is
+	closed and reads as empty.
+	*/
+	bool				read(CString& text);
+
+	//! Go idle
+	/*!
+	Consumer only.  Call after \c read() returned false to ask for a
+	wakeup on the next record.  Returns false if a record arrived
+	meanwhile, in which case keep reading instead.
+	*/
+	bool				idle();
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Check for a mapped ring
+	bool				isOpen() const;
+
+	//! Get the ring's name
+	const CString&		getName() const;
+
+	//@}
+
+private:
+	class CHeader;
+
+	void				close();
+	void				copyIn(UInt32 offset, const void* src, UInt32 n);
+	void				copyOut(UInt32 offset, void* dst, UInt32 n) const;
+
+private:
+	CString				m_name;
+	bool				m_owner;
+	void*				m_mapping;
+	size_t				m_mappingSize;
+	CHeader*			m_header;
+	UInt8*				m_data;
+	UInt32				m_mask;
+};
@@ -57,6 +57,25 @@ CIpcLogLineMessage::~CIpcLogLineMessage()
 {
 }
 
+CIpcStatsRequestMessage::CIpcStatsRequestMessage() :
+CIpcMessage(kIpcStatsRequest)
+{
+}
+
+CIpcStatsRequestMessage::~CIpcStatsRequestMessage()
+{
+}
+
+CIpcStatsMessage::CIpcStatsMessage(const CString& stats) :
+CIpcMessage(kIpcStats),
+m_stats(stats)
+{
+}
+
+CIpcStatsMessage::~CIpcStatsMessage()
+{
+}
+
 CIpcCommandMessage::CIpcCommandMessage(const CString& command, bool elevate) :
 CIpcMessage(kIpcCommand),
 m_command(command),
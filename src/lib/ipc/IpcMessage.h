@@ -68,6 +68,24 @@ private:
 	CString				m_logLine;
 };
 
+class CIpcStatsRequestMessage : public CIpcMessage {
+public:
+	CIpcStatsRequestMessage();
+	virtual ~CIpcStatsRequestMessage();
+};
+
+class CIpcStatsMessage : public CIpcMessage {
+public:
+	CIpcStatsMessage(const CString& stats);
+	virtual ~CIpcStatsMessage();
+
+	//! Gets the stats.
+	CString				stats() const { return m_stats; }
+
+private:
+	CString				m_stats;
+};
+
 class CIpcCommandMessage : public CIpcMessage {
 public:
 	CIpcCommandMessage(const CString& command, bool elevate);
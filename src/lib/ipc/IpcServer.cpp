@@ -35,7 +35,9 @@
 CIpcServer::CIpcServer(IEventQueue* events, CSocketMultiplexer* socketMultiplexer) :
 	m_socket(events, socketMultiplexer),
 	m_address(CNetworkAddress(IPC_HOST, IPC_PORT)),
-	m_events(events)
+	m_localSocket(nullptr),
+	m_events(events),
+	m_socketMultiplexer(socketMultiplexer)
 {
 	init();
 }
@@ -43,7 +45,9 @@ CIpcServer::CIpcServer(IEventQueue* events, CSocketMultiplexer* socketMultiplexe
 CIpcServer::CIpcServer(IEventQueue* events, CSocketMultiplexer* socketMultiplexer, int port) :
 	m_socket(events, socketMultiplexer),
 	m_address(CNetworkAddress(IPC_HOST, port)),
-	m_events(events)
+	m_localSocket(nullptr),
+	m_events(events),
+	m_socketMultiplexer(socketMultiplexer)
 {
 	init();
 }
@@ -72,6 +76,10 @@ CIpcServer::~CIpcServer()
 	ARCH->closeMutex(m_clientsMutex);
 	
 	m_events->removeHandler(m_events->forIListenSocket().connecting(), &m_socket);
+	if (m_localSocket != nullptr) {
+		m_events->removeHandler(m_events->forIListenSocket().connecting(), m_localSocket);
+		delete m_localSocket;
+	}
 }
 
 void
@@ -81,17 +89,46 @@ CIpcServer::listen()
 }
 
 void
-CIpcServer::handleClientConnecting(const CEvent&, void*)
+CIpcServer::listenLocal(const CString& path)
 {
-	synergy::IStream* stream = m_socket.accept();
-	if (stream == NULL) {
-		return;
+	assert(m_localSocket == nullptr);
+
+	CNetworkAddress address = CNetworkAddress::localPath(path);
+	CTCPListenSocket* socket = new CTCPListenSocket(
+							m_events, m_socketMultiplexer, IArchNetwork::kUNIX);
+	try {
+		socket->bind(address);
 	}
+	catch (...) {
+		delete socket;
+		throw;
+	}
+	m_localSocket = socket;
+
+	m_events->adoptHandler(
+		m_events->forIListenSocket().connecting(), m_localSocket,
+		new TMethodEventJob<CIpcServer>(
+		this, &CIpcServer::handleClientConnecting));
+}
 
-	LOG((CLOG_DEBUG "accepted ipc client connection"));
+void
+CIpcServer::handleClientConnecting(const CEvent& e, void*)
+{
+	CTCPListenSocket* socket = static_cast<CTCPListenSocket*>(e.getTarget());
+	synergy::IStream* stream;
+	while ((stream = socket->accept(NULL)) != NULL) {
+		addClient(stream, socket == m_localSocket);
+	}
+}
+
+void
+CIpcServer::addClient(synergy::IStream* stream, bool local)
+{
+	LOG((CLOG_DEBUG "accepted %s ipc client connection", local ? "local" : "tcp"));
 
 	ARCH->lockMutex(m_clientsMutex);
 	CIpcClientProxy* proxy = new CIpcClientProxy(*stream, m_events);
+	proxy->m_local = local;
 	m_clients.push_back(proxy);
 	ARCH->unlockMutex(m_clientsMutex);
 
@@ -31,6 +31,7 @@ class CIpcClientProxy;
 class CIpcMessage;
 class IEventQueue;
 class CSocketMultiplexer;
+namespace synergy { class IStream; }
 
 //! IPC server for communication between daemon and GUI.
 /*!
@@ -51,6 +52,16 @@ public:
 	//! Opens a TCP socket only allowing local connections.
 	void				listen();
 
+	//! Also listen on a local socket
+	/*!
+	Opens a local (unix domain) socket at \p path as well.  Only clients
+	running as the same user (or the superuser) are accepted on it and
+	they may receive log lines through shared memory.  Throws
+	XSocketAddress if the platform has no local sockets or \p path is
+	unusable, and XSocketBind if it can't be opened.
+	*/
+	void				listenLocal(const CString& path);
+
 	//! Send a message to all clients matching the filter type.
 	void				send(const CIpcMessage& message, EIpcClientType filterType);
 
@@ -66,6 +77,7 @@ public:
 private:
 	void				init();
 	void				handleClientConnecting(const CEvent&, void*);
+	void				addClient(synergy::IStream* stream, bool local);
 	void				handleClientDisconnected(const CEvent&, void*);
 	void				handleMessageReceived(const CEvent&, void*);
 	void				deleteClient(CIpcClientProxy* proxy);
@@ -75,7 +87,9 @@ private:
 
 	CTCPListenSocket	m_socket;
 	CNetworkAddress		m_address;
+	CTCPListenSocket*	m_localSocket;
 	CClientList			m_clients;
 	CArchMutex			m_clientsMutex;
 	IEventQueue*		m_events;
+	CSocketMultiplexer*	m_socketMultiplexer;
 };
@@ -19,18 +19,24 @@
 #include "ipc/IpcServerProxy.h"
 
 #include "ipc/IpcMessage.h"
+#include "ipc/IpcLogRing.h"
 #include "ipc/Ipc.h"
 #include "synergy/ProtocolUtil.h"
 #include "io/IStream.h"
 #include "base/TMethodEventJob.h"
 #include "base/Log.h"
 
+// most log records to read from the ring before letting the event
+// queue catch up
+static const int		kMaxLogRingRecords = 256;
+
 //
 // CIpcServerProxy
 //
 
 CIpcServerProxy::CIpcServerProxy(synergy::IStream& stream, IEventQueue* events) :
 	m_stream(stream),
+	m_logRing(nullptr),
 	m_events(events)
 {
 	m_events->adoptHandler(m_events->forIStream().inputReady(),
@@ -43,6 +49,7 @@ CIpcServerProxy::~CIpcServerProxy()
 {
 	m_events->removeHandler(m_events->forIStream().inputReady(),
 		m_stream.getEventTarget());
+	delete m_logRing;
 }
 
 void
@@ -50,31 +57,47 @@ CIpcServerProxy::handleData(const CEvent&, void*)
 {
 	LOG((CLOG_DEBUG "start ipc handle data"));
 
-	UInt8 code[4];
-	UInt32 n = m_stream.read(code, 4);
-	while (n != 0) {
+	// carry on from where we stopped reading the ring last time
+	readLogRing();
 
+	// a long message can arrive in pieces.  only take a message once it's
+	// all there or the rest of it would be parsed as the next message.
+	CString body;
+	while (readMessage(body)) {
+		const UInt8* code = m_code;
 		LOG((CLOG_DEBUG "ipc read: %c%c%c%c",
 			code[0], code[1], code[2], code[3]));
 		
 		CIpcMessage* m = nullptr;
 		if (memcmp(code, kIpcMsgLogLine, 4) == 0) {
-			m = parseLogLine();
+			// anything left in the ring is older than this
+			readLogRing();
+			m = new CIpcLogLineMessage(body);
 		}
 		else if (memcmp(code, kIpcMsgShutdown, 4) == 0) {
 			m = new CIpcShutdownMessage();
 		}
+		else if (memcmp(code, kIpcMsgLogRing, 4) == 0) {
+			openLogRing(body);
+		}
+		else if (memcmp(code, kIpcMsgLogRingReady, 4) == 0) {
+			readLogRing();
+		}
+		else if (memcmp(code, kIpcMsgStatsRequest, 4) == 0) {
+			m = new CIpcStatsRequestMessage();
+		}
+		else if (memcmp(code, kIpcMsgStats, 4) == 0) {
+			m = new CIpcStatsMessage(body);
+		}
 		else {
 			LOG((CLOG_ERR "invalid ipc message"));
 			disconnect();
+			return;
 		}
 		
-		// don't delete with this event; the data is passed to a new event.
-		CEvent e(m_events->forCIpcServerProxy().messageReceived(), this, NULL, CEvent::kDontFreeData);
-		e.setDataObject(m);
-		m_events->addEvent(e);
-
-		n = m_stream.read(code, 4);
+		if (m != nullptr) {
+			postMessage(m);
+		}
 	}
 	
 	LOG((CLOG_DEBUG "finished ipc handle data"));
@@ -99,20 +122,119 @@ CIpcServerProxy::send(const CIpcMessage& message)
 		break;
 	}
 
+	case kIpcStatsRequest:
+		CProtocolUtil::writef(&m_stream, kIpcMsgStatsRequest);
+		break;
+
+	case kIpcStats: {
+		const CIpcStatsMessage& sm = static_cast<const CIpcStatsMessage&>(message);
+		CString stats = sm.stats();
+		CProtocolUtil::writef(&m_stream, kIpcMsgStats, &stats);
+		break;
+	}
+
 	default:
 		LOG((CLOG_ERR "ipc message not supported: %d", message.type()));
 		break;
 	}
 }
 
-CIpcLogLineMessage*
-CIpcServerProxy::parseLogLine()
+void
+CIpcServerProxy::requestLogRing()
+{
+	CProtocolUtil::writef(&m_stream, kIpcMsgLogRingRequest);
+}
+
+void
+CIpcServerProxy::openLogRing(const CString& name)
+{
+	// if we can't map it then just don't acknowledge it and the server
+	// keeps using the socket
+	CIpcLogRing* ring = new CIpcLogRing;
+	if (m_logRing != nullptr || !ring->open(name)) {
+		delete ring;
+		return;
+	}
+	m_logRing = ring;
+	CProtocolUtil::writef(&m_stream, kIpcMsgLogRingAck);
+	LOG((CLOG_DEBUG "receiving ipc log lines through shared memory"));
+}
+
+void
+CIpcServerProxy::readLogRing()
 {
+	if (m_logRing == nullptr) {
+		return;
+	}
+
 	CString logLine;
-	CProtocolUtil::readf(&m_stream, kIpcMsgLogLine + 4, &logLine);
-	
-	// must be deleted by event handler.
-	return new CIpcLogLineMessage(logLine);
+	for (int i = 0; i < kMaxLogRingRecords; ) {
+		if (m_logRing->read(logLine)) {
+			postMessage(new CIpcLogLineMessage(logLine));
+			++i;
+		}
+		else if (m_logRing->idle()) {
+			return;
+		}
+	}
+
+	// there's more but don't starve the event queue.  come back later
+	// without waiting for the server to poke us.
+	m_events->addEvent(CEvent(m_events->forIStream().inputReady(),
+							m_stream.getEventTarget()));
+}
+
+void
+CIpcServerProxy::postMessage(CIpcMessage* message)
+{
+	// don't delete with this event; the data is passed to a new event.
+	CEvent e(m_events->forCIpcServerProxy().messageReceived(), this, NULL, CEvent::kDontFreeData);
+	e.setDataObject(message);
+	m_events->addEvent(e);
+}
+
+bool
+CIpcServerProxy::readMessage(CString& body)
+{
+	// take everything the socket has.  it only tells us about new data
+	// once its own buffer has been emptied.
+	UInt8 buffer[4096];
+	UInt32 n;
+	while ((n = m_stream.read(buffer, sizeof(buffer))) != 0) {
+		m_buffer.write(buffer, n);
+	}
+
+	UInt32 size = m_buffer.getSize();
+	if (size < 4) {
+		return false;
+	}
+	memcpy(m_code, m_buffer.peek(4), 4);
+	if (memcmp(m_code, kIpcMsgLogLine, 4) != 0 &&
+		memcmp(m_code, kIpcMsgLogRing, 4) != 0 &&
+		memcmp(m_code, kIpcMsgStats, 4) != 0) {
+		// the rest take no arguments
+		m_buffer.pop(4);
+		body.clear();
+		return true;
+	}
+
+	// the only argument is a string
+	if (size < 8) {
+		return false;
+	}
+	const UInt8* header = static_cast<const UInt8*>(m_buffer.peek(8));
+	UInt32 length = (static_cast<UInt32>(header[4]) << 24) |
+					(static_cast<UInt32>(header[5]) << 16) |
+					(static_cast<UInt32>(header[6]) <<  8) |
+					 static_cast<UInt32>(header[7]);
+	if (length > size - 8) {
+		return false;
+	}
+
+	const char* data = static_cast<const char*>(m_buffer.peek(8 + length));
+	body.assign(data + 8, length);
+	m_buffer.pop(8 + length);
+	return true;
 }
 
 void
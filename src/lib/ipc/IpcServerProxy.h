@@ -20,10 +20,13 @@
 
 #include "base/Event.h"
 #include "base/EventTypes.h"
+#include "io/StreamBuffer.h"
+#include "base/String.h"
 
 namespace synergy { class IStream; }
 class CIpcMessage;
 class CIpcLogLineMessage;
+class CIpcLogRing;
 class IEventQueue;
 
 class CIpcServerProxy {
@@ -35,12 +38,19 @@ public:
 
 private:
 	void				send(const CIpcMessage& message);
+	void				requestLogRing();
 
 	void				handleData(const CEvent&, void*);
-	CIpcLogLineMessage*	parseLogLine();
+	bool				readMessage(CString& body);
+	void				openLogRing(const CString& name);
+	void				readLogRing();
+	void				postMessage(CIpcMessage* message);
 	void				disconnect();
 
 private:
 	synergy::IStream&	m_stream;
+	UInt8				m_code[4];
+	CStreamBuffer		m_buffer;
+	CIpcLogRing*		m_logRing;
 	IEventQueue*		m_events;
 };
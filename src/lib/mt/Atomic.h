@@ -0,0 +1,71 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/common.h"
+
+#if SYSAPI_WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#endif
+
+//
+// atomic operations for lock-free handoffs between two threads, like
+// the single producer, single consumer queues in CTCPSocket and
+// CInputChannel.  all of them are full memory barriers.
+//
+
+//! Memory barrier
+inline void
+atomicBarrier()
+{
+#if SYSAPI_WIN32
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+//! Compare and swap
+/*!
+Replaces \c *v with \p newValue if it's \p oldValue.  Returns true if
+it did.
+*/
+inline bool
+atomicCompareAndSwap(volatile long* v, long oldValue, long newValue)
+{
+#if SYSAPI_WIN32
+	return (InterlockedCompareExchange(v, newValue, oldValue) == oldValue);
+#else
+	return __sync_bool_compare_and_swap(v, oldValue, newValue);
+#endif
+}
+
+//! Add
+/*!
+Adds \p n to \c *v and returns the result.
+*/
+inline long
+atomicAdd(volatile long* v, long n)
+{
+#if SYSAPI_WIN32
+	return InterlockedExchangeAdd(v, n) + n;
+#else
+	return __sync_add_and_fetch(v, n);
+#endif
+}
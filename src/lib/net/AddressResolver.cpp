@@ -0,0 +1,218 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/AddressResolver.h"
+
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+#include "base/TMethodJob.h"
+#include "base/XBase.h"
+
+#include <algorithm>
+
+//
+// CAddressResolver::CRequest
+//
+
+class CAddressResolver::CRequest {
+public:
+	CRequest(const CNetworkAddress& address) :
+		m_address(address), m_done(false), m_cancelled(false) { }
+
+	CNetworkAddress		m_address;
+	std::vector<CNetworkAddress>	m_addresses;
+	CString				m_error;
+	bool				m_done;
+	bool				m_cancelled;
+};
+
+
+//
+// CAddressResolver
+//
+
+CAddressResolver::CAddressResolver(IEventQueue* events, double ttl) :
+	m_events(events),
+	m_ttl(ttl),
+	m_mutex(new CMutex),
+	m_queueReady(new CCondVar<bool>(m_mutex, false)),
+	m_running(NULL),
+	m_thread(NULL)
+{
+	m_thread = new CThread(new TMethodJob<CAddressResolver>(
+								this, &CAddressResolver::resolverThread));
+}
+
+CAddressResolver::~CAddressResolver()
+{
+	// a lookup in progress can't be interrupted so this may wait for it
+	m_thread->cancel();
+	m_thread->wait();
+	delete m_thread;
+
+	for (CQueue::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
+		delete *i;
+	}
+	delete m_running;
+	delete m_queueReady;
+	delete m_mutex;
+}
+
+CAddressResolver::CRequest*
+CAddressResolver::resolve(const CNetworkAddress& address)
+{
+	CRequest* request = new CRequest(address);
+
+	CLock lock(m_mutex);
+
+	// use the cached addresses if they're still fresh
+	CCache::iterator i = m_cache.find(address.getHostname());
+	if (i != m_cache.end()) {
+		if (ARCH->time() < i->second.m_expires &&
+			i->second.m_port == address.getPort()) {
+			LOG((CLOG_DEBUG1 "using cached addresses for %s",
+								address.getHostname().c_str()));
+			request->m_addresses = i->second.m_addresses;
+			request->m_done      = true;
+			m_events->addEvent(CEvent(
+								m_events->forCAddressResolver().resolved(),
+								request));
+			return request;
+		}
+		m_cache.erase(i);
+	}
+
+	// leave it to the worker
+	m_queue.push_back(request);
+	m_queueReady->signal();
+	return request;
+}
+
+bool
+CAddressResolver::takeResult(CRequest* request,
+				std::vector<CNetworkAddress>& addresses, CString& error)
+{
+	assert(request != NULL);
+
+	CLock lock(m_mutex);
+	if (!request->m_done) {
+		return false;
+	}
+	addresses.swap(request->m_addresses);
+	error = request->m_error;
+	delete request;
+	return true;
+}
+
+void
+CAddressResolver::cancel(CRequest* request)
+{
+	if (request == NULL) {
+		return;
+	}
+
+	CLock lock(m_mutex);
+	CQueue::iterator i = std::find(m_queue.begin(), m_queue.end(), request);
+	if (i != m_queue.end()) {
+		m_queue.erase(i);
+		delete request;
+	}
+	else if (request == m_running) {
+		// the worker deletes it when the lookup returns
+		request->m_cancelled = true;
+	}
+	else {
+		delete request;
+	}
+}
+
+void
+CAddressResolver::invalidate(const CString& hostname)
+{
+	CLock lock(m_mutex);
+	m_cache.erase(hostname);
+}
+
+std::vector<CNetworkAddress>
+CAddressResolver::lookup(const CNetworkAddress& address)
+{
+	return address.resolveAll();
+}
+
+void
+CAddressResolver::resolverThread(void*)
+{
+	for (;;) {
+		// wait for a request
+		CRequest* request;
+		{
+			CLock lock(m_mutex);
+			while (m_queue.empty()) {
+				m_queueReady->wait();
+			}
+			request   = m_queue.front();
+			m_running = request;
+			m_queue.pop_front();
+		}
+
+		// look it up without holding the lock.  only this thread
+		// touches the request until it's marked done.
+		CStopwatch timer;
+		std::vector<CNetworkAddress> addresses;
+		CString error;
+		try {
+			addresses = lookup(request->m_address);
+			if (addresses.empty()) {
+				error = "no addresses found";
+			}
+		}
+		catch (XBase& e) {
+			addresses.clear();
+			error = e.what();
+		}
+		LOG((CLOG_DEBUG1 "resolved %s to %d addresses in %.3f ms",
+								request->m_address.getHostname().c_str(),
+								static_cast<int>(addresses.size()),
+								1000.0 * timer.getTime()));
+
+		CLock lock(m_mutex);
+		m_running = NULL;
+		if (request->m_cancelled) {
+			delete request;
+			continue;
+		}
+
+		// only cache successes so a failure is retried next time
+		if (!addresses.empty()) {
+			CCacheEntry& entry = m_cache[request->m_address.getHostname()];
+			entry.m_addresses = addresses;
+			entry.m_port      = request->m_address.getPort();
+			entry.m_expires   = ARCH->time() + m_ttl;
+		}
+		request->m_addresses.swap(addresses);
+		request->m_error = error;
+		request->m_done  = true;
+		m_events->addEvent(CEvent(m_events->forCAddressResolver().resolved(),
+								request));
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/NetworkAddress.h"
+#include "base/String.h"
+#include "common/stddeque.h"
+#include "common/stdmap.h"
+#include "common/stdvector.h"
+
+template <class T>
+class CCondVar;
+class CMutex;
+class CThread;
+class IEventQueue;
+
+//! Asynchronous host name resolver
+/*!
+Resolves host names on a worker thread so a slow name server can't
+stall the event loop.  Successful lookups are cached for a while so
+reconnecting doesn't wait on the name server at all.
+*/
+class CAddressResolver {
+public:
+	//! Opaque pending lookup
+	class CRequest;
+
+	/*!
+	Lookups are cached for \p ttl seconds.
+	*/
+	CAddressResolver(IEventQueue* events, double ttl = 60.0);
+	virtual ~CAddressResolver();
+
+	//! @name manipulators
+	//@{
+
+	//! Start a lookup
+	/*!
+	Starts resolving \p address and returns immediately.  When the lookup
+	has finished a \c CAddressResolverEvents::resolved event is sent with
+	the returned request as the target;  pass that to \c takeResult().
+	The event is sent even for cache hits, so it's never delivered
+	before this returns.
+	*/
+	CRequest*			resolve(const CNetworkAddress& address);
+
+	//! Take the result of a lookup
+	/*!
+	Returns false if \p request hasn't finished yet.  Otherwise fills
+	\p addresses with the resolved addresses, in order of preference,
+	or leaves it empty and sets \p error if the lookup failed, deletes
+	the request and returns true.
+	*/
+	bool				takeResult(CRequest* request,
+							std::vector<CNetworkAddress>& addresses,
+							CString& error);
+
+	//! Abandon a lookup
+	/*!
+	Deletes \p request.  A resolved event for it may still be delivered
+	so remove any handler for it first.
+	*/
+	void				cancel(CRequest* request);
+
+	//! Forget a cached lookup
+	/*!
+	Drops any cached addresses for \p hostname, e.g. after none of them
+	could be connected to.
+	*/
+	void				invalidate(const CString& hostname);
+
+	//@}
+
+protected:
+	//! Look up an address
+	/*!
+	Does the actual, blocking lookup.  Called on the worker thread.
+	Throws XSocketAddress on failure.  The default uses
+	\c CNetworkAddress::resolveAll().
+	*/
+	virtual std::vector<CNetworkAddress>
+						lookup(const CNetworkAddress& address);
+
+private:
+	class CCacheEntry {
+	public:
+		std::vector<CNetworkAddress>	m_addresses;
+		int				m_port;
+		double			m_expires;
+	};
+	typedef std::map<CString, CCacheEntry> CCache;
+	typedef std::deque<CRequest*> CQueue;
+
+	void				resolverThread(void*);
+
+private:
+	IEventQueue*		m_events;
+	double				m_ttl;
+	CMutex*				m_mutex;
+	CCondVar<bool>*		m_queueReady;
+	CQueue				m_queue;
+	CRequest*			m_running;
+	CCache				m_cache;
+	CThread*			m_thread;
+};
@@ -50,6 +50,15 @@ public:
 	*/
 	virtual void		connect(const CNetworkAddress&) = 0;
 
+	//! Set whether to record write latency
+	/*!
+	If \p enabled then the socket records how long written data waits
+	before the kernel has it, in CLatencyStats' socket write stage.  It's
+	off by default;  only the synergy connections turn it on so other
+	traffic, like IPC, doesn't show up in the stage.
+	*/
+	virtual void		setRecordWriteLatency(bool enabled) = 0;
+
 	//@}
 
 	// ISocket overrides
@@ -20,6 +20,7 @@
 
 #include "net/ISocket.h"
 #include "base/EventTypes.h"
+#include "base/String.h"
 
 class IDataSocket;
 
@@ -37,9 +38,15 @@ public:
 	/*!
 	Accept a connection, returning a socket representing the full-duplex
 	data stream.  Returns NULL if no socket is waiting to be accepted.
+	If \p peerHost isn't NULL it's set to the remote end's address.
 	This is only valid after a call to \c bind().
+
+	A \c IListenSocketEvents::connecting event may stand for any number
+	of waiting connections and no further event is sent until this has
+	returned NULL, so call it until it does (or send yourself another
+	connecting event to carry on later).
 	*/
-	virtual IDataSocket*	accept() = 0;
+	virtual IDataSocket*	accept(CString* peerHost) = 0;
 
 	//@}
 
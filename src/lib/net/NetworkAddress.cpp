@@ -116,6 +116,23 @@ CNetworkAddress::~CNetworkAddress()
 	}
 }
 
+CNetworkAddress
+CNetworkAddress::localPath(const CString& path)
+{
+	CNetworkAddress address;
+	try {
+		address.m_address = ARCH->pathToAddr(path);
+	}
+	catch (XArchNetworkSupport&) {
+		throw XSocketAddress(XSocketAddress::kUnsupported, path, 0);
+	}
+	catch (XArchNetwork&) {
+		throw XSocketAddress(XSocketAddress::kNoAddress, path, 0);
+	}
+	address.m_hostname = path;
+	return address;
+}
+
 CNetworkAddress&
 CNetworkAddress::operator=(const CNetworkAddress& addr)
 {
@@ -135,20 +152,36 @@ CNetworkAddress::operator=(const CNetworkAddress& addr)
 void
 CNetworkAddress::resolve()
 {
+	if (isLocal()) {
+		return;
+	}
+
 	// discard previous address
 	if (m_address != NULL) {
 		ARCH->closeAddr(m_address);
 		m_address = NULL;
 	}
 
+	std::vector<CNetworkAddress> addresses = resolveAll();
+	m_address = ARCH->copyAddr(addresses[0].m_address);
+}
+
+std::vector<CNetworkAddress>
+CNetworkAddress::resolveAll() const
+{
+	if (isLocal()) {
+		return std::vector<CNetworkAddress>(1, *this);
+	}
+
+	std::vector<CArchNetAddress> addrs;
 	try {
 		// if hostname is empty then use wildcard address otherwise look
 		// up the name.
 		if (m_hostname.empty()) {
-			m_address = ARCH->newAnyAddr(IArchNetwork::kINET);
+			addrs.push_back(ARCH->newAnyAddr(IArchNetwork::kINET));
 		}
 		else {
-			m_address = ARCH->nameToAddr(m_hostname);
+			addrs = ARCH->nameToAddrs(m_hostname);
 		}
 	}
 	catch (XArchNetworkNameUnknown&) {
@@ -164,8 +197,18 @@ CNetworkAddress::resolve()
 		throw XSocketAddress(XSocketAddress::kUnknown, m_hostname, m_port);
 	}
 
-	// set port in address
-	ARCH->setAddrPort(m_address, m_port);
+	// set port in each address
+	std::vector<CNetworkAddress> addresses;
+	addresses.reserve(addrs.size());
+	for (size_t i = 0; i < addrs.size(); ++i) {
+		CNetworkAddress address;
+		address.m_address  = addrs[i];
+		address.m_hostname = m_hostname;
+		address.m_port     = m_port;
+		ARCH->setAddrPort(address.m_address, m_port);
+		addresses.push_back(address);
+	}
+	return addresses;
 }
 
 bool
@@ -204,6 +247,13 @@ CNetworkAddress::getHostname() const
 	return m_hostname;
 }
 
+bool
+CNetworkAddress::isLocal() const
+{
+	return (m_address != NULL &&
+			ARCH->getAddrFamily(m_address) == IArchNetwork::kUNIX);
+}
+
 void
 CNetworkAddress::checkPort()
 {
@@ -21,6 +21,7 @@
 #include "base/String.h"
 #include "base/EventTypes.h"
 #include "arch/IArchNetwork.h"
+#include "common/stdvector.h"
 
 //! Network address type
 /*!
@@ -55,6 +56,15 @@ public:
 
 	~CNetworkAddress();
 
+	//! Make a local address
+	/*!
+	Returns the address of the local (unix domain) socket at \c path.
+	The hostname is the path and the port is zero.  It needs no
+	resolving.  Throws \c XSocketAddress if the platform has no local
+	sockets or the path is unusable.
+	*/
+	static CNetworkAddress	localPath(const CString& path);
+
 	CNetworkAddress&	operator=(const CNetworkAddress&);
 
 	//! @name manipulators
@@ -64,6 +74,7 @@ public:
 	/*!
 	Resolves the hostname to an address.  This can be done any number of
 	times and is done automatically by the c'tor taking a hostname.
+	Local addresses are left as they are.
 	Throws XSocketAddress if resolution is unsuccessful, after which
 	\c isValid returns false until the next call to this method.
 	*/
@@ -73,6 +84,17 @@ public:
 	//! @name accessors
 	//@{
 
+	//! Resolve address to all its addresses
+	/*!
+	Like \c resolve() but returns a resolved copy of this address for
+	every address the hostname resolves to, leaving this one unchanged.
+	The first one is the one \c resolve() would pick.  Throws
+	XSocketAddress if resolution is unsuccessful.  Unlike \c resolve()
+	this may be called from any thread.
+	*/
+	std::vector<CNetworkAddress>
+						resolveAll() const;
+
 	//! Check address equality
 	/*!
 	Returns true if this address is equal to \p address.
@@ -114,6 +136,7 @@ public:
 	//@}
 
 private:
+	bool				isLocal() const;
 	void				checkPort();
 
 private:
@@ -43,11 +43,6 @@ CSocketMultiplexer::CSocketMultiplexer() :
 	m_jobListLocker(NULL),
 	m_jobListLockLocker(NULL)
 {
-	// this pointer just has to be unique and not NULL.  it will
-	// never be dereferenced.  it's used to identify cursor nodes
-	// in the jobs list.
-	m_cursorMark = reinterpret_cast<ISocketMultiplexerJob*>(this);
-
 	// start thread
 	m_thread = new CThread(new TMethodJob<CSocketMultiplexer>(
 								this, &CSocketMultiplexer::serviceThread));
@@ -169,9 +164,8 @@ CSocketMultiplexer::serviceThread(void*)
 			pfds.clear();
 			pfds.reserve(m_socketJobMap.size());
 
-			CJobCursor cursor    = newCursor();
-			CJobCursor jobCursor = nextCursor(cursor);
-			while (jobCursor != m_socketJobs.end()) {
+			for (CJobCursor jobCursor = m_socketJobs.begin();
+							jobCursor != m_socketJobs.end(); ++jobCursor) {
 				ISocketMultiplexerJob* job = *jobCursor;
 				if (job != NULL) {
 					pfd.m_socket = job->getSocket();
@@ -183,10 +177,8 @@ CSocketMultiplexer::serviceThread(void*)
 						pfd.m_events |= IArchNetwork::kPOLLOUT;
 					}
 					pfds.push_back(pfd);
-				}				
-				jobCursor = nextCursor(cursor);
+				}
 			}
-			deleteCursor(cursor);
 		}
 
 		int status;
@@ -206,10 +198,10 @@ CSocketMultiplexer::serviceThread(void*)
 
 		if (status != 0) {
 			// iterate over socket jobs, invoking each and saving the
-			// new job.
+			// new job.  we hold the job list so nobody else can change
+			// it under us.
 			UInt32 i             = 0;
-			CJobCursor cursor    = newCursor();
-			CJobCursor jobCursor = nextCursor(cursor);
+			CJobCursor jobCursor = m_socketJobs.begin();
 			while (i < pfds.size() && jobCursor != m_socketJobs.end()) {
 				if (*jobCursor != NULL) {
 					// get poll state
@@ -234,9 +226,8 @@ CSocketMultiplexer::serviceThread(void*)
 				}
 
 				// next job
-				jobCursor = nextCursor(cursor);
+				++jobCursor;
 			}
-			deleteCursor(cursor);
 		}
 
 		// delete any removed socket jobs
@@ -256,39 +247,6 @@ CSocketMultiplexer::serviceThread(void*)
 	}
 }
 
-CSocketMultiplexer::CJobCursor
-CSocketMultiplexer::newCursor()
-{
-	CLock lock(m_mutex);
-	return m_socketJobs.insert(m_socketJobs.begin(), m_cursorMark);
-}
-
-CSocketMultiplexer::CJobCursor
-CSocketMultiplexer::nextCursor(CJobCursor cursor)
-{
-	CLock lock(m_mutex);
-	CJobCursor j = m_socketJobs.end();
-	CJobCursor i = cursor;
-	while (++i != m_socketJobs.end()) {
-		if (*i != m_cursorMark) {
-			// found a real job (as opposed to a cursor)
-			j = i;
-
-			// move our cursor just past the job
-			m_socketJobs.splice(++i, m_socketJobs, cursor);
-			break;
-		}
-	}
-	return j;
-}
-
-void
-CSocketMultiplexer::deleteCursor(CJobCursor cursor)
-{
-	CLock lock(m_mutex);
-	m_socketJobs.erase(cursor);
-}
-
 void
 CSocketMultiplexer::lockJobListLock()
 {
@@ -56,8 +56,9 @@ public:
 	//@}
 
 private:
-	// list of jobs.  we use a list so we can safely iterate over it
-	// while other threads modify it.
+	// list of jobs.  we use a list so iterators stay valid while jobs
+	// are added and removed.  only the thread holding the job list may
+	// touch it.
 	typedef std::list<ISocketMultiplexerJob*> CSocketJobs;
 	typedef CSocketJobs::iterator CJobCursor;
 	typedef std::map<ISocket*, CJobCursor> CSocketJobMap;
@@ -68,19 +69,6 @@ private:
 	// false.  only the service thread sets m_polling.
 	void				serviceThread(void*);
 
-	// create, iterate, and destroy a cursor.  a cursor is used to
-	// safely iterate through the job list while other threads modify
-	// the list.  it works by inserting a dummy item in the list and
-	// moving that item through the list.  the dummy item will never
-	// be removed by other edits so an iterator pointing at the item
-	// remains valid until we remove the dummy item in deleteCursor().
-	// nextCursor() finds the next non-dummy item, moves our dummy
-	// item just past it, and returns an iterator for the non-dummy
-	// item.  all cursor calls lock the mutex for their duration.
-	CJobCursor			newCursor();
-	CJobCursor			nextCursor(CJobCursor);
-	void				deleteCursor(CJobCursor);
-
 	// lock out locking the job list.  this blocks if another thread
 	// has already locked out locking.  once it returns, only the
 	// calling thread will be able to lock the job list after any
@@ -106,5 +94,4 @@ private:
 
 	CSocketJobs			m_socketJobs;
 	CSocketJobMap		m_socketJobMap;
-	ISocketMultiplexerJob*	m_cursorMark;
 };
@@ -29,18 +29,28 @@
 #include "arch/Arch.h"
 #include "arch/XArch.h"
 #include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+
+// how long to wait before accepting again after running out of file
+// descriptors or memory
+static const double		kAcceptRetryDelay = 0.5;
 
 //
 // CTCPListenSocket
 //
 
-CTCPListenSocket::CTCPListenSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer) :
+CTCPListenSocket::CTCPListenSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+				IArchNetwork::EAddressFamily family) :
+	m_family(family),
 	m_events(events),
-	m_socketMultiplexer(socketMultiplexer)
+	m_socketMultiplexer(socketMultiplexer),
+	m_retryTimer(NULL),
+	m_acceptFailing(false)
 {
 	m_mutex = new CMutex;
 	try {
-		m_socket = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+		m_socket = ARCH->newSocket(m_family, IArchNetwork::kSTREAM);
 	}
 	catch (XArchNetwork& e) {
 		throw XSocketCreate(e.what());
@@ -49,6 +59,7 @@ CTCPListenSocket::CTCPListenSocket(IEventQueue* events, CSocketMultiplexer* sock
 
 CTCPListenSocket::~CTCPListenSocket()
 {
+	removeRetryTimer();
 	try {
 		if (m_socket != NULL) {
 			m_socketMultiplexer->removeSocket(this);
@@ -69,10 +80,7 @@ CTCPListenSocket::bind(const CNetworkAddress& addr)
 		ARCH->setReuseAddrOnSocket(m_socket, true);
 		ARCH->bindSocket(m_socket, addr.getAddress());
 		ARCH->listenOnSocket(m_socket);
-		m_socketMultiplexer->addSocket(this,
-							new TSocketMultiplexerMethodJob<CTCPListenSocket>(
-								this, &CTCPListenSocket::serviceListening,
-								m_socket, true, false));
+		pollForConnections();
 	}
 	catch (XArchNetworkAddressInUse& e) {
 		throw XSocketAddressInUse(e.what());
@@ -89,6 +97,7 @@ CTCPListenSocket::close()
 	if (m_socket == NULL) {
 		throw XIOClosed();
 	}
+	removeRetryTimer();
 	try {
 		m_socketMultiplexer->removeSocket(this);
 		ARCH->closeSocket(m_socket);
@@ -106,30 +115,91 @@ CTCPListenSocket::getEventTarget() const
 }
 
 IDataSocket*
-CTCPListenSocket::accept()
+CTCPListenSocket::accept(CString* peerHost)
 {
-	IDataSocket* socket = NULL;
-	try {
-		socket = new CTCPSocket(m_events, m_socketMultiplexer, ARCH->acceptSocket(m_socket, NULL));
-		if (socket != NULL) {
-			m_socketMultiplexer->addSocket(this,
+	// don't go back to polling until the backlog is drained.  each
+	// round trip through the multiplexer costs a wakeup of its thread.
+	CArchSocket socket = NULL;
+	CArchNetAddress addr = NULL;
+	for (;;) {
+		try {
+			socket = ARCH->acceptSocket(m_socket, (peerHost != NULL) ? &addr : NULL);
+		}
+		catch (XArchNetwork& e) {
+			// out of file descriptors or the like.  the connection is still
+			// waiting so polling would wake us again at once;  give whatever
+			// holds the descriptors a moment to let go of them.
+			if (!m_acceptFailing) {
+				LOG((CLOG_WARN "cannot accept connections: %s", e.what()));
+				m_acceptFailing = true;
+			}
+			if (m_retryTimer == NULL) {
+				m_retryTimer = m_events->newOneShotTimer(kAcceptRetryDelay, NULL);
+				m_events->adoptHandler(CEvent::kTimer, m_retryTimer,
+							new TMethodEventJob<CTCPListenSocket>(this,
+								&CTCPListenSocket::handleRetryTimer));
+			}
+			return NULL;
+		}
+		if (socket == NULL) {
+			// backlog drained
+			pollForConnections();
+			return NULL;
+		}
+
+		// anybody on the machine can connect to a local socket so check
+		// who it is.  a network socket leaves that to the protocol.
+		if (m_family != IArchNetwork::kUNIX || ARCH->isPeerTrusted(socket)) {
+			break;
+		}
+		LOG((CLOG_WARN "refused local connection from another user"));
+		if (addr != NULL) {
+			ARCH->closeAddr(addr);
+			addr = NULL;
+		}
+		try {
+			ARCH->closeSocket(socket);
+		}
+		catch (XArchNetwork&) {
+			// ignore
+		}
+	}
+	if (m_acceptFailing) {
+		LOG((CLOG_NOTE "accepting connections again"));
+		m_acceptFailing = false;
+	}
+	if (peerHost != NULL) {
+		*peerHost = ARCH->addrToString(addr);
+		ARCH->closeAddr(addr);
+	}
+	return new CTCPSocket(m_events, m_socketMultiplexer, socket);
+}
+
+void
+CTCPListenSocket::pollForConnections()
+{
+	m_socketMultiplexer->addSocket(this,
 							new TSocketMultiplexerMethodJob<CTCPListenSocket>(
 								this, &CTCPListenSocket::serviceListening,
 								m_socket, true, false));
-		}
-		return socket;
-	}
-	catch (XArchNetwork&) {
-		if (socket != NULL) {
-			delete socket;
-		}
-		return NULL;
+}
+
+void
+CTCPListenSocket::removeRetryTimer()
+{
+	if (m_retryTimer != NULL) {
+		m_events->removeHandler(CEvent::kTimer, m_retryTimer);
+		m_events->deleteTimer(m_retryTimer);
+		m_retryTimer = NULL;
 	}
-	catch (std::exception &ex) {
-		if (socket != NULL) {
-			delete socket;
-		}
-		throw ex;
+}
+
+void
+CTCPListenSocket::handleRetryTimer(const CEvent&, void*)
+{
+	removeRetryTimer();
+	if (m_socket != NULL) {
+		pollForConnections();
 	}
 }
 
@@ -25,14 +25,20 @@ class CMutex;
 class ISocketMultiplexerJob;
 class IEventQueue;
 class CSocketMultiplexer;
+class CEventQueueTimer;
+class CEvent;
 
 //! TCP listen socket
 /*!
-A listen socket using TCP.
+A listen socket using TCP.  Pass \c IArchNetwork::kUNIX to the c'tor to
+listen on a local socket instead;  those only accept peers running as
+the same user (or the superuser).
 */
 class CTCPListenSocket : public IListenSocket {
 public:
-	CTCPListenSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer);
+	CTCPListenSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+							IArchNetwork::EAddressFamily family =
+								IArchNetwork::kINET);
 	~CTCPListenSocket();
 
 	// ISocket overrides
@@ -41,16 +47,23 @@ public:
 	virtual void*		getEventTarget() const;
 
 	// IListenSocket overrides
-	virtual IDataSocket*	accept();
+	virtual IDataSocket*	accept(CString* peerHost);
 
 private:
+	void				pollForConnections();
+	void				removeRetryTimer();
+	void				handleRetryTimer(const CEvent&, void*);
+
 	ISocketMultiplexerJob*
 						serviceListening(ISocketMultiplexerJob*,
 							bool, bool, bool);
 
 private:
+	IArchNetwork::EAddressFamily	m_family;
 	CArchSocket			m_socket;
 	CMutex*				m_mutex;
 	IEventQueue*		m_events;
 	CSocketMultiplexer* m_socketMultiplexer;
+	CEventQueueTimer*	m_retryTimer;
+	bool				m_acceptFailing;
 };
@@ -23,9 +23,11 @@
 #include "net/TSocketMultiplexerMethodJob.h"
 #include "net/XSocket.h"
 #include "mt/Lock.h"
+#include "mt/Atomic.h"
 #include "arch/Arch.h"
 #include "arch/XArch.h"
 #include "base/Log.h"
+#include "base/LatencyStats.h"
 #include "base/IEventQueue.h"
 #include "base/IEventJob.h"
 
@@ -33,11 +35,30 @@
 #include <cstdlib>
 #include <memory>
 
+//
+// CTCPSocket::CInputChunk
+//
+
+// a node in the input queue.  the queue always holds one node whose data
+// has already been taken, the head, so the reader and the multiplexer
+// never touch the same node's link at the same time.
+class CTCPSocket::CInputChunk {
+public:
+	enum { kSize = 4096 };
+
+	CInputChunk() : m_next(NULL), m_size(0) { }
+
+	CInputChunk* volatile	m_next;
+	UInt32				m_size;
+	UInt8				m_data[kSize];
+};
+
 //
 // CTCPSocket
 //
 
-CTCPSocket::CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer) :
+CTCPSocket::CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+				IArchNetwork::EAddressFamily family) :
 	IDataSocket(events),
 	m_mutex(),
 	m_flushed(&m_mutex, true),
@@ -45,7 +66,7 @@ CTCPSocket::CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexe
 	m_socketMultiplexer(socketMultiplexer)
 {
 	try {
-		m_socket = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+		m_socket = ARCH->newSocket(family, IArchNetwork::kSTREAM);
 	}
 	catch (XArchNetwork& e) {
 		throw XSocketCreate(e.what());
@@ -78,6 +99,14 @@ CTCPSocket::~CTCPSocket()
 	catch (...) {
 		// ignore
 	}
+
+	// the multiplexer is done with us so the whole queue is ours
+	while (m_inputHead != NULL) {
+		CInputChunk* next = m_inputHead->m_next;
+		delete m_inputHead;
+		m_inputHead = next;
+	}
+	delete m_spareChunk;
 }
 
 void
@@ -132,7 +161,7 @@ UInt32
 CTCPSocket::read(void* buffer, UInt32 n)
 {
 	// copy data directly from our input buffer
-	CLock lock(&m_mutex);
+	pullInput();
 	UInt32 size = m_inputBuffer.getSize();
 	if (n > size) {
 		n = size;
@@ -142,10 +171,16 @@ CTCPSocket::read(void* buffer, UInt32 n)
 	}
 	m_inputBuffer.pop(n);
 
-	// if no more data and we cannot read or write then send disconnected
-	if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
-		sendEvent(m_events->forISocket().disconnected());
-		m_connected = false;
+	// if no more data and we cannot read or write then send disconnected.
+	// the multiplexer may be coming to the same conclusion so only one
+	// of us gets to send it.
+	if (m_inputBuffer.getSize() == 0 && checkInputIdle() &&
+		n > 0 && !m_readable && !m_writable) {
+		CLock lock(&m_mutex);
+		if (m_connected) {
+			sendEvent(m_events->forISocket().disconnected());
+			m_connected = false;
+		}
 	}
 
 	return n;
@@ -154,6 +189,28 @@ CTCPSocket::read(void* buffer, UInt32 n)
 void
 CTCPSocket::write(const void* buffer, UInt32 n)
 {
+	// write straight to the socket if nothing is waiting to go out ahead
+	// of this.  whatever doesn't fit and any error are left to the
+	// multiplexer, as if we hadn't tried.
+	double start = ARCH->monotonicTime();
+	if (n != 0 && m_connected && m_writable && !m_outputPending) {
+		try {
+			UInt32 written = (UInt32)ARCH->writeSocket(m_socket, buffer, n);
+			buffer = static_cast<const UInt8*>(buffer) + written;
+			n     -= written;
+			if (n == 0) {
+				if (m_recordWriteLatency) {
+					CLatencyStats::record(CLatencyStats::kSocketWrite,
+							ARCH->monotonicTime() - start);
+				}
+				return;
+			}
+		}
+		catch (XArchNetwork&) {
+			// ignore
+		}
+	}
+
 	bool wasEmpty;
 	{
 		CLock lock(&m_mutex);
@@ -172,9 +229,13 @@ CTCPSocket::write(const void* buffer, UInt32 n)
 		// copy data to the output buffer
 		wasEmpty = (m_outputBuffer.getSize() == 0);
 		m_outputBuffer.write(buffer, n);
+		if (wasEmpty) {
+			m_outputSince = start;
+		}
 
 		// there's data to write
-		m_flushed = false;
+		m_outputPending = true;
+		m_flushed       = false;
 	}
 
 	// make sure we're waiting to write
@@ -249,14 +310,14 @@ CTCPSocket::shutdownOutput()
 bool
 CTCPSocket::isReady() const
 {
-	CLock lock(&m_mutex);
+	pullInput();
 	return (m_inputBuffer.getSize() > 0);
 }
 
 UInt32
 CTCPSocket::getSize() const
 {
-	CLock lock(&m_mutex);
+	pullInput();
 	return m_inputBuffer.getSize();
 }
 
@@ -289,13 +350,22 @@ CTCPSocket::connect(const CNetworkAddress& addr)
 	setJob(newJob());
 }
 
+void
+CTCPSocket::setRecordWriteLatency(bool enabled)
+{
+	m_recordWriteLatency = enabled;
+}
+
 void
 CTCPSocket::init()
 {
 	// default state
-	m_connected = false;
-	m_readable  = false;
-	m_writable  = false;
+	m_connected     = false;
+	m_readable      = false;
+	m_writable      = false;
+	m_outputPending = false;
+	m_outputSince   = 0.0;
+	m_recordWriteLatency = false;
 
 	try {
 		// turn off Nagle algorithm.  we send lots of very short messages
@@ -313,6 +383,13 @@ CTCPSocket::init()
 		}
 		throw XSocketCreate(e.what());
 	}
+
+	// the input queue starts out with just its head
+	m_inputHead    = new CInputChunk;
+	m_inputTail    = m_inputHead;
+	m_spareChunk   = NULL;
+	m_inputIdle    = 1;
+	m_inputDiscard = false;
 }
 
 void
@@ -364,7 +441,7 @@ CTCPSocket::sendConnectionFailedEvent(const char* msg)
 }
 
 void
-CTCPSocket::sendEvent(CEvent::Type type)
+CTCPSocket::sendEvent(CEvent::Type type) const
 {
 	m_events->addEvent(CEvent(type, getEventTarget(), NULL));
 }
@@ -380,15 +457,18 @@ CTCPSocket::onConnected()
 void
 CTCPSocket::onInputShutdown()
 {
-	m_inputBuffer.pop(m_inputBuffer.getSize());
-	m_readable = false;
+	// this may be the multiplexer thread so leave the input buffer to
+	// the reader
+	m_inputDiscard = true;
+	m_readable     = false;
 }
 
 void
 CTCPSocket::onOutputShutdown()
 {
 	m_outputBuffer.pop(m_outputBuffer.getSize());
-	m_writable = false;
+	m_outputPending = false;
+	m_writable      = false;
 
 	// we're now flushed
 	m_flushed = true;
@@ -404,6 +484,79 @@ CTCPSocket::onDisconnected()
 	m_connected = false;
 }
 
+void
+CTCPSocket::pushInput(CInputChunk* chunk)
+{
+	// the data must be visible before the link is
+	chunk->m_next = NULL;
+	atomicBarrier();
+	m_inputTail->m_next = chunk;
+	m_inputTail         = chunk;
+
+	// wake the reader if it's waiting for input
+	atomicBarrier();
+	if (atomicCompareAndSwap(&m_inputIdle, 1, 0)) {
+		sendEvent(m_events->forIStream().inputReady());
+	}
+}
+
+void
+CTCPSocket::pullInput() const
+{
+	if (m_inputDiscard) {
+		discardInput();
+	}
+
+	CInputChunk* next;
+	while ((next = m_inputHead->m_next) != NULL) {
+		atomicBarrier();
+		m_inputBuffer.write(next->m_data, next->m_size);
+		delete m_inputHead;
+		m_inputHead = next;
+	}
+}
+
+bool
+CTCPSocket::checkInputIdle() const
+{
+	// from now on the multiplexer owes us an event for new input, unless
+	// some came in while we weren't looking, in which case whoever takes
+	// the flag back first sends it
+	m_inputIdle = 1;
+	atomicBarrier();
+	if (m_inputHead->m_next == NULL) {
+		return true;
+	}
+	if (atomicCompareAndSwap(&m_inputIdle, 1, 0)) {
+		sendEvent(m_events->forIStream().inputReady());
+	}
+	return false;
+}
+
+void
+CTCPSocket::discardInput() const
+{
+	m_inputDiscard = false;
+	atomicBarrier();
+
+	CInputChunk* next;
+	while ((next = m_inputHead->m_next) != NULL) {
+		delete m_inputHead;
+		m_inputHead = next;
+	}
+	m_inputBuffer.pop(m_inputBuffer.getSize());
+}
+
+bool
+CTCPSocket::isInputIdle() const
+{
+	// note -- only for the multiplexer.  true if the reader has taken
+	// everything and found nothing more.
+
+	atomicBarrier();
+	return (m_inputIdle == 1);
+}
+
 ISocketMultiplexerJob*
 CTCPSocket::serviceConnecting(ISocketMultiplexerJob* job,
 				bool, bool write, bool error)
@@ -473,6 +626,11 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 			if (n > 0) {
 				m_outputBuffer.pop(n);
 				if (m_outputBuffer.getSize() == 0) {
+					if (m_recordWriteLatency) {
+						CLatencyStats::record(CLatencyStats::kSocketWrite,
+							ARCH->monotonicTime() - m_outputSince);
+					}
+					m_outputPending = false;
 					sendEvent(m_events->forIStream().outputFlushed());
 					m_flushed = true;
 					m_flushed.broadcast();
@@ -485,7 +643,7 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 			// has therefore shutdown.
 			onOutputShutdown();
 			sendEvent(m_events->forIStream().outputShutdown());
-			if (!m_readable && m_inputBuffer.getSize() == 0) {
+			if (!m_readable && isInputIdle()) {
 				sendEvent(m_events->forISocket().disconnected());
 				m_connected = false;
 			}
@@ -509,32 +667,32 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 
 	if (read && m_readable) {
 		try {
-			UInt8 buffer[4096];
-			size_t n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+			// read into a chunk that we can hand straight to the reader
+			if (m_spareChunk == NULL) {
+				m_spareChunk = new CInputChunk;
+			}
+			size_t n = ARCH->readSocket(m_socket,
+							m_spareChunk->m_data, CInputChunk::kSize);
 			if (n > 0) {
-				bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
 				// slurp up as much as possible
 				do {
-					m_inputBuffer.write(buffer, (UInt32)n);
-					n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+					m_spareChunk->m_size = (UInt32)n;
+					pushInput(m_spareChunk);
+					m_spareChunk = new CInputChunk;
+					n = ARCH->readSocket(m_socket,
+							m_spareChunk->m_data, CInputChunk::kSize);
 				} while (n > 0);
-
-				// send input ready if input buffer was empty
-				if (wasEmpty) {
-					sendEvent(m_events->forIStream().inputReady());
-				}
 			}
 			else {
 				// remote write end of stream hungup.  our input side
 				// has therefore shutdown but don't flush our buffer
 				// since there's still data to be read.
+				m_readable = false;
 				sendEvent(m_events->forIStream().inputShutdown());
-				if (!m_writable && m_inputBuffer.getSize() == 0) {
+				if (!m_writable && isInputIdle()) {
 					sendEvent(m_events->forISocket().disconnected());
 					m_connected = false;
 				}
-				m_readable = false;
 				needNewJob = true;
 			}
 		}
@@ -32,11 +32,21 @@ class CSocketMultiplexer;
 
 //! TCP data socket
 /*!
-A data socket using TCP.
+A data socket using TCP.  Pass \c IArchNetwork::kUNIX to the c'tor to
+talk over a local socket instead.
+
+The socket multiplexer thread reads incoming data into chunks and hands
+them to the reader through a lock-free queue, and writes go straight to
+the socket while nothing is waiting to be sent, so passing data in
+either direction doesn't take the socket's mutex.  In exchange only one
+thread at a time may read and only one thread at a time may write;
+normally that's the thread dispatching the socket's events.
 */
 class CTCPSocket : public IDataSocket {
 public:
-	CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer);
+	CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer,
+							IArchNetwork::EAddressFamily family =
+								IArchNetwork::kINET);
 	CTCPSocket(IEventQueue* events, CSocketMultiplexer* socketMultiplexer, CArchSocket socket);
 	~CTCPSocket();
 
@@ -56,20 +66,35 @@ public:
 
 	// IDataSocket overrides
 	virtual void		connect(const CNetworkAddress&);
+	virtual void		setRecordWriteLatency(bool enabled);
 
 private:
+	class CInputChunk;
+
 	void				init();
 
 	void				setJob(ISocketMultiplexerJob*);
 	ISocketMultiplexerJob*	newJob();
 	void				sendConnectionFailedEvent(const char*);
-	void				sendEvent(CEvent::Type);
+	void				sendEvent(CEvent::Type) const;
 
 	void				onConnected();
 	void				onInputShutdown();
 	void				onOutputShutdown();
 	void				onDisconnected();
 
+	// multiplexer side of the input queue
+	void				pushInput(CInputChunk*);
+
+	// reader side of the input queue.  pullInput() moves everything
+	// queued into m_inputBuffer.  checkInputIdle() must be called when
+	// m_inputBuffer has been emptied;  it returns false if more input
+	// came in meanwhile.
+	void				pullInput() const;
+	bool				checkInputIdle() const;
+	void				discardInput() const;
+	bool				isInputIdle() const;
+
 	ISocketMultiplexerJob*
 						serviceConnecting(ISocketMultiplexerJob*,
 							bool, bool, bool);
@@ -80,12 +105,36 @@ private:
 private:
 	CMutex				m_mutex;
 	CArchSocket			m_socket;
-	CStreamBuffer		m_inputBuffer;
 	CStreamBuffer		m_outputBuffer;
 	CCondVar<bool>		m_flushed;
-	bool				m_connected;
-	bool				m_readable;
-	bool				m_writable;
+	volatile bool		m_connected;
+	volatile bool		m_readable;
+	volatile bool		m_writable;
+
+	// true while m_outputBuffer has data.  set by the writer and cleared
+	// by the multiplexer, both with m_mutex locked.
+	volatile bool		m_outputPending;
+
+	// when the oldest data in m_outputBuffer was written to us, and
+	// whether to record how long it took to send
+	double				m_outputSince;
+	volatile bool		m_recordWriteLatency;
+
+	// only touched by the reader
+	mutable CStreamBuffer	m_inputBuffer;
+	mutable CInputChunk*	m_inputHead;
+
+	// only touched by the multiplexer
+	CInputChunk*		m_inputTail;
+	CInputChunk*		m_spareChunk;
+
+	// 1 while the reader has run out of input and is owed an inputReady
+	// event for the next chunk.  whoever swaps it back to 0 sends it.
+	mutable volatile long	m_inputIdle;
+
+	// set when the input has been shutdown;  the reader throws away what
+	// it has buffered the next time it looks at it
+	mutable volatile bool	m_inputDiscard;
 	IEventQueue*		m_events;
 	CSocketMultiplexer* m_socketMultiplexer;
 };
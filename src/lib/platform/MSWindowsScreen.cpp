@@ -39,6 +39,7 @@
 #include "base/Log.h"
 #include "base/String.h"
 #include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/TMethodEventJob.h"
 #include "base/TMethodJob.h"
 
@@ -921,7 +922,7 @@ CMSWindowsScreen::sendEvent(CEvent::Type type, void* data)
 void
 CMSWindowsScreen::sendClipboardEvent(CEvent::Type type, ClipboardID id)
 {
-	CClipboardInfo* info   = (CClipboardInfo*)malloc(sizeof(CClipboardInfo));
+	CClipboardInfo* info   = (CClipboardInfo*)CEventDataPool::alloc(sizeof(CClipboardInfo));
 	if(info == NULL) {
 		LOG((CLOG_ERR "malloc failed on %s:%s", __FILE__, __LINE__ ));
 		return;
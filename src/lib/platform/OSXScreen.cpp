@@ -36,6 +36,7 @@
 #include "arch/XArch.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/TMethodEventJob.h"
 #include "base/TMethodJob.h"
 
@@ -1029,7 +1030,7 @@ COSXScreen::sendEvent(CEvent::Type type, void* data) const
 void
 COSXScreen::sendClipboardEvent(CEvent::Type type, ClipboardID id) const
 {
-	CClipboardInfo* info   = (CClipboardInfo*)malloc(sizeof(CClipboardInfo));
+	CClipboardInfo* info   = (CClipboardInfo*)CEventDataPool::alloc(sizeof(CClipboardInfo));
 	info->m_id             = id;
 	info->m_sequenceNumber = m_sequenceNumber;
 	sendEvent(type, info);
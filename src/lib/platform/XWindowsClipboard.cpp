@@ -23,6 +23,7 @@
 #include "platform/XWindowsClipboardUTF8Converter.h"
 #include "platform/XWindowsClipboardHTMLConverter.h"
 #include "platform/XWindowsClipboardBMPConverter.h"
+#include "platform/XWindowsClipboardPNGConverter.h"
 #include "platform/XWindowsUtil.h"
 #include "mt/Thread.h"
 #include "arch/Arch.h"
@@ -46,7 +47,8 @@ CXWindowsClipboard::CXWindowsClipboard(Display* display,
 	m_time(0),
 	m_owner(false),
 	m_timeOwned(0),
-	m_timeLost(0)
+	m_timeLost(0),
+	m_maxReplySize(0)
 {
 	// get some atoms
 	m_atomTargets         = XInternAtom(m_display, "TARGETS", False);
@@ -75,10 +77,15 @@ CXWindowsClipboard::CXWindowsClipboard(Display* display,
 		break;
 	}
 
+	// leave room in each request for the property request itself,
+	// like XMaxRequestSize() based chunking always has
+	m_maxReplySize = 3 * (CXWindowsUtil::getMaxRequestSize(m_display) / 4);
+
 	// add converters, most desired first
 	m_converters.push_back(new CXWindowsClipboardHTMLConverter(m_display,
 								"text/html"));
 	m_converters.push_back(new CXWindowsClipboardBMPConverter(m_display));
+	m_converters.push_back(new CXWindowsClipboardPNGConverter(m_display));
 	m_converters.push_back(new CXWindowsClipboardUTF8Converter(m_display,
 								"text/plain;charset=UTF-8"));
 	m_converters.push_back(new CXWindowsClipboardUTF8Converter(m_display,
@@ -99,6 +106,7 @@ CXWindowsClipboard::CXWindowsClipboard(Display* display,
 CXWindowsClipboard::~CXWindowsClipboard()
 {
 	clearReplies();
+	clearReplyData();
 	clearConverters();
 }
 
@@ -164,28 +172,27 @@ CXWindowsClipboard::addSimpleRequest(Window requestor,
 	}
 
 	// handle targets
-	CString data;
+	CReplyData* data = NULL;
 	Atom type  = None;
 	int format = 0;
 	if (target == m_atomTargets) {
-		type = getTargetsData(data, &format);
+		data = new CReplyData;
+		type = getTargetsData(data->m_data, &format);
 	}
 	else if (target == m_atomTimestamp) {
-		type = getTimestampData(data, &format);
+		data = new CReplyData;
+		type = getTimestampData(data->m_data, &format);
 	}
 	else {
 		IXWindowsClipboardConverter* converter = getConverter(target);
 		if (converter != NULL) {
 			IClipboard::EFormat clipboardFormat = converter->getFormat();
 			if (m_added[clipboardFormat]) {
-				try {
-					data   = converter->fromIClipboard(m_data[clipboardFormat]);
+				data = getReplyData(target, converter);
+				if (data != NULL) {
 					format = converter->getDataSize();
 					type   = converter->getAtom();
 				}
-				catch (...) {
-					// ignore -- cannot convert
-				}
 			}
 		}
 	}
@@ -200,6 +207,9 @@ CXWindowsClipboard::addSimpleRequest(Window requestor,
 	else {
 		// failure
 		LOG((CLOG_DEBUG1 "failed"));
+		if (data != NULL) {
+			data->unref();
+		}
 		insertReply(new CReply(requestor, target, time));
 		return false;
 	}
@@ -308,6 +318,9 @@ CXWindowsClipboard::add(EFormat format, const CString& data)
 	m_data[format]  = data;
 	m_added[format] = true;
 
+	// previously converted data is stale now
+	clearReplyData();
+
 	// FIXME -- set motif clipboard item?
 }
 
@@ -467,6 +480,7 @@ CXWindowsClipboard::doClearCache()
 		m_data[index]  = "";
 		m_added[index] = false;
 	}
+	clearReplyData();
 }
 
 void
@@ -876,7 +890,7 @@ CXWindowsClipboard::insertMultipleReply(Window requestor,
 
 	// add reply for MULTIPLE request
 	insertReply(new CReply(requestor, m_atomMultiple,
-								time, property, CString(), None, 32));
+								time, property, new CReplyData, None, 32));
 
 	return true;
 }
@@ -994,12 +1008,12 @@ CXWindowsClipboard::sendReply(CReply* reply)
 
 		// send using INCR if already sending incrementally or if reply
 		// is too large, otherwise just send it.
-		const UInt32 maxRequestSize = 3 * XMaxRequestSize(m_display);
-		const bool useINCR = (reply->m_data.size() > maxRequestSize);
+		const CString& data = reply->m_data->m_data;
+		const bool useINCR  = (data.size() > m_maxReplySize);
 
 		// send INCR reply if incremental and we haven't replied yet
 		if (useINCR && !reply->m_replied) {
-			UInt32 size = reply->m_data.size();
+			UInt32 size = data.size();
 			if (!CXWindowsUtil::setWindowProperty(m_display,
 								reply->m_requestor, reply->m_property,
 								&size, 4, m_atomINCR, 32)) {
@@ -1010,14 +1024,14 @@ CXWindowsClipboard::sendReply(CReply* reply)
 		// send more INCR reply or entire non-incremental reply
 		else {
 			// how much more data should we send?
-			UInt32 size = reply->m_data.size() - reply->m_ptr;
-			if (size > maxRequestSize)
-				size = maxRequestSize;
+			UInt32 size = data.size() - reply->m_ptr;
+			if (size > m_maxReplySize)
+				size = m_maxReplySize;
 
 			// send it
 			if (!CXWindowsUtil::setWindowProperty(m_display,
 								reply->m_requestor, reply->m_property,
-								reply->m_data.data() + reply->m_ptr,
+								data.data() + reply->m_ptr,
 								size,
 								reply->m_type, reply->m_format)) {
 				failed = true;
@@ -1153,6 +1167,43 @@ CXWindowsClipboard::clearReplies(CReplyList& replies)
 	replies.clear();
 }
 
+CXWindowsClipboard::CReplyData*
+CXWindowsClipboard::getReplyData(Atom target,
+				IXWindowsClipboardConverter* converter)
+{
+	// convert at most once per clipboard change
+	CReplyDataMap::iterator index = m_replyData.find(target);
+	if (index == m_replyData.end()) {
+		CReplyData* data = new CReplyData;
+		try {
+			CString converted =
+				converter->fromIClipboard(m_data[converter->getFormat()]);
+			data->m_data.swap(converted);
+		}
+		catch (...) {
+			// cannot convert
+			data->unref();
+			return NULL;
+		}
+		index = m_replyData.insert(std::make_pair(target, data)).first;
+	}
+
+	// the caller gets its own reference
+	index->second->ref();
+	return index->second;
+}
+
+void
+CXWindowsClipboard::clearReplyData()
+{
+	// replies still being sent keep their data alive
+	for (CReplyDataMap::iterator index = m_replyData.begin();
+								index != m_replyData.end(); ++index) {
+		index->second->unref();
+	}
+	m_replyData.clear();
+}
+
 void
 CXWindowsClipboard::sendNotify(Window requestor,
 				Atom selection, Atom target, Atom property, Time time)
@@ -1488,7 +1539,7 @@ CXWindowsClipboard::CReply::CReply(Window requestor, Atom target, ::Time time) :
 	m_property(None),
 	m_replied(false),
 	m_done(false),
-	m_data(),
+	m_data(NULL),
 	m_type(None),
 	m_format(32),
 	m_ptr(0)
@@ -1497,7 +1548,7 @@ CXWindowsClipboard::CReply::CReply(Window requestor, Atom target, ::Time time) :
 }
 
 CXWindowsClipboard::CReply::CReply(Window requestor, Atom target, ::Time time,
-				Atom property, const CString& data, Atom type, int format) :
+				Atom property, CReplyData* data, Atom type, int format) :
 	m_requestor(requestor),
 	m_target(target),
 	m_time(time),
@@ -1511,3 +1562,37 @@ CXWindowsClipboard::CReply::CReply(Window requestor, Atom target, ::Time time,
 {
 	// do nothing
 }
+
+CXWindowsClipboard::CReply::~CReply()
+{
+	if (m_data != NULL) {
+		m_data->unref();
+	}
+}
+
+
+//
+// CXWindowsClipboard::CReplyData
+//
+
+CXWindowsClipboard::CReplyData::CReplyData() :
+	m_data(),
+	m_refCount(1)
+{
+	// do nothing
+}
+
+void
+CXWindowsClipboard::CReplyData::ref()
+{
+	++m_refCount;
+}
+
+void
+CXWindowsClipboard::CReplyData::unref()
+{
+	assert(m_refCount > 0);
+	if (--m_refCount == 0) {
+		delete this;
+	}
+}
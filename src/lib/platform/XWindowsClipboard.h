@@ -218,12 +218,32 @@ private:
 		SInt32			m_pad3[4];
 	};
 
+	// converted data for replies.  it's never modified once created
+	// and is shared by every reply for the same target until the
+	// clipboard changes, so concurrent requestors don't each get a
+	// copy.  it's deleted when the last reference is released.
+	class CReplyData {
+	public:
+		CReplyData();
+
+		void			ref();
+		void			unref();
+
+	public:
+		CString			m_data;
+
+	private:
+		int				m_refCount;
+	};
+	typedef std::map<Atom, CReplyData*> CReplyDataMap;
+
 	// stores data needed to respond to a selection request
 	class CReply {
 	public:
 		CReply(Window, Atom target, ::Time);
 		CReply(Window, Atom target, ::Time, Atom property,
-							const CString& data, Atom type, int format);
+							CReplyData* adoptedData, Atom type, int format);
+		~CReply();
 
 	public:
 		// information about the request
@@ -239,7 +259,7 @@ private:
 		bool			m_done;
 
 		// the data to send and its type and format
-		CString			m_data;
+		CReplyData*		m_data;
 		Atom			m_type;
 		int				m_format;
 
@@ -265,6 +285,13 @@ private:
 							Atom* actualTarget, CString* data) const;
 	Time				motifGetTime() const;
 
+	// get the data for target converted by converter, converting it
+	// if it isn't cached.  returns a new reference or NULL if the
+	// conversion failed.
+	CReplyData*			getReplyData(Atom target,
+							IXWindowsClipboardConverter* converter);
+	void				clearReplyData();
+
 	// reply methods
 	bool				insertMultipleReply(Window, ::Time, Atom);
 	void				insertReply(CReply*);
@@ -305,6 +332,12 @@ private:
 	bool				m_added[kNumFormats];
 	CString				m_data[kNumFormats];
 
+	// converted data for replies, by target
+	CReplyDataMap		m_replyData;
+
+	// largest property chunk to send to a requestor, in bytes
+	UInt32				m_maxReplySize;
+
 	// conversion request replies
 	CReplyMap			m_replies;
 	CReplyEventMask		m_eventMasks;
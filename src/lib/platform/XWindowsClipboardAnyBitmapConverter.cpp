@@ -185,7 +185,10 @@ CXWindowsClipboardAnyBitmapConverter::toIClipboard(const CString& image) const
 	toLE(dst, static_cast<UInt32>(0));
 	toLE(dst, static_cast<UInt32>(0));
 
-	// construct image
-	return CString(reinterpret_cast<const char*>(infoHeader),
-							sizeof(infoHeader)) + rawBMP;
+	// construct image in one buffer
+	CString bmp;
+	bmp.reserve(sizeof(infoHeader) + rawBMP.size());
+	bmp.append(reinterpret_cast<const char*>(infoHeader), sizeof(infoHeader));
+	bmp.append(rawBMP);
+	return bmp;
 }
@@ -24,9 +24,13 @@
 #include "base/IEventQueue.h"
 
 #include <fcntl.h>
+#include <cmath>
 #if HAVE_UNISTD_H
 #	include <unistd.h>
 #endif
+#if HAVE_SYS_EVENTFD_H
+#	include <sys/eventfd.h>
+#endif
 #if HAVE_POLL
 #	include <poll.h>
 #else
@@ -54,31 +58,37 @@ class CEventQueueTimer { };
 
 CXWindowsEventQueueBuffer::CXWindowsEventQueueBuffer(
 		Display* display, Window window, IEventQueue* events) :
-	m_events(events),
 	m_display(display),
 	m_window(window),
-	m_waiting(false)
+	m_xEventsFirst(-1),
+	m_events(events)
 {
 	assert(m_display != NULL);
 	assert(m_window  != None);
 
-	m_userEvent = XInternAtom(m_display, "SYNERGY_USER_EVENT", False);
-	// set up for pipe hack
-	int result = pipe(m_pipefd);
+	// set up the descriptor addEvent() uses to wake waitForEvent()
+#if HAVE_SYS_EVENTFD_H
+	m_wakefd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_wakefd[1] = m_wakefd[0];
+	assert(m_wakefd[0] != -1);
+#else
+	int result = pipe(m_wakefd);
 	assert(result == 0);
 
 	int pipeflags;
-	pipeflags = fcntl(m_pipefd[0], F_GETFL);
-	fcntl(m_pipefd[0], F_SETFL, pipeflags | O_NONBLOCK);
-	pipeflags = fcntl(m_pipefd[1], F_GETFL);
-	fcntl(m_pipefd[1], F_SETFL, pipeflags | O_NONBLOCK);
+	pipeflags = fcntl(m_wakefd[0], F_GETFL);
+	fcntl(m_wakefd[0], F_SETFL, pipeflags | O_NONBLOCK);
+	pipeflags = fcntl(m_wakefd[1], F_GETFL);
+	fcntl(m_wakefd[1], F_SETFL, pipeflags | O_NONBLOCK);
+#endif
 }
 
 CXWindowsEventQueueBuffer::~CXWindowsEventQueueBuffer()
 {
-	// release pipe hack resources
-	close(m_pipefd[0]);
-	close(m_pipefd[1]);
+	close(m_wakefd[0]);
+	if (m_wakefd[1] != m_wakefd[0]) {
+		close(m_wakefd[1]);
+	}
 }
 
 void
@@ -86,43 +96,38 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 {
 	CThread::testCancel();
 
-	// clear out the pipe in preparation for waiting.
-
-	char buf[16];
-	ssize_t read_response = read(m_pipefd[0], buf, 15);
-	
-	// with linux automake, warnings are treated as errors by default
-	if (read_response < 0)
-	{
-		// todo: handle read response
-	}
-
+	// don't wait if a user event is queued.  addEvent() signals the
+	// wake descriptor after queueing so a user event added from here
+	// on makes the poll() below return immediately.
 	{
 		CLock lock(&m_mutex);
-		// we're now waiting for events
-		m_waiting = true;
-
-		// push out pending events
-		flush();
+		if (!m_postedEvents.empty()) {
+			return;
+		}
 	}
-	// calling flush may have queued up a new event.
-	if (!CXWindowsEventQueueBuffer::isEmpty()) {
+
+	// push out our requests and read whatever the X server has sent.
+	// Xlib may now have events buffered that will never make the
+	// connection readable again so don't wait if it has any.
+	if (XPending(m_display) > 0) {
 		CThread::testCancel();
 		return;
 	}
 
-	// use poll() to wait for a message from the X server or for timeout.
-	// this is a good deal more efficient than polling and sleeping.
+	// wait for the X server, a user event or the timeout.  round the
+	// timeout up so we don't wake just before a timer expires and
+	// then spin until it does.
 #if HAVE_POLL
 	struct pollfd pfds[2];
 	pfds[0].fd     = ConnectionNumber(m_display);
 	pfds[0].events = POLLIN;
-	pfds[1].fd     = m_pipefd[0];
+	pfds[1].fd     = m_wakefd[0];
 	pfds[1].events = POLLIN;
 	int timeout    = (dtimeout < 0.0) ? -1 :
-						static_cast<int>(1000.0 * dtimeout);
-	int remaining  =  timeout;
-	int retval     =  0;
+						static_cast<int>(ceil(1000.0 * dtimeout));
+	if (poll(pfds, 2, timeout) > 0 && (pfds[1].revents & POLLIN) != 0) {
+		drainWake();
+	}
 #else
 	struct timeval timeout;
 	struct timeval* timeoutPtr;
@@ -131,8 +136,8 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 	}
 	else {
 		timeout.tv_sec  = static_cast<int>(dtimeout);
-		timeout.tv_usec = static_cast<int>(1.0e+6 *
-								(dtimeout - timeout.tv_sec));
+		timeout.tv_usec = static_cast<int>(ceil(1.0e+6 *
+								(dtimeout - timeout.tv_sec)));
 		timeoutPtr      = &timeout;
 	}
 
@@ -140,59 +145,24 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 	fd_set rfds;
 	FD_ZERO(&rfds);
 	FD_SET(ConnectionNumber(m_display), &rfds);
-	FD_SET(m_pipefd[0], &rfds);
- 	int nfds;
- 	if (ConnectionNumber(m_display) > m_pipefd[0]) {
- 		nfds = ConnectionNumber(m_display) + 1;
- 	}
- 	else {
- 		nfds = m_pipefd[0] + 1;
- 	}
-#endif
-	// It's possible that the X server has queued events locally
-	// in xlib's event buffer and not pushed on to the fd. Hence we
-	// can't simply monitor the fd as we may never be woken up.
-	// ie addEvent calls flush, XFlush may not send via the fd hence
-	// there is an event waiting to be sent but we must exit the poll
-	// before it can.
-	// Instead we poll for a brief period of time (so if events
-	// queued locally in the xlib buffer can be processed)
-	// and continue doing this until timeout is reached.
-	// The human eye can notice 60hz (ansi) which is 16ms, however
-	// we want to give the cpu a chance s owe up this to 25ms
-#define TIMEOUT_DELAY 25
-
-	while( ((dtimeout < 0.0) || (remaining > 0)) && QLength(m_display)==0 && retval==0){
-#if HAVE_POLL
-	retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
- 	if (pfds[1].revents & POLLIN) {
- 		ssize_t read_response = read(m_pipefd[0], buf, 15);
-		
-		// with linux automake, warnings are treated as errors by default
-		if (read_response < 0)
-		{
-			// todo: handle read response
-		}
-
- 	}
-#else
-	retval = select(nfds,
-						SELECT_TYPE_ARG234 &rfds,
-						SELECT_TYPE_ARG234 NULL,
-						SELECT_TYPE_ARG234 NULL,
-						SELECT_TYPE_ARG5   TIMEOUT_DELAY);
-	if (FD_SET(m_pipefd[0], &rfds)) {
-		read(m_pipefd[0], buf, 15);
+	FD_SET(m_wakefd[0], &rfds);
+	int nfds;
+	if (ConnectionNumber(m_display) > m_wakefd[0]) {
+		nfds = ConnectionNumber(m_display) + 1;
 	}
-#endif
-	    remaining-=TIMEOUT_DELAY;
+	else {
+		nfds = m_wakefd[0] + 1;
 	}
 
-	{
-		// we're no longer waiting for events
-		CLock lock(&m_mutex);
-		m_waiting = false;
+	if (select(nfds,
+				SELECT_TYPE_ARG234 &rfds,
+				SELECT_TYPE_ARG234 NULL,
+				SELECT_TYPE_ARG234 NULL,
+				SELECT_TYPE_ARG5   timeoutPtr) > 0 &&
+			FD_ISSET(m_wakefd[0], &rfds)) {
+		drainWake();
 	}
+#endif
 
 	CThread::testCancel();
 }
@@ -200,59 +170,48 @@ CXWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 IEventQueueBuffer::Type
 CXWindowsEventQueueBuffer::getEvent(CEvent& event, UInt32& dataID)
 {
-	CLock lock(&m_mutex);
-
-	// push out pending events
-	flush();
+	{
+		CLock lock(&m_mutex);
+		if (!m_postedEvents.empty()) {
+			// a user event goes after the X events we'd already
+			// received when we first saw it.  this keeps user events
+			// from jumping ahead of input that arrived before them.
+			// handlers may have taken some of those X events off the
+			// queue themselves since, so never wait for more than are
+			// still there.
+			int queued = QLength(m_display);
+			if (m_xEventsFirst < 0 || m_xEventsFirst > queued) {
+				m_xEventsFirst = queued;
+			}
+			if (m_xEventsFirst == 0) {
+				m_xEventsFirst = -1;
+				dataID = m_postedEvents.front();
+				m_postedEvents.pop_front();
+				return kUser;
+			}
+			--m_xEventsFirst;
+		}
+	}
 
 	// get next event
 	XNextEvent(m_display, &m_event);
-
-	// process event
-	if (m_event.xany.type == ClientMessage &&
-		m_event.xclient.message_type == m_userEvent) {
-		dataID = static_cast<UInt32>(m_event.xclient.data.l[0]);
-		return kUser;
-	}
-	else {
-		event = CEvent(CEvent::kSystem,
-							m_events->getSystemTarget(), &m_event);
-		return kSystem;
-	}
+	event = CEvent(CEvent::kSystem, m_events->getSystemTarget(), &m_event);
+	return kSystem;
 }
 
 bool
 CXWindowsEventQueueBuffer::addEvent(UInt32 dataID)
 {
-	// prepare a message
-	XEvent xevent;
-	xevent.xclient.type         = ClientMessage;
-	xevent.xclient.window       = m_window;
-	xevent.xclient.message_type = m_userEvent;
-	xevent.xclient.format       = 32;
-	xevent.xclient.data.l[0]    = static_cast<long>(dataID);
-
-	// save the message
-	CLock lock(&m_mutex);
-	m_postedEvents.push_back(xevent);
-
-	// if we're currently waiting for an event then send saved events to
-	// the X server now.  if we're not waiting then some other thread
-	// might be using the display connection so we can't safely use it
-	// too.
-	if (m_waiting) {
-		flush();
-		// Send a character through the round-trip pipe to wake a thread
-		// that is waiting for a ConnectionNumber() socket to be readable.
-		// The flush call can read incoming data from the socket and put
-		// it in Xlib's input buffer.  That sneaks it past the other thread.
-		ssize_t write_response = write(m_pipefd[1], "!", 1);
-
-		// with linux automake, warnings are treated as errors by default
-		if (write_response < 0)
-		{
-			// todo: handle read response
-		}
+	// save the event and wake the event thread if it's waiting.  we
+	// never touch the display here;  another thread may be using it.
+	bool wasEmpty;
+	{
+		CLock lock(&m_mutex);
+		wasEmpty = m_postedEvents.empty();
+		m_postedEvents.push_back(dataID);
+	}
+	if (wasEmpty) {
+		wake();
 	}
 
 	return true;
@@ -261,8 +220,13 @@ CXWindowsEventQueueBuffer::addEvent(UInt32 dataID)
 bool
 CXWindowsEventQueueBuffer::isEmpty() const
 {
-	CLock lock(&m_mutex);
-	return (XPending(m_display) == 0 );
+	{
+		CLock lock(&m_mutex);
+		if (!m_postedEvents.empty()) {
+			return false;
+		}
+	}
+	return (XPending(m_display) == 0);
 }
 
 CEventQueueTimer*
@@ -278,14 +242,25 @@ CXWindowsEventQueueBuffer::deleteTimer(CEventQueueTimer* timer) const
 }
 
 void
-CXWindowsEventQueueBuffer::flush()
+CXWindowsEventQueueBuffer::wake()
 {
-	// note -- m_mutex must be locked on entry
+#if HAVE_SYS_EVENTFD_H
+	const uint64_t one = 1;
+	ssize_t write_response = write(m_wakefd[1], &one, sizeof(one));
+#else
+	ssize_t write_response = write(m_wakefd[1], "!", 1);
+#endif
+
+	// a full pipe (or saturated eventfd) is already readable so a
+	// failed write loses nothing
+	(void)write_response;
+}
 
-	// flush the posted event list to the X server
-	for (size_t i = 0; i < m_postedEvents.size(); ++i) {
-		XSendEvent(m_display, m_window, False, 0, &m_postedEvents[i]);
+void
+CXWindowsEventQueueBuffer::drainWake()
+{
+	char buf[64];
+	while (read(m_wakefd[0], buf, sizeof(buf)) > 0) {
+		// discard
 	}
-	XFlush(m_display);
-	m_postedEvents.clear();
 }
@@ -20,7 +20,7 @@
 
 #include "mt/Mutex.h"
 #include "base/IEventQueueBuffer.h"
-#include "common/stdvector.h"
+#include "common/stddeque.h"
 
 #if X_DISPLAY_MISSING
 #	error X11 is required to build synergy
@@ -31,6 +31,13 @@
 class IEventQueue;
 
 //! Event queue buffer for X11
+/*!
+User events are kept in a local queue rather than being sent through
+the X server.  waitForEvent() blocks in a single poll() on the X
+connection and a wake descriptor (an eventfd where available, else a
+pipe) that addEvent() signals, so an idle queue never wakes up until
+an X event, a user event or the timeout arrives.
+*/
 class CXWindowsEventQueueBuffer : public IEventQueueBuffer {
 public:
 	CXWindowsEventQueueBuffer(Display*, Window, IEventQueue* events);
@@ -47,18 +54,18 @@ public:
 	virtual void		deleteTimer(CEventQueueTimer*) const;
 
 private:
-	void				flush();
+	void				wake();
+	void				drainWake();
 
 private:
-	typedef std::vector<XEvent> CEventList;
+	typedef std::deque<UInt32> CEventDeque;
 
 	CMutex				m_mutex;
 	Display*			m_display;
 	Window				m_window;
-	Atom				m_userEvent;
 	XEvent				m_event;
-	CEventList			m_postedEvents;
-	bool				m_waiting;
-	int					m_pipefd[2];
+	CEventDeque			m_postedEvents;
+	int					m_xEventsFirst;
+	int					m_wakefd[2];
 	IEventQueue*		m_events;
 };
@@ -203,6 +203,25 @@ CXWindowsKeyState::pollActiveGroup() const
 	return 0;
 }
 
+void
+CXWindowsKeyState::pollActiveModifiersAndGroup(KeyModifierMask& mask,
+				SInt32& group) const
+{
+#if HAVE_XKB_EXTENSION
+	// one request gets both the modifiers and the group
+	if (m_xkb != NULL) {
+		XkbStateRec state;
+		if (XkbGetState(m_display, XkbUseCoreKbd, &state) == Success) {
+			mask  = mapModifiersFromX(XkbBuildCoreState(state.mods,
+														state.group));
+			group = (m_group >= 0) ? m_group : state.group;
+			return;
+		}
+	}
+#endif
+	CKeyState::pollActiveModifiersAndGroup(mask, group);
+}
+
 void
 CXWindowsKeyState::pollPressedKeys(KeyButtonSet& pressedKeys) const
 {
@@ -293,7 +312,6 @@ CXWindowsKeyState::fakeKey(const Keystroke& keystroke)
 		}
 		break;
 	}
-	XFlush(m_display);
 }
 
 void
@@ -114,6 +114,8 @@ protected:
 	// CKeyState overrides
 	virtual void		getKeyMap(CKeyMap& keyMap);
 	virtual void		fakeKey(const Keystroke& keystroke);
+	virtual void		pollActiveModifiersAndGroup(KeyModifierMask& mask,
+							SInt32& group) const;
 
 private:
 	void				init(Display* display, bool useXKB);
@@ -29,9 +29,11 @@
 #include "arch/XArch.h"
 #include "arch/Arch.h"
 #include "base/Log.h"
+#include "base/LatencyStats.h"
 #include "base/Stopwatch.h"
 #include "base/String.h"
 #include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstring>
@@ -102,6 +104,7 @@ CXWindowsScreen::CXWindowsScreen(
 	m_root(None),
 	m_window(None),
 	m_xCenter(0), m_yCenter(0),
+	m_warpSize(32),
 	m_xCursor(0), m_yCursor(0),
 	m_keyState(NULL),
 	m_lastFocus(None),
@@ -116,6 +119,10 @@ CXWindowsScreen::CXWindowsScreen(
 	m_preserveFocus(false),
 	m_xkb(false),
 	m_xi2detected(false),
+	m_xi2RawMotion(false),
+	m_xi2AbsoluteMotion(false),
+	m_xRawDelta(0.0),
+	m_yRawDelta(0.0),
 	m_xrandr(false),
 	m_events(events)
 {
@@ -161,6 +168,7 @@ CXWindowsScreen::CXWindowsScreen(
 		if (m_xi2detected) {
 #ifdef HAVE_XI2
 			selectXIRawMotion();
+			m_xi2RawMotion = m_isPrimary;
 #endif
 		} else
 		{
@@ -371,6 +379,13 @@ CXWindowsScreen::leave()
 		m_filtered.clear();
 	}
 
+#ifdef HAVE_XI2
+	// devices come and go and their ids get reused, so find out again
+	// which are relative
+	m_xi2RelativeDevices.clear();
+	m_xi2AbsoluteMotion = false;
+#endif
+
 	// now off screen
 	m_isOnScreen = false;
 
@@ -472,6 +487,14 @@ CXWindowsScreen::isPrimary() const
 	return m_isPrimary;
 }
 
+void
+CXWindowsScreen::setInputChannel(CInputChannel* channel)
+{
+	CPlatformScreen::setInputChannel(channel);
+	m_keyState->setInputChannel(channel);
+	m_screensaver->setInputChannel(channel);
+}
+
 void*
 CXWindowsScreen::getEventTarget() const
 {
@@ -531,8 +554,9 @@ CXWindowsScreen::reconfigure(UInt32)
 void
 CXWindowsScreen::warpCursor(SInt32 x, SInt32 y)
 {
-	// warp mouse
+	// warp mouse and wait for the server to process it
 	warpCursorNoFlush(x, y);
+	XSync(m_display, False);
 
 	// remove all input events before and including warp
 	XEvent event;
@@ -824,7 +848,6 @@ CXWindowsScreen::fakeMouseButton(ButtonID button, bool press)
 	if (xButton != 0) {
 		XTestFakeButtonEvent(m_display, xButton,
 							press ? True : False, CurrentTime);
-		XFlush(m_display);
 	}
 }
 
@@ -838,7 +861,6 @@ CXWindowsScreen::fakeMouseMove(SInt32 x, SInt32 y)
 		XTestFakeMotionEvent(m_display, DefaultScreen(m_display),
 							x, y, CurrentTime);
 	}
-	XFlush(m_display);
 
 	// Remember we asked for this.
 	pushMouseMove(x, y);
@@ -854,7 +876,6 @@ CXWindowsScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
 	else {
 		XTestFakeRelativeMotionEvent(m_display, dx, dy, CurrentTime);
 	}
-	XFlush(m_display);
 }
 
 void
@@ -900,6 +921,14 @@ CXWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
 		XTestFakeButtonEvent(m_display, xButton, True, CurrentTime);
 		XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
+}
+
+void
+CXWindowsScreen::flushFakeInput()
+{
+	// the fake methods above leave their requests in xlib's output
+	// buffer.  anything not flushed here goes out when the event loop
+	// next checks for events.
 	XFlush(m_display);
 }
 
@@ -993,6 +1022,7 @@ CXWindowsScreen::saveShape()
 	// get center of default screen
 	m_xCenter = m_x + (m_w >> 1);
 	m_yCenter = m_y + (m_h >> 1);
+	SInt32 wCenter = m_w, hCenter = m_h;
 
 	// check if xinerama is enabled and there is more than one screen.
 	// get center of first Xinerama screen.  Xinerama appears to have
@@ -1020,11 +1050,20 @@ CXWindowsScreen::saveShape()
 				m_xinerama = true;
 				m_xCenter  = screens[0].x_org + (screens[0].width  >> 1);
 				m_yCenter  = screens[0].y_org + (screens[0].height >> 1);
+				wCenter    = screens[0].width;
+				hCenter    = screens[0].height;
 			}
 			XFree(screens);
 		}
 	}
 #endif
+
+	// let the cursor roam over the middle half of the screen we warp
+	// to before warping it back to the center
+	m_warpSize = ((wCenter < hCenter) ? wCenter : hCenter) >> 2;
+	if (m_warpSize < 32) {
+		m_warpSize = 32;
+	}
 }
 
 Window
@@ -1151,12 +1190,56 @@ CXWindowsScreen::sendEvent(CEvent::Type type, void* data)
 void
 CXWindowsScreen::sendClipboardEvent(CEvent::Type type, ClipboardID id)
 {
-	CClipboardInfo* info   = (CClipboardInfo*)malloc(sizeof(CClipboardInfo));
+	CClipboardInfo* info   = (CClipboardInfo*)CEventDataPool::alloc(sizeof(CClipboardInfo));
 	info->m_id             = id;
 	info->m_sequenceNumber = m_sequenceNumber;
 	sendEvent(type, info);
 }
 
+void
+CXWindowsScreen::sendMotion(CInputChannel::CInput::EType type,
+				SInt32 x, SInt32 y)
+{
+	if (m_inputChannel != NULL) {
+		m_inputChannel->sendMotion(type, x, y);
+		return;
+	}
+
+	switch (type) {
+	case CInputChannel::CInput::kMotionOnPrimary:
+		sendEvent(m_events->forIPrimaryScreen().motionOnPrimary(),
+							CMotionInfo::alloc(x, y));
+		break;
+
+	case CInputChannel::CInput::kMotionOnSecondary:
+		sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(),
+							CMotionInfo::alloc(x, y));
+		break;
+
+	default:
+		sendEvent(m_events->forIPrimaryScreen().wheel(),
+							CWheelInfo::alloc(x, y));
+		break;
+	}
+}
+
+void
+CXWindowsScreen::sendButton(CInputChannel::CInput::EType type,
+				ButtonID button, KeyModifierMask mask)
+{
+	if (m_inputChannel != NULL) {
+		m_inputChannel->sendButton(type, button, mask);
+	}
+	else if (type == CInputChannel::CInput::kButtonDown) {
+		sendEvent(m_events->forIPrimaryScreen().buttonDown(),
+							CButtonInfo::alloc(button, mask));
+	}
+	else {
+		sendEvent(m_events->forIPrimaryScreen().buttonUp(),
+							CButtonInfo::alloc(button, mask));
+	}
+}
+
 IKeyState*
 CXWindowsScreen::getKeyState() const
 {
@@ -1265,31 +1348,23 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 	if (m_isPrimary && m_xi2detected) {
 		// Process RawMotion
 		XGenericEventCookie *cookie = (XGenericEventCookie*)&xevent->xcookie;
-			if (XGetEventData(m_display, cookie) &&
-				cookie->type == GenericEvent &&
-				cookie->extension == xi_opcode) {
+		if (XGetEventData(m_display, cookie) &&
+			cookie->type == GenericEvent &&
+			cookie->extension == xi_opcode) {
 			if (cookie->evtype == XI_RawMotion) {
-				// Get current pointer's position
-				Window root, child;
-				XMotionEvent xmotion;
-				xmotion.type = MotionNotify;
-				xmotion.send_event = False; // Raw motion
-				xmotion.display = m_display;
-				xmotion.window = m_window;
-				/* xmotion's time, state and is_hint are not used */
-				unsigned int msk;
-					xmotion.same_screen = XQueryPointer(
-						m_display, m_root, &xmotion.root, &xmotion.subwindow,
-						&xmotion.x_root,
-						&xmotion.y_root,
-						&xmotion.x,
-						&xmotion.y,
-						&msk);
-					onMouseMove(xmotion);
-					XFreeEventData(m_display, cookie);
-					return;
+				{
+					CLatencyTimer timer(CLatencyStats::kCapture);
+					if (m_isOnScreen) {
+						onRawMotionOnScreen();
+					}
+					else {
+						onRawMotionOffScreen(cookie);
+					}
+				}
+				XFreeEventData(m_display, cookie);
+				return;
 			}
-        		XFreeEventData(m_display, cookie);
+			XFreeEventData(m_display, cookie);
 		}
 	}
 #endif
@@ -1375,31 +1450,38 @@ CXWindowsScreen::handleSystemEvent(const CEvent& event, void*)
 
 	case KeyPress:
 		if (m_isPrimary) {
+			CLatencyTimer timer(CLatencyStats::kCapture);
 			onKeyPress(xevent->xkey);
 		}
 		return;
 
 	case KeyRelease:
 		if (m_isPrimary) {
+			CLatencyTimer timer(CLatencyStats::kCapture);
 			onKeyRelease(xevent->xkey, isRepeat);
 		}
 		return;
 
 	case ButtonPress:
 		if (m_isPrimary) {
+			CLatencyTimer timer(CLatencyStats::kCapture);
 			onMousePress(xevent->xbutton);
 		}
 		return;
 
 	case ButtonRelease:
 		if (m_isPrimary) {
+			CLatencyTimer timer(CLatencyStats::kCapture);
 			onMouseRelease(xevent->xbutton);
 		}
 		return;
 
 	case MotionNotify:
 		if (m_isPrimary) {
-			onMouseMove(xevent->xmotion);
+			CLatencyTimer timer(CLatencyStats::kCapture);
+			XMotionEvent xmotion = xevent->xmotion;
+			coalesceMotion(xmotion);
+			onMouseMove(xmotion);
 		}
 		else {
 			onMotionNotify(xevent->xmotion.x_root, xevent->xmotion.y_root);
@@ -1549,10 +1631,16 @@ CXWindowsScreen::onHotKey(XKeyEvent& xkey, bool isRepeat)
 		return false;
 	}
 
-	// generate event (ignore key repeats)
+	// generate event (ignore key repeats).  keys typed before and after
+	// the hot key mustn't be handled on the wrong side of it.
 	if (!isRepeat) {
-		m_events->addEvent(CEvent(type, getEventTarget(),
-								CHotKeyInfo::alloc(i->second)));
+		CEvent event(type, getEventTarget(), CHotKeyInfo::alloc(i->second));
+		if (m_inputChannel != NULL) {
+			m_inputChannel->addEvent(event);
+		}
+		else {
+			m_events->addEvent(event);
+		}
 	}
 	return true;
 }
@@ -1564,7 +1652,7 @@ CXWindowsScreen::onMousePress(const XButtonEvent& xbutton)
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
-		sendEvent(m_events->forIPrimaryScreen().buttonDown(), CButtonInfo::alloc(button, mask));
+		sendButton(CInputChannel::CInput::kButtonDown, button, mask);
 	}
 }
 
@@ -1575,15 +1663,15 @@ CXWindowsScreen::onMouseRelease(const XButtonEvent& xbutton)
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
-		sendEvent(m_events->forIPrimaryScreen().buttonUp(), CButtonInfo::alloc(button, mask));
+		sendButton(CInputChannel::CInput::kButtonUp, button, mask);
 	}
 	else if (xbutton.button == 4) {
 		// wheel forward (away from user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), CWheelInfo::alloc(0, 120));
+		sendMotion(CInputChannel::CInput::kWheel, 0, 120);
 	}
 	else if (xbutton.button == 5) {
 		// wheel backward (toward user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), CWheelInfo::alloc(0, -120));
+		sendMotion(CInputChannel::CInput::kWheel, 0, -120);
 	}
 	// XXX -- support x-axis scrolling
 }
@@ -1621,8 +1709,13 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 	}
 	else if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(m_events->forIPrimaryScreen().motionOnPrimary(),
-							CMotionInfo::alloc(m_xCursor, m_yCursor));
+		sendMotion(CInputChannel::CInput::kMotionOnPrimary,
+							m_xCursor, m_yCursor);
+	}
+	else if (m_xi2RawMotion && !m_xi2AbsoluteMotion) {
+		// motion on secondary screen comes from the raw XI2
+		// events (see onRawMotionOffScreen()) and the mouse
+		// stays where it is, so there's nothing to do.
 	}
 	else {
 		// motion on secondary screen.  warp mouse back to
@@ -1636,12 +1729,13 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// big deal (we're just limited to every other
 		// pixel) but the latter is a PITA.  to work around
 		// it we only warp when the mouse has moved more
-		// than s_size pixels from the center.
-		static const SInt32 s_size = 32;
-		if (xmotion.x_root - m_xCenter < -s_size ||
-			xmotion.x_root - m_xCenter >  s_size ||
-			xmotion.y_root - m_yCenter < -s_size ||
-			xmotion.y_root - m_yCenter >  s_size) {
+		// than m_warpSize pixels from the center.  that
+		// also keeps the number of warps (and the round
+		// trips discarding their events) down.
+		if (xmotion.x_root - m_xCenter < -m_warpSize ||
+			xmotion.x_root - m_xCenter >  m_warpSize ||
+			xmotion.y_root - m_yCenter < -m_warpSize ||
+			xmotion.y_root - m_yCenter >  m_warpSize) {
 			warpCursorNoFlush(m_xCenter, m_yCenter);
 		}
 
@@ -1652,11 +1746,180 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// warping to the primary screen's enter position,
 		// effectively overriding it.
 		if (x != 0 || y != 0) {
-			sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(), CMotionInfo::alloc(x, y));
+			sendMotion(CInputChannel::CInput::kMotionOnSecondary, x, y);
 		}
 	}
 }
 
+#ifdef HAVE_XI2
+bool
+CXWindowsScreen::nextEventIsRawMotion() const
+{
+	if (XEventsQueued(m_display, QueuedAfterReading) == 0) {
+		return false;
+	}
+	XEvent xnext;
+	XPeekEvent(m_display, &xnext);
+	return (xnext.xcookie.type      == GenericEvent &&
+			xnext.xcookie.extension == xi_opcode &&
+			xnext.xcookie.evtype    == XI_RawMotion);
+}
+
+void
+CXWindowsScreen::onRawMotionOnScreen()
+{
+	// only the latest position matters so skip any raw motion queued
+	// right behind this one.  that saves a round trip per skipped
+	// event.
+	XEvent xnext;
+	while (nextEventIsRawMotion()) {
+		XNextEvent(m_display, &xnext);
+	}
+
+	// get current pointer's position
+	XMotionEvent xmotion;
+	xmotion.type       = MotionNotify;
+	xmotion.send_event = False; // Raw motion
+	xmotion.display    = m_display;
+	xmotion.window     = m_window;
+	/* xmotion's time, state and is_hint are not used */
+	unsigned int msk;
+	xmotion.same_screen = XQueryPointer(
+						m_display, m_root, &xmotion.root, &xmotion.subwindow,
+						&xmotion.x_root,
+						&xmotion.y_root,
+						&xmotion.x,
+						&xmotion.y,
+						&msk);
+	onMouseMove(xmotion);
+}
+
+void
+CXWindowsScreen::onRawMotionOffScreen(XGenericEventCookie* cookie)
+{
+	// use the unaccelerated deltas of this and any raw motion queued
+	// right behind it as the motion on the secondary screen.  unlike
+	// MotionNotify this needs neither a round trip nor warping the
+	// mouse back to the center.
+	double dx = 0.0, dy = 0.0;
+	bool relative = addRawDelta(static_cast<XIRawEvent*>(cookie->data),
+							dx, dy);
+	XEvent xnext;
+	while (nextEventIsRawMotion()) {
+		XNextEvent(m_display, &xnext);
+		if (XGetEventData(m_display, &xnext.xcookie)) {
+			relative = addRawDelta(
+							static_cast<XIRawEvent*>(xnext.xcookie.data),
+							dx, dy);
+			XFreeEventData(m_display, &xnext.xcookie);
+		}
+	}
+
+	// an absolute device moved the mouse last.  its MotionNotify is
+	// handled like without XI2, by warping to the center.
+	m_xi2AbsoluteMotion = !relative;
+
+	// carry fractions of a pixel over to the next motion
+	m_xRawDelta += dx;
+	m_yRawDelta += dy;
+	SInt32 x = static_cast<SInt32>(m_xRawDelta);
+	SInt32 y = static_cast<SInt32>(m_yRawDelta);
+	m_xRawDelta -= x;
+	m_yRawDelta -= y;
+
+	LOG((CLOG_DEBUG2 "event: RawMotion %+d,%+d", x, y));
+	if (x != 0 || y != 0) {
+		sendMotion(CInputChannel::CInput::kMotionOnSecondary, x, y);
+	}
+}
+
+bool
+CXWindowsScreen::addRawDelta(const XIRawEvent* raw, double& dx, double& dy)
+{
+	// the raw values of an absolute device are positions
+	if (!isRelativeDevice(raw->sourceid)) {
+		return false;
+	}
+
+	// raw_values holds one value for each valuator set in the mask.
+	// valuators 0 and 1 are the x and y axes.
+	const double* value = raw->raw_values;
+	for (int i = 0; i < 2 && i < raw->valuators.mask_len * 8; ++i) {
+		if (XIMaskIsSet(raw->valuators.mask, i)) {
+			if (i == 0) {
+				dx += *value;
+			}
+			else {
+				dy += *value;
+			}
+			++value;
+		}
+	}
+	return true;
+}
+
+bool
+CXWindowsScreen::isRelativeDevice(int deviceid)
+{
+	CRelativeDeviceMap::const_iterator i = m_xi2RelativeDevices.find(deviceid);
+	if (i != m_xi2RelativeDevices.end()) {
+		return i->second;
+	}
+
+	// a device is relative if its x axis is.  one we can't query is
+	// taken as absolute so we fall back to warping.
+	bool relative = false;
+	int n;
+	XIDeviceInfo* info = XIQueryDevice(m_display, deviceid, &n);
+	if (info != NULL) {
+		for (int j = 0; j < info->num_classes; ++j) {
+			const XIAnyClassInfo* any = info->classes[j];
+			if (any->type == XIValuatorClass) {
+				const XIValuatorClassInfo* valuator =
+					reinterpret_cast<const XIValuatorClassInfo*>(any);
+				if (valuator->number == 0) {
+					relative = (valuator->mode == XIModeRelative);
+					break;
+				}
+			}
+		}
+		XIFreeDeviceInfo(info);
+	}
+	LOG((CLOG_DEBUG "XI2 device %d is %s", deviceid,
+							relative ? "relative" : "absolute"));
+	m_xi2RelativeDevices.insert(std::make_pair(deviceid, relative));
+	return relative;
+}
+#endif
+
+void
+CXWindowsScreen::coalesceMotion(XMotionEvent& xmotion) const
+{
+	// replace xmotion with the last of the MotionNotify events queued
+	// directly behind it.  onMouseMove() works with the delta to the
+	// last position so nothing is lost, except that we must stop at
+	// our own warp markers (see warpCursorNoFlush()) and, when on
+	// screen, at a screen edge so the server still sees the cursor
+	// reach the edge.
+	XEvent xevent;
+	while (!(m_isOnScreen && isMotionAtEdge(xmotion)) &&
+			XEventsQueued(m_display, QueuedAfterReading) > 0) {
+		XPeekEvent(m_display, &xevent);
+		if (xevent.type != MotionNotify || xevent.xmotion.send_event) {
+			break;
+		}
+		XNextEvent(m_display, &xevent);
+		xmotion = xevent.xmotion;
+	}
+}
+
+bool
+CXWindowsScreen::isMotionAtEdge(const XMotionEvent& xmotion) const
+{
+	return (xmotion.x_root <= m_x || xmotion.x_root >= m_x + m_w - 1 ||
+			xmotion.y_root <= m_y || xmotion.y_root >= m_y + m_h - 1);
+}
+
 Cursor
 CXWindowsScreen::createBlankCursor() const
 {
@@ -1939,9 +2202,11 @@ CXWindowsScreen::warpCursorNoFlush(SInt32 x, SInt32 y)
 	// warp mouse
 	XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
 
-	// send an event that we can recognize after the mouse warp
+	// send an event that we can recognize after the mouse warp.  we
+	// don't wait for the server here;  the requests go out with the
+	// next flush and onMouseMove() skips everything up to this event
+	// when it comes back.
 	XSendEvent(m_display, m_window, False, 0, &eventAfter);
-	XSync(m_display, False);
 
 	LOG((CLOG_DEBUG2 "warped to %d,%d", x, y));
 }
@@ -2078,8 +2343,21 @@ bool
 CXWindowsScreen::detectXI2()
 {
 	int event, error;
-	return XQueryExtension(m_display,
-			"XInputExtension", &xi_opcode, &event, &error);
+	if (!XQueryExtension(m_display,
+			"XInputExtension", &xi_opcode, &event, &error)) {
+		return false;
+	}
+
+#ifdef HAVE_XI2
+	// the server only sends XI2 events to clients that said which
+	// version they speak
+	int major = 2, minor = 0;
+	if (XIQueryVersion(m_display, &major, &minor) != Success) {
+		LOG((CLOG_DEBUG "XI2 not supported by the X server"));
+		return false;
+	}
+#endif
+	return true;
 }
 
 #ifdef HAVE_XI2
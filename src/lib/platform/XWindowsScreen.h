@@ -20,6 +20,7 @@
 
 #include "synergy/PlatformScreen.h"
 #include "synergy/KeyMap.h"
+#include "synergy/InputChannel.h"
 #include "common/stdset.h"
 #include "common/stdvector.h"
 
@@ -27,6 +28,9 @@
 #	error X11 is required to build synergy
 #else
 #	include <X11/Xlib.h>
+#	ifdef HAVE_XI2
+#		include <X11/extensions/XInput2.h>
+#	endif
 #endif
 
 class CXWindowsClipboard;
@@ -41,6 +45,10 @@ public:
 		IEventQueue* events);
 	virtual ~CXWindowsScreen();
 
+#ifdef TEST_ENV
+	void setRelativeDevice(int deviceid, bool relative) { m_xi2RelativeDevices[deviceid] = relative; }
+#endif
+
 	//! @name manipulators
 	//@{
 
@@ -69,6 +77,7 @@ public:
 	virtual void		fakeMouseMove(SInt32 x, SInt32 y);
 	virtual void		fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const;
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const;
+	virtual void		flushFakeInput();
 
 	// IPlatformScreen overrides
 	virtual void		enable();
@@ -84,6 +93,7 @@ public:
 	virtual void		setOptions(const COptionsList& options);
 	virtual void		setSequenceNumber(UInt32);
 	virtual bool		isPrimary() const;
+	virtual void		setInputChannel(CInputChannel*);
 
 protected:
 	// IPlatformScreen overrides
@@ -96,6 +106,12 @@ private:
 	void				sendEvent(CEvent::Type, void* = NULL);
 	void				sendClipboardEvent(CEvent::Type, ClipboardID);
 
+	// user input sending, through the input channel if there is one
+	void				sendMotion(CInputChannel::CInput::EType,
+							SInt32 x, SInt32 y);
+	void				sendButton(CInputChannel::CInput::EType,
+							ButtonID, KeyModifierMask);
+
 	// create the transparent cursor
 	Cursor				createBlankCursor() const;
 
@@ -148,6 +164,15 @@ private:
 	unsigned int		mapButtonToX(ButtonID id) const;
 
 	void				warpCursorNoFlush(SInt32 x, SInt32 y);
+	void				coalesceMotion(XMotionEvent&) const;
+#ifdef HAVE_XI2
+	bool				nextEventIsRawMotion() const;
+	void				onRawMotionOnScreen();
+	void				onRawMotionOffScreen(XGenericEventCookie*);
+	bool				addRawDelta(const XIRawEvent*, double& dx, double& dy);
+	bool				isRelativeDevice(int deviceid);
+#endif
+	bool				isMotionAtEdge(const XMotionEvent&) const;
 
 	void				refreshKeyboard(XEvent*);
 
@@ -179,6 +204,9 @@ private:
 	// screen shape stuff
 	SInt32				m_xCenter, m_yCenter;
 
+	// how far the cursor may stray from the center while off screen
+	SInt32				m_warpSize;
+
 	// last mouse position
 	SInt32				m_xCursor, m_yCursor;
 
@@ -232,6 +260,18 @@ private:
 
 	bool				m_xi2detected;
 
+	// true if motion off screen is taken from XI2 raw motion events.
+	// m_xRawDelta and m_yRawDelta hold the fractional pixels not yet
+	// sent.  devices reporting absolute positions, like tablets, have
+	// no useful deltas;  while one of those moves the mouse
+	// m_xi2AbsoluteMotion is true and MotionNotify is used instead.
+	// m_xi2RelativeDevices caches which source devices are relative.
+	typedef std::map<int, bool> CRelativeDeviceMap;
+	bool				m_xi2RawMotion;
+	bool				m_xi2AbsoluteMotion;
+	CRelativeDeviceMap	m_xi2RelativeDevices;
+	double				m_xRawDelta, m_yRawDelta;
+
 	// XRandR extension stuff
 	bool                m_xrandr;
 	int                 m_xrandrEventBase;
@@ -20,6 +20,7 @@
 
 #include "platform/XWindowsUtil.h"
 #include "synergy/IPlatformScreen.h"
+#include "synergy/InputChannel.h"
 #include "base/Log.h"
 #include "base/Event.h"
 #include "base/IEventQueue.h"
@@ -63,6 +64,7 @@ CXWindowsScreenSaver::CXWindowsScreenSaver(
 	m_display(display),
 	m_xscreensaverSink(window),
 	m_eventTarget(eventTarget),
+	m_inputChannel(NULL),
 	m_xscreensaver(None),
 	m_xscreensaverActive(false),
 	m_dpms(false),
@@ -213,6 +215,12 @@ CXWindowsScreenSaver::handleXEvent(const XEvent* xevent)
 	return false;
 }
 
+void
+CXWindowsScreenSaver::setInputChannel(CInputChannel* channel)
+{
+	m_inputChannel = channel;
+}
+
 void
 CXWindowsScreenSaver::enable()
 {
@@ -398,15 +406,15 @@ CXWindowsScreenSaver::setXScreenSaverActive(bool activated)
 		m_suppressDisable = activated;
 		updateDisableTimer();
 
-		if (activated) {
-			m_events->addEvent(CEvent(
-							m_events->forIPrimaryScreen().screensaverActivated(),
-							m_eventTarget));
+		CEvent event(activated ?
+						m_events->forIPrimaryScreen().screensaverActivated() :
+						m_events->forIPrimaryScreen().screensaverDeactivated(),
+						m_eventTarget);
+		if (m_inputChannel != NULL) {
+			m_inputChannel->addEvent(event);
 		}
 		else {
-			m_events->addEvent(CEvent(
-							m_events->forIPrimaryScreen().screensaverDeactivated(),
-							m_eventTarget));
+			m_events->addEvent(event);
 		}
 	}
 }
@@ -29,6 +29,7 @@
 #endif
 
 class CEvent;
+class CInputChannel;
 class CEventQueueTimer;
 
 //! X11 screen saver implementation
@@ -47,6 +48,13 @@ public:
 	*/
 	bool				handleXEvent(const XEvent*);
 
+	//! Set the input channel
+	/*!
+	Activation events go through \p channel, if not NULL, so they keep
+	their place among the input sent through it.
+	*/
+	void				setInputChannel(CInputChannel* channel);
+
 	//! Destroy without the display
 	/*!
 	Tells this object to delete itself without using the X11 display.
@@ -121,6 +129,9 @@ private:
 	// the target for the events we generate
 	void*				m_eventTarget;
 
+	// where the input from the screen goes, or NULL
+	CInputChannel*		m_inputChannel;
+
 	// xscreensaver's window
 	Window				m_xscreensaver;
 
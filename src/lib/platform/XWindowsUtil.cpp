@@ -1380,12 +1380,24 @@ CXWindowsUtil::getWindowProperty(Display* display, Window window,
 	}
 }
 
+UInt32
+CXWindowsUtil::getMaxRequestSize(Display* display)
+{
+	// sizes are in 4 byte units.  the extended size is 0 without
+	// BIG-REQUESTS.
+	long size = XExtendedMaxRequestSize(display);
+	if (size == 0) {
+		size = XMaxRequestSize(display);
+	}
+	return 4 * static_cast<UInt32>(size);
+}
+
 bool
 CXWindowsUtil::setWindowProperty(Display* display, Window window,
 				Atom property, const void* vdata, UInt32 size,
 				Atom type, SInt32 format)
 {
-	const UInt32 length       = 4 * XMaxRequestSize(display);
+	const UInt32 length       = getMaxRequestSize(display);
 	const unsigned char* data = reinterpret_cast<const unsigned char*>(vdata);
 	UInt32 datumSize    = static_cast<UInt32>(format / 8);
 	// format 32 on 64bit systems is 8 bytes not 4.
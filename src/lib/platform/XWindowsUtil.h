@@ -47,6 +47,13 @@ public:
 							CString* data, Atom* type,
 							SInt32* format, bool deleteProperty);
 
+	//! Get maximum request size
+	/*!
+	Returns the largest request the X server accepts, in bytes.  This
+	is the BIG-REQUESTS limit if the server supports that extension.
+	*/
+	static UInt32		getMaxRequestSize(Display*);
+
 	//! Set property
 	/*!
 	Sets property \c property on \c window to \c size bytes of data from
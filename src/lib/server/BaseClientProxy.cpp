@@ -18,6 +18,8 @@
 
 #include "server/BaseClientProxy.h"
 
+#include "server/KeyBroadcast.h"
+
 //
 // CBaseClientProxy
 //
@@ -49,6 +51,17 @@ CBaseClientProxy::getJumpCursorPos(SInt32& x, SInt32& y) const
 	y = m_y;
 }
 
+void
+CBaseClientProxy::sendKey(CKeyBroadcast& key)
+{
+	if (key.isPress()) {
+		keyDown(key.getKey(), key.getMask(), key.getButton());
+	}
+	else {
+		keyUp(key.getKey(), key.getMask(), key.getButton());
+	}
+}
+
 CString
 CBaseClientProxy::getName() const
 {
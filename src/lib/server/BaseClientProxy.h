@@ -21,6 +21,8 @@
 #include "synergy/IClient.h"
 #include "base/String.h"
 
+class CKeyBroadcast;
+
 //! Generic proxy for client or primary
 class CBaseClientProxy : public IClient {
 public:
@@ -39,6 +41,23 @@ public:
 	*/
 	void				setJumpCursorPos(SInt32 x, SInt32 y);
 
+	//! Update the client's session
+	/*!
+	Tells the client the token to present when it reconnects after a
+	dropped connection and the sequence number of the latest state
+	change sent to it.  Returns false if the client's protocol doesn't
+	support resuming sessions.
+	*/
+	virtual bool		setSession(const CString&, UInt32) { return false; }
+
+	//! Send a key event that also goes to other clients
+	/*!
+	Does what \c keyDown() or \c keyUp() would, but takes the encoded
+	message from \p key so clients speaking the same protocol share the
+	work of encoding it.
+	*/
+	virtual void		sendKey(CKeyBroadcast& key);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -49,6 +68,28 @@ public:
 	*/
 	void				getJumpCursorPos(SInt32& x, SInt32& y) const;
 
+	//! Get resume token
+	/*!
+	Returns the session token the client presented during the handshake,
+	or an empty string if it's starting a new session.
+	*/
+	virtual CString		getResumeToken() const { return CString(); }
+
+	//! Get resume sequence number
+	/*!
+	Returns the sequence number of the latest state change the client
+	got before its connection dropped.  Only meaningful along with a
+	resume token.
+	*/
+	virtual UInt32		getResumeSeqNum() const { return 0; }
+
+	//! Test clipboard dirty flag
+	/*!
+	Returns true if clipboard \p id has to be sent to the client before
+	it's up to date.
+	*/
+	virtual bool		isClipboardDirty(ClipboardID) const { return true; }
+
 	//@}
 
 	// IScreen
@@ -28,10 +28,28 @@
 #include "io/CryptoStream.h"
 #include "io/CryptoOptions.h"
 #include "io/IStreamFilterFactory.h"
+#include "arch/Arch.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
 #include "base/TMethodEventJob.h"
 
+// how long a new client has to complete the handshake
+static const double		kHandshakeTimeout = 30.0;
+
+// how often to look for clients that are too slow with the handshake
+static const double		kSweepInterval = 1.0;
+
+// most connections accepted per pass through the event loop
+static const int		kMaxAcceptBatch = 64;
+
+// most handshakes in progress, in all and from any one host
+static const size_t		kMaxPendingClients = 256;
+static const UInt32		kMaxPendingPerHost = 32;
+
+// sustained and burst rate of new connections allowed from one host
+static const double		kHostConnectRate  = 50.0;
+static const double		kHostConnectBurst = 100.0;
+
 //
 // CClientListener
 //
@@ -43,6 +61,8 @@ CClientListener::CClientListener(const CNetworkAddress& address,
 				IEventQueue* events) :
 	m_socketFactory(socketFactory),
 	m_streamFilterFactory(streamFilterFactory),
+	m_sweepTimer(NULL),
+	m_refused(0),
 	m_server(NULL),
 	m_crypto(crypto),
 	m_events(events)
@@ -84,7 +104,7 @@ CClientListener::~CClientListener()
 	// discard already connected clients
 	for (CNewClients::iterator index = m_newClients.begin();
 								index != m_newClients.end(); ++index) {
-		CClientProxyUnknown* client = *index;
+		CClientProxyUnknown* client = index->first;
 		m_events->removeHandler(
 							m_events->forCClientProxyUnknown().success(), client);
 		m_events->removeHandler(
@@ -93,6 +113,10 @@ CClientListener::~CClientListener()
 							m_events->forCClientProxy().disconnected(), client);
 		delete client;
 	}
+	if (m_sweepTimer != NULL) {
+		m_events->removeHandler(CEvent::kTimer, m_sweepTimer);
+		m_events->deleteTimer(m_sweepTimer);
+	}
 
 	// discard waiting clients
 	CClientProxy* client = getNextClient();
@@ -129,12 +153,59 @@ CClientListener::getNextClient()
 void
 CClientListener::handleClientConnecting(const CEvent&, void*)
 {
-	// accept client connection
-	synergy::IStream* stream = m_listen->accept();
-	if (stream == NULL) {
-		return;
+	// accept everything that's waiting but leave the event loop to
+	// other work now and then during a storm
+	double now = ARCH->time();
+	for (int i = 0; i < kMaxAcceptBatch; ++i) {
+		CString host;
+		IDataSocket* socket = m_listen->accept(&host);
+		if (socket == NULL) {
+			return;
+		}
+		if (admit(host, now)) {
+			socket->setRecordWriteLatency(true);
+			addClient(socket, host, now);
+		}
+		else {
+			// hang up before spending anything on it
+			delete socket;
+		}
+	}
+	m_events->addEvent(CEvent(m_events->forIListenSocket().connecting(),
+							m_listen));
+}
+
+bool
+CClientListener::admit(const CString& host, double now)
+{
+	CHostInfo& info = m_hosts[host];
+
+	// refill the host's allowance of connections
+	info.m_tokens  += (now - info.m_lastTime) * kHostConnectRate;
+	info.m_lastTime = now;
+	if (info.m_tokens > kHostConnectBurst) {
+		info.m_tokens = kHostConnectBurst;
+	}
+
+	if (m_newClients.size() >= kMaxPendingClients ||
+		info.m_pending >= kMaxPendingPerHost ||
+		info.m_tokens < 1.0) {
+		// complain once per sweep, not per connection
+		if (m_refused++ == 0) {
+			LOG((CLOG_WARN "too many new connections, refusing some from %s", host.c_str()));
+		}
+		return false;
 	}
-	LOG((CLOG_NOTE "accepted client connection"));
+	info.m_tokens -= 1.0;
+	++info.m_pending;
+	return true;
+}
+
+void
+CClientListener::addClient(synergy::IStream* stream,
+				const CString& host, double now)
+{
+	LOG((CLOG_NOTE "accepted client connection from %s", host.c_str()));
 
 	// filter socket messages, including a packetizing filter
 	if (m_streamFilterFactory != NULL) {
@@ -151,8 +222,18 @@ CClientListener::handleClientConnecting(const CEvent&, void*)
 	assert(m_server != NULL);
 
 	// create proxy for unknown client
-	CClientProxyUnknown* client = new CClientProxyUnknown(stream, 30.0, m_server, m_events);
-	m_newClients.insert(client);
+	CClientProxyUnknown* client = new CClientProxyUnknown(stream, m_server, m_events);
+	CPendingClient& pending = m_newClients[client];
+	pending.m_host     = host;
+	pending.m_deadline = now + kHandshakeTimeout;
+
+	// one timer looks after all the handshakes
+	if (m_sweepTimer == NULL) {
+		m_sweepTimer = m_events->newTimer(kSweepInterval, NULL);
+		m_events->adoptHandler(CEvent::kTimer, m_sweepTimer,
+							new TMethodEventJob<CClientListener>(this,
+								&CClientListener::handleSweep));
+	}
 
 	// watch for events from unknown client
 	m_events->adoptHandler(m_events->forCClientProxyUnknown().success(), client,
@@ -170,7 +251,8 @@ CClientListener::handleUnknownClient(const CEvent&, void* vclient)
 		reinterpret_cast<CClientProxyUnknown*>(vclient);
 
 	// we should have the client in our new client list
-	assert(m_newClients.count(unknownClient) == 1);
+	CNewClients::iterator pending = m_newClients.find(unknownClient);
+	assert(pending != m_newClients.end());
 
 	// get the real client proxy and install it
 	CClientProxy* client = unknownClient->orphanClientProxy();
@@ -187,12 +269,58 @@ CClientListener::handleUnknownClient(const CEvent&, void* vclient)
 	}
 
 	// now finished with unknown client
-	m_events->removeHandler(m_events->forCClientProxyUnknown().success(), client);
-	m_events->removeHandler(m_events->forCClientProxyUnknown().failure(), client);
-	m_newClients.erase(unknownClient);
+	m_events->removeHandler(m_events->forCClientProxyUnknown().success(),
+							unknownClient);
+	m_events->removeHandler(m_events->forCClientProxyUnknown().failure(),
+							unknownClient);
+	CHosts::iterator host = m_hosts.find(pending->second.m_host);
+	if (host != m_hosts.end()) {
+		--host->second.m_pending;
+	}
+	m_newClients.erase(pending);
 	delete unknownClient;
 }
 
+void
+CClientListener::handleSweep(const CEvent&, void*)
+{
+	double now = ARCH->time();
+
+	// fail handshakes that have taken too long.  each one reports back
+	// through the failure event so only do it once.
+	for (CNewClients::iterator i = m_newClients.begin();
+								i != m_newClients.end(); ++i) {
+		if (i->second.m_deadline <= now) {
+			i->second.m_deadline = kHandshakeTimeout + now;
+			i->first->timeout();
+		}
+	}
+
+	// forget hosts that are back to their full allowance
+	for (CHosts::iterator i = m_hosts.begin(); i != m_hosts.end(); ) {
+		const CHostInfo& info = i->second;
+		if (info.m_pending == 0 && (now - info.m_lastTime) *
+				kHostConnectRate + info.m_tokens >= kHostConnectBurst) {
+			m_hosts.erase(i++);
+		}
+		else {
+			++i;
+		}
+	}
+
+	if (m_refused > 0) {
+		LOG((CLOG_WARN "refused %d new connections", m_refused));
+		m_refused = 0;
+	}
+
+	// nothing left to watch
+	if (m_newClients.empty() && m_hosts.empty()) {
+		m_events->removeHandler(CEvent::kTimer, m_sweepTimer);
+		m_events->deleteTimer(m_sweepTimer);
+		m_sweepTimer = NULL;
+	}
+}
+
 void
 CClientListener::handleClientDisconnected(const CEvent&, void* vclient)
 {
@@ -210,3 +338,16 @@ CClientListener::handleClientDisconnected(const CEvent&, void* vclient)
 		}
 	}
 }
+
+
+//
+// CClientListener::CHostInfo
+//
+
+CClientListener::CHostInfo::CHostInfo() :
+	m_pending(0),
+	m_tokens(kHostConnectBurst),
+	m_lastTime(ARCH->time())
+{
+	// do nothing
+}
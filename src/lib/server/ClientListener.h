@@ -22,18 +22,30 @@
 #include "io/CryptoOptions.h"
 #include "base/EventTypes.h"
 #include "base/Event.h"
+#include "base/String.h"
 #include "common/stddeque.h"
-#include "common/stdset.h"
+#include "common/stdmap.h"
 
 class CClientProxy;
 class CClientProxyUnknown;
+class CEventQueueTimer;
 class CNetworkAddress;
 class IListenSocket;
 class ISocketFactory;
 class IStreamFilterFactory;
+namespace synergy { class IStream; }
 class CServer;
 class IEventQueue;
 
+//! Accepts new clients
+/*!
+Accepts connections and runs the handshake with each new client before
+handing it to the server.  To survive a storm of connections, whether
+from a whole office restarting at once or a client stuck in a reconnect
+loop, the number of handshakes in progress is bounded, both in total
+and per remote host, and each host may only open so many connections
+per second.  Connections over the limits are closed right away.
+*/
 class CClientListener {
 public:
 	// The factories are adopted.
@@ -65,6 +77,9 @@ public:
 	//! Get server which owns this listener
 	CServer*			getServer() { return m_server; }
 
+	//! Get number of handshakes in progress
+	size_t				getNumPendingClients() const { return m_newClients.size(); }
+
 	//@}
 
 private:
@@ -72,16 +87,40 @@ private:
 	void				handleClientConnecting(const CEvent&, void*);
 	void				handleUnknownClient(const CEvent&, void*);
 	void				handleClientDisconnected(const CEvent&, void*);
+	void				handleSweep(const CEvent&, void*);
+
+	// check the limits on new connections from \p host
+	bool				admit(const CString& host, double now);
+	void				addClient(synergy::IStream*, const CString& host,
+							double now);
 
 private:
-	typedef std::set<CClientProxyUnknown*> CNewClients;
+	class CPendingClient {
+	public:
+		CString			m_host;
+		double			m_deadline;
+	};
+	class CHostInfo {
+	public:
+		CHostInfo();
+
+	public:
+		UInt32			m_pending;
+		double			m_tokens;
+		double			m_lastTime;
+	};
+	typedef std::map<CClientProxyUnknown*, CPendingClient> CNewClients;
 	typedef std::deque<CClientProxy*> CWaitingClients;
+	typedef std::map<CString, CHostInfo> CHosts;
 
 	IListenSocket*		m_listen;
 	ISocketFactory*		m_socketFactory;
 	IStreamFilterFactory*	m_streamFilterFactory;
 	CNewClients			m_newClients;
 	CWaitingClients		m_waitingClients;
+	CHosts				m_hosts;
+	CEventQueueTimer*	m_sweepTimer;
+	UInt32				m_refused;
 	CServer*			m_server;
 	CCryptoOptions		m_crypto;
 	IEventQueue*		m_events;
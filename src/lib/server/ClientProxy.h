@@ -51,8 +51,10 @@ public:
 	/*!
 	Returns a crypto stream if the user has this enabled,
 	otherwise returns the original stream passed to the c'tor.
+	Subclasses that hold back messages send them before returning
+	the stream so anything written to it goes out in order.
 	*/
-	synergy::IStream*			getStream() const;
+	virtual synergy::IStream*	getStream() const;
 
 	//@}
 
@@ -18,11 +18,13 @@
 
 #include "server/ClientProxy1_0.h"
 
+#include "server/KeyBroadcast.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/XSynergy.h"
 #include "io/IStream.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstring>
@@ -303,6 +305,12 @@ CClientProxy1_0::setClipboardDirty(ClipboardID id, bool dirty)
 	m_clipboard[id].m_dirty = dirty;
 }
 
+bool
+CClientProxy1_0::isClipboardDirty(ClipboardID id) const
+{
+	return m_clipboard[id].m_dirty;
+}
+
 void
 CClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton)
 {
@@ -310,6 +318,15 @@ CClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton)
 	CProtocolUtil::writef(getStream(), kMsgDKeyDown1_0, key, mask);
 }
 
+void
+CClientProxy1_0::sendKey(CKeyBroadcast& key)
+{
+	LOG((CLOG_DEBUG1 "send key %s to \"%s\" id=%d, mask=0x%04x", key.isPress() ? "down" : "up", getName().c_str(), key.getKey(), key.getMask()));
+	const CString& msg = key.getMessage(key.isPress() ? kMsgDKeyDown1_0 :
+														kMsgDKeyUp1_0);
+	getStream()->write(msg.data(), static_cast<UInt32>(msg.size()));
+}
+
 void
 CClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton)
@@ -470,7 +487,8 @@ CClientProxy1_0::recvClipboard()
 	m_clipboard[id].m_sequenceNumber = seqNum;
 
 	// notify
-	CClipboardInfo* info   = new CClipboardInfo;
+	CClipboardInfo* info   =
+		(CClipboardInfo*)CEventDataPool::alloc(sizeof(CClipboardInfo));
 	info->m_id             = id;
 	info->m_sequenceNumber = seqNum;
 	m_events->addEvent(CEvent(m_events->forCClientProxy().clipboardChanged(),
@@ -496,7 +514,8 @@ CClientProxy1_0::recvGrabClipboard()
 	}
 
 	// notify
-	CClipboardInfo* info   = new CClipboardInfo;
+	CClipboardInfo* info   =
+		(CClipboardInfo*)CEventDataPool::alloc(sizeof(CClipboardInfo));
 	info->m_id             = id;
 	info->m_sequenceNumber = seqNum;
 	m_events->addEvent(CEvent(m_events->forIScreen().clipboardGrabbed(),
@@ -38,6 +38,10 @@ public:
 							SInt32& width, SInt32& height) const;
 	virtual void		getCursorPos(SInt32& x, SInt32& y) const;
 
+	// CBaseClientProxy overrides
+	virtual bool		isClipboardDirty(ClipboardID) const;
+	virtual void		sendKey(CKeyBroadcast&);
+
 	// IClient overrides
 	virtual void		enter(SInt32 xAbs, SInt32 yAbs,
 							UInt32 seqNum, KeyModifierMask mask,
@@ -18,7 +18,9 @@
 
 #include "server/ClientProxy1_1.h"
 
+#include "server/KeyBroadcast.h"
 #include "synergy/ProtocolUtil.h"
+#include "io/IStream.h"
 #include "base/Log.h"
 
 #include <cstring>
@@ -45,6 +47,15 @@ CClientProxy1_1::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
 	CProtocolUtil::writef(getStream(), kMsgDKeyDown, key, mask, button);
 }
 
+void
+CClientProxy1_1::sendKey(CKeyBroadcast& key)
+{
+	LOG((CLOG_DEBUG1 "send key %s to \"%s\" id=%d, mask=0x%04x, button=0x%04x", key.isPress() ? "down" : "up", getName().c_str(), key.getKey(), key.getMask(), key.getButton()));
+	const CString& msg = key.getMessage(key.isPress() ? kMsgDKeyDown :
+														kMsgDKeyUp);
+	getStream()->write(msg.data(), static_cast<UInt32>(msg.size()));
+}
+
 void
 CClientProxy1_1::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton button)
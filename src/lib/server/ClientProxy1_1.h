@@ -26,6 +26,9 @@ public:
 	CClientProxy1_1(const CString& name, synergy::IStream* adoptedStream, IEventQueue* events);
 	~CClientProxy1_1();
 
+	// CBaseClientProxy overrides
+	virtual void		sendKey(CKeyBroadcast&);
+
 	// IClient overrides
 	virtual void		keyDown(KeyID, KeyModifierMask, KeyButton);
 	virtual void		keyRepeat(KeyID, KeyModifierMask,
@@ -19,6 +19,7 @@
 #include "server/ClientProxy1_4.h"
 
 #include "server/Server.h"
+#include "server/KeyBroadcast.h"
 #include "synergy/ProtocolUtil.h"
 #include "io/CryptoStream.h"
 #include "base/Log.h"
@@ -49,6 +50,13 @@ CClientProxy1_4::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
 	CClientProxy1_3::keyDown(key, mask, button);
 }
 
+void
+CClientProxy1_4::sendKey(CKeyBroadcast& key)
+{
+	cryptoIv();
+	CClientProxy1_3::sendKey(key);
+}
+
 void
 CClientProxy1_4::keyRepeat(KeyID key, KeyModifierMask mask, SInt32 count, KeyButton button)
 {
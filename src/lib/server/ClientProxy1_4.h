@@ -36,6 +36,9 @@ public:
 
 	//@}
 
+	// CBaseClientProxy overrides
+	virtual void		sendKey(CKeyBroadcast&);
+
 	// IClient overrides
 	virtual void		keyDown(KeyID key, KeyModifierMask mask, KeyButton button);
 	virtual void		keyRepeat(KeyID key, KeyModifierMask mask, SInt32 count, KeyButton button);
@@ -0,0 +1,61 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+
+#include "synergy/ProtocolUtil.h"
+#include "io/IStream.h"
+#include "base/Log.h"
+
+#include <cstring>
+
+//
+// CClientProxy1_7
+//
+
+CClientProxy1_7::CClientProxy1_7(const CString& name, synergy::IStream* stream, CServer* server, IEventQueue* events) :
+	CClientProxy1_6(name, stream, server, events),
+	m_resumeSeqNum(0)
+{
+}
+
+CClientProxy1_7::~CClientProxy1_7()
+{
+}
+
+bool
+CClientProxy1_7::setSession(const CString& token, UInt32 seqNum)
+{
+	LOG((CLOG_DEBUG1 "send session to \"%s\" seqnum=%d", getName().c_str(), seqNum));
+	CProtocolUtil::writef(getStream(), kMsgDSession, &token, seqNum);
+	return true;
+}
+
+bool
+CClientProxy1_7::parseHandshakeMessage(const UInt8* code)
+{
+	if (memcmp(code, kMsgDSession, 4) == 0) {
+		// the client wants to pick up where it left off
+		if (!CProtocolUtil::readf(getStream(), kMsgDSession + 4,
+								&m_resumeToken, &m_resumeSeqNum)) {
+			return false;
+		}
+		LOG((CLOG_DEBUG1 "client \"%s\" resuming session seqnum=%d", getName().c_str(), m_resumeSeqNum));
+		return true;
+	}
+	return CClientProxy1_6::parseHandshakeMessage(code);
+}
@@ -0,0 +1,42 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_6.h"
+
+class CServer;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.7
+class CClientProxy1_7 : public CClientProxy1_6 {
+public:
+	CClientProxy1_7(const CString& name, synergy::IStream* adoptedStream, CServer* server, IEventQueue* events);
+	~CClientProxy1_7();
+
+	// CBaseClientProxy overrides
+	virtual bool		setSession(const CString& token, UInt32 seqNum);
+	virtual CString		getResumeToken() const { return m_resumeToken; }
+	virtual UInt32		getResumeSeqNum() const { return m_resumeSeqNum; }
+
+protected:
+	virtual bool		parseHandshakeMessage(const UInt8* code);
+
+private:
+	CString			m_resumeToken;
+	UInt32			m_resumeSeqNum;
+};
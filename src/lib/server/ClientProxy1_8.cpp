@@ -0,0 +1,199 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_8.h"
+
+#include "server/KeyBroadcast.h"
+#include "synergy/ProtocolUtil.h"
+#include "io/IStream.h"
+#include "io/CryptoStream.h"
+#include "base/Log.h"
+#include "base/LatencyStats.h"
+#include "base/IEventQueue.h"
+#include "base/TMethodEventJob.h"
+
+//
+// CClientProxy1_8
+//
+
+CClientProxy1_8::CClientProxy1_8(const CString& name, synergy::IStream* stream, CServer* server, IEventQueue* events) :
+	CClientProxy1_7(name, stream, server, events),
+	m_flushPosted(false),
+	m_haveMouse(false),
+	m_xMouse(0),
+	m_yMouse(0),
+	m_events(events)
+{
+	m_events->adoptHandler(m_events->forCClientProxy().inputFlush(),
+							this,
+							new TMethodEventJob<CClientProxy1_8>(this,
+								&CClientProxy1_8::handleInputFlush));
+}
+
+CClientProxy1_8::~CClientProxy1_8()
+{
+	m_events->removeHandler(m_events->forCClientProxy().inputFlush(), this);
+}
+
+synergy::IStream*
+CClientProxy1_8::getStream() const
+{
+	// whatever the caller writes must go after the input we're holding
+	const_cast<CClientProxy1_8*>(this)->flushInput();
+	return CClientProxy1_7::getStream();
+}
+
+void
+CClientProxy1_8::enter(SInt32 xAbs, SInt32 yAbs,
+				UInt32 seqNum, KeyModifierMask mask, bool forScreensaver)
+{
+	// the client starts over from the (16 bit) entry position.  send the
+	// next motion in full.
+	m_haveMouse = false;
+	CClientProxy1_7::enter(xAbs, yAbs, seqNum, mask, forScreensaver);
+}
+
+void
+CClientProxy1_8::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	newCryptoIv();
+	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+	CProtocolUtil::appendf(m_input, kMsgIKeyDown, key, mask, button);
+	postFlush();
+}
+
+void
+CClientProxy1_8::sendKey(CKeyBroadcast& key)
+{
+	newCryptoIv();
+	LOG((CLOG_DEBUG1 "send key %s to \"%s\" id=%d, mask=0x%04x, button=0x%04x", key.isPress() ? "down" : "up", getName().c_str(), key.getKey(), key.getMask(), key.getButton()));
+	m_input += key.getMessage(key.isPress() ? kMsgIKeyDown : kMsgIKeyUp);
+	postFlush();
+}
+
+void
+CClientProxy1_8::keyRepeat(KeyID key, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	newCryptoIv();
+	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
+	CProtocolUtil::appendf(m_input, kMsgIKeyRepeat, key, mask, count, button);
+	postFlush();
+}
+
+void
+CClientProxy1_8::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	newCryptoIv();
+	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+	CProtocolUtil::appendf(m_input, kMsgIKeyUp, key, mask, button);
+	postFlush();
+}
+
+void
+CClientProxy1_8::mouseDown(ButtonID button)
+{
+	LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
+	CProtocolUtil::appendf(m_input, kMsgIMouseDown, button);
+	postFlush();
+}
+
+void
+CClientProxy1_8::mouseUp(ButtonID button)
+{
+	LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
+	CProtocolUtil::appendf(m_input, kMsgIMouseUp, button);
+	postFlush();
+}
+
+void
+CClientProxy1_8::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+	if (m_haveMouse) {
+		CProtocolUtil::appendf(m_input, kMsgIMouseDelta,
+							xAbs - m_xMouse, yAbs - m_yMouse);
+	}
+	else {
+		CProtocolUtil::appendf(m_input, kMsgIMouseMove, xAbs, yAbs);
+		m_haveMouse = true;
+	}
+	m_xMouse = xAbs;
+	m_yMouse = yAbs;
+	postFlush();
+}
+
+void
+CClientProxy1_8::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	LOG((CLOG_DEBUG2 "send mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
+	CProtocolUtil::appendf(m_input, kMsgIMouseRelMove, xRel, yRel);
+	postFlush();
+}
+
+void
+CClientProxy1_8::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
+	CProtocolUtil::appendf(m_input, kMsgIMouseWheel, xDelta, yDelta);
+	postFlush();
+}
+
+void
+CClientProxy1_8::newCryptoIv()
+{
+	// sending the iv sends the batch ahead of it.  don't break up the
+	// batch for nothing when there's no encryption.
+	if (dynamic_cast<CCryptoStream*>(CClientProxy1_7::getStream()) != NULL) {
+		cryptoIv();
+	}
+}
+
+void
+CClientProxy1_8::postFlush()
+{
+	// input already queued behind the flush event goes out with it
+	if (!m_flushPosted) {
+		m_flushPosted = true;
+		m_events->addEvent(CEvent(m_events->forCClientProxy().inputFlush(),
+								this));
+	}
+}
+
+void
+CClientProxy1_8::flushInput()
+{
+	if (m_input.empty()) {
+		return;
+	}
+
+	CLatencyTimer timer(CLatencyStats::kEncode);
+
+	// swap the batch out first.  the write can fail and disconnect us.
+	CString input;
+	input.swap(m_input);
+	LOG((CLOG_DEBUG2 "send %d bytes of input to \"%s\"", input.size(), getName().c_str()));
+	CClientProxy1_7::getStream()->write(input.data(),
+							static_cast<UInt32>(input.size()));
+}
+
+void
+CClientProxy1_8::handleInputFlush(const CEvent&, void*)
+{
+	m_flushPosted = false;
+	flushInput();
+}
@@ -0,0 +1,78 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_7.h"
+
+class CServer;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.8
+/*!
+Sends input as compact records and batches the records from one pass
+through the event queue into a single write.  Any other message sends
+the batch first so the client sees everything in order.
+*/
+class CClientProxy1_8 : public CClientProxy1_7 {
+public:
+	CClientProxy1_8(const CString& name, synergy::IStream* adoptedStream, CServer* server, IEventQueue* events);
+	~CClientProxy1_8();
+
+	// CBaseClientProxy overrides
+	virtual void		sendKey(CKeyBroadcast&);
+
+	// CClientProxy overrides
+	virtual synergy::IStream*	getStream() const;
+
+	// IClient overrides
+	virtual void		enter(SInt32 xAbs, SInt32 yAbs,
+							UInt32 seqNum, KeyModifierMask mask,
+							bool forScreensaver);
+	virtual void		keyDown(KeyID, KeyModifierMask, KeyButton);
+	virtual void		keyRepeat(KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+	virtual void		keyUp(KeyID, KeyModifierMask, KeyButton);
+	virtual void		mouseDown(ButtonID);
+	virtual void		mouseUp(ButtonID);
+	virtual void		mouseMove(SInt32 xAbs, SInt32 yAbs);
+	virtual void		mouseRelativeMove(SInt32 xRel, SInt32 yRel);
+	virtual void		mouseWheel(SInt32 xDelta, SInt32 yDelta);
+
+#ifdef TEST_ENV
+	void				flushInputForTest() { flushInput(); }
+#endif
+
+private:
+	// change the crypto iv ahead of a key message, if encrypting
+	void				newCryptoIv();
+
+	// queue the batch to be sent
+	void				postFlush();
+
+	// send the batch, if any
+	void				flushInput();
+
+	void				handleInputFlush(const CEvent&, void*);
+
+private:
+	CString				m_input;
+	bool				m_flushPosted;
+	bool				m_haveMouse;
+	SInt32				m_xMouse, m_yMouse;
+	IEventQueue*		m_events;
+};
@@ -26,6 +26,8 @@
 #include "server/ClientProxy1_4.h"
 #include "server/ClientProxy1_5.h"
 #include "server/ClientProxy1_6.h"
+#include "server/ClientProxy1_7.h"
+#include "server/ClientProxy1_8.h"
 #include "synergy/protocol_types.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/XSynergy.h"
@@ -40,7 +42,7 @@
 // CClientProxyUnknown
 //
 
-CClientProxyUnknown::CClientProxyUnknown(synergy::IStream* stream, double timeout, CServer* server, IEventQueue* events) :
+CClientProxyUnknown::CClientProxyUnknown(synergy::IStream* stream, CServer* server, IEventQueue* events) :
 	m_stream(stream),
 	m_proxy(NULL),
 	m_ready(false),
@@ -49,10 +51,6 @@ CClientProxyUnknown::CClientProxyUnknown(synergy::IStream* stream, double timeou
 {
 	assert(m_server != NULL);
 
-	m_events->adoptHandler(CEvent::kTimer, this,
-							new TMethodEventJob<CClientProxyUnknown>(this,
-								&CClientProxyUnknown::handleTimeout, NULL));
-	m_timer = m_events->newOneShotTimer(timeout, this);
 	addStreamHandlers();
 
 	LOG((CLOG_DEBUG1 "saying hello"));
@@ -64,7 +62,6 @@ CClientProxyUnknown::CClientProxyUnknown(synergy::IStream* stream, double timeou
 CClientProxyUnknown::~CClientProxyUnknown()
 {
 	removeHandlers();
-	removeTimer();
 	delete m_stream;
 	delete m_proxy;
 }
@@ -87,7 +84,6 @@ void
 CClientProxyUnknown::sendSuccess()
 {
 	m_ready = true;
-	removeTimer();
 	m_events->addEvent(CEvent(m_events->forCClientProxyUnknown().success(), this));
 }
 
@@ -98,7 +94,6 @@ CClientProxyUnknown::sendFailure()
 	m_proxy = NULL;
 	m_ready = false;
 	removeHandlers();
-	removeTimer();
 	m_events->addEvent(CEvent(m_events->forCClientProxyUnknown().failure(), this));
 }
 
@@ -123,6 +118,12 @@ CClientProxyUnknown::addStreamHandlers()
 							m_stream->getEventTarget(),
 							new TMethodEventJob<CClientProxyUnknown>(this,
 								&CClientProxyUnknown::handleWriteError));
+
+	// a connection reset shows up as nothing else
+	m_events->adoptHandler(m_events->forISocket().disconnected(),
+							m_stream->getEventTarget(),
+							new TMethodEventJob<CClientProxyUnknown>(this,
+								&CClientProxyUnknown::handleDisconnect));
 }
 
 void
@@ -152,6 +153,8 @@ CClientProxyUnknown::removeHandlers()
 							m_stream->getEventTarget());
 		m_events->removeHandler(m_events->forIStream().outputShutdown(),
 							m_stream->getEventTarget());
+		m_events->removeHandler(m_events->forISocket().disconnected(),
+							m_stream->getEventTarget());
 	}
 	if (m_proxy != NULL) {
 		m_events->removeHandler(m_events->forCClientProxy().ready(),
@@ -161,16 +164,6 @@ CClientProxyUnknown::removeHandlers()
 	}
 }
 
-void
-CClientProxyUnknown::removeTimer()
-{
-	if (m_timer != NULL) {
-		m_events->deleteTimer(m_timer);
-		m_events->removeHandler(CEvent::kTimer, this);
-		m_timer = NULL;
-	}
-}
-
 void
 CClientProxyUnknown::handleData(const CEvent&, void*)
 {
@@ -232,6 +225,14 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 			case 6:
 				m_proxy = new CClientProxy1_6(name, m_stream, m_server, m_events);
 				break;
+
+			case 7:
+				m_proxy = new CClientProxy1_7(name, m_stream, m_server, m_events);
+				break;
+
+			case 8:
+				m_proxy = new CClientProxy1_8(name, m_stream, m_server, m_events);
+				break;
 			}
 		}
 
@@ -242,6 +243,14 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 
 		// the proxy is created and now proxy now owns the stream
 		LOG((CLOG_DEBUG1 "created proxy for client \"%s\" version %d.%d", name.c_str(), major, minor));
+
+		// the client may have sent more right behind the hello.  we
+		// won't receive another event for already pending messages so
+		// fake one for the proxy.
+		if (m_stream->isReady()) {
+			m_events->addEvent(CEvent(m_events->forIStream().inputReady(),
+								m_stream->getEventTarget()));
+		}
 		m_stream = NULL;
 
 		// wait until the proxy signals that it's ready or has disconnected
@@ -275,8 +284,12 @@ CClientProxyUnknown::handleWriteError(const CEvent&, void*)
 }
 
 void
-CClientProxyUnknown::handleTimeout(const CEvent&, void*)
+CClientProxyUnknown::timeout()
 {
+	// too late if the success event is already on its way
+	if (m_ready) {
+		return;
+	}
 	LOG((CLOG_NOTE "new client is unresponsive"));
 	sendFailure();
 }
@@ -22,14 +22,13 @@
 #include "base/EventTypes.h"
 
 class CClientProxy;
-class CEventQueueTimer;
 namespace synergy { class IStream; }
 class CServer;
 class IEventQueue;
 
 class CClientProxyUnknown {
 public:
-	CClientProxyUnknown(synergy::IStream* stream, double timeout, CServer* server, IEventQueue* events);
+	CClientProxyUnknown(synergy::IStream* stream, CServer* server, IEventQueue* events);
 	~CClientProxyUnknown();
 
 	//! @name manipulators
@@ -43,6 +42,14 @@ public:
 	*/
 	CClientProxy*		orphanClientProxy();
 
+	//! Give up on the handshake
+	/*!
+	Fails the handshake because the client took too long.  The owner
+	keeps track of the time so a flood of new connections doesn't need
+	a timer each.
+	*/
+	void				timeout();
+
 	//@}
 
 private:
@@ -51,16 +58,13 @@ private:
 	void				addStreamHandlers();
 	void				addProxyHandlers();
 	void				removeHandlers();
-	void				removeTimer();
 	void				handleData(const CEvent&, void*);
 	void				handleWriteError(const CEvent&, void*);
-	void				handleTimeout(const CEvent&, void*);
 	void				handleDisconnect(const CEvent&, void*);
 	void				handleReady(const CEvent&, void*);
 
 private:
 	synergy::IStream*	m_stream;
-	CEventQueueTimer*	m_timer;
 	CClientProxy*		m_proxy;
 	bool				m_ready;
 	CServer*			m_server;
@@ -762,6 +762,9 @@ CConfig::readSectionOptions(CConfigReadContext& s)
 		else if (name == "relativeMouseMoves") {
 			addOption("", kOptionRelativeMouseMoves, s.parseBoolean(value));
 		}
+		else if (name == "mouseSendInterval") {
+			addOption("", kOptionMouseSendInterval, s.parseInt(value));
+		}
 		else if (name == "win32KeepForeground") {
 			addOption("", kOptionWin32KeepForeground, s.parseBoolean(value));
 		}
@@ -1370,6 +1373,9 @@ CConfig::getOptionName(OptionID id)
 	if (id == kOptionRelativeMouseMoves) {
 		return "relativeMouseMoves";
 	}
+	if (id == kOptionMouseSendInterval) {
+		return "mouseSendInterval";
+	}
 	if (id == kOptionWin32KeepForeground) {
 		return "win32KeepForeground";
 	}
@@ -1427,7 +1433,8 @@ CConfig::getOptionValue(OptionID id, OptionValue value)
 	if (id == kOptionHeartbeat ||
 		id == kOptionScreenSwitchCornerSize ||
 		id == kOptionScreenSwitchDelay ||
-		id == kOptionScreenSwitchTwoTap) {
+		id == kOptionScreenSwitchTwoTap ||
+		id == kOptionMouseSendInterval) {
 		return synergy::string::sprintf("%d", value);
 	}
 	if (id == kOptionScreenSwitchCorners) {
@@ -21,12 +21,36 @@
 #include "server/PrimaryClient.h"
 #include "synergy/KeyMap.h"
 #include "base/EventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/Log.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstdlib>
 #include <cstring>
 
+// modifiers that cannot be combined with a mouse button
+static const KeyModifierMask s_ignoreButtonMask =
+	KeyModifierAltGr | KeyModifierCapsLock |
+	KeyModifierNumLock | KeyModifierScrollLock;
+
+// kinds of CInputFilter::CIndexKey
+enum {
+	kHotKeyIndex = 1,
+	kButtonIndex = 2
+};
+
+static CInputFilter::CIndexKey
+makeHotKeyIndexKey(UInt32 id)
+{
+	return CInputFilter::CIndexKey(kHotKeyIndex << 16, id);
+}
+
+static CInputFilter::CIndexKey
+makeButtonIndexKey(ButtonID button, KeyModifierMask mask)
+{
+	return CInputFilter::CIndexKey((kButtonIndex << 16) | button, mask);
+}
+
 // -----------------------------------------------------------------------------
 // Input Filter Condition Classes
 // -----------------------------------------------------------------------------
@@ -40,6 +64,12 @@ CInputFilter::CCondition::~CCondition()
 	// do nothing
 }
 
+bool
+CInputFilter::CCondition::getIndexKey(CIndexKey&) const
+{
+	return false;
+}
+
 void
 CInputFilter::CCondition::enablePrimary(CPrimaryClient*)
 {
@@ -59,7 +89,7 @@ CInputFilter::CKeystrokeCondition::CKeystrokeCondition(
 	m_mask(info->m_mask),
 	m_events(events)
 {
-	free(info);
+	CEventDataPool::free(info);
 }
 
 CInputFilter::CKeystrokeCondition::CKeystrokeCondition(
@@ -129,6 +159,13 @@ CInputFilter::CKeystrokeCondition::match(const CEvent& event)
 	return status;
 }
 
+bool
+CInputFilter::CKeystrokeCondition::getIndexKey(CIndexKey& key) const
+{
+	key = makeHotKeyIndexKey(m_id);
+	return true;
+}
+
 void
 CInputFilter::CKeystrokeCondition::enablePrimary(CPrimaryClient* primary)
 {
@@ -148,7 +185,7 @@ CInputFilter::CMouseButtonCondition::CMouseButtonCondition(
 	m_mask(info->m_mask),
 	m_events(events)
 {
-	free(info);
+	CEventDataPool::free(info);
 }
 
 CInputFilter::CMouseButtonCondition::CMouseButtonCondition(
@@ -196,10 +233,6 @@ CInputFilter::CMouseButtonCondition::format() const
 CInputFilter::EFilterStatus		
 CInputFilter::CMouseButtonCondition::match(const CEvent& event)
 {
-	static const KeyModifierMask s_ignoreMask =
-		KeyModifierAltGr | KeyModifierCapsLock |
-		KeyModifierNumLock | KeyModifierScrollLock;
-
 	EFilterStatus status;
 
 	// check for hotkey events
@@ -219,13 +252,20 @@ CInputFilter::CMouseButtonCondition::match(const CEvent& event)
 	IPlatformScreen::CButtonInfo* minfo =
 		reinterpret_cast<IPlatformScreen::CButtonInfo*>(event.getData());
 	if (minfo->m_button != m_button ||
-		(minfo->m_mask & ~s_ignoreMask) != m_mask) {
+		(minfo->m_mask & ~s_ignoreButtonMask) != m_mask) {
 		return kNoMatch;
 	}
 
 	return status;
 }
 
+bool
+CInputFilter::CMouseButtonCondition::getIndexKey(CIndexKey& key) const
+{
+	key = makeButtonIndexKey(m_button, m_mask);
+	return true;
+}
+
 CInputFilter::CScreenConnectedCondition::CScreenConnectedCondition(
 		IEventQueue* events, const CString& screen) :
 	m_screen(screen),
@@ -496,13 +536,13 @@ CInputFilter::CKeystrokeAction::CKeystrokeAction(
 
 CInputFilter::CKeystrokeAction::~CKeystrokeAction()
 {
-	free(m_keyInfo);
+	CEventDataPool::free(m_keyInfo);
 }
 
 void
 CInputFilter::CKeystrokeAction::adoptInfo(IPlatformScreen::CKeyInfo* info)
 {
-	free(m_keyInfo);
+	CEventDataPool::free(m_keyInfo);
 	m_keyInfo = info;
 }
 
@@ -584,7 +624,7 @@ CInputFilter::CMouseButtonAction::CMouseButtonAction(
 
 CInputFilter::CMouseButtonAction::~CMouseButtonAction()
 {
-	free(m_buttonInfo);
+	CEventDataPool::free(m_buttonInfo);
 }
 
 const IPlatformScreen::CButtonInfo*
@@ -889,7 +929,8 @@ CInputFilter::CRule::getAction(bool onActivation, UInt32 index) const
 // -----------------------------------------------------------------------------
 CInputFilter::CInputFilter(IEventQueue* events) :
 	m_primaryClient(NULL),
-	m_events(events)
+	m_events(events),
+	m_indexValid(false)
 {
 	// do nothing
 }
@@ -897,7 +938,8 @@ CInputFilter::CInputFilter(IEventQueue* events) :
 CInputFilter::CInputFilter(const CInputFilter& x) :
 	m_ruleList(x.m_ruleList),
 	m_primaryClient(NULL),
-	m_events(x.m_events)
+	m_events(x.m_events),
+	m_indexValid(false)
 {
 	setPrimaryClient(x.m_primaryClient);
 }
@@ -914,7 +956,8 @@ CInputFilter::operator=(const CInputFilter& x)
 		CPrimaryClient* oldClient = m_primaryClient;
 		setPrimaryClient(NULL);
 
-		m_ruleList = x.m_ruleList;
+		m_ruleList   = x.m_ruleList;
+		m_indexValid = false;
 
 		setPrimaryClient(oldClient);
 	}
@@ -928,6 +971,7 @@ CInputFilter::addFilterRule(const CRule& rule)
 	if (m_primaryClient != NULL) {
 		m_ruleList.back().enable(m_primaryClient);
 	}
+	m_indexValid = false;
 }
 
 void
@@ -937,11 +981,14 @@ CInputFilter::removeFilterRule(UInt32 index)
 		m_ruleList[index].disable(m_primaryClient);
 	}
 	m_ruleList.erase(m_ruleList.begin() + index);
+	m_indexValid = false;
 }
 
 CInputFilter::CRule&
 CInputFilter::getRule(UInt32 index)
 {
+	// the caller may change the rule's condition
+	m_indexValid = false;
 	return m_ruleList[index];
 }
 
@@ -977,6 +1024,7 @@ CInputFilter::setPrimaryClient(CPrimaryClient* client)
 	}
 
 	m_primaryClient = client;
+	m_indexValid    = false;
 
 	if (m_primaryClient != NULL) {
 		m_events->adoptHandler(m_events->forIKeyState().keyDown(),
@@ -1071,20 +1119,91 @@ CInputFilter::operator!=(const CInputFilter& x) const
 void
 CInputFilter::handleEvent(const CEvent& event, void*)
 {
+	if (!m_indexValid) {
+		buildIndex();
+	}
+
 	// copy event and adjust target
 	CEvent myEvent(event.getType(), this, event.getData(),
 								event.getFlags() | CEvent::kDontFreeData |
 								CEvent::kDeliverImmediately);
 
-	// let each rule try to match the event until one does
-	for (CRuleList::iterator rule  = m_ruleList.begin();
-							 rule != m_ruleList.end(); ++rule) {
-		if (rule->handleEvent(myEvent)) {
+	// only the rules indexed under the event's key and those that can't
+	// be indexed can match.  try them in rule order so the first rule
+	// that matches still wins.
+	static const CRuleIndexList s_none;
+	const CRuleIndexList* indexed = &s_none;
+	CIndexKey key;
+	if (getEventKey(event, key)) {
+		CRuleIndex::const_iterator i = m_ruleIndex.find(key);
+		if (i != m_ruleIndex.end()) {
+			indexed = &i->second;
+		}
+	}
+	CRuleIndexList::const_iterator i = indexed->begin();
+	CRuleIndexList::const_iterator j = m_unindexedRules.begin();
+	while (i != indexed->end() || j != m_unindexedRules.end()) {
+		UInt32 index;
+		if (j == m_unindexedRules.end() ||
+			(i != indexed->end() && *i < *j)) {
+			index = *i++;
+		}
+		else {
+			index = *j++;
+		}
+		if (m_ruleList[index].handleEvent(myEvent)) {
 			// handled
 			return;
 		}
 	}
 
-	// not handled so pass through
-	m_events->addEvent(myEvent);
+	// not handled so pass it straight on to the server
+	m_events->dispatchEvent(myEvent);
+}
+
+void
+CInputFilter::buildIndex()
+{
+	m_ruleIndex.clear();
+	m_unindexedRules.clear();
+	for (UInt32 index = 0; index < m_ruleList.size(); ++index) {
+		// NULL condition never matches
+		const CCondition* condition = m_ruleList[index].getCondition();
+		if (condition == NULL) {
+			continue;
+		}
+
+		CIndexKey key;
+		if (condition->getIndexKey(key)) {
+			m_ruleIndex[key].push_back(index);
+		}
+		else {
+			m_unindexedRules.push_back(index);
+		}
+	}
+	m_indexValid = true;
+}
+
+bool
+CInputFilter::getEventKey(const CEvent& event, CIndexKey& key)
+{
+	CEvent::Type type = event.getType();
+	if (type == m_events->forIPrimaryScreen().hotKeyDown() ||
+		type == m_events->forIPrimaryScreen().hotKeyUp()) {
+		IPlatformScreen::CHotKeyInfo* kinfo =
+			reinterpret_cast<IPlatformScreen::CHotKeyInfo*>(event.getData());
+		key = makeHotKeyIndexKey(kinfo->m_id);
+		return true;
+	}
+	if (type == m_events->forIPrimaryScreen().buttonDown() ||
+		type == m_events->forIPrimaryScreen().buttonUp()) {
+		IPlatformScreen::CButtonInfo* minfo =
+			reinterpret_cast<IPlatformScreen::CButtonInfo*>(event.getData());
+		key = makeButtonIndexKey(minfo->m_button,
+							minfo->m_mask & ~s_ignoreButtonMask);
+		return true;
+	}
+
+	// no indexed condition matches other events
+	return false;
 }
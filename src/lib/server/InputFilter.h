@@ -41,6 +41,10 @@ public:
 		kDeactivate
 	};
 
+	// identifies the events a condition can match so rules can be looked
+	// up instead of asking every condition about every event
+	typedef std::pair<UInt32, UInt32> CIndexKey;
+
 	class CCondition {
 	public:
 		CCondition();
@@ -51,6 +55,10 @@ public:
 
 		virtual EFilterStatus	match(const CEvent&) = 0;
 
+		// get the key of the events this condition can match.  returns
+		// false if the condition has to be tried on every event.
+		virtual bool			getIndexKey(CIndexKey&) const;
+
 		virtual void			enablePrimary(CPrimaryClient*);
 		virtual void			disablePrimary(CPrimaryClient*);
 	};
@@ -69,6 +77,7 @@ public:
 		virtual CCondition*		clone() const;
 		virtual CString			format() const;
 		virtual EFilterStatus	match(const CEvent&);
+		virtual bool			getIndexKey(CIndexKey&) const;
 		virtual void			enablePrimary(CPrimaryClient*);
 		virtual void			disablePrimary(CPrimaryClient*);
 
@@ -93,6 +102,7 @@ public:
 		virtual CCondition*		clone() const;
 		virtual CString			format() const;
 		virtual EFilterStatus	match(const CEvent&);
+		virtual bool			getIndexKey(CIndexKey&) const;
 
 	private:
 		ButtonID				m_button;
@@ -321,7 +331,8 @@ public:
 	virtual ~CInputFilter();
 
 #ifdef TEST_ENV
-	CInputFilter() : m_primaryClient(NULL) { }
+	CInputFilter() : m_primaryClient(NULL), m_indexValid(false) { }
+	void				handleEventForTest(const CEvent& event) { handleEvent(event, NULL); }
 #endif
 
 	CInputFilter&		operator=(const CInputFilter&);
@@ -354,8 +365,21 @@ private:
 	// event handling
 	void				handleEvent(const CEvent&, void*);
 
+	// rule lookup
+	void				buildIndex();
+	bool				getEventKey(const CEvent&, CIndexKey&);
+
 private:
+	typedef std::vector<UInt32> CRuleIndexList;
+	typedef std::map<CIndexKey, CRuleIndexList> CRuleIndex;
+
 	CRuleList			m_ruleList;
 	CPrimaryClient*		m_primaryClient;
 	IEventQueue*		m_events;
+
+	// indexes into m_ruleList, in rule order.  the index is rebuilt on
+	// the next event after the rules or their hot key ids change.
+	CRuleIndex			m_ruleIndex;
+	CRuleIndexList		m_unindexedRules;
+	bool				m_indexValid;
 };
@@ -0,0 +1,52 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/KeyBroadcast.h"
+
+#include "synergy/ProtocolUtil.h"
+
+//
+// CKeyBroadcast
+//
+
+CKeyBroadcast::CKeyBroadcast(bool press, KeyID key,
+				KeyModifierMask mask, KeyButton button) :
+	m_press(press),
+	m_key(key),
+	m_mask(mask),
+	m_button(button)
+{
+	// do nothing
+}
+
+const CString&
+CKeyBroadcast::getMessage(const char* fmt)
+{
+	// formats are the constants from protocol_types.h so comparing the
+	// pointers is enough.  there are only ever a few of them.
+	for (CMessageList::const_iterator i = m_messages.begin();
+								i != m_messages.end(); ++i) {
+		if (i->first == fmt) {
+			return i->second;
+		}
+	}
+
+	m_messages.push_back(std::make_pair(fmt, CString()));
+	CProtocolUtil::appendf(m_messages.back().second, fmt,
+							m_key, m_mask, m_button);
+	return m_messages.back().second;
+}
@@ -0,0 +1,73 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "synergy/key_types.h"
+#include "base/String.h"
+#include "common/stdvector.h"
+
+//! Key event sent to several clients
+/*!
+Holds a key press or release that goes to more than one client, for
+instance while the keyboard is being broadcast.  The message is encoded
+at most once per wire format and the same bytes are written to every
+client that speaks that format.
+*/
+class CKeyBroadcast {
+public:
+	CKeyBroadcast(bool press, KeyID, KeyModifierMask, KeyButton);
+
+	//! @name manipulators
+	//@{
+
+	//! Get the encoded message
+	/*!
+	Returns the event encoded with \p fmt, a \c kMsgDKeyDown or
+	\c kMsgDKeyUp style format taking the key, mask and button in that
+	order (trailing arguments may be left out by the format).  Encodes
+	it the first time a format is asked for.
+	*/
+	const CString&		getMessage(const char* fmt);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test for a key press
+	bool				isPress() const { return m_press; }
+
+	//! Get the key
+	KeyID				getKey() const { return m_key; }
+
+	//! Get the modifier mask
+	KeyModifierMask		getMask() const { return m_mask; }
+
+	//! Get the key button
+	KeyButton			getButton() const { return m_button; }
+
+	//@}
+
+private:
+	typedef std::vector<std::pair<const char*, CString> > CMessageList;
+
+	bool				m_press;
+	KeyID				m_key;
+	KeyModifierMask		m_mask;
+	KeyButton			m_button;
+	CMessageList		m_messages;
+};
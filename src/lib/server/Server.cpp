@@ -21,6 +21,7 @@
 
 #include "server/ClientProxy.h"
 #include "server/ClientProxyUnknown.h"
+#include "server/KeyBroadcast.h"
 #include "server/PrimaryClient.h"
 #include "synergy/IPlatformScreen.h"
 #include "synergy/DropHelper.h"
@@ -31,6 +32,8 @@
 #include "synergy/FileChunker.h"
 #include "synergy/KeyState.h"
 #include "synergy/Screen.h"
+#include "synergy/InputTrace.h"
+#include "io/CryptoStream_cryptopp.h"
 #include "net/IDataSocket.h"
 #include "net/IListenSocket.h"
 #include "net/XSocket.h"
@@ -38,7 +41,9 @@
 #include "arch/Arch.h"
 #include "base/TMethodJob.h"
 #include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
 #include "base/Log.h"
+#include "base/LatencyStats.h"
 #include "base/TMethodEventJob.h"
 #include "common/stdexcept.h"
 
@@ -47,6 +52,12 @@
 #include <sstream>
 #include <fstream>
 
+// how long a dropped client can take to reconnect and still resume
+static const double		kSessionLifetime = 30.0;
+
+// how many random bytes make a session token
+static const size_t		kSessionTokenSize = 16;
+
 //
 // CServer
 //
@@ -67,6 +78,8 @@ CServer::CServer(
 	m_yDelta2(0),
 	m_config(&config),
 	m_inputFilter(config.getInputFilter()),
+	m_stateSeqNum(0),
+	m_screenSaverSeqNum(0),
 	m_activeSaver(NULL),
 	m_switchDir(kNoDirection),
 	m_switchScreen(NULL),
@@ -80,10 +93,20 @@ CServer::CServer(
 	m_switchNeedsControl(false),
 	m_switchNeedsAlt(false),
 	m_relativeMoves(false),
+	m_motionPending(false),
+	m_relMotionPending(false),
+	m_relMotionDx(0),
+	m_relMotionDy(0),
+	m_motionFlushPosted(false),
+	m_motionSendInterval(0.0),
+	m_motionSendTimer(NULL),
 	m_keyboardBroadcasting(false),
 	m_lockedToScreen(false),
 	m_screen(screen),
 	m_events(events),
+	m_inputChannel(new CInputChannel(events)),
+	m_receivingInput(false),
+	m_inputTrace(NULL),
 	m_sendFileThread(NULL),
 	m_writeToDropDirThread(NULL),
 	m_ignoreFileTransfer(false),
@@ -178,6 +201,14 @@ CServer::CServer(
 							m_inputFilter,
 							new TMethodEventJob<CServer>(this,
 								&CServer::handleFakeInputEndEvent));
+	m_events->adoptHandler(m_events->forCServer().motionFlush(),
+							this,
+							new TMethodEventJob<CServer>(this,
+								&CServer::handleMotionFlushEvent));
+	m_events->adoptHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_inputChannel->getEventTarget(),
+							new TMethodEventJob<CServer>(this,
+								&CServer::handleInputReadyEvent));
 
 	if (m_enableDragDrop) {
 		m_events->adoptHandler(m_events->forIScreen().fileChunkSending(),
@@ -206,6 +237,8 @@ CServer::CServer(
 		m_lockedToScreen = true;
 	}
 
+	// take user input straight from the screen
+	m_screen->setInputChannel(m_inputChannel);
 }
 
 CServer::~CServer()
@@ -214,6 +247,11 @@ CServer::~CServer()
 		return;
 	}
 
+	// stop taking user input from the screen
+	m_screen->setInputChannel(NULL);
+	m_events->removeHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_inputChannel->getEventTarget());
+
 	// remove event handlers and timers
 	m_events->removeHandler(m_events->forIKeyState().keyDown(),
 							m_inputFilter);
@@ -239,8 +277,10 @@ CServer::~CServer()
 							m_inputFilter);
 	m_events->removeHandler(m_events->forIPrimaryScreen().fakeInputEnd(),
 							m_inputFilter);
+	m_events->removeHandler(m_events->forCServer().motionFlush(), this);
 	m_events->removeHandler(CEvent::kTimer, this);
 	stopSwitch();
+	discardMotion();
 
 	// force immediate disconnection of secondary clients
 	disconnect();
@@ -259,6 +299,8 @@ CServer::~CServer()
 	// disable and disconnect primary client
 	m_primaryClient->disable();
 	removeClient(m_primaryClient);
+
+	delete m_inputChannel;
 }
 
 bool
@@ -321,7 +363,9 @@ CServer::adoptClient(CBaseClientProxy* client)
 		return;
 	}
 
-	// add client to client list
+	// add client to client list.  a client resuming its session may
+	// beat us to noticing that its old connection is dead;  it's turned
+	// away like any other and retries until we have noticed.
 	if (!addClient(client)) {
 		// can only have one screen with a given name at any given time
 		LOG((CLOG_WARN "a client with name \"%s\" is already connected", getName(client).c_str()));
@@ -330,13 +374,9 @@ CServer::adoptClient(CBaseClientProxy* client)
 	}
 	LOG((CLOG_NOTE "client \"%s\" has connected", getName(client).c_str()));
 
-	// send configuration options to client
-	sendOptions(client);
-
-	// activate screen saver on new client if active on the primary screen
-	if (m_activeSaver != NULL) {
-		client->screensaver(true);
-	}
+	// send configuration options and the screen saver state to the
+	// client
+	startSession(client);
 
 	// send notification
 	CServer::CScreenConnectedInfo* info =
@@ -461,6 +501,9 @@ CServer::switchScreen(CBaseClientProxy* dst,
 	// stop waiting to switch
 	stopSwitch();
 
+	// the active screen must see all motion up to the switch
+	flushMotion();
+
 	// record new position
 	m_x       = x;
 	m_y       = y;
@@ -508,6 +551,7 @@ CServer::switchScreen(CBaseClientProxy* dst,
 		for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 			m_active->setClipboard(id, &m_clipboards[id].m_clipboard);
 		}
+		noteClipboardsSent(m_active);
 
 		CServer::CSwitchToScreenInfo* info =
 			CServer::CSwitchToScreenInfo::alloc(m_active->getName());
@@ -1107,10 +1151,113 @@ void
 CServer::sendMouseMove()
 {
 	assert(m_active != m_primaryClient);
+
+	// pending relative motion precedes this, pending absolute motion
+	// is superseded by it.
+	m_motionPending = false;
+	flushMotion();
+
 	LOG((CLOG_DEBUG2 "synchronize move on %s by %d,%d", getName(m_active).c_str(), m_x, m_y));
 	m_active->mouseMove(m_x, m_y);
 }
 
+void
+CServer::setInputTrace(CInputTrace* trace)
+{
+	m_inputTrace = trace;
+}
+
+void
+CServer::queueMouseMove()
+{
+	if (m_relMotionPending) {
+		flushMotion();
+	}
+	m_motionPending = true;
+	scheduleMotionFlush();
+}
+
+void
+CServer::queueMouseRelativeMove(SInt32 dx, SInt32 dy)
+{
+	if (m_motionPending) {
+		flushMotion();
+	}
+	m_relMotionPending = true;
+	m_relMotionDx     += dx;
+	m_relMotionDy     += dy;
+	scheduleMotionFlush();
+}
+
+void
+CServer::scheduleMotionFlush()
+{
+	if (m_motionSendInterval > 0.0) {
+		// send at most once per interval.  the first motion after the
+		// mouse has been still goes at once;  motion during the interval
+		// goes when it's over.
+		if (m_motionSendTimer == NULL) {
+			flushMotion();
+			startMotionSendTimer();
+		}
+	}
+	else if (m_receivingInput) {
+		// handleInputReadyEvent() schedules it again when it's done
+		// with the input that's come in so far
+	}
+	else if (m_events->isEmpty()) {
+		// nothing else is waiting so there's nothing to coalesce with
+		flushMotion();
+	}
+	else if (!m_motionFlushPosted) {
+		// more events are waiting, probably more motion.  post a flush
+		// behind them so everything queued so far goes out as a single
+		// message.
+		m_motionFlushPosted = true;
+		m_events->addEvent(CEvent(m_events->forCServer().motionFlush(), this));
+	}
+}
+
+void
+CServer::startMotionSendTimer()
+{
+	m_motionSendTimer = m_events->newOneShotTimer(m_motionSendInterval, NULL);
+	m_events->adoptHandler(CEvent::kTimer, m_motionSendTimer,
+							new TMethodEventJob<CServer>(this,
+								&CServer::handleMotionSendTimeout));
+}
+
+void
+CServer::flushMotion()
+{
+	if (m_relMotionPending) {
+		m_relMotionPending = false;
+		LOG((CLOG_DEBUG2 "relative move on %s by %d,%d", getName(m_active).c_str(), m_relMotionDx, m_relMotionDy));
+		m_active->mouseRelativeMove(m_relMotionDx, m_relMotionDy);
+		m_relMotionDx = 0;
+		m_relMotionDy = 0;
+	}
+	if (m_motionPending) {
+		m_motionPending = false;
+		LOG((CLOG_DEBUG2 "move on %s to %d,%d", getName(m_active).c_str(), m_x, m_y));
+		m_active->mouseMove(m_x, m_y);
+	}
+}
+
+void
+CServer::discardMotion()
+{
+	m_motionPending    = false;
+	m_relMotionPending = false;
+	m_relMotionDx      = 0;
+	m_relMotionDy      = 0;
+	if (m_motionSendTimer != NULL) {
+		m_events->removeHandler(CEvent::kTimer, m_motionSendTimer);
+		m_events->deleteTimer(m_motionSendTimer);
+		m_motionSendTimer = NULL;
+	}
+}
+
 void
 CServer::sendOptions(CBaseClientProxy* client) const
 {
@@ -1189,6 +1336,12 @@ CServer::processOptions()
 		else if (id == kOptionRelativeMouseMoves) {
 			newRelativeMoves = (value != 0);
 		}
+		else if (id == kOptionMouseSendInterval) {
+			m_motionSendInterval = 1.0e-3 * static_cast<double>(value);
+			if (m_motionSendInterval < 0.0) {
+				m_motionSendInterval = 0.0;
+			}
+		}
 	}
 	if (m_relativeMoves && !newRelativeMoves) {
 		stopRelativeMoves();
@@ -1260,6 +1413,7 @@ CServer::handleClipboardGrabbed(const CEvent& event, void* vclient)
 		clipboard.m_clipboard.close();
 	}
 	clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+	++clipboard.m_clipboardVersion;
 
 	// tell all other screens to take ownership of clipboard.  tell the
 	// grabber that it's clipboard isn't dirty.
@@ -1384,6 +1538,7 @@ CServer::handleClientDisconnected(const CEvent&, void* vclient)
 	// client has disconnected.  it might be an old client or an
 	// active client.  we don't care so just handle it both ways.
 	CBaseClientProxy* client = reinterpret_cast<CBaseClientProxy*>(vclient);
+	saveSession(client);
 	removeActiveClient(client);
 	removeOldClient(client);
 	delete client;
@@ -1460,6 +1615,7 @@ CServer::handleKeyboardBroadcastEvent(const CEvent& event, void*)
 		m_keyboardBroadcasting        = newState;
 		m_keyboardBroadcastingScreens = info->m_screens;
 		LOG((CLOG_DEBUG "keyboard broadcasting %s: %s", m_keyboardBroadcasting ? "on" : "off", m_keyboardBroadcastingScreens.c_str()));
+		updateKeyboardBroadcastTargets();
 	}
 }
 
@@ -1521,6 +1677,117 @@ CServer::handleFileRecieveCompletedEvent(const CEvent& event, void*)
 	onFileRecieveCompleted();
 }
 
+void
+CServer::handleMotionFlushEvent(const CEvent&, void*)
+{
+	m_motionFlushPosted = false;
+	flushMotion();
+}
+
+void
+CServer::handleMotionSendTimeout(const CEvent&, void*)
+{
+	m_events->removeHandler(CEvent::kTimer, m_motionSendTimer);
+	m_events->deleteTimer(m_motionSendTimer);
+	m_motionSendTimer = NULL;
+
+	// if the mouse is still moving then send what it did during the
+	// interval and start another.  otherwise the next motion goes at once.
+	if (m_motionPending || m_relMotionPending) {
+		flushMotion();
+		startMotionSendTimer();
+	}
+}
+
+void
+CServer::handleInputReadyEvent(const CEvent& event, void*)
+{
+	m_receivingInput = true;
+	CInputChannel::CInput input;
+	while (m_inputChannel->receive(input)) {
+		onInput(input);
+	}
+	const CInputChannel::CInput* overflow =
+		m_inputChannel->receiveOverflow(event);
+	if (overflow != NULL) {
+		onInput(*overflow);
+	}
+	m_receivingInput = false;
+
+	if (m_motionPending || m_relMotionPending) {
+		scheduleMotionFlush();
+	}
+}
+
+void
+CServer::onInput(const CInputChannel::CInput& input)
+{
+	CLatencyStats::record(CLatencyStats::kQueueDwell,
+							ARCH->monotonicTime() - input.m_time);
+	CLatencyTimer timer(CLatencyStats::kRouting);
+
+	// only what a client gets.  input for the server's own screen
+	// isn't relayed, and may be a password typed into it.
+	if (m_inputTrace != NULL && m_active != m_primaryClient) {
+		m_inputTrace->recordInput(input);
+	}
+
+	// motion goes straight to the server.  buttons and keys go through
+	// the input filter like the events they replace, without copying
+	// them to the heap.
+	CEvent::Type type = CEvent::kUnknown;
+	IPlatformScreen::CButtonInfo buttonInfo;
+	IPlatformScreen::CKeyInfo keyInfo;
+	void* data = NULL;
+	switch (input.m_type) {
+	case CInputChannel::CInput::kMotionOnPrimary:
+		onMouseMovePrimary(input.m_x, input.m_y);
+		return;
+
+	case CInputChannel::CInput::kMotionOnSecondary:
+		onMouseMoveSecondary(input.m_x, input.m_y);
+		return;
+
+	case CInputChannel::CInput::kWheel:
+		onMouseWheel(input.m_x, input.m_y);
+		return;
+
+	case CInputChannel::CInput::kButtonDown:
+	case CInputChannel::CInput::kButtonUp:
+		type = (input.m_type == CInputChannel::CInput::kButtonDown) ?
+				m_events->forIPrimaryScreen().buttonDown() :
+				m_events->forIPrimaryScreen().buttonUp();
+		buttonInfo.m_button = input.m_button;
+		buttonInfo.m_mask   = input.m_mask;
+		data                = &buttonInfo;
+		break;
+
+	case CInputChannel::CInput::kKeyDown:
+	case CInputChannel::CInput::kKeyUp:
+	case CInputChannel::CInput::kKeyRepeat:
+		if (input.m_type == CInputChannel::CInput::kKeyDown) {
+			type = m_events->forIKeyState().keyDown();
+		}
+		else if (input.m_type == CInputChannel::CInput::kKeyUp) {
+			type = m_events->forIKeyState().keyUp();
+		}
+		else {
+			type = m_events->forIKeyState().keyRepeat();
+		}
+		keyInfo.m_key              = input.m_key;
+		keyInfo.m_mask             = input.m_mask;
+		keyInfo.m_button           = input.m_keyButton;
+		keyInfo.m_count            = input.m_count;
+		keyInfo.m_screens          = NULL;
+		keyInfo.m_screensBuffer[0] = '\0';
+		data                       = &keyInfo;
+		break;
+	}
+
+	m_events->dispatchEvent(CEvent(type, m_primaryClient->getEventTarget(),
+							data, CEvent::kDontFreeData));
+}
+
 void
 CServer::onClipboardChanged(CBaseClientProxy* sender,
 				ClipboardID id, UInt32 seqNum)
@@ -1549,6 +1816,10 @@ CServer::onClipboardChanged(CBaseClientProxy* sender,
 	// got new data
 	LOG((CLOG_INFO "screen \"%s\" updated clipboard %d", clipboard.m_clipboardOwner.c_str(), id));
 	clipboard.m_clipboardData = data;
+	++clipboard.m_clipboardVersion;
+	if (m_inputTrace != NULL && sender == m_primaryClient) {
+		m_inputTrace->recordClipboard(id, data);
+	}
 
 	// tell all clients except the sender that the clipboard is dirty
 	for (CClientList::const_iterator index = m_clients.begin();
@@ -1559,12 +1830,14 @@ CServer::onClipboardChanged(CBaseClientProxy* sender,
 
 	// send the new clipboard to the active screen
 	m_active->setClipboard(id, &clipboard.m_clipboard);
+	noteClipboardsSent(m_active);
 }
 
 void
 CServer::onScreensaver(bool activated)
 {
 	LOG((CLOG_DEBUG "onScreenSaver %s", activated ? "activated" : "deactivated"));
+	flushMotion();
 
 	if (activated) {
 		// save current screen and position
@@ -1609,10 +1882,12 @@ CServer::onScreensaver(bool activated)
 	}
 
 	// send message to all clients
+	m_screenSaverSeqNum = ++m_stateSeqNum;
 	for (CClientList::const_iterator index = m_clients.begin();
 								index != m_clients.end(); ++index) {
 		CBaseClientProxy* client = index->second;
 		client->screensaver(activated);
+		sendSessionSeqNum(client);
 	}
 }
 
@@ -1622,24 +1897,15 @@ CServer::onKeyDown(KeyID id, KeyModifierMask mask, KeyButton button,
 {
 	LOG((CLOG_DEBUG1 "onKeyDown id=%d mask=0x%04x button=0x%04x", id, mask, button));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	if (!m_keyboardBroadcasting && IKeyState::CKeyInfo::isDefault(screens)) {
 		m_active->keyDown(id, mask, button);
 	}
 	else {
-		if (!screens && m_keyboardBroadcasting) {
-			screens = m_keyboardBroadcastingScreens.c_str();
-			if (IKeyState::CKeyInfo::isDefault(screens)) {
-				screens = "*";
-			}
-		}
-		for (CClientList::const_iterator index = m_clients.begin();
-								index != m_clients.end(); ++index) {
-			if (IKeyState::CKeyInfo::contains(screens, index->first)) {
-				index->second->keyDown(id, mask, button);
-			}
-		}
+		CKeyBroadcast key(true, id, mask, button);
+		sendKeyToScreens(key, screens);
 	}
 }
 
@@ -1649,24 +1915,15 @@ CServer::onKeyUp(KeyID id, KeyModifierMask mask, KeyButton button,
 {
 	LOG((CLOG_DEBUG1 "onKeyUp id=%d mask=0x%04x button=0x%04x", id, mask, button));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	if (!m_keyboardBroadcasting && IKeyState::CKeyInfo::isDefault(screens)) {
 		m_active->keyUp(id, mask, button);
 	}
 	else {
-		if (!screens && m_keyboardBroadcasting) {
-			screens = m_keyboardBroadcastingScreens.c_str();
-			if (IKeyState::CKeyInfo::isDefault(screens)) {
-				screens = "*";
-			}
-		}
-		for (CClientList::const_iterator index = m_clients.begin();
-								index != m_clients.end(); ++index) {
-			if (IKeyState::CKeyInfo::contains(screens, index->first)) {
-				index->second->keyUp(id, mask, button);
-			}
-		}
+		CKeyBroadcast key(false, id, mask, button);
+		sendKeyToScreens(key, screens);
 	}
 }
 
@@ -1676,16 +1933,40 @@ CServer::onKeyRepeat(KeyID id, KeyModifierMask mask,
 {
 	LOG((CLOG_DEBUG1 "onKeyRepeat id=%d mask=0x%04x count=%d button=0x%04x", id, mask, count, button));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	m_active->keyRepeat(id, mask, count, button);
 }
 
+void
+CServer::sendKeyToScreens(CKeyBroadcast& key, const char* screens)
+{
+	if (IKeyState::CKeyInfo::isDefault(screens)) {
+		// keyboard broadcasting
+		for (std::vector<CBaseClientProxy*>::const_iterator
+								index  = m_keyboardBroadcastTargets.begin();
+								index != m_keyboardBroadcastTargets.end();
+								++index) {
+			(*index)->sendKey(key);
+		}
+	}
+	else {
+		for (CClientList::const_iterator index = m_clients.begin();
+								index != m_clients.end(); ++index) {
+			if (IKeyState::CKeyInfo::contains(screens, index->first)) {
+				index->second->sendKey(key);
+			}
+		}
+	}
+}
+
 void
 CServer::onMouseDown(ButtonID id)
 {
 	LOG((CLOG_DEBUG1 "onMouseDown id=%d", id));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	m_active->mouseDown(id);
@@ -1699,6 +1980,7 @@ CServer::onMouseUp(ButtonID id)
 {
 	LOG((CLOG_DEBUG1 "onMouseUp id=%d", id));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	m_active->mouseUp(id);
@@ -1863,6 +2145,9 @@ CServer::sendDragInfo(CBaseClientProxy* newScreen)
 		LOG((CLOG_DEBUG2 "sending drag information to client"));
 		LOG((CLOG_DEBUG3 "dragging file list: %s", info));
 		LOG((CLOG_DEBUG3 "dragging file list string size: %i", size));
+		if (m_inputTrace != NULL) {
+			m_inputTrace->recordDragInfo(fileCount, infoString);
+		}
 		newScreen->sendDragInfo(fileCount, info, size);
 	}
 }
@@ -1886,8 +2171,7 @@ CServer::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 	// program on the secondary screen to warp the mouse on us, so we
 	// have no idea where it really is.
 	if (isLockedToScreen()) {
-		LOG((CLOG_DEBUG2 "relative move on %s by %d,%d", getName(m_active).c_str(), dx, dy));
-		m_active->mouseRelativeMove(dx, dy);
+		queueMouseRelativeMove(dx, dy);
 		return;
 	}
 
@@ -2022,8 +2306,7 @@ CServer::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 
 		// warp cursor if it moved.
 		if (m_x != xOld || m_y != yOld) {
-			LOG((CLOG_DEBUG2 "move on %s to %d,%d", getName(m_active).c_str(), m_x, m_y));
-			m_active->mouseMove(m_x, m_y);
+			queueMouseMove();
 		}
 	}
 }
@@ -2033,6 +2316,7 @@ CServer::onMouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
 	LOG((CLOG_DEBUG1 "onMouseWheel %+d,%+d", xDelta, yDelta));
 	assert(m_active != NULL);
+	flushMotion();
 
 	// relay
 	m_active->mouseWheel(xDelta, yDelta);
@@ -2098,6 +2382,7 @@ CServer::addClient(CBaseClientProxy* client)
 	// add to list
 	m_clientSet.insert(client);
 	m_clients.insert(std::make_pair(name, client));
+	updateKeyboardBroadcastTargets();
 
 	// initialize client data
 	SInt32 x, y;
@@ -2130,10 +2415,31 @@ CServer::removeClient(CBaseClientProxy* client)
 	// remove from list
 	m_clients.erase(getName(client));
 	m_clientSet.erase(i);
+	updateKeyboardBroadcastTargets();
 
 	return true;
 }
 
+void
+CServer::updateKeyboardBroadcastTargets()
+{
+	m_keyboardBroadcastTargets.clear();
+	if (!m_keyboardBroadcasting) {
+		return;
+	}
+
+	const char* screens = m_keyboardBroadcastingScreens.c_str();
+	if (IKeyState::CKeyInfo::isDefault(screens)) {
+		screens = "*";
+	}
+	for (CClientList::const_iterator index = m_clients.begin();
+								index != m_clients.end(); ++index) {
+		if (IKeyState::CKeyInfo::contains(screens, index->first)) {
+			m_keyboardBroadcastTargets.push_back(index->second);
+		}
+	}
+}
+
 void
 CServer::closeClient(CBaseClientProxy* client, const char* msg)
 {
@@ -2161,6 +2467,9 @@ CServer::closeClient(CBaseClientProxy* client, const char* msg)
 							new TMethodEventJob<CServer>(this,
 								&CServer::handleClientCloseTimeout, client));
 
+	// we hung up on purpose so there's nothing to resume
+	m_sessions.erase(getName(client));
+
 	// move client to closing list
 	removeClient(client);
 	m_oldClients.insert(std::make_pair(client, timer));
@@ -2222,6 +2531,125 @@ CServer::removeOldClient(CBaseClientProxy* client)
 	}
 }
 
+void
+CServer::startSession(CBaseClientProxy* client)
+{
+	CString name = getName(client);
+	double now   = ARCH->time();
+
+	// forget sessions nobody came back for
+	for (CSessions::iterator i = m_sessions.begin(); i != m_sessions.end(); ) {
+		if (i->second.m_expires != 0.0 && i->second.m_expires < now) {
+			m_sessions.erase(i++);
+		}
+		else {
+			++i;
+		}
+	}
+
+	// the options always go because they end the client's handshake
+	sendOptions(client);
+
+	// a resuming client still has everything we sent it up to the
+	// last sequence number it got.  only what changed after that is
+	// sent again.  keys were released and the cursor taken back when
+	// it dropped, and the next enter carries the lock state.
+	CSessions::iterator i = m_sessions.find(name);
+	CString token = client->getResumeToken();
+	if (!token.empty() && i != m_sessions.end() &&
+		i->second.m_token == token && i->second.m_expires != 0.0) {
+		const CSession& session = i->second;
+		UInt32 seqNum = client->getResumeSeqNum();
+		if (seqNum < m_screenSaverSeqNum) {
+			client->screensaver(m_activeSaver != NULL);
+		}
+
+		// clipboards it got that haven't changed since it dropped
+		// needn't be sent again
+		int kept = 0;
+		if (seqNum >= session.m_clipboardSeqNum) {
+			for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+				if (session.m_clipboardVersion[id] ==
+								m_clipboards[id].m_clipboardVersion) {
+					client->setClipboardDirty(id, false);
+					++kept;
+				}
+			}
+		}
+		LOG((CLOG_NOTE "client \"%s\" resumed its session at seqnum=%d of %d, %d of %d clipboards current", name.c_str(), seqNum, m_stateSeqNum, kept, static_cast<int>(kClipboardEnd)));
+	}
+	else {
+		// activate screen saver on new client if active on the primary
+		// screen
+		if (m_activeSaver != NULL) {
+			client->screensaver(true);
+		}
+	}
+
+	// issue a fresh token.  anyone who can guess it can take over the
+	// client's screen so it comes from a CSPRNG.
+	token = newSessionToken();
+	if (client->setSession(token, m_stateSeqNum)) {
+		CSession& session = m_sessions[name];
+		session           = CSession();
+		session.m_token   = token;
+	}
+	else {
+		m_sessions.erase(name);
+	}
+}
+
+CString
+CServer::newSessionToken()
+{
+	CryptoPP::AutoSeededRandomPool random;
+	UInt8 token[kSessionTokenSize];
+	random.GenerateBlock(token, sizeof(token));
+	return CString(reinterpret_cast<const char*>(token), sizeof(token));
+}
+
+void
+CServer::sendSessionSeqNum(CBaseClientProxy* client)
+{
+	CSessions::iterator i = m_sessions.find(getName(client));
+	if (i != m_sessions.end() && i->second.m_expires == 0.0) {
+		client->setSession(i->second.m_token, m_stateSeqNum);
+	}
+}
+
+void
+CServer::noteClipboardsSent(CBaseClientProxy* client)
+{
+	// the client may never see them if its connection drops now.  it
+	// has them once it has seen the next sequence number.
+	CSessions::iterator i = m_sessions.find(getName(client));
+	if (i != m_sessions.end() && i->second.m_expires == 0.0) {
+		i->second.m_clipboardSeqNum = ++m_stateSeqNum;
+		client->setSession(i->second.m_token, m_stateSeqNum);
+	}
+}
+
+void
+CServer::saveSession(CBaseClientProxy* client)
+{
+	// only clients that were dropped while connected can resume
+	if (m_clientSet.count(client) == 0) {
+		return;
+	}
+	CSessions::iterator i = m_sessions.find(getName(client));
+	if (i == m_sessions.end()) {
+		return;
+	}
+
+	CSession& session = i->second;
+	session.m_expires = ARCH->time() + kSessionLifetime;
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		session.m_clipboardVersion[id] =
+			client->isClipboardDirty(id) ? 0 :
+								m_clipboards[id].m_clipboardVersion;
+	}
+}
+
 void
 CServer::forceLeaveClient(CBaseClientProxy* client)
 {
@@ -2236,6 +2664,9 @@ CServer::forceLeaveClient(CBaseClientProxy* client)
 			stopSwitch();
 		}
 
+		// motion queued for this client can't be delivered
+		discardMotion();
+
 		// don't notify active screen since it has probably already
 		// disconnected.
 		LOG((CLOG_INFO "jump from \"%s\" to \"%s\" at %d,%d", getName(active).c_str(), getName(m_primaryClient).c_str(), m_x, m_y));
@@ -2271,12 +2702,27 @@ CServer::CClipboardInfo::CClipboardInfo() :
 	m_clipboard(),
 	m_clipboardData(),
 	m_clipboardOwner(),
-	m_clipboardSeqNum(0)
+	m_clipboardSeqNum(0),
+	m_clipboardVersion(1)
 {
 	// do nothing
 }
 
 
+//
+// CServer::CSession
+//
+
+CServer::CSession::CSession() :
+	m_expires(0.0),
+	m_clipboardSeqNum(0)
+{
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		m_clipboardVersion[id] = 0;
+	}
+}
+
+
 //
 // CServer::CLockCursorToScreenInfo
 //
@@ -2285,7 +2731,7 @@ CServer::CLockCursorToScreenInfo*
 CServer::CLockCursorToScreenInfo::alloc(State state)
 {
 	CLockCursorToScreenInfo* info =
-		(CLockCursorToScreenInfo*)malloc(sizeof(CLockCursorToScreenInfo));
+		(CLockCursorToScreenInfo*)CEventDataPool::alloc(sizeof(CLockCursorToScreenInfo));
 	info->m_state = state;
 	return info;
 }
@@ -2299,7 +2745,7 @@ CServer::CSwitchToScreenInfo*
 CServer::CSwitchToScreenInfo::alloc(const CString& screen)
 {
 	CSwitchToScreenInfo* info =
-		(CSwitchToScreenInfo*)malloc(sizeof(CSwitchToScreenInfo) +
+		(CSwitchToScreenInfo*)CEventDataPool::alloc(sizeof(CSwitchToScreenInfo) +
 								screen.size());
 	strcpy(info->m_screen, screen.c_str());
 	return info;
@@ -2314,7 +2760,7 @@ CServer::CSwitchInDirectionInfo*
 CServer::CSwitchInDirectionInfo::alloc(EDirection direction)
 {
 	CSwitchInDirectionInfo* info =
-		(CSwitchInDirectionInfo*)malloc(sizeof(CSwitchInDirectionInfo));
+		(CSwitchInDirectionInfo*)CEventDataPool::alloc(sizeof(CSwitchInDirectionInfo));
 	info->m_direction = direction;
 	return info;
 }
@@ -2327,7 +2773,7 @@ CServer::CKeyboardBroadcastInfo*
 CServer::CKeyboardBroadcastInfo::alloc(State state)
 {
 	CKeyboardBroadcastInfo* info =
-		(CKeyboardBroadcastInfo*)malloc(sizeof(CKeyboardBroadcastInfo));
+		(CKeyboardBroadcastInfo*)CEventDataPool::alloc(sizeof(CKeyboardBroadcastInfo));
 	info->m_state      = state;
 	info->m_screens[0] = '\0';
 	return info;
@@ -2337,7 +2783,7 @@ CServer::CKeyboardBroadcastInfo*
 CServer::CKeyboardBroadcastInfo::alloc(State state, const CString& screens)
 {
 	CKeyboardBroadcastInfo* info =
-		(CKeyboardBroadcastInfo*)malloc(sizeof(CKeyboardBroadcastInfo) +
+		(CKeyboardBroadcastInfo*)CEventDataPool::alloc(sizeof(CKeyboardBroadcastInfo) +
 								screens.size());
 	info->m_state = state;
 	strcpy(info->m_screens, screens.c_str());
@@ -25,6 +25,7 @@
 #include "synergy/mouse_types.h"
 #include "synergy/INode.h"
 #include "synergy/DragInformation.h"
+#include "synergy/InputChannel.h"
 #include "base/Event.h"
 #include "base/Stopwatch.h"
 #include "base/EventTypes.h"
@@ -33,9 +34,11 @@
 #include "common/stdvector.h"
 
 class CBaseClientProxy;
+class CKeyBroadcast;
 class CEventQueueTimer;
 class CPrimaryClient;
 class CInputFilter;
+class CInputTrace;
 class CScreen;
 class IEventQueue;
 class CThread;
@@ -163,6 +166,14 @@ public:
 	//! Force a mouse move message to the active client.
 	void				sendMouseMove();
 
+	//! Record what's relayed to clients
+	/*!
+	Records the input, clipboards and dragged files the server relays to
+	its clients in \p trace, or stops recording if \p trace is NULL.
+	The caller retains ownership of \p trace.
+	*/
+	void				setInputTrace(CInputTrace* trace);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -290,6 +301,26 @@ private:
 	// stop relative mouse moves
 	void				stopRelativeMoves();
 
+	// queue an absolute (at m_x, m_y) or relative mouse move for the
+	// active client.  motion is coalesced until the event queue drains
+	// or the send interval expires, whichever applies.
+	void				queueMouseMove();
+	void				queueMouseRelativeMove(SInt32 dx, SInt32 dy);
+
+	// arrange for queued motion to be sent
+	void				scheduleMotionFlush();
+
+	// start the interval during which motion is held back
+	void				startMotionSendTimer();
+
+	// send queued motion to the active client now.  this must be called
+	// before anything else is sent to the active client so the client
+	// sees events in the order they happened.
+	void				flushMotion();
+
+	// forget queued motion without sending it
+	void				discardMotion();
+
 	// send screen options to \c client
 	void				sendOptions(CBaseClientProxy* client) const;
 
@@ -321,8 +352,12 @@ private:
 	void				handleFakeInputEndEvent(const CEvent&, void*);
 	void				handleFileChunkSendingEvent(const CEvent&, void*);
 	void				handleFileRecieveCompletedEvent(const CEvent&, void*);
+	void				handleMotionFlushEvent(const CEvent&, void*);
+	void				handleMotionSendTimeout(const CEvent&, void*);
+	void				handleInputReadyEvent(const CEvent&, void*);
 
 	// event processing
+	void				onInput(const CInputChannel::CInput&);
 	void				onClipboardChanged(CBaseClientProxy* sender,
 							ClipboardID id, UInt32 seqNum);
 	void				onScreensaver(bool activated);
@@ -331,6 +366,7 @@ private:
 	void				onKeyUp(KeyID, KeyModifierMask, KeyButton,
 							const char* screens);
 	void				onKeyRepeat(KeyID, KeyModifierMask, SInt32, KeyButton);
+	void				sendKeyToScreens(CKeyBroadcast&, const char* screens);
 	void				onMouseDown(ButtonID);
 	void				onMouseUp(ButtonID);
 	bool				onMouseMovePrimary(SInt32 x, SInt32 y);
@@ -345,6 +381,9 @@ private:
 	// remove client from list and detach event handlers for client
 	bool				removeClient(CBaseClientProxy*);
 
+	// work out which clients broadcast keys go to
+	void				updateKeyboardBroadcastTargets();
+
 	// close a client
 	void				closeClient(CBaseClientProxy*, const char* msg);
 
@@ -359,6 +398,24 @@ private:
 	void				removeActiveClient(CBaseClientProxy*);
 	void				removeOldClient(CBaseClientProxy*);
 
+	// send the client its options and the screen saver state.  a client
+	// resuming its previous session with a valid token only gets the
+	// screen saver state if it changed since.  hand out a token for the
+	// next reconnect.
+	void				startSession(CBaseClientProxy*);
+
+	// tell the client the sequence number of the latest state change
+	void				sendSessionSeqNum(CBaseClientProxy*);
+
+	// note that clipboards went out to the client
+	void				noteClipboardsSent(CBaseClientProxy*);
+
+	// make up a token for a session
+	static CString		newSessionToken();
+
+	// remember what a dropped client already has so it can resume
+	void				saveSession(CBaseClientProxy*);
+
 	// force the cursor off of \p client
 	void				forceLeaveClient(CBaseClientProxy* client);
 	
@@ -387,7 +444,20 @@ private:
 		CString			m_clipboardData;
 		CString			m_clipboardOwner;
 		UInt32			m_clipboardSeqNum;
+		UInt32			m_clipboardVersion;
+	};
+
+	class CSession {
+	public:
+		CSession();
+
+	public:
+		CString			m_token;
+		double			m_expires;
+		UInt32			m_clipboardSeqNum;
+		UInt32			m_clipboardVersion[kClipboardEnd];
 	};
+	typedef std::map<CString, CSession> CSessions;
 
 	// the primary screen client
 	CPrimaryClient*		m_primaryClient;
@@ -428,6 +498,14 @@ private:
 	// clipboard cache
 	CClipboardInfo		m_clipboards[kClipboardEnd];
 
+	// resumable client sessions indexed by name
+	CSessions			m_sessions;
+
+	// numbers every change to state clients keep across connections
+	// and the latest change to the screen saver
+	UInt32				m_stateSeqNum;
+	UInt32				m_screenSaverSeqNum;
+
 	// state saved when screen saver activates
 	CBaseClientProxy*	m_activeSaver;
 	SInt32				m_xSaver, m_ySaver;
@@ -457,11 +535,26 @@ private:
 	// relative mouse move option
 	bool				m_relativeMoves;
 
+	// coalesced motion for the active client.  m_motionSendInterval is
+	// the minimum time between motion messages;  zero means send once
+	// per pass through the event queue.  m_motionSendTimer runs while
+	// an interval is in progress.
+	bool				m_motionPending;
+	bool				m_relMotionPending;
+	SInt32				m_relMotionDx, m_relMotionDy;
+	bool				m_motionFlushPosted;
+	double				m_motionSendInterval;
+	CEventQueueTimer*	m_motionSendTimer;
+
 	// flag whether or not we have broadcasting enabled and the screens to
 	// which we should send broadcasted keys.
 	bool				m_keyboardBroadcasting;
 	CString				m_keyboardBroadcastingScreens;
 
+	// the clients broadcasted keys go to.  kept up to date as clients
+	// come and go so a key doesn't have to search the screen list.
+	std::vector<CBaseClientProxy*>	m_keyboardBroadcastTargets;
+
 	// screen locking (former scroll lock)
 	bool				m_lockedToScreen;
 
@@ -470,6 +563,15 @@ private:
 
 	IEventQueue*		m_events;
 
+	// user input from the primary screen.  m_receivingInput is true
+	// while a batch of it is being handled, so motion is flushed once
+	// at the end of the batch.
+	CInputChannel*		m_inputChannel;
+	bool				m_receivingInput;
+
+	// where to record what's relayed to clients, if anywhere
+	CInputTrace*		m_inputTrace;
+
 	// file transfer
 	size_t				m_expectedFileSize;
 	CString				m_receivedFileData;
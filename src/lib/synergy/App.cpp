@@ -30,7 +30,9 @@
 #include "base/TMethodEventJob.h"
 #include "ipc/IpcMessage.h"
 #include "ipc/Ipc.h"
+#include "net/XSocket.h"
 #include "base/EventQueue.h"
+#include "base/LatencyStats.h"
 
 #if SYSAPI_WIN32
 #include "arch/win32/ArchMiscWindows.h"
@@ -385,8 +387,29 @@ CApp::initApp(int argc, const char** argv)
 void
 CApp::initIpcClient()
 {
-	m_ipcClient = new CIpcClient(m_events, m_socketMultiplexer);
-	m_ipcClient->connect();
+	m_ipcClient = nullptr;
+
+#if SYSAPI_UNIX
+	// a daemon running as our user has a local socket, which nobody else
+	// can get into.  we don't want its log so there's no log ring.
+	try {
+		m_ipcClient = new CIpcClient(m_events, m_socketMultiplexer,
+							ARCH->concatPath(ARCH->getUserDirectory(),
+								IPC_LOCAL_NAME), false);
+		m_ipcClient->connect();
+		LOG((CLOG_DEBUG "ipc using local socket"));
+	}
+	catch (XSocket& e) {
+		LOG((CLOG_DEBUG "ipc local socket unavailable, using tcp: %s", e.what()));
+		delete m_ipcClient;
+		m_ipcClient = nullptr;
+	}
+#endif
+
+	if (m_ipcClient == nullptr) {
+		m_ipcClient = new CIpcClient(m_events, m_socketMultiplexer);
+		m_ipcClient->connect();
+	}
 
 	m_events->adoptHandler(
 		m_events->forCIpcClient().messageReceived(), m_ipcClient,
@@ -409,6 +432,9 @@ CApp::handleIpcMessage(const CEvent& e, void*)
 		LOG((CLOG_INFO "got ipc shutdown message"));
 		m_events->addEvent(CEvent(CEvent::kQuit));
     }
+	else if (m->type() == kIpcStatsRequest) {
+		m_ipcClient->send(CIpcStatsMessage(CLatencyStats::format()));
+	}
 }
 
 void
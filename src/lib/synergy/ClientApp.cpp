@@ -59,11 +59,13 @@
 #include <stdio.h>
 
 #define RETRY_TIME 1.0
+#define MIN_RETRY_TIME 0.01
 
 CClientApp::CClientApp(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver) :
 	CApp(events, createTaskBarReceiver, new CArgs()),
 	m_client(NULL),
-	m_clientScreen(NULL)
+	m_clientScreen(NULL),
+	m_retryTime(0.0)
 {
 }
 
@@ -263,31 +265,26 @@ CClientApp::updateStatus(const CString& msg)
 void
 CClientApp::resetRestartTimeout()
 {
-	// retry time can nolonger be changed
-	//s_retryTime = 0.0;
+	m_retryTime = 0.0;
 }
 
 
 double
 CClientApp::nextRestartTimeout()
 {
-	// retry at a constant rate (Issue 52)
-	return RETRY_TIME;
-
-	/*
-	// choose next restart timeout.  we start with rapid retries
-	// then slow down.
-	if (s_retryTime < 1.0) {
-	s_retryTime = 1.0;
-	}
-	else if (s_retryTime < 3.0) {
-	s_retryTime = 3.0;
+	// choose next restart timeout.  most drops are a blip in the link
+	// so start retrying within milliseconds, then back off to a
+	// constant rate (Issue 52).
+	if (m_retryTime < MIN_RETRY_TIME) {
+		m_retryTime = MIN_RETRY_TIME;
 	}
 	else {
-	s_retryTime = 5.0;
+		m_retryTime *= 2.0;
+	}
+	if (m_retryTime > RETRY_TIME) {
+		m_retryTime = RETRY_TIME;
 	}
-	return s_retryTime;
-	*/
+	return m_retryTime;
 }
 
 
@@ -340,7 +337,7 @@ void
 CClientApp::scheduleClientRestart(double retryTime)
 {
 	// install a timer and handler to retry later
-	LOG((CLOG_DEBUG "retry in %.0f seconds", retryTime));
+	LOG((CLOG_DEBUG "retry in %.3f seconds", retryTime));
 	CEventQueueTimer* timer = m_events->newOneShotTimer(retryTime, NULL);
 	m_events->adoptHandler(CEvent::kTimer, timer,
 		new TMethodEventJob<CClientApp>(this, &CClientApp::handleClientRestart, timer));
@@ -42,6 +42,10 @@ public:
 	CClientApp(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver);
 	virtual ~CClientApp();
 
+#ifdef TEST_ENV
+	void setClient(CClient* client, CScreen* screen) { m_client = client; m_clientScreen = screen; }
+#endif
+
 	// Parse client specific command line arguments.
 	void parseArgs(int argc, const char* const* argv);
 
@@ -91,4 +95,5 @@ private:
 private:
 	CClient*			m_client;
 	CScreen*			m_clientScreen;
+	double				m_retryTime;
 };
@@ -111,6 +111,12 @@ CClipboard::unmarshall(const CString& data, Time time)
 	IClipboard::unmarshall(this, data, time);
 }
 
+void
+CClipboard::unmarshall(const char* data, UInt32 size, Time time)
+{
+	IClipboard::unmarshall(this, data, size, time);
+}
+
 CString
 CClipboard::marshall() const
 {
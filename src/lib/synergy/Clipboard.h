@@ -39,6 +39,12 @@ public:
 	*/
 	void				unmarshall(const CString& data, Time time);
 
+	//! Unmarshall clipboard data
+	/*!
+	Like the above but from \p size bytes at \p data.
+	*/
+	void				unmarshall(const char* data, UInt32 size, Time time);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -26,6 +26,7 @@
 #include "ipc/IpcMessage.h"
 #include "ipc/IpcLogOutputter.h"
 #include "net/SocketMultiplexer.h"
+#include "net/XSocket.h"
 #include "arch/XArch.h"
 #include "base/Log.h"
 #include "base/TMethodJob.h"
@@ -217,6 +218,18 @@ CDaemonApp::mainLoop(bool logToFile)
 			new TMethodEventJob<CDaemonApp>(this, &CDaemonApp::handleIpcMessage));
 
 		m_ipcServer->listen();
+
+#if SYSAPI_UNIX
+		// synergys/c running as the same user connect here first.  the
+		// gui still uses tcp.
+		try {
+			m_ipcServer->listenLocal(ARCH->concatPath(
+							ARCH->getUserDirectory(), IPC_LOCAL_NAME));
+		}
+		catch (XSocket& e) {
+			LOG((CLOG_WARN "cannot listen on local ipc socket: %s", e.what()));
+		}
+#endif
 		
 #if SYSAPI_WIN32
 
@@ -344,12 +357,23 @@ CDaemonApp::handleIpcMessage(const CEvent& e, void*)
 			break;
 		}
 
+		case kIpcStatsRequest:
+			// only synergys/c have stats
+			m_ipcServer->send(*m, kIpcClientNode);
+			break;
+
+		case kIpcStats:
+			// only syntool asks for them;  the gui can't read them
+			m_ipcServer->send(*m, kIpcClientTool);
+			break;
+
 		case kIpcHello:
 			CIpcHelloMessage* hm = static_cast<CIpcHelloMessage*>(m);
 			CString type;
 			switch (hm->clientType()) {
 				case kIpcClientGui: type = "gui"; break;
 				case kIpcClientNode: type = "node"; break;
+				case kIpcClientTool: type = "tool"; break;
 				default: type = "unknown"; break;
 			}
 
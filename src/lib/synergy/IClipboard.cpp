@@ -25,21 +25,36 @@
 
 void
 IClipboard::unmarshall(IClipboard* clipboard, const CString& data, Time time)
+{
+	unmarshall(clipboard, data.data(), static_cast<UInt32>(data.size()), time);
+}
+
+void
+IClipboard::unmarshall(IClipboard* clipboard,
+				const char* data, UInt32 dataSize, Time time)
 {
 	assert(clipboard != NULL);
 
-	const char* index = data.data();
+	const char* index = data;
+	const char* end   = data + dataSize;
 
 	// clear existing data
 	clipboard->open(time);
 	clipboard->empty();
 
 	// read the number of formats
-	const UInt32 numFormats = readUInt32(index);
-	index += 4;
+	UInt32 numFormats = 0;
+	if (dataSize >= 4) {
+		numFormats = readUInt32(index);
+		index += 4;
+	}
 
 	// read each format
 	for (UInt32 i = 0; i < numFormats; ++i) {
+		if (end - index < 8) {
+			break;
+		}
+
 		// get the format id
 		IClipboard::EFormat format =
 			static_cast<IClipboard::EFormat>(readUInt32(index));
@@ -48,6 +63,9 @@ IClipboard::unmarshall(IClipboard* clipboard, const CString& data, Time time)
 		// get the size of the format data
 		UInt32 size = readUInt32(index);
 		index += 4;
+		if (size > static_cast<UInt32>(end - index)) {
+			break;
+		}
 
 		// save the data if it's a known format.  if either the client
 		// or server supports more clipboard formats than the other
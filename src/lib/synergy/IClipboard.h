@@ -54,11 +54,16 @@ public:
 	\c kHTML is a text format encoded in UTF-8 and containing a valid
 	HTML fragment (but not necessarily a complete HTML document).
 	Newlines are LF.
+
+	\c kPNG is an image format.  The data is a complete PNG file.  Peers
+	that don't know this format skip it when unmarshalling so images
+	are usually sent as both \c kBitmap and \c kPNG.
 	*/
 	enum EFormat {
 		kText,			//!< Text format, UTF-8, newline is LF
 		kBitmap,		//!< Bitmap format, BMP 24/32bpp, BI_RGB
 		kHTML,			//!< HTML format, HTML fragment, UTF-8, newline is LF
+		kPNG,			//!< PNG format, PNG file
 		kNumFormats		//!< The number of clipboard formats
 	};
 
@@ -142,6 +147,14 @@ public:
 	static void			unmarshall(IClipboard* clipboard,
 							const CString& data, Time time);
 
+	//! Unmarshall clipboard data
+	/*!
+	Like the above but takes the data from \p size bytes at \p data.
+	Formats that don't fit in \p size are dropped.
+	*/
+	static void			unmarshall(IClipboard* clipboard,
+							const char* data, UInt32 size, Time time);
+
 	//! Copy clipboard
 	/*!
 	Transfers all the data in one clipboard to another.  The
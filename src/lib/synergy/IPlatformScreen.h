@@ -27,6 +27,7 @@
 #include "synergy/option_types.h"
 
 class IClipboard;
+class CInputChannel;
 
 //! Screen interface
 /*!
@@ -133,6 +134,14 @@ public:
 	//! Change dragging status
 	virtual void		setDraggingStarted(bool started) = 0;
 
+	//! Set input channel
+	/*!
+	Sets the channel that user input on a primary screen goes through
+	instead of the event queue, or NULL to go back to the event queue.
+	Screens that don't support a channel may ignore it.
+	*/
+	virtual void		setInputChannel(CInputChannel*) = 0;
+
 	//! Press mouse button.
 	/*!
 	Called when a mouse button press was received from the server.
@@ -195,6 +204,7 @@ public:
 	virtual void		fakeMouseMove(SInt32 x, SInt32 y) = 0;
 	virtual void		fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const = 0;
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const = 0;
+	virtual void		flushFakeInput() = 0;
 	virtual void		mouseWarp(SInt16 x, SInt16 y) = 0;
 
 	// IKeyState overrides
@@ -57,6 +57,14 @@ public:
 	*/
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const = 0;
 
+	//! Flush faked input
+	/*!
+	Send any synthesized input that is still buffered.  The fake
+	methods may leave their input buffered so that a batch of it can
+	be sent at once;  the client calls this after each batch.
+	*/
+	virtual void		flushFakeInput() = 0;
+
 	//@}
 
 	//! Warp the mouse
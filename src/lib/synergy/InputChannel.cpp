@@ -0,0 +1,199 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/InputChannel.h"
+#include "mt/Atomic.h"
+#include "base/IEventQueue.h"
+#include "base/EventDataPool.h"
+#include "base/Log.h"
+#include "arch/Arch.h"
+
+#include <cassert>
+#include <cstdlib>
+
+// the data of the inputReady events that addEvent() queues in front of
+// its event.  they carry no input.
+static char				s_marker;
+
+//
+// CInputChannel
+//
+
+CInputChannel::CInputChannel(IEventQueue* events, UInt32 size) :
+	m_events(events),
+	m_ring(new CInput[size]),
+	m_mask(size - 1),
+	m_head(0),
+	m_tail(0),
+	m_idle(1),
+	m_overflow(0)
+{
+	assert(size != 0 && (size & (size - 1)) == 0);
+}
+
+CInputChannel::~CInputChannel()
+{
+	delete[] m_ring;
+}
+
+void
+CInputChannel::send(const CInput& input)
+{
+	if (m_overflow == 0) {
+		UInt32 head = m_head;
+		if (head - m_tail <= m_mask) {
+			CInput& slot = m_ring[head & m_mask];
+			slot         = input;
+			slot.m_time  = ARCH->monotonicTime();
+
+			// the record must be visible before the count is
+			atomicBarrier();
+			m_head = head + 1;
+
+			// wake the receiver if it's run out of input
+			atomicBarrier();
+			if (atomicCompareAndSwap(&m_idle, 1, 0)) {
+				sendEvent(NULL);
+			}
+			return;
+		}
+	}
+
+	// the ring is full or the receiver is still working through what
+	// didn't fit before.  go through the event queue so nothing is lost
+	// and nothing overtakes what's already on its way.
+	LOG((CLOG_DEBUG1 "input channel full"));
+	atomicAdd(&m_overflow, 1);
+	CInput* copy = static_cast<CInput*>(CEventDataPool::alloc(sizeof(CInput)));
+	*copy        = input;
+	copy->m_time = ARCH->monotonicTime();
+	sendEvent(copy);
+}
+
+void
+CInputChannel::sendMotion(CInput::EType type, SInt32 x, SInt32 y)
+{
+	CInput input;
+	input.m_type      = type;
+	input.m_x         = x;
+	input.m_y         = y;
+	input.m_button    = kButtonNone;
+	input.m_key       = kKeyNone;
+	input.m_mask      = 0;
+	input.m_keyButton = 0;
+	input.m_count     = 0;
+	input.m_time      = 0.0;
+	send(input);
+}
+
+void
+CInputChannel::sendButton(CInput::EType type,
+				ButtonID button, KeyModifierMask mask)
+{
+	CInput input;
+	input.m_type      = type;
+	input.m_x         = 0;
+	input.m_y         = 0;
+	input.m_button    = button;
+	input.m_key       = kKeyNone;
+	input.m_mask      = mask;
+	input.m_keyButton = 0;
+	input.m_count     = 0;
+	input.m_time      = 0.0;
+	send(input);
+}
+
+void
+CInputChannel::sendKey(CInput::EType type, KeyID key,
+				KeyModifierMask mask, SInt32 count, KeyButton button)
+{
+	CInput input;
+	input.m_type      = type;
+	input.m_x         = 0;
+	input.m_y         = 0;
+	input.m_button    = kButtonNone;
+	input.m_key       = key;
+	input.m_mask      = mask;
+	input.m_keyButton = button;
+	input.m_count     = count;
+	input.m_time      = 0.0;
+	send(input);
+}
+
+void
+CInputChannel::addEvent(const CEvent& event)
+{
+	// input still in the ring is received when the inputReady event
+	// already in the queue is handled, and so would anything sent before
+	// then.  queue a marker ahead of the event and send input through the
+	// queue behind it until the receiver has reached the marker.
+	if (m_idle == 0 || m_head != m_tail) {
+		atomicAdd(&m_overflow, 1);
+		sendEvent(reinterpret_cast<CInput*>(&s_marker), CEvent::kDontFreeData);
+	}
+	m_events->addEvent(event);
+}
+
+bool
+CInputChannel::receive(CInput& input)
+{
+	UInt32 tail = m_tail;
+	if (m_head == tail) {
+		// out of input so the next send() has to wake us up.  if some
+		// came in while we weren't looking then try to take the job
+		// back;  if send() beat us to it we'll just get a spare event.
+		m_idle = 1;
+		atomicBarrier();
+		if (m_head == tail) {
+			return false;
+		}
+		atomicCompareAndSwap(&m_idle, 1, 0);
+	}
+
+	// read the record before handing its slot back
+	atomicBarrier();
+	input = m_ring[tail & m_mask];
+	atomicBarrier();
+	m_tail = tail + 1;
+	return true;
+}
+
+const CInputChannel::CInput*
+CInputChannel::receiveOverflow(const CEvent& event)
+{
+	const CInput* input = static_cast<const CInput*>(event.getData());
+	if (input != NULL) {
+		atomicAdd(&m_overflow, -1);
+		if (event.getData() == &s_marker) {
+			return NULL;
+		}
+	}
+	return input;
+}
+
+void*
+CInputChannel::getEventTarget() const
+{
+	return const_cast<void*>(static_cast<const void*>(this));
+}
+
+void
+CInputChannel::sendEvent(CInput* data, UInt32 flags)
+{
+	m_events->addEvent(CEvent(m_events->forIPrimaryScreen().inputReady(),
+							getEventTarget(), data, flags));
+}
@@ -0,0 +1,156 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "synergy/key_types.h"
+#include "synergy/mouse_types.h"
+#include "common/basic_types.h"
+
+class CEvent;
+class IEventQueue;
+
+//! Input from the primary screen
+/*!
+Carries mouse and key input from the primary screen to the server
+without going through the event queue one event at a time.  The screen
+send()s fixed size records into a ring and the server receive()s them
+when it handles the channel's IPrimaryScreenEvents::inputReady event.
+That event is only sent when the server has run out of input, so a
+burst of input costs one event, and the records need no heap
+allocation, no lock and no handler lookup.
+
+There must be only one thread sending and only one receiving, which
+may be different threads.  If the ring fills up the input goes through
+the event queue instead, one event each, until the server has caught
+up, so nothing is lost or reordered.  Other events from the screen,
+like hot keys and the screen saver starting, must go through addEvent()
+to keep their place among the input.
+*/
+class CInputChannel {
+public:
+	//! Input record
+	class CInput {
+	public:
+		enum EType {
+			kMotionOnPrimary,		//!< absolute position in m_x, m_y
+			kMotionOnSecondary,		//!< deltas in m_x, m_y
+			kWheel,					//!< deltas in m_x, m_y
+			kButtonDown,
+			kButtonUp,
+			kKeyDown,
+			kKeyUp,
+			kKeyRepeat
+		};
+
+	public:
+		EType			m_type;
+		SInt32			m_x;
+		SInt32			m_y;
+		ButtonID		m_button;
+		KeyID			m_key;
+		KeyModifierMask	m_mask;
+		KeyButton		m_keyButton;
+		SInt32			m_count;
+		double			m_time;			//!< ARCH->monotonicTime() at send()
+	};
+
+	//! Create a channel with room for \p size records
+	/*!
+	\p size must be a power of two.
+	*/
+	CInputChannel(IEventQueue* events, UInt32 size = 1024);
+	~CInputChannel();
+
+	//! @name manipulators
+	//@{
+
+	//! Send input
+	void				send(const CInput&);
+
+	//! Send mouse motion
+	/*!
+	\p type is kMotionOnPrimary, kMotionOnSecondary or kWheel.
+	*/
+	void				sendMotion(CInput::EType type, SInt32 x, SInt32 y);
+
+	//! Send a mouse button
+	void				sendButton(CInput::EType type,
+							ButtonID, KeyModifierMask);
+
+	//! Send a key
+	void				sendKey(CInput::EType type, KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+
+	//! Add an event in order with the input
+	/*!
+	Adds \p event to the event queue so that it's handled after the
+	input sent before it and before the input sent after it.  Call it
+	from the sending thread.
+	*/
+	void				addEvent(const CEvent& event);
+
+	//! Receive input
+	/*!
+	Gets the next record in the ring.  Returns false if there isn't one,
+	after which the next send() sends an inputReady event.
+	*/
+	bool				receive(CInput&);
+
+	//! Receive input that didn't fit
+	/*!
+	Returns the record carried by \p event, an inputReady event, or NULL
+	if it carries none.  It follows everything in the ring so call it
+	once receive() has returned false.  The record is freed with the
+	event.
+	*/
+	const CInput*		receiveOverflow(const CEvent& event);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get event target
+	/*!
+	Returns the target of the inputReady events.
+	*/
+	void*				getEventTarget() const;
+
+	//@}
+
+private:
+	void				sendEvent(CInput* data, UInt32 flags = 0);
+
+private:
+	IEventQueue*		m_events;
+	CInput*				m_ring;
+	UInt32				m_mask;
+
+	// running counts of records sent and received.  only the sender
+	// writes m_head and only the receiver writes m_tail.
+	volatile UInt32		m_head;
+	volatile UInt32		m_tail;
+
+	// 1 while the receiver is out of input.  whoever swaps it back to 0
+	// is responsible for the next inputReady event.
+	volatile long		m_idle;
+
+	// the number of records sent through the event queue that haven't
+	// been received yet, addEvent()'s markers included.  the sender
+	// skips the ring while there are any.
+	volatile long		m_overflow;
+};
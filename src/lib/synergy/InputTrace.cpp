@@ -0,0 +1,360 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/InputTrace.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "common/stdfstream.h"
+#include "common/stdsstream.h"
+#include "common/stdistream.h"
+#include "common/stdostream.h"
+
+#if SYSAPI_UNIX
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+// names of the records in a trace file, by CInputChannel::CInput::EType
+static const char*		s_inputNames[] = {
+	"move",
+	"relmove",
+	"wheel",
+	"buttondown",
+	"buttonup",
+	"keydown",
+	"keyup",
+	"keyrepeat"
+};
+static const UInt32		kNumInputNames =
+							sizeof(s_inputNames) / sizeof(s_inputNames[0]);
+
+static const char*		kClipboardName = "clipboard";
+static const char*		kDragInfoName  = "drag";
+
+static
+CString
+toHex(const CString& data)
+{
+	static const char s_digits[] = "0123456789abcdef";
+	CString hex;
+	hex.reserve(2 * data.size());
+	for (CString::const_iterator i = data.begin(); i != data.end(); ++i) {
+		UInt8 c = static_cast<UInt8>(*i);
+		hex += s_digits[c >> 4];
+		hex += s_digits[c & 15];
+	}
+	return hex;
+}
+
+static
+bool
+fromHex(const CString& hex, CString& data)
+{
+	if ((hex.size() & 1) != 0) {
+		return false;
+	}
+	data.clear();
+	data.reserve(hex.size() / 2);
+	for (CString::size_type i = 0; i < hex.size(); i += 2) {
+		UInt8 c = 0;
+		for (CString::size_type j = i; j < i + 2; ++j) {
+			char digit = hex[j];
+			c <<= 4;
+			if (digit >= '0' && digit <= '9') {
+				c |= static_cast<UInt8>(digit - '0');
+			}
+			else if (digit >= 'a' && digit <= 'f') {
+				c |= static_cast<UInt8>(digit - 'a' + 10);
+			}
+			else {
+				return false;
+			}
+		}
+		data += static_cast<char>(c);
+	}
+	return true;
+}
+
+static
+bool
+readInput(std::istream& fields, CInputChannel::CInput& input)
+{
+	// ButtonID and KeyButton are too narrow to read into directly
+	UInt32 button = 0, key = 0, mask = 0;
+	input.m_x         = 0;
+	input.m_y         = 0;
+	input.m_button    = kButtonNone;
+	input.m_key       = kKeyNone;
+	input.m_mask      = 0;
+	input.m_keyButton = 0;
+	input.m_count     = 0;
+	input.m_time      = 0.0;
+	switch (input.m_type) {
+	case CInputChannel::CInput::kMotionOnPrimary:
+	case CInputChannel::CInput::kMotionOnSecondary:
+	case CInputChannel::CInput::kWheel:
+		fields >> input.m_x >> input.m_y;
+		break;
+
+	case CInputChannel::CInput::kButtonDown:
+	case CInputChannel::CInput::kButtonUp:
+		fields >> button >> std::hex >> mask;
+		input.m_button = static_cast<ButtonID>(button);
+		input.m_mask   = mask;
+		break;
+
+	case CInputChannel::CInput::kKeyDown:
+	case CInputChannel::CInput::kKeyUp:
+		fields >> std::hex >> key >> mask >> std::dec >> button;
+		input.m_key       = key;
+		input.m_mask      = mask;
+		input.m_keyButton = static_cast<KeyButton>(button);
+		break;
+
+	case CInputChannel::CInput::kKeyRepeat:
+		fields >> std::hex >> key >> mask >> std::dec >> button >> input.m_count;
+		input.m_key       = key;
+		input.m_mask      = mask;
+		input.m_keyButton = static_cast<KeyButton>(button);
+		break;
+	}
+	return !fields.fail();
+}
+
+//
+// CInputTrace
+//
+
+CInputTrace::CInputTrace() :
+	m_file(NULL),
+	m_start(0.0)
+{
+	// do nothing
+}
+
+CInputTrace::~CInputTrace()
+{
+	close();
+}
+
+bool
+CInputTrace::open(const CString& filename)
+{
+	close();
+
+#if SYSAPI_UNIX
+	// the trace has everything that was typed, passwords included, so
+	// only the user may read it.  make the file that way before there's
+	// anything in it, and fix an older trace we're about to replace.
+	int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd != -1) {
+		fchmod(fd, 0600);
+		::close(fd);
+	}
+#endif
+
+	std::ofstream* file = new std::ofstream(filename.c_str(),
+							std::ios::out | std::ios::trunc);
+	if (!file->is_open()) {
+		LOG((CLOG_ERR "cannot write input trace \"%s\"", filename.c_str()));
+		delete file;
+		return false;
+	}
+	*file << "# synergy input trace\n";
+
+	LOG((CLOG_NOTE "recording input trace to \"%s\"", filename.c_str()));
+	LOG((CLOG_WARN "the input trace contains everything typed, including passwords"));
+	m_file  = file;
+	m_start = ARCH->time();
+	return true;
+}
+
+void
+CInputTrace::close()
+{
+	// deleting the file flushes and closes it
+	delete m_file;
+	m_file = NULL;
+}
+
+void
+CInputTrace::recordInput(const CInputChannel::CInput& input)
+{
+	CRecord record;
+	record.m_type  = CRecord::kInput;
+	record.m_input = input;
+	record.m_id    = 0;
+	record.m_count = 0;
+	this->record(record);
+}
+
+void
+CInputTrace::recordClipboard(ClipboardID id, const CString& data)
+{
+	CRecord record;
+	record.m_type  = CRecord::kClipboard;
+	record.m_id    = id;
+	record.m_count = 0;
+	record.m_data  = data;
+	this->record(record);
+}
+
+void
+CInputTrace::recordDragInfo(UInt32 count, const CString& info)
+{
+	CRecord record;
+	record.m_type  = CRecord::kDragInfo;
+	record.m_id    = 0;
+	record.m_count = count;
+	record.m_data  = info;
+	this->record(record);
+}
+
+void
+CInputTrace::record(CRecord& record)
+{
+	if (m_file != NULL) {
+		record.m_time = ARCH->time() - m_start;
+		write(*m_file, record);
+	}
+}
+
+bool
+CInputTrace::isOpen() const
+{
+	return (m_file != NULL);
+}
+
+bool
+CInputTrace::load(const CString& filename, CRecordList& records)
+{
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		LOG((CLOG_ERR "cannot read input trace \"%s\"", filename.c_str()));
+		return false;
+	}
+	return read(file, records);
+}
+
+bool
+CInputTrace::read(std::istream& in, CRecordList& records)
+{
+	CString line;
+	for (UInt32 lineNumber = 1; std::getline(in, line); ++lineNumber) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream fields(line);
+		CString name;
+		CRecord record;
+		record.m_id    = 0;
+		record.m_count = 0;
+		bool okay      = !(fields >> record.m_time >> name).fail();
+
+		UInt32 type;
+		for (type = 0; type < kNumInputNames; ++type) {
+			if (name == s_inputNames[type]) {
+				break;
+			}
+		}
+		if (!okay) {
+			// not even a time and a name
+		}
+		else if (type < kNumInputNames) {
+			record.m_type         = CRecord::kInput;
+			record.m_input.m_type = static_cast<CInputChannel::CInput::EType>(type);
+			okay = readInput(fields, record.m_input);
+		}
+		else if (name == kClipboardName || name == kDragInfoName) {
+			// empty data leaves nothing after the number
+			UInt32 number = 0;
+			CString hex;
+			okay = !(fields >> number).fail();
+			fields >> hex;
+			okay = okay && fromHex(hex, record.m_data);
+			if (name == kClipboardName) {
+				record.m_type = CRecord::kClipboard;
+				record.m_id   = static_cast<ClipboardID>(number);
+				okay = okay && number < kClipboardEnd;
+			}
+			else {
+				record.m_type  = CRecord::kDragInfo;
+				record.m_count = number;
+			}
+		}
+		else {
+			okay = false;
+		}
+
+		if (!okay) {
+			LOG((CLOG_ERR "bad input trace record on line %u", lineNumber));
+			return false;
+		}
+		records.push_back(record);
+	}
+	return true;
+}
+
+void
+CInputTrace::write(std::ostream& out, const CRecord& record)
+{
+	CString line = synergy::string::sprintf("%.6f ", record.m_time);
+	const CInputChannel::CInput& input = record.m_input;
+	switch (record.m_type) {
+	case CRecord::kInput:
+		line += s_inputNames[input.m_type];
+		switch (input.m_type) {
+		case CInputChannel::CInput::kMotionOnPrimary:
+		case CInputChannel::CInput::kMotionOnSecondary:
+		case CInputChannel::CInput::kWheel:
+			line += synergy::string::sprintf(" %d %d", input.m_x, input.m_y);
+			break;
+
+		case CInputChannel::CInput::kButtonDown:
+		case CInputChannel::CInput::kButtonUp:
+			line += synergy::string::sprintf(" %u %x",
+								input.m_button, input.m_mask);
+			break;
+
+		case CInputChannel::CInput::kKeyDown:
+		case CInputChannel::CInput::kKeyUp:
+			line += synergy::string::sprintf(" %x %x %u",
+								input.m_key, input.m_mask, input.m_keyButton);
+			break;
+
+		case CInputChannel::CInput::kKeyRepeat:
+			line += synergy::string::sprintf(" %x %x %u %d",
+								input.m_key, input.m_mask, input.m_keyButton,
+								input.m_count);
+			break;
+		}
+		break;
+
+	case CRecord::kClipboard:
+		line += synergy::string::sprintf("%s %u ", kClipboardName, record.m_id);
+		line += toHex(record.m_data);
+		break;
+
+	case CRecord::kDragInfo:
+		line += synergy::string::sprintf("%s %u ", kDragInfoName, record.m_count);
+		line += toHex(record.m_data);
+		break;
+	}
+	out << line << "\n";
+}
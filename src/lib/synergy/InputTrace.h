@@ -0,0 +1,119 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "synergy/InputChannel.h"
+#include "synergy/clipboard_types.h"
+#include "base/String.h"
+#include "common/stdvector.h"
+
+#include <iosfwd>
+
+//! Input trace
+/*!
+A recording of what a server relayed to its clients:  mouse and key
+input from the primary screen while a client had the focus, the
+primary screen's clipboards and the files dragged onto a client.
+Traces are text, one record per line, so they can be compared and
+edited by hand.  The benchmarks replay them through the server and the
+client.
+
+A trace has everything typed on the clients while it was recording.
+*/
+class CInputTrace {
+public:
+	//! Trace record
+	class CRecord {
+	public:
+		enum EType {
+			kInput,			//!< m_input
+			kClipboard,		//!< m_id, m_data is the marshalled clipboard
+			kDragInfo		//!< m_count files, m_data is the drag info
+		};
+
+	public:
+		EType			m_type;
+		double			m_time;			//!< seconds into the trace
+		CInputChannel::CInput	m_input;
+		ClipboardID		m_id;
+		UInt32			m_count;
+		CString			m_data;
+	};
+	typedef std::vector<CRecord> CRecordList;
+
+	CInputTrace();
+	~CInputTrace();
+
+	//! @name manipulators
+	//@{
+
+	//! Start recording
+	/*!
+	Writes records to \p filename from now on, replacing the file.  On
+	Unix only the user may read the file.  Returns false if it can't be
+	opened.
+	*/
+	bool				open(const CString& filename);
+
+	//! Stop recording
+	void				close();
+
+	//! Record input
+	void				recordInput(const CInputChannel::CInput&);
+
+	//! Record a clipboard
+	void				recordClipboard(ClipboardID, const CString& data);
+
+	//! Record dragged files
+	void				recordDragInfo(UInt32 count, const CString& info);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if recording
+	bool				isOpen() const;
+
+	//! Read a trace file
+	/*!
+	Appends the records in \p filename to \p records.  Returns false if
+	the file can't be read or has a line that isn't a record.
+	*/
+	static bool			load(const CString& filename, CRecordList& records);
+
+	//! Read a trace
+	/*!
+	Like load() but from a stream.
+	*/
+	static bool			read(std::istream&, CRecordList& records);
+
+	//! Write a record
+	/*!
+	Writes \p record as a line of a trace.
+	*/
+	static void			write(std::ostream&, const CRecord& record);
+
+	//@}
+
+private:
+	void				record(CRecord&);
+
+private:
+	std::ostream*		m_file;
+	double				m_start;
+};
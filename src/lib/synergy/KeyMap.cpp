@@ -21,9 +21,20 @@
 #include "base/Log.h"
 
 #include <assert.h>
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
 
+// modifiers we try to match when synthesizing a key but don't require
+static const KeyModifierMask s_notRequiredMask =
+	KeyModifierAltGr | KeyModifierNumLock | KeyModifierScrollLock;
+
+// orders KeyIDIndex entries by KeyID
+struct CKeyIDIndexLess {
+	template <class T>
+	bool operator()(const T& a, KeyID b) const { return a.first < b; }
+};
+
 CKeyMap::CNameToKeyMap*			CKeyMap::s_nameToKeyMap      = NULL;
 CKeyMap::CNameToModifierMap*	CKeyMap::s_nameToModifierMap = NULL;
 CKeyMap::CKeyToNameMap*			CKeyMap::s_keyToNameMap      = NULL;
@@ -53,6 +64,7 @@ void
 CKeyMap::swap(CKeyMap& x)
 {
 	m_keyIDMap.swap(x.m_keyIDMap);
+	m_keyIDIndex.swap(x.m_keyIDIndex);
 	m_modifierKeys.swap(x.m_modifierKeys);
 	m_halfDuplex.swap(x.m_halfDuplex);
 	m_halfDuplexMods.swap(x.m_halfDuplexMods);
@@ -234,6 +246,14 @@ CKeyMap::finish()
 
 	// compute keys that generate each modifier
 	setModifierKeys();
+
+	// flatten the KeyID map for lookup
+	m_keyIDIndex.clear();
+	m_keyIDIndex.reserve(m_keyIDMap.size());
+	for (KeyIDMap::const_iterator i = m_keyIDMap.begin();
+								i != m_keyIDMap.end(); ++i) {
+		m_keyIDIndex.push_back(std::make_pair(i->first, &i->second));
+	}
 }
 
 void
@@ -329,6 +349,53 @@ CKeyMap::mapKey(Keystrokes& keys, KeyID id, SInt32 group,
 	return item;
 }
 
+void
+CKeyMap::collectActiveModifiers(SInt32 group, KeyModifierMask mask,
+				ModifierToKeys& activeModifiers) const
+{
+	if (group < 0 || group >= getNumGroups()) {
+		return;
+	}
+
+	for (SInt32 b = 0; b < kKeyModifierNumBits; ++b) {
+		const KeyModifierMask bit = (1u << b);
+		if ((mask & bit) == 0) {
+			continue;
+		}
+
+		// a key generating several active modifiers is in the list
+		// for each of them.  add it only for the lowest.
+		const ModifierKeyItemList& items =
+			m_modifierKeys[group * kKeyModifierNumBits + b];
+		for (size_t i = 0; i < items.size(); ++i) {
+			const KeyItem* item        = items[i];
+			KeyModifierMask generated  = (item->m_generates & mask);
+			if ((generated & (bit - 1)) == 0) {
+				activeModifiers.insert(std::make_pair(
+								item->m_generates, *item));
+			}
+		}
+	}
+}
+
+const CKeyMap::KeyGroupTable*
+CKeyMap::findKeyGroupTable(KeyID id) const
+{
+	KeyIDIndex::const_iterator i =
+		std::lower_bound(m_keyIDIndex.begin(), m_keyIDIndex.end(), id,
+							CKeyIDIndexLess());
+	if (i != m_keyIDIndex.end() && i->first == id) {
+		return i->second;
+	}
+
+	// not indexed.  it may have been added after finish().
+	KeyIDMap::const_iterator j = m_keyIDMap.find(id);
+	if (j == m_keyIDMap.end()) {
+		return NULL;
+	}
+	return &j->second;
+}
+
 SInt32
 CKeyMap::getNumGroups() const
 {
@@ -347,12 +414,12 @@ CKeyMap::findCompatibleKey(KeyID id, SInt32 group,
 {
 	assert(group >= 0 && group < getNumGroups());
 
-    KeyIDMap::const_iterator i = m_keyIDMap.find(id);
-	if (i == m_keyIDMap.end()) {
+	const KeyGroupTable* groupTable = findKeyGroupTable(id);
+	if (groupTable == NULL) {
 		return NULL;
 	}
 
-	const KeyEntryList& entries = i->second[group];
+	const KeyEntryList& entries = (*groupTable)[group];
 	for (size_t j = 0; j < entries.size(); ++j) {
 		if ((entries[j].back().m_sensitive & sensitive) == 0 ||
 			(entries[j].back().m_required & sensitive) ==
@@ -601,13 +668,13 @@ CKeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, SInt32 group,
 				bool isAutoRepeat) const
 {
 	// find KeySym in table
-	KeyIDMap::const_iterator i = m_keyIDMap.find(id);
-	if (i == m_keyIDMap.end()) {
+	const KeyGroupTable* groupTable = findKeyGroupTable(id);
+	if (groupTable == NULL) {
 		// unknown key
 		LOG((CLOG_DEBUG1 "key %04x is not on keyboard", id));
 		return NULL;
 	}
-	const KeyGroupTable& keyGroupTable = i->second;
+	const KeyGroupTable& keyGroupTable = *groupTable;
 
 	// find best key in any group, starting with the active group
 	SInt32 keyIndex  = -1;
@@ -637,6 +704,20 @@ CKeyMap::mapCharacterKey(Keystrokes& keys, KeyID id, SInt32 group,
 	}
 	const KeyItem& keyItem = itemList.back();
 
+	// the common case is a plain key in the active group for which the
+	// modifiers are already right.  that's just the key itself and
+	// the slow path below would change nothing else, so skip it and
+	// the copies of the modifier state it makes.
+	if (itemList.size() == 1 && effectiveGroup == group &&
+		!keyItem.m_dead && keyItem.m_generates == 0 &&
+		((currentState ^ keyItem.m_required) & keyItem.m_sensitive) == 0 &&
+		((currentState ^ desiredMask) & ~keyItem.m_sensitive &
+			~s_notRequiredMask) == 0) {
+		addKeystrokes(isAutoRepeat ? kKeystrokeRepeat : kKeystrokePress,
+							keyItem, activeModifiers, currentState, keys);
+		return &keyItem;
+	}
+
 	// make working copy of modifiers
 	ModifierToKeys newModifiers = activeModifiers;
 	KeyModifierMask newState    = currentState;
@@ -751,9 +832,6 @@ CKeyMap::keysForKeyItem(const KeyItem& keyItem, SInt32& group,
 				bool isAutoRepeat,
 				Keystrokes& keystrokes) const
 {
-	static const KeyModifierMask s_notRequiredMask =
-		KeyModifierAltGr | KeyModifierNumLock | KeyModifierScrollLock;
-
 	// add keystrokes to adjust the group
 	if (group != keyItem.m_group) {
 		group = keyItem.m_group;
@@ -220,6 +220,17 @@ public:
 							KeyModifierMask desiredMask,
 							bool isAutoRepeat) const;
 
+	//! Get the keys for active modifiers
+	/*!
+	Adds to \p activeModifiers each key in group \p group that
+	generates any of the modifiers in \p mask, keyed by the modifiers
+	it generates.  This uses the modifier index built by \c finish() so
+	it only looks at the keys generating the modifiers in \p mask.
+	*/
+	virtual void		collectActiveModifiers(SInt32 group,
+							KeyModifierMask mask,
+							ModifierToKeys& activeModifiers) const;
+
 	//! Get number of groups
 	/*!
 	Returns the number of keyboard groups (independent layouts) in the map.
@@ -448,6 +459,9 @@ private:
 	// Table of KeyID to ways to synthesize that KeyID
 	typedef std::map<KeyID, KeyGroupTable> KeyIDMap;
 
+	// KeyID to ways to synthesize that KeyID, sorted by KeyID
+	typedef std::vector<std::pair<KeyID, const KeyGroupTable*> > KeyIDIndex;
+
 	// List of KeyItems that generate a particular modifier
 	typedef std::vector<const KeyItem*> ModifierKeyItemList;
 
@@ -468,8 +482,13 @@ private:
 	typedef std::map<KeyID, CString> CKeyToNameMap;
 	typedef std::map<KeyModifierMask, CString> CModifierToNameMap;
 
-	// KeyID info
+	// Find the ways to synthesize a KeyID, or NULL if there are none
+	const KeyGroupTable*	findKeyGroupTable(KeyID id) const;
+
+	// KeyID info.  m_keyIDIndex is a flat copy of m_keyIDMap made by
+	// finish() for faster lookup;  keys added later are only in the map.
 	KeyIDMap			m_keyIDMap;
+	KeyIDIndex			m_keyIDIndex;
 	SInt32				m_numGroups;
 	ModifierToKeyTable	m_modifierKeys;
 
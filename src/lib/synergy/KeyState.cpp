@@ -388,7 +388,8 @@ CKeyState::CKeyState(IEventQueue* events) :
 	m_keyMapPtr(new CKeyMap()),
 	m_keyMap(*m_keyMapPtr),
 	m_mask(0),
-	m_events(events)
+	m_events(events),
+	m_inputChannel(NULL)
 {
 	init();
 }
@@ -398,7 +399,8 @@ CKeyState::CKeyState(IEventQueue* events, CKeyMap& keyMap) :
 	m_keyMapPtr(0),
 	m_keyMap(keyMap),
 	m_mask(0),
-	m_events(events)
+	m_events(events),
+	m_inputChannel(NULL)
 {
 	init();
 }
@@ -453,28 +455,62 @@ CKeyState::sendKeyEvent(
 			// ignore auto-repeat on half-duplex keys
 		}
 		else {
-			m_events->addEvent(CEvent(m_events->forIKeyState().keyDown(), target,
-							CKeyInfo::alloc(key, mask, button, 1)));
-			m_events->addEvent(CEvent(m_events->forIKeyState().keyUp(), target,
-							CKeyInfo::alloc(key, mask, button, 1)));
+			postKeyEvent(target, CInputChannel::CInput::kKeyDown,
+							key, mask, 1, button);
+			postKeyEvent(target, CInputChannel::CInput::kKeyUp,
+							key, mask, 1, button);
 		}
 	}
 	else {
 		if (isAutoRepeat) {
-			m_events->addEvent(CEvent(m_events->forIKeyState().keyRepeat(), target,
-							 CKeyInfo::alloc(key, mask, button, count)));
+			postKeyEvent(target, CInputChannel::CInput::kKeyRepeat,
+							key, mask, count, button);
 		}
 		else if (press) {
-			m_events->addEvent(CEvent(m_events->forIKeyState().keyDown(), target,
-							CKeyInfo::alloc(key, mask, button, 1)));
+			postKeyEvent(target, CInputChannel::CInput::kKeyDown,
+							key, mask, 1, button);
 		}
 		else {
-			m_events->addEvent(CEvent(m_events->forIKeyState().keyUp(), target,
-							CKeyInfo::alloc(key, mask, button, 1)));
+			postKeyEvent(target, CInputChannel::CInput::kKeyUp,
+							key, mask, 1, button);
 		}
 	}
 }
 
+void
+CKeyState::setInputChannel(CInputChannel* channel)
+{
+	m_inputChannel = channel;
+}
+
+void
+CKeyState::postKeyEvent(void* target, CInputChannel::CInput::EType type,
+				KeyID key, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	if (m_inputChannel != NULL) {
+		m_inputChannel->sendKey(type, key, mask, count, button);
+		return;
+	}
+
+	CEvent::Type eventType;
+	switch (type) {
+	case CInputChannel::CInput::kKeyRepeat:
+		eventType = m_events->forIKeyState().keyRepeat();
+		break;
+
+	case CInputChannel::CInput::kKeyUp:
+		eventType = m_events->forIKeyState().keyUp();
+		break;
+
+	default:
+		eventType = m_events->forIKeyState().keyDown();
+		break;
+	}
+	m_events->addEvent(CEvent(eventType, target,
+							CKeyInfo::alloc(key, mask, button, count)));
+}
+
 void
 CKeyState::updateKeyMap()
 {
@@ -509,27 +545,21 @@ CKeyState::updateKeyState()
 	}
 
 	// get the current modifier state
-	m_mask = pollActiveModifiers();
+	SInt32 group;
+	pollActiveModifiersAndGroup(m_mask, group);
 
 	// set active modifiers
-	CAddActiveModifierContext addModifierContext(pollActiveGroup(), m_mask,
-												m_activeModifiers);
-	m_keyMap.foreachKey(&CKeyState::addActiveModifierCB, &addModifierContext);
+	m_keyMap.collectActiveModifiers(group, m_mask, m_activeModifiers);
 
 	LOG((CLOG_DEBUG1 "modifiers on update: 0x%04x", m_mask));
 }
 
 void
-CKeyState::addActiveModifierCB(KeyID, SInt32 group,
-				CKeyMap::KeyItem& keyItem, void* vcontext)
+CKeyState::pollActiveModifiersAndGroup(KeyModifierMask& mask,
+				SInt32& group) const
 {
-	CAddActiveModifierContext* context =
-		reinterpret_cast<CAddActiveModifierContext*>(vcontext);
-	if (group == context->m_activeGroup &&
-		(keyItem.m_generates & context->m_mask) != 0) {
-		context->m_activeModifiers.insert(std::make_pair(
-								keyItem.m_generates, keyItem));
-	}	
+	mask  = pollActiveModifiers();
+	group = pollActiveGroup();
 }
 
 void
@@ -902,17 +932,3 @@ CKeyState::updateModifierKeyState(KeyButton button,
 		}
 	}
 }
-
-//
-// CKeyState::CAddActiveModifierContext
-//
-
-CKeyState::CAddActiveModifierContext::CAddActiveModifierContext(
-				SInt32 group, KeyModifierMask mask,
-				ModifierToKeys&	activeModifiers) :
-	m_activeGroup(group),
-	m_mask(mask),
-	m_activeModifiers(activeModifiers)
-{
-	// do nothing
-}
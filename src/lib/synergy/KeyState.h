@@ -20,6 +20,7 @@
 
 #include "synergy/IKeyState.h"
 #include "synergy/KeyMap.h"
+#include "synergy/InputChannel.h"
 
 //! Core key state
 /*!
@@ -56,6 +57,14 @@ public:
 							KeyID key, KeyModifierMask mask,
 							SInt32 count, KeyButton button);
 
+	//! Set the input channel
+	/*!
+	Key events go through \p channel instead of the event queue, ignoring
+	the target passed to sendKeyEvent().  NULL goes back to the event
+	queue.
+	*/
+	void				setInputChannel(CInputChannel* channel);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -113,6 +122,16 @@ protected:
 	//! @name protected accessors
 	//@{
 
+	//! Get the active modifiers and group
+	/*!
+	Sets \p mask to what \c pollActiveModifiers() returns and \p group
+	to what \c pollActiveGroup() returns.  The default calls those two
+	methods;  subclasses that can get both with one query to the system
+	should override it.
+	*/
+	virtual void		pollActiveModifiersAndGroup(KeyModifierMask& mask,
+							SInt32& group) const;
+
 	//! Compute a group number
 	/*!
 	Returns the number of the group \p offset groups after group \p group.
@@ -138,23 +157,7 @@ protected:
 private:
 	typedef CKeyMap::Keystrokes Keystrokes;
 	typedef CKeyMap::ModifierToKeys ModifierToKeys;
-public:
-	struct CAddActiveModifierContext {
-	public:
-		CAddActiveModifierContext(SInt32 group, KeyModifierMask mask,
-							ModifierToKeys&	activeModifiers);
 
-	public:
-		SInt32			m_activeGroup;
-		KeyModifierMask	m_mask;
-		ModifierToKeys&	m_activeModifiers;
-
-	private:
-		// not implemented
-		CAddActiveModifierContext(const CAddActiveModifierContext&);
-		CAddActiveModifierContext& operator=(const CAddActiveModifierContext&);
-	};
-private:
 	
 	class ButtonToKeyLess {
 	public:
@@ -165,6 +168,12 @@ private:
 		}
 	};
 
+	// post one key event, through the input channel if there is one
+	void				postKeyEvent(void* target,
+							CInputChannel::CInput::EType type,
+							KeyID key, KeyModifierMask mask,
+							SInt32 count, KeyButton button);
+
 	// not implemented
 	CKeyState(const CKeyState&);
 	CKeyState& operator=(const CKeyState&);
@@ -191,10 +200,6 @@ private:
 							const ModifierToKeys& oldModifiers,
 							const ModifierToKeys& newModifiers);
 
-	// active modifiers collection callback
-	static void			addActiveModifierCB(KeyID id, SInt32 group,
-							CKeyMap::KeyItem& keyItem, void* vcontext);
-
 private:
 	// must be declared before m_keyMap. used when this class owns the key map.
 	CKeyMap*			m_keyMapPtr;
@@ -227,4 +232,5 @@ private:
 	KeyButton			m_serverKeys[kNumButtons];
 
 	IEventQueue*		m_events;
+	CInputChannel*		m_inputChannel;
 };
@@ -0,0 +1,251 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/PacketReader.h"
+#include "common/stdvector.h"
+
+#include <cassert>
+#include <cstring>
+
+//
+// CPacketReader
+//
+
+CPacketReader::CPacketReader() :
+	m_data(NULL),
+	m_size(0)
+{
+	// do nothing
+}
+
+CPacketReader::CPacketReader(const void* data, UInt32 size) :
+	m_data(static_cast<const UInt8*>(data)),
+	m_size(size)
+{
+	// do nothing
+}
+
+bool
+CPacketReader::readf(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = vreadf(fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool
+CPacketReader::vreadf(const char* fmt, va_list args)
+{
+	assert(fmt != NULL);
+
+	while (*fmt) {
+		if (*fmt != '%') {
+			// regular characters must match
+			if (m_size == 0 || *m_data != static_cast<UInt8>(*fmt)) {
+				return false;
+			}
+			++m_data;
+			--m_size;
+			++fmt;
+			continue;
+		}
+
+		// format specifier.  the length is a single digit in all the
+		// formats we know.
+		++fmt;
+		UInt32 len = 0;
+		if (*fmt >= '0' && *fmt <= '9') {
+			len = static_cast<UInt32>(*fmt++ - '0');
+		}
+		switch (*fmt) {
+		case 'i': {
+			assert(len == 1 || len == 2 || len == 4);
+			if (m_size < len) {
+				return false;
+			}
+			void* v = va_arg(args, void*);
+			switch (len) {
+			case 1:
+				*static_cast<UInt8*>(v) = m_data[0];
+				break;
+
+			case 2:
+				*static_cast<UInt16*>(v) = static_cast<UInt16>(
+					(static_cast<UInt16>(m_data[0]) << 8) |
+					 static_cast<UInt16>(m_data[1]));
+				break;
+
+			case 4:
+				*static_cast<UInt32*>(v) =
+					(static_cast<UInt32>(m_data[0]) << 24) |
+					(static_cast<UInt32>(m_data[1]) << 16) |
+					(static_cast<UInt32>(m_data[2]) <<  8) |
+					 static_cast<UInt32>(m_data[3]);
+				break;
+			}
+			m_data += len;
+			m_size -= len;
+			break;
+		}
+
+		case 'I': {
+			assert(len == 1 || len == 2 || len == 4);
+			UInt32 n;
+			if (!readUInt32(n) || n > m_size / len) {
+				return false;
+			}
+			void* v = va_arg(args, void*);
+			switch (len) {
+			case 1: {
+				std::vector<UInt8>* list = static_cast<std::vector<UInt8>*>(v);
+				list->insert(list->end(), m_data, m_data + n);
+				break;
+			}
+
+			case 2: {
+				std::vector<UInt16>* list = static_cast<std::vector<UInt16>*>(v);
+				list->reserve(list->size() + n);
+				for (UInt32 i = 0; i < n; ++i) {
+					const UInt8* p = m_data + 2 * i;
+					list->push_back(static_cast<UInt16>(
+						(static_cast<UInt16>(p[0]) << 8) |
+						 static_cast<UInt16>(p[1])));
+				}
+				break;
+			}
+
+			case 4: {
+				std::vector<UInt32>* list = static_cast<std::vector<UInt32>*>(v);
+				list->reserve(list->size() + n);
+				for (UInt32 i = 0; i < n; ++i) {
+					const UInt8* p = m_data + 4 * i;
+					list->push_back(
+						(static_cast<UInt32>(p[0]) << 24) |
+						(static_cast<UInt32>(p[1]) << 16) |
+						(static_cast<UInt32>(p[2]) <<  8) |
+						 static_cast<UInt32>(p[3]));
+				}
+				break;
+			}
+			}
+			m_data += n * len;
+			m_size -= n * len;
+			break;
+		}
+
+		case 's':
+		case 'r': {
+			assert(len == 0);
+			UInt32 n;
+			if (!readUInt32(n) || n > m_size) {
+				return false;
+			}
+			const char* s = reinterpret_cast<const char*>(m_data);
+			if (*fmt == 's') {
+				va_arg(args, CString*)->assign(s, n);
+			}
+			else {
+				*va_arg(args, CStringRef*) = CStringRef(s, n);
+			}
+			m_data += n;
+			m_size -= n;
+			break;
+		}
+
+		case 'v': {
+			assert(len == 0);
+			if (!readVarint(*va_arg(args, UInt32*))) {
+				return false;
+			}
+			break;
+		}
+
+		case 'z': {
+			assert(len == 0);
+			UInt32 u;
+			if (!readVarint(u)) {
+				return false;
+			}
+			*va_arg(args, SInt32*) =
+				static_cast<SInt32>(u >> 1) ^ -static_cast<SInt32>(u & 1);
+			break;
+		}
+
+		case '%':
+			assert(len == 0);
+			if (m_size == 0 || *m_data != '%') {
+				return false;
+			}
+			++m_data;
+			--m_size;
+			break;
+
+		default:
+			assert(0 && "invalid format specifier");
+			return false;
+		}
+		++fmt;
+	}
+	return true;
+}
+
+UInt32
+CPacketReader::read(void* buffer, UInt32 n)
+{
+	if (n > m_size) {
+		n = m_size;
+	}
+	if (buffer != NULL && n != 0) {
+		memcpy(buffer, m_data, n);
+	}
+	m_data += n;
+	m_size -= n;
+	return n;
+}
+
+bool
+CPacketReader::readUInt32(UInt32& v)
+{
+	if (m_size < 4) {
+		return false;
+	}
+	v = (static_cast<UInt32>(m_data[0]) << 24) |
+		(static_cast<UInt32>(m_data[1]) << 16) |
+		(static_cast<UInt32>(m_data[2]) <<  8) |
+		 static_cast<UInt32>(m_data[3]);
+	m_data += 4;
+	m_size -= 4;
+	return true;
+}
+
+bool
+CPacketReader::readVarint(UInt32& v)
+{
+	// same encoding as CProtocolUtil, at most 5 bytes
+	v = 0;
+	for (UInt32 shift = 0; shift < 35 && m_size != 0; shift += 7) {
+		UInt8 byte = *m_data++;
+		--m_size;
+		v |= static_cast<UInt32>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
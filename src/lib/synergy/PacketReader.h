@@ -0,0 +1,106 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+
+#include <stdarg.h>
+
+//! Bytes inside a packet
+/*!
+Refers to a string field where it lies in a packet instead of copying
+it.  Only valid as long as the packet is.
+*/
+class CStringRef {
+public:
+	CStringRef() : m_data(NULL), m_size(0) { }
+	CStringRef(const char* data, UInt32 size) : m_data(data), m_size(size) { }
+	explicit CStringRef(const CString& s) :
+		m_data(s.data()), m_size(static_cast<UInt32>(s.size())) { }
+
+	const char*			data() const { return m_data; }
+	UInt32				size() const { return m_size; }
+	bool				empty() const { return m_size == 0; }
+
+	//! Copy to a string
+	CString				str() const { return CString(m_data, m_size); }
+
+private:
+	const char*			m_data;
+	UInt32				m_size;
+};
+
+//! In place message decoder
+/*!
+Parses protocol messages straight out of a packet in memory, as handed
+out by CPacketStreamFilter::peekPacket(), instead of reading every field
+through the stream.  The reader doesn't own the packet.
+*/
+class CPacketReader {
+public:
+	CPacketReader();
+	CPacketReader(const void* data, UInt32 size);
+
+	//! @name manipulators
+	//@{
+
+	//! Read formatted data
+	/*!
+	Reads the same formats as CProtocolUtil::readf() and one more:
+	- \%r   -- reads bytes in place;  argument is a CStringRef*
+
+	Returns true if the entire format was parsed.  On a mismatch or if
+	the packet is too short it returns false and the reader is left
+	somewhere in the middle of the message.
+	*/
+	bool				readf(const char* fmt, ...);
+
+	//! Read formatted data
+	/*!
+	Like readf() but with the arguments in a \c va_list.
+	*/
+	bool				vreadf(const char* fmt, va_list);
+
+	//! Read bytes
+	/*!
+	Copies up to \p n bytes to \p buffer, or skips them if \p buffer
+	is NULL, and returns how many there were.
+	*/
+	UInt32				read(void* buffer, UInt32 n);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get the unread part of the packet
+	const UInt8*		getData() const { return m_data; }
+
+	//! Get the number of unread bytes
+	UInt32				getSize() const { return m_size; }
+
+	//@}
+
+private:
+	bool				readUInt32(UInt32&);
+	bool				readVarint(UInt32&);
+
+private:
+	const UInt8*		m_data;
+	UInt32				m_size;
+};
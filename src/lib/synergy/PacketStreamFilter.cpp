@@ -18,7 +18,6 @@
 
 #include "synergy/PacketStreamFilter.h"
 #include "base/IEventQueue.h"
-#include "mt/Lock.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstring>
@@ -45,7 +44,6 @@ CPacketStreamFilter::~CPacketStreamFilter()
 void
 CPacketStreamFilter::close()
 {
-	CLock lock(&m_mutex);
 	m_size = 0;
 	m_buffer.pop(m_buffer.getSize());
 	CStreamFilter::close();
@@ -58,10 +56,8 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 		return 0;
 	}
 
-	CLock lock(&m_mutex);
-
 	// if not enough data yet then give up
-	if (!isReadyNoLock()) {
+	if (!isPacketReady()) {
 		return 0;
 	}
 
@@ -74,17 +70,7 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 	if (buffer != NULL) {
 		memcpy(buffer, m_buffer.peek(n), n);
 	}
-	m_buffer.pop(n);
-	m_size -= n;
-
-	// get next packet's size if we've finished with this packet and
-	// there's enough data to do so.
-	readPacketSize();
-
-	if (m_inputShutdown && m_size == 0) {
-		m_events->addEvent(CEvent(m_events->forIStream().inputShutdown(),
-						getEventTarget(), NULL));
-	}
+	popBytes(n);
 
 	return n;
 }
@@ -92,22 +78,29 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 void
 CPacketStreamFilter::write(const void* buffer, UInt32 count)
 {
-	// write the length of the payload
-	UInt8 length[4];
-	length[0] = (UInt8)((count >> 24) & 0xff);
-	length[1] = (UInt8)((count >> 16) & 0xff);
-	length[2] = (UInt8)((count >>  8) & 0xff);
-	length[3] = (UInt8)( count        & 0xff);
-	getStream()->write(length, sizeof(length));
-
-	// write the payload
-	getStream()->write(buffer, count);
+	// the length of the payload goes first
+	UInt8 packet[256];
+	packet[0] = (UInt8)((count >> 24) & 0xff);
+	packet[1] = (UInt8)((count >> 16) & 0xff);
+	packet[2] = (UInt8)((count >>  8) & 0xff);
+	packet[3] = (UInt8)( count        & 0xff);
+
+	// write small packets, which is nearly all of them, in one go rather
+	// than taking two trips through the stream below.  copying a big one
+	// would cost more than the extra write.
+	if (count <= sizeof(packet) - 4) {
+		memcpy(packet + 4, buffer, count);
+		getStream()->write(packet, count + 4);
+	}
+	else {
+		getStream()->write(packet, 4);
+		getStream()->write(buffer, count);
+	}
 }
 
 void
 CPacketStreamFilter::shutdownInput()
 {
-	CLock lock(&m_mutex);
 	m_size = 0;
 	m_buffer.pop(m_buffer.getSize());
 	CStreamFilter::shutdownInput();
@@ -116,28 +109,67 @@ CPacketStreamFilter::shutdownInput()
 bool
 CPacketStreamFilter::isReady() const
 {
-	CLock lock(&m_mutex);
-	return isReadyNoLock();
+	return isPacketReady();
 }
 
 UInt32
 CPacketStreamFilter::getSize() const
 {
-	CLock lock(&m_mutex);
-	return isReadyNoLock() ? m_size : 0;
+	return isPacketReady() ? m_size : 0;
+}
+
+const UInt8*
+CPacketStreamFilter::peekPacket(UInt32& size)
+{
+	if (!isPacketReady()) {
+		size = 0;
+		return NULL;
+	}
+
+	// makes the packet contiguous if it isn't already
+	size = m_size;
+	return static_cast<const UInt8*>(m_buffer.peek(m_size));
+}
+
+void
+CPacketStreamFilter::popPacket()
+{
+	if (isPacketReady()) {
+		popBytes(m_size);
+	}
+}
+
+bool
+CPacketStreamFilter::isMoreBuffered() const
+{
+	return (m_buffer.getSize() > m_size);
 }
 
 bool
-CPacketStreamFilter::isReadyNoLock() const
+CPacketStreamFilter::isPacketReady() const
 {
 	return (m_size != 0 && m_buffer.getSize() >= m_size);
 }
 
 void
-CPacketStreamFilter::readPacketSize()
+CPacketStreamFilter::popBytes(UInt32 n)
 {
-	// note -- m_mutex must be locked on entry
+	m_buffer.pop(n);
+	m_size -= n;
+
+	// get next packet's size if we've finished with this packet and
+	// there's enough data to do so.
+	readPacketSize();
 
+	if (m_inputShutdown && m_size == 0) {
+		m_events->addEvent(CEvent(m_events->forIStream().inputShutdown(),
+						getEventTarget(), NULL));
+	}
+}
+
+void
+CPacketStreamFilter::readPacketSize()
+{
 	if (m_size == 0 && m_buffer.getSize() >= 4) {
 		UInt8 buffer[4];
 		memcpy(buffer, m_buffer.peek(sizeof(buffer)), sizeof(buffer));
@@ -153,7 +185,7 @@ bool
 CPacketStreamFilter::readMore()
 {
 	// note if we have whole packet
-	bool wasReady = isReadyNoLock();
+	bool wasReady = isPacketReady();
 
 	// read more data
 	char buffer[4096];
@@ -168,7 +200,7 @@ CPacketStreamFilter::readMore()
 	readPacketSize();
 
 	// note if we now have a whole packet
-	bool isReady = isReadyNoLock();
+	bool isReady = isPacketReady();
 
 	// if we weren't ready before but now we are then send a
 	// input ready event apparently from the filtered stream.
@@ -179,14 +211,12 @@ void
 CPacketStreamFilter::filterEvent(const CEvent& event)
 {
 	if (event.getType() == m_events->forIStream().inputReady()) {
-		CLock lock(&m_mutex);
 		if (!readMore()) {
 			return;
 		}
 	}
 	else if (event.getType() == m_events->forIStream().inputShutdown()) {
 		// discard this if we have buffered data
-		CLock lock(&m_mutex);
 		m_inputShutdown = true;
 		if (m_size != 0) {
 			return;
@@ -20,13 +20,14 @@
 
 #include "io/StreamFilter.h"
 #include "io/StreamBuffer.h"
-#include "mt/Mutex.h"
 
 class IEventQueue;
 
 //! Packetizing stream filter 
 /*!
-Filters a stream to read and write packets.
+Filters a stream to read and write packets.  It keeps no lock of its
+own, so it must only be used from the thread that dispatches the
+stream's events.
 */
 class CPacketStreamFilter : public CStreamFilter {
 public:
@@ -41,17 +42,37 @@ public:
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
 
+	//! Get the next packet in place
+	/*!
+	Returns the rest of the current packet, without copying it, and
+	sets \p size to its length.  Returns NULL if there isn't a complete
+	packet yet.  The memory is only valid until the packet is popped or
+	the stream is read from or receives more data, so only use this
+	while handling an event from the stream.
+	*/
+	const UInt8*		peekPacket(UInt32& size);
+
+	//! Discard the packet returned by peekPacket()
+	void				popPacket();
+
+	//! Check for data behind the current packet
+	/*!
+	Returns true if any data, complete packet or not, follows the
+	packet returned by peekPacket().
+	*/
+	bool				isMoreBuffered() const;
+
 protected:
 	// CStreamFilter overrides
 	virtual void		filterEvent(const CEvent&);
 
 private:
-	bool				isReadyNoLock() const;
+	bool				isPacketReady() const;
+	void				popBytes(UInt32 n);
 	void				readPacketSize();
 	bool				readMore();
 
 private:
-	CMutex				m_mutex;
 	UInt32				m_size;
 	CStreamBuffer		m_buffer;
 	bool				m_inputShutdown;
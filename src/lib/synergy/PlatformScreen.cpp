@@ -42,7 +42,8 @@ CPlatformScreen::CPlatformScreen(IEventQueue* events, bool isPrimary) :
 	m_motionEventMouseY(0),
 	m_relativeMouseMode(false),
 	m_locked(false),
-	m_relativeCount(0)
+	m_relativeCount(0),
+	m_inputChannel(NULL)
 {
 }
 
@@ -51,6 +52,12 @@ CPlatformScreen::~CPlatformScreen()
 	// do nothing
 }
 
+void
+CPlatformScreen::setInputChannel(CInputChannel* channel)
+{
+	m_inputChannel = channel;
+}
+
 void
 CPlatformScreen::enter(SInt32 xAbs, SInt32 yAbs)
 {
@@ -395,6 +402,12 @@ CPlatformScreen::onMotionNotify(SInt32 x, SInt32 y)
 	m_motionEventMouseY = y;
 }
 
+void
+CPlatformScreen::flushFakeInput()
+{
+	// do nothing
+}
+
 void
 CPlatformScreen::mouseWarp(SInt16 x, SInt16 y)
 {
@@ -57,6 +57,7 @@ public:
 	virtual void		fakeMouseMove(SInt32 x, SInt32 y) = 0;
 	virtual void		fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const = 0;
 	virtual void		fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const = 0;
+	virtual void		flushFakeInput();
 	virtual void		mouseWarp(SInt16 x, SInt16 y);
 
 	// IKeyState overrides
@@ -98,6 +99,7 @@ public:
 	virtual void		setOptions(const COptionsList& options) = 0;
 	virtual void		setSequenceNumber(UInt32) = 0;
 	virtual bool		isPrimary() const = 0;
+	virtual void		setInputChannel(CInputChannel*);
 	
 	virtual void		fakeDraggingFiles(CDragFileList fileList) { throw std::runtime_error("fakeDraggingFiles not implemented"); }
 	virtual const CString&
@@ -157,4 +159,6 @@ protected:
 								// really is.
 	bool				m_locked;		// True when the DLCK message to the server was a lock request.
 	int				m_relativeCount;	// Number of received mouseMove messages from the server while in m_relativeMouseMode.
+
+	CInputChannel*		m_inputChannel;		// Where user input goes when not NULL, instead of the event queue.
 };
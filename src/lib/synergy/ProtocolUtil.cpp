@@ -24,6 +24,14 @@
 #include <cctype>
 #include <cstring>
 
+// maps signed integers to unsigned so that small magnitudes of either
+// sign encode as short varints:  0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+static inline UInt32
+zigzag(SInt32 v)
+{
+	return (static_cast<UInt32>(v) << 1) ^ static_cast<UInt32>(v >> 31);
+}
+
 //
 // CProtocolUtil
 //
@@ -44,25 +52,50 @@ CProtocolUtil::writef(synergy::IStream* stream, const char* fmt, ...)
 	va_end(args);
 }
 
+void
+CProtocolUtil::appendf(CString& buffer, const char* fmt, ...)
+{
+	assert(fmt != NULL);
+
+	va_list args;
+	va_start(args, fmt);
+	UInt32 size = getLength(fmt, args);
+	va_end(args);
+	if (size == 0) {
+		return;
+	}
+
+	size_t offset = buffer.size();
+	buffer.resize(offset + size);
+	va_start(args, fmt);
+	writef(&buffer[offset], fmt, args);
+	va_end(args);
+}
+
 bool
 CProtocolUtil::readf(synergy::IStream* stream, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	bool result = vreadf(stream, fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool
+CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 {
 	assert(stream != NULL);
 	assert(fmt != NULL);
 	LOG((CLOG_DEBUG2 "readf(%s)", fmt));
 
-	bool result;
-	va_list args;
-	va_start(args, fmt);
 	try {
-		vreadf(stream, fmt, args);
-		result = true;
+		readFields(stream, fmt, args);
+		return true;
 	}
 	catch (XIO&) {
-		result = false;
+		return false;
 	}
-	va_end(args);
-	return result;
 }
 
 void
@@ -95,7 +128,7 @@ CProtocolUtil::vwritef(synergy::IStream* stream,
 }
 
 void
-CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
+CProtocolUtil::readFields(synergy::IStream* stream, const char* fmt, va_list args)
 {
 	assert(stream != NULL);
 	assert(fmt != NULL);
@@ -247,6 +280,23 @@ CProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
 				break;
 			}
 
+			case 'v': {
+				assert(len == 0);
+				UInt32* v = va_arg(args, UInt32*);
+				*v = readVarint(stream);
+				LOG((CLOG_DEBUG2 "readf: read varint: %u", *v));
+				break;
+			}
+
+			case 'z': {
+				assert(len == 0);
+				UInt32 u = readVarint(stream);
+				SInt32* v = va_arg(args, SInt32*);
+				*v = static_cast<SInt32>(u >> 1) ^ -static_cast<SInt32>(u & 1);
+				LOG((CLOG_DEBUG2 "readf: read zigzag varint: %d", *v));
+				break;
+			}
+
 			case '%':
 				assert(len == 0);
 				break;
@@ -319,6 +369,19 @@ CProtocolUtil::getLength(const char* fmt, va_list args)
 				(void)va_arg(args, UInt8*);
 				break;
 
+			case 'v':
+			case 'z': {
+				assert(len == 0);
+				UInt32 v = va_arg(args, UInt32);
+				if (*fmt == 'z') {
+					v = zigzag(static_cast<SInt32>(v));
+				}
+				for (len = 1; v >= 0x80; v >>= 7) {
+					++len;
+				}
+				break;
+			}
+
 			case '%':
 				assert(len == 0);
 				len = 1;
@@ -469,6 +532,23 @@ CProtocolUtil::writef(void* buffer, const char* fmt, va_list args)
 				break;
 			}
 
+			case 'v':
+			case 'z': {
+				assert(len == 0);
+				UInt32 v = va_arg(args, UInt32);
+				if (*fmt == 'z') {
+					v = zigzag(static_cast<SInt32>(v));
+				}
+
+				// 7 bits at a time, low bits first.  the top bit says
+				// whether another byte follows.
+				for (; v >= 0x80; v >>= 7) {
+					*dst++ = static_cast<UInt8>((v & 0x7f) | 0x80);
+				}
+				*dst++ = static_cast<UInt8>(v);
+				break;
+			}
+
 			case '%':
 				assert(len == 0);
 				*dst++ = '%';
@@ -536,6 +616,23 @@ CProtocolUtil::read(synergy::IStream* stream, void* vbuffer, UInt32 count)
 	}
 }
 
+UInt32
+CProtocolUtil::readVarint(synergy::IStream* stream)
+{
+	UInt32 v = 0;
+	for (UInt32 shift = 0; shift < 35; shift += 7) {
+		UInt8 byte;
+		read(stream, &byte, 1);
+		v |= static_cast<UInt32>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return v;
+		}
+	}
+
+	// more than 32 bits
+	throw XIOReadMismatch();
+}
+
 
 //
 // XIOReadMismatch
@@ -20,6 +20,7 @@
 
 #include "io/XIO.h"
 #include "base/EventTypes.h"
+#include "base/String.h"
 
 #include <stdarg.h>
 
@@ -49,10 +50,20 @@ public:
 	- \%4I  -- converts std::vector<UInt32>* to 4 byte integers in NBO
 	- \%s   -- converts CString* to stream of bytes
 	- \%S   -- converts integer N and const UInt8* to stream of N bytes
+	- \%v   -- converts integer argument to a 1 to 5 byte varint
+	- \%z   -- converts signed integer argument to a zigzag varint, so
+	           small magnitudes of either sign take one byte
 	*/
 	static void			writef(synergy::IStream*,
 							const char* fmt, ...);
 
+	//! Append formatted data
+	/*!
+	Like writef() but appends to \c buffer instead of writing to a
+	stream, so several messages can go out in a single write.
+	*/
+	static void			appendf(CString& buffer, const char* fmt, ...);
+
 	//! Read formatted data
 	/*!
 	Read formatted binary data from a buffer.  This performs the
@@ -68,20 +79,30 @@ public:
 	- \%2I  -- reads NBO 2 byte integers;  arg is std::vector<UInt16>*
 	- \%4I  -- reads NBO 4 byte integers;  arg is std::vector<UInt32>*
 	- \%s   -- reads bytes;  argument must be a CString*, \b not a char*
+	- \%v   -- reads a varint;  argument is a UInt32*
+	- \%z   -- reads a zigzag varint;  argument is a SInt32*
 	*/
 	static bool			readf(synergy::IStream*,
 							const char* fmt, ...);
 
+	//! Read formatted data
+	/*!
+	Like readf() but with the arguments in a \c va_list.
+	*/
+	static bool			vreadf(synergy::IStream*,
+							const char* fmt, va_list);
+
 private:
 	static void			vwritef(synergy::IStream*,
 							const char* fmt, UInt32 size, va_list);
-	static void			vreadf(synergy::IStream*,
+	static void			readFields(synergy::IStream*,
 							const char* fmt, va_list);
 
 	static UInt32		getLength(const char* fmt, va_list);
 	static void			writef(void*, const char* fmt, va_list);
 	static UInt32		eatLength(const char** fmt);
 	static void			read(synergy::IStream*, void*, UInt32);
+	static UInt32		readVarint(synergy::IStream*);
 };
 
 //! Mismatched read exception
@@ -246,6 +246,12 @@ CScreen::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 	m_screen->fakeMouseWheel(xDelta, yDelta);
 }
 
+void
+CScreen::flushFakeInput()
+{
+	m_screen->flushFakeInput();
+}
+
 void
 CScreen::resetOptions()
 {
@@ -410,6 +416,12 @@ CScreen::setDraggingStarted(bool started)
 	m_screen->setDraggingStarted(started);
 }
 
+void
+CScreen::setInputChannel(CInputChannel* channel)
+{
+	m_screen->setInputChannel(channel);
+}
+
 void
 CScreen::startDraggingFiles(CDragFileList& fileList)
 {
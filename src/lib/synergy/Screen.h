@@ -28,6 +28,7 @@
 
 class IClipboard;
 class IPlatformScreen;
+class CInputChannel;
 class IEventQueue;
 
 //! Platform independent screen
@@ -109,7 +110,7 @@ public:
 	Forcibly activates the screen saver if \c activate is true otherwise
 	forcibly deactivates it.
 	*/
-	void				screensaver(bool activate);
+	virtual void		screensaver(bool activate);
 
 	//! Notify of key press
 	/*!
@@ -172,6 +173,12 @@ public:
 	*/
 	void				mouseWheel(SInt32 xDelta, SInt32 yDelta);
 
+	//! Flush synthesized input
+	/*!
+	Sends any fake input buffered by the platform screen.
+	*/
+	virtual void		flushFakeInput();
+
 	//! Notify of options changes
 	/*!
 	Resets all options to their default values.
@@ -221,6 +228,13 @@ public:
 
 	//! Change dragging status
 	void				setDraggingStarted(bool started);
+
+	//! Set input channel
+	/*!
+	Sends user input on the primary screen through \p channel instead of
+	the event queue, or through the event queue again if it's NULL.
+	*/
+	virtual void		setInputChannel(CInputChannel* channel);
 	
 	//! Fake a files dragging operation
 	void				startDraggingFiles(CDragFileList& fileList);
@@ -25,6 +25,7 @@
 #include "synergy/Screen.h"
 #include "synergy/XScreen.h"
 #include "synergy/ServerTaskBarReceiver.h"
+#include "synergy/InputTrace.h"
 #include "net/SocketMultiplexer.h"
 #include "net/TCPSocketFactory.h"
 #include "net/XSocket.h"
@@ -69,7 +70,8 @@ CServerApp::CServerApp(IEventQueue* events, CreateTaskBarReceiverFunc createTask
 	m_serverScreen(NULL),
 	m_primaryClient(NULL),
 	m_listener(NULL),
-	m_timer(NULL)
+	m_timer(NULL),
+	m_inputTrace(NULL)
 {
 }
 
@@ -115,6 +117,11 @@ CServerApp::parseArg(const int& argc, const char* const* argv, int& i)
 		args().m_configFile = argv[++i];
 	}
 
+	else if (isArg(i, argc, argv, NULL, "--trace-input", 1)) {
+		// save input trace file path
+		args().m_inputTraceFile = argv[++i];
+	}
+
 	else {
 		// option not supported here
 		return false;
@@ -170,12 +177,13 @@ CServerApp::help()
 #  define WINAPI_INFO
 #endif
 
-	char buffer[2000];
+	char buffer[3000];
 	sprintf(
 		buffer,
 		"Usage: %s"
 		" [--address <address>]"
 		" [--config <pathname>]"
+		" [--trace-input <pathname>]"
 		WINAPI_ARGS
 		HELP_SYS_ARGS
 		HELP_COMMON_ARGS
@@ -184,6 +192,9 @@ CServerApp::help()
 		"\n"
 		"  -a, --address <address>  listen for clients on the given address.\n"
 		"  -c, --config <pathname>  use the named configuration file instead.\n"
+		"      --trace-input <pathname>\n"
+		"                           record the input sent to clients, typing\n"
+		"                             included, to replay in the benchmarks.\n"
 		HELP_COMMON_INFO_1
 		WINAPI_INFO
 		HELP_SYS_INFO
@@ -349,6 +360,8 @@ CServerApp::closeServer(CServer* server)
 
 	// done with server
 	delete server;
+	delete m_inputTrace;
+	m_inputTrace = NULL;
 }
 
 void 
@@ -697,6 +710,12 @@ CServer*
 CServerApp::openServer(CConfig& config, CPrimaryClient* primaryClient)
 {
 	CServer* server = new CServer(config, primaryClient, m_serverScreen, m_events, args().m_enableDragDrop);
+	if (!args().m_inputTraceFile.empty()) {
+		m_inputTrace = new CInputTrace;
+		if (m_inputTrace->open(args().m_inputTraceFile)) {
+			server->setInputTrace(m_inputTrace);
+		}
+	}
 	try {
 		m_events->adoptHandler(
 			m_events->forCServer().disconnected(), server,
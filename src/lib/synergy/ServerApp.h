@@ -41,6 +41,7 @@ enum EServerState {
 class CServer;
 class CScreen;
 class CClientListener;
+class CInputTrace;
 class CEventQueueTimer;
 class ILogOutputter;
 class IEventQueue;
@@ -56,6 +57,7 @@ public:
 		CString	m_configFile;
 		CNetworkAddress* m_synergyAddress;
 		CConfig* m_config;
+		CString	m_inputTraceFile;
 	};
 
 	CServerApp(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver);
@@ -120,6 +122,7 @@ public:
 	CPrimaryClient*		m_primaryClient;
 	CClientListener*	m_listener;
 	CEventQueueTimer*	m_timer;
+	CInputTrace*		m_inputTrace;
 
 private:
 	virtual bool parseArg(const int& argc, const char* const* argv, int& i);
@@ -16,8 +16,15 @@
  */
 
 #include "synergy/ToolApp.h"
+#include "ipc/IpcClient.h"
+#include "ipc/IpcMessage.h"
+#include "ipc/Ipc.h"
+#include "net/SocketMultiplexer.h"
 #include "arch/Arch.h"
+#include "base/EventQueue.h"
+#include "base/Log.h"
 #include "base/String.h"
+#include "base/TMethodEventJob.h"
 
 #include <iostream>
 #include <sstream>
@@ -32,6 +39,16 @@ enum {
 	kErrorUnknown
 };
 
+// how long to wait for synergys/c to send its stats through the daemon
+static const double		kStatsTimeout = 5.0;
+
+CToolApp::CToolApp() :
+	m_events(NULL),
+	m_ipcClient(NULL),
+	m_gotStats(false)
+{
+}
+
 UInt32
 CToolApp::run(int argc, char** argv)
 {
@@ -46,6 +63,9 @@ CToolApp::run(int argc, char** argv)
 				premiumAuth();
 				return kErrorOk;
 			}
+			else if (strcmp(argv[i], "--stats") == 0) {
+				return stats() ? kErrorOk : kErrorUnknown;
+			}
 			else {
 				std::cerr << "unknown arg: " << argv[i] << std::endl;
 				return kErrorArgs;
@@ -81,3 +101,69 @@ CToolApp::premiumAuth()
 
 	std::cout << ARCH->internet().get(ss.str()) << std::endl;
 }
+
+bool
+CToolApp::stats()
+{
+	// ask the daemon, which asks synergys/c
+	CLog log;
+	CLOG->setFilter(kWARNING);
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CIpcClient client(&events, &multiplexer);
+	client.setClientType(kIpcClientTool);
+	m_events    = &events;
+	m_ipcClient = &client;
+	m_gotStats  = false;
+
+	events.adoptHandler(events.forCIpcClient().connected(), &client,
+							new TMethodEventJob<CToolApp>(this,
+								&CToolApp::handleIpcConnected));
+	events.adoptHandler(events.forCIpcClient().messageReceived(), &client,
+							new TMethodEventJob<CToolApp>(this,
+								&CToolApp::handleIpcMessage));
+	CEventQueueTimer* timer = events.newOneShotTimer(kStatsTimeout, NULL);
+	events.adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CToolApp>(this,
+								&CToolApp::handleStatsTimeout));
+
+	client.connect();
+	events.loop();
+
+	events.removeHandler(CEvent::kTimer, timer);
+	events.deleteTimer(timer);
+	events.removeHandler(events.forCIpcClient().messageReceived(), &client);
+	events.removeHandler(events.forCIpcClient().connected(), &client);
+	client.disconnect();
+	m_events    = NULL;
+	m_ipcClient = NULL;
+
+	if (!m_gotStats) {
+		std::cerr << "no stats, is synergys or synergyc running?" << std::endl;
+	}
+	return m_gotStats;
+}
+
+void
+CToolApp::handleIpcConnected(const CEvent&, void*)
+{
+	m_ipcClient->send(CIpcStatsRequestMessage());
+}
+
+void
+CToolApp::handleIpcMessage(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->type() == kIpcStats) {
+		CIpcStatsMessage* sm = static_cast<CIpcStatsMessage*>(m);
+		std::cout << sm->stats();
+		m_gotStats = true;
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+}
+
+void
+CToolApp::handleStatsTimeout(const CEvent&, void*)
+{
+	m_events->addEvent(CEvent(CEvent::kQuit));
+}
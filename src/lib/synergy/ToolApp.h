@@ -19,10 +19,25 @@
 
 #include "common/basic_types.h"
 
+class CEvent;
+class CIpcClient;
+class IEventQueue;
+
 class CToolApp {
 public:
+	CToolApp();
+
 	UInt32				run(int argc, char** argv);
 
 private:
 	void				premiumAuth();
+	bool				stats();
+	void				handleIpcConnected(const CEvent&, void*);
+	void				handleIpcMessage(const CEvent&, void*);
+	void				handleStatsTimeout(const CEvent&, void*);
+
+private:
+	IEventQueue*		m_events;
+	CIpcClient*			m_ipcClient;
+	bool				m_gotStats;
 };
@@ -66,6 +66,7 @@ static const OptionID	kOptionScreenSaverSync        = OPTION_CODE("SSVR");
 static const OptionID	kOptionXTestXineramaUnaware   = OPTION_CODE("XTXU");
 static const OptionID	kOptionScreenPreserveFocus    = OPTION_CODE("SFOC");
 static const OptionID	kOptionRelativeMouseMoves     = OPTION_CODE("MDLT");
+static const OptionID	kOptionMouseSendInterval      = OPTION_CODE("MSIV");
 static const OptionID	kOptionWin32KeepForeground    = OPTION_CODE("_KFW");
 //@}
 
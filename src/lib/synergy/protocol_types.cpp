@@ -46,9 +46,19 @@ const char*				kMsgDMouseWheel1_0	= "DMWM%2i";
 const char*				kMsgDClipboard		= "DCLP%1i%4i%s";
 const char*				kMsgDInfo			= "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*				kMsgDSetOptions		= "DSOP%4I";
+const char*				kMsgDSession		= "DSES%s%4i";
 const char*				kMsgDCryptoIv		= "DCIV%s";
 const char*				kMsgDFileTransfer	= "DFTR%1i%s";
 const char*				kMsgDDragInfo		= "DDRG%2i%s";
+const char*				kMsgIMouseMove		= "\001%z%z";
+const char*				kMsgIMouseDelta		= "\002%z%z";
+const char*				kMsgIMouseRelMove	= "\003%z%z";
+const char*				kMsgIMouseWheel		= "\004%z%z";
+const char*				kMsgIKeyDown		= "\005%v%v%v";
+const char*				kMsgIKeyRepeat		= "\006%v%v%v%v";
+const char*				kMsgIKeyUp			= "\007%v%v%v";
+const char*				kMsgIMouseDown		= "\010%1i";
+const char*				kMsgIMouseUp		= "\011%1i";
 const char*				kMsgQInfo			= "QINF";
 const char*				kMsgEIncompatible	= "EICV%2i%2i";
 const char*				kMsgEBusy 			= "EBSY";
@@ -28,9 +28,11 @@
 //       adds horizontal mouse scrolling
 // 1.4:  adds crypto support
 // 1.6:  adds mouse warping support
+// 1.7:  adds session resumption
+// 1.8:  adds compact input records
 // NOTE: with new version, synergy minor version should increment
 static const SInt16		kProtocolMajorVersion = 1;
-static const SInt16		kProtocolMinorVersion = 6;
+static const SInt16		kProtocolMinorVersion = 8;
 
 // default contact port number
 static const UInt16		kDefaultPort = 24800;
@@ -259,6 +261,18 @@ extern const char*		kMsgDInfo;
 // pairs.
 extern const char*		kMsgDSetOptions;
 
+// session:  primary <-> secondary
+// the primary sends $1 = token, 16 random bytes, once the secondary
+// has been accepted and $2 = the sequence number of the latest change
+// to state the secondary keeps across connections:  the screen saver
+// and clipboards.  it sends it again with a new $2 after each
+// such change.
+// after a dropped connection the secondary sends back the token and
+// the last sequence number it got, between kMsgHelloBack and
+// kMsgDInfo, to resume the session;  the primary then only resends
+// what changed after that.
+extern const char*		kMsgDSession;
+
 // crypto iv:  primary -> secondary
 // sends a new iv (initialization vector) to the client for the
 // cryptography stream.
@@ -277,6 +291,62 @@ extern const char*		kMsgDFileTransfer;
 // of each object's directory.
 extern const char*		kMsgDDragInfo;
 
+//
+// compact input records
+//
+// since 1.8 the primary sends input as records with a one byte code
+// below kCompactCodeLimit instead of the 4 byte codes above.  regular
+// codes always start with a letter so the two can be told apart by the
+// first byte.  several records may follow each other in one packet.
+// integers are varints, 7 bits per byte low bits first, with the top
+// bit set on all but the last byte.  signed integers are zigzag encoded
+// first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...).  coordinates are
+// 32 bits wide.
+//
+
+static const UInt8		kCompactCodeLimit = 0x20;
+
+// mouse moved:  primary -> secondary
+// $1 = x, $2 = y.  x,y are absolute screen coordinates.
+extern const char*		kMsgIMouseMove;
+
+// mouse moved:  primary -> secondary
+// $1 = dx, $2 = dy.  dx,dy are the change from the position in the
+// previous kMsgIMouseMove or kMsgIMouseDelta.  the primary sends a
+// kMsgIMouseMove first after each kMsgCEnter.
+extern const char*		kMsgIMouseDelta;
+
+// relative mouse move:  primary -> secondary
+// $1 = dx, $2 = dy.  same as kMsgDMouseRelMove.
+extern const char*		kMsgIMouseRelMove;
+
+// mouse scroll:  primary -> secondary
+// $1 = xDelta, $2 = yDelta.  same as kMsgDMouseWheel.
+extern const char*		kMsgIMouseWheel;
+
+// key pressed:  primary -> secondary
+// $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton.  same as
+// kMsgDKeyDown.
+extern const char*		kMsgIKeyDown;
+
+// key auto-repeat:  primary -> secondary
+// $1 = KeyID, $2 = KeyModifierMask, $3 = number of repeats,
+// $4 = KeyButton.  same as kMsgDKeyRepeat.
+extern const char*		kMsgIKeyRepeat;
+
+// key released:  primary -> secondary
+// $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton.  same as
+// kMsgDKeyUp.
+extern const char*		kMsgIKeyUp;
+
+// mouse button pressed:  primary -> secondary
+// $1 = ButtonID
+extern const char*		kMsgIMouseDown;
+
+// mouse button released:  primary -> secondary
+// $1 = ButtonID
+extern const char*		kMsgIMouseUp;
+
 //
 // query codes
 //
@@ -35,6 +35,22 @@ freely, subject to the following restrictions:
 
 
 
+/**
+@brief States of a streamed clipboard message
+**/
+enum
+{
+	USYNERGY_CLIPBOARD_STATE_NONE					= 0,			/* Not streaming a clipboard, data is thrown away */
+	USYNERGY_CLIPBOARD_STATE_HEADER					= 1,			/* Collecting the message header */
+	USYNERGY_CLIPBOARD_STATE_FORMAT					= 2,			/* Collecting a format header */
+	USYNERGY_CLIPBOARD_STATE_DATA					= 3,			/* Passing on format data */
+};
+
+#define				USYNERGY_CLIPBOARD_HEADER_SIZE	21				/* Size, "DCLP", index, sequence number, string size, number of formats */
+#define				USYNERGY_CLIPBOARD_FORMAT_SIZE	8				/* Format, size */
+
+
+
 /**
 @brief Read 16 bit integer in network byte order and convert to native byte order
 **/
@@ -75,6 +91,17 @@ static void sTrace(uSynergyContext *context, const char* text)
 
 
 
+/**
+@brief Suspend the thread for a while, unless we're being polled
+**/
+static void sSleep(uSynergyContext *context, int timeMs)
+{
+	if (!context->m_polling)
+		context->m_sleepFunc(context->m_cookie, timeMs);
+}
+
+
+
 /**
 @brief Add string to reply packet
 **/
@@ -155,6 +182,9 @@ static uSynergyBool sSendReply(uSynergyContext *context)
 **/
 static void sSendMouseCallback(uSynergyContext *context)
 {
+	// This callback has the latest position, no need to send another one
+	context->m_mouseMovePending = USYNERGY_FALSE;
+
 	// Skip if no callback is installed
 	if (context->m_mouseCallback == 0L)
 		return;
@@ -199,12 +229,125 @@ static void sSendJoystickCallback(uSynergyContext *context, uint8_t joyNum)
 
 
 
+/**
+@brief Start streaming a clipboard message
+**/
+static void sStartClipboard(uSynergyContext *context)
+{
+	context->m_clipboardState		= USYNERGY_CLIPBOARD_STATE_HEADER;
+	context->m_clipboardHeaderSize	= 0;
+}
+
+
+
+/**
+@brief Move on to the next format of a streamed clipboard message
+**/
+static void sEndClipboardFormat(uSynergyContext *context)
+{
+	if (--context->m_clipboardFormats != 0)
+		context->m_clipboardState = USYNERGY_CLIPBOARD_STATE_FORMAT;
+	else
+		context->m_clipboardState = USYNERGY_CLIPBOARD_STATE_NONE;
+}
+
+
+
+/**
+@brief Pass on the next piece of a clipboard message, or throw it away if we're not streaming one
+**/
+static void sStreamClipboard(uSynergyContext *context, const uint8_t *data, uint32_t size)
+{
+	while (size != 0)
+	{
+		uint32_t n = size;
+		switch (context->m_clipboardState)
+		{
+		case USYNERGY_CLIPBOARD_STATE_HEADER:
+		case USYNERGY_CLIPBOARD_STATE_FORMAT:
+		{
+			// Collect the header, it may come in pieces
+			uint8_t *header = context->m_clipboardHeader;
+			uint32_t need = (context->m_clipboardState == USYNERGY_CLIPBOARD_STATE_HEADER ?
+				USYNERGY_CLIPBOARD_HEADER_SIZE : USYNERGY_CLIPBOARD_FORMAT_SIZE) - context->m_clipboardHeaderSize;
+			if (n > need)
+				n = need;
+			memcpy(header + context->m_clipboardHeaderSize, data, n);
+			context->m_clipboardHeaderSize += n;
+			if (n != need)
+				break;
+			context->m_clipboardHeaderSize = 0;
+
+			if (context->m_clipboardState == USYNERGY_CLIPBOARD_STATE_HEADER)
+			{
+				// Message header, see sProcessMessage
+				context->m_clipboardFormats = sNetToNative32(header + 17);
+				context->m_clipboardState = context->m_clipboardFormats != 0 ?
+					USYNERGY_CLIPBOARD_STATE_FORMAT : USYNERGY_CLIPBOARD_STATE_NONE;
+			}
+			else
+			{
+				// Format header
+				context->m_clipboardFormat = sNetToNative32(header);
+				context->m_clipboardSize = sNetToNative32(header + 4);
+				context->m_clipboardOffset = 0;
+				context->m_clipboardState = USYNERGY_CLIPBOARD_STATE_DATA;
+				if (context->m_clipboardSize == 0)
+				{
+					context->m_clipboardChunkCallback(context->m_cookie, context->m_clipboardFormat, 0, 0, data + n, 0);
+					sEndClipboardFormat(context);
+				}
+			}
+			break;
+		}
+
+		case USYNERGY_CLIPBOARD_STATE_DATA:
+			if (n > context->m_clipboardSize - context->m_clipboardOffset)
+				n = context->m_clipboardSize - context->m_clipboardOffset;
+			context->m_clipboardChunkCallback(context->m_cookie, context->m_clipboardFormat,
+				context->m_clipboardSize, context->m_clipboardOffset, data, n);
+			context->m_clipboardOffset += n;
+			if (context->m_clipboardOffset == context->m_clipboardSize)
+				sEndClipboardFormat(context);
+			break;
+
+		default:
+			break;
+		}
+		data += n;
+		size -= n;
+	}
+}
+
+
+
+/**
+@brief Send the callbacks and replies that were held back while polling
+**/
+static void sFlushPending(uSynergyContext *context)
+{
+	if (context->m_mouseMovePending)
+		sSendMouseCallback(context);
+	if (context->m_noopPending && context->m_connected)
+	{
+		context->m_noopPending = USYNERGY_FALSE;
+		sAddString(context, "CNOP");
+		sSendReply(context);
+	}
+}
+
+
+
 /**
 @brief Parse a single client message, update state, send callbacks and send replies
 **/
 #define USYNERGY_IS_PACKET(pkt_id)	memcmp(message+4, pkt_id, 4)==0
 static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 {
+	// A held back mouse move goes out before whatever happens next
+	if (context->m_mouseMovePending && !USYNERGY_IS_PACKET("DMMV"))
+		sSendMouseCallback(context);
+
 	// We have a packet!
 	if (memcmp(message+4, "Synergy", 7)==0)
 	{
@@ -221,7 +364,7 @@ static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 			// Send reply failed, let's try to reconnect
 			sTrace(context, "SendReply failed, trying to reconnect in a second");
 			context->m_connected = USYNERGY_FALSE;
-			context->m_sleepFunc(context->m_cookie, 1000);
+			sSleep(context, 1000);
 		}
 		else
 		{
@@ -315,9 +458,13 @@ static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 	{
 		// Mouse move. Reply with CNOP
 		//		kMsgDMouseMove		= "DMMV%2i%2i"
+		// When polling only the last move of a burst gets a callback
 		context->m_mouseX = sNetToNative16(message+8);
 		context->m_mouseY = sNetToNative16(message+10);
-		sSendMouseCallback(context);
+		if (context->m_polling)
+			context->m_mouseMovePending = USYNERGY_TRUE;
+		else
+			sSendMouseCallback(context);
 	}
 	else if (USYNERGY_IS_PACKET("DMWM"))
 	{
@@ -412,7 +559,16 @@ static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 		//		1 uint32:	The size n of the clipboard data
 		//		n uint8:	The clipboard data
 		const uint8_t *	parse_msg	= message+17;
-		uint32_t		num_formats = sNetToNative32(parse_msg);
+		uint32_t		num_formats;
+		if (context->m_clipboardChunkCallback != 0L)
+		{
+			// The whole message is here, stream it in one go
+			sStartClipboard(context);
+			sStreamClipboard(context, message, sNetToNative32(message) + 4);
+			context->m_clipboardState = USYNERGY_CLIPBOARD_STATE_NONE;
+			return;
+		}
+		num_formats = sNetToNative32(parse_msg);
 		parse_msg += 4;
 		for (; num_formats; num_formats--)
 		{
@@ -448,7 +604,12 @@ static void sProcessMessage(uSynergyContext *context, const uint8_t *message)
 		return;
 	}
 
-	// Reply with CNOP maybe?
+	// Reply with CNOP maybe?  When polling, one per poll will do.
+	if (context->m_polling)
+	{
+		context->m_noopPending = USYNERGY_TRUE;
+		return;
+	}
 	sAddString(context, "CNOP");
 	sSendReply(context);
 }
@@ -466,6 +627,11 @@ static void sSetDisconnected(uSynergyContext *context)
 	context->m_isCaptured		= USYNERGY_FALSE;
 	context->m_replyCur			= context->m_replyBuffer + 4;
 	context->m_sequenceNumber	= 0;
+	context->m_receiveOfs		= 0;
+	context->m_receiveSkip		= 0;
+	context->m_clipboardState	= USYNERGY_CLIPBOARD_STATE_NONE;
+	context->m_mouseMovePending	= USYNERGY_FALSE;
+	context->m_noopPending		= USYNERGY_FALSE;
 }
 
 
@@ -475,10 +641,11 @@ static void sSetDisconnected(uSynergyContext *context)
 **/
 static void sUpdateContext(uSynergyContext *context)
 {
-	/* Receive data (blocking) */
+	/* Receive data (blocking, unless we're being polled) */
 	int receive_size = USYNERGY_RECEIVE_BUFFER_SIZE - context->m_receiveOfs;
 	int num_received = 0;
-	int packlen = 0;
+	int start = 0;
+	uint32_t packlen = 0;
 	if (context->m_receiveFunc(context->m_cookie, context->m_receiveBuffer + context->m_receiveOfs, receive_size, &num_received) == USYNERGY_FALSE)
 	{
 		/* Receive failed, let's try to reconnect */
@@ -486,16 +653,15 @@ static void sUpdateContext(uSynergyContext *context)
 		sprintf(buffer, "Receive failed (%d bytes asked, %d bytes received), trying to reconnect in a second", receive_size, num_received);
 		sTrace(context, buffer);
 		sSetDisconnected(context);
-		context->m_sleepFunc(context->m_cookie, 1000);
+		sSleep(context, 1000);
 		return;
 	}
-	context->m_receiveOfs += num_received;
 
 	/*	If we didn't receive any data then we're probably still polling to get connected and
 		therefore not getting any data back. To avoid overloading the system with a Synergy
 		thread that would hammer on polling, we let it rest for a bit if there's no data. */
 	if (num_received == 0)
-		context->m_sleepFunc(context->m_cookie, 500);
+		sSleep(context, 500);
 
 	/* Check for timeouts */
 	if (context->m_hasReceivedHello)
@@ -511,48 +677,55 @@ static void sUpdateContext(uSynergyContext *context)
 			context->m_lastMessageTime = cur_time;
 	}
 
-	/* Eat packets */
-	for (;;)
+	/* Pass on the rest of an oversized clipboard, or throw away the rest of another oversized packet */
+	if (context->m_receiveSkip != 0 && num_received != 0)
+	{
+		uint8_t *received = context->m_receiveBuffer + context->m_receiveOfs;
+		int skip = (uint32_t)num_received < context->m_receiveSkip ? num_received : (int)context->m_receiveSkip;
+		sStreamClipboard(context, received, (uint32_t)skip);
+		memmove(received, received + skip, num_received - skip);
+		context->m_receiveSkip -= skip;
+		num_received -= skip;
+		if (context->m_receiveSkip == 0)
+			context->m_clipboardState = USYNERGY_CLIPBOARD_STATE_NONE;
+	}
+	context->m_receiveOfs += num_received;
+
+	/*	Eat packets. They're parsed where they are in the buffer and only the incomplete packet
+		at the end, if any, is moved to the front once we're done. */
+	while (context->m_receiveOfs - start >= 4)
 	{
 		/* Grab packet length and bail out if the packet goes beyond the end of the buffer */
-		packlen = sNetToNative32(context->m_receiveBuffer);
-		if (packlen+4 > context->m_receiveOfs)
+		packlen = (uint32_t)sNetToNative32(context->m_receiveBuffer + start);
+		if (packlen > (uint32_t)(context->m_receiveOfs - start - 4))
 			break;
 
 		/* Process message */
-		sProcessMessage(context, context->m_receiveBuffer);
-
-		/* Move packet to front of buffer */
-		memmove(context->m_receiveBuffer, context->m_receiveBuffer+packlen+4, context->m_receiveOfs-packlen-4);
-		context->m_receiveOfs -= packlen+4;
+		sProcessMessage(context, context->m_receiveBuffer + start);
+		start += packlen + 4;
+		packlen = 0;
+	}
+	sFlushPending(context);
+	if (start != 0)
+	{
+		memmove(context->m_receiveBuffer, context->m_receiveBuffer + start, context->m_receiveOfs - start);
+		context->m_receiveOfs -= start;
 	}
 
-	/* Throw away over-sized packets */
-	if (packlen > USYNERGY_RECEIVE_BUFFER_SIZE)
+	/*	Over-sized packets don't fit in the buffer. Large clipboards are streamed to the user as they come
+		in, anything else is thrown away. We need to have the packet ID to tell. */
+	if (packlen > USYNERGY_RECEIVE_BUFFER_SIZE - 4 && context->m_receiveOfs >= 8)
 	{
-		/* Oversized packet, ditch tail end */
-		char buffer[128];
-		sprintf(buffer, "Oversized packet: '%c%c%c%c' (length %d)", context->m_receiveBuffer[4], context->m_receiveBuffer[5], context->m_receiveBuffer[6], context->m_receiveBuffer[7], packlen);
-		sTrace(context, buffer);
-		num_received = context->m_receiveOfs-4; // 4 bytes for the size field
-		while (num_received != packlen)
+		if (memcmp(context->m_receiveBuffer + 4, "DCLP", 4) == 0 && context->m_clipboardChunkCallback != 0L)
+			sStartClipboard(context);
+		else
 		{
-			int buffer_left = packlen - num_received;
-			int to_receive = buffer_left < USYNERGY_RECEIVE_BUFFER_SIZE ? buffer_left : USYNERGY_RECEIVE_BUFFER_SIZE;
-			int ditch_received = 0;
-			if (context->m_receiveFunc(context->m_cookie, context->m_receiveBuffer, to_receive, &ditch_received) == USYNERGY_FALSE)
-			{
-				/* Receive failed, let's try to reconnect */
-				sTrace(context, "Receive failed, trying to reconnect in a second");
-				sSetDisconnected(context);
-				context->m_sleepFunc(context->m_cookie, 1000);
-				break;
-			}
-			else
-			{
-				num_received += ditch_received;
-			}
+			char buffer[128];
+			sprintf(buffer, "Oversized packet: '%c%c%c%c' (length %u)", context->m_receiveBuffer[4], context->m_receiveBuffer[5], context->m_receiveBuffer[6], context->m_receiveBuffer[7], packlen);
+			sTrace(context, buffer);
 		}
+		sStreamClipboard(context, context->m_receiveBuffer, (uint32_t)context->m_receiveOfs);
+		context->m_receiveSkip = packlen + 4 - context->m_receiveOfs;
 		context->m_receiveOfs = 0;
 	}
 }
@@ -597,6 +770,27 @@ void uSynergyUpdate(uSynergyContext *context)
 
 
 
+/**
+@brief Poll uSynergy
+**/
+uSynergyBool uSynergyPoll(uSynergyContext *context)
+{
+	context->m_polling = USYNERGY_TRUE;
+
+	/* Try to connect */
+	if (!context->m_connected && context->m_connectFunc(context->m_cookie))
+		context->m_connected = USYNERGY_TRUE;
+
+	/* Process whatever has arrived, call callbacks */
+	if (context->m_connected)
+		sUpdateContext(context);
+
+	context->m_polling = USYNERGY_FALSE;
+	return context->m_connected;
+}
+
+
+
 /**
 @brief Send clipboard data
 **/
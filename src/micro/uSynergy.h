@@ -173,6 +173,9 @@ USYNERGY_TRUE if receiving data succeeded and USYNERGY_FALSE otherwise. This fun
 has been received and wait for data to become available. If @a outLength is set to 0 upon completion it is
 assumed that the connection is alive, but still in a connecting state and needs time to settle.
 
+When the client is driven by uSynergyPoll the function must not block instead. It should return USYNERGY_TRUE
+with @a outLength set to 0 if no data is available right now.
+
 @param cookie		Cookie supplied in the Synergy context
 @param buffer		Address of buffer to receive data into
 @param maxLength	Maximum amount of bytes to write into the receive buffer
@@ -187,7 +190,7 @@ typedef uSynergyBool (*uSynergyReceiveFunc)(uSynergyCookie cookie, uint8_t *buff
 
 This function is called when uSynergy wants to suspend operation for a while before retrying an operation. It
 is mostly used when a socket times out or disconnect occurs to prevent uSynergy from continuously hammering a
-network connection in case the network is down.
+network connection in case the network is down. uSynergyPoll never calls it.
 
 @param cookie		Cookie supplied in the Synergy context
 @param timeMs		Time to sleep the current thread (in milliseconds)
@@ -306,6 +309,30 @@ typedef void		(*uSynergyClipboardCallback)(uSynergyCookie cookie, enum uSynergyC
 
 
 
+/**
+@brief Streaming clipboard event callback
+
+This callback is the alternative to uSynergyClipboardCallback for clipboards of any size. The clipboard data is
+passed on piece by piece as it comes in, so uSynergy doesn't need to hold all of it and input that arrives behind
+the clipboard isn't held up. Pieces of one format come in order, the formats one after the other. A format starts
+with @a offset 0 and is complete when @a offset + @a size equals @a totalSize. A format without data gets a single
+call with @a size 0. If the connection drops in the middle a format may never be completed. The data provided
+is read-only and only valid during the call.
+
+When this callback is installed it is used for all clipboards, instead of m_clipboardCallback. Without it,
+clipboards too big for the receive buffer are thrown away.
+
+@param cookie		Cookie supplied in the Synergy context
+@param format		Clipboard format
+@param totalSize	Size of this format's clipboard data
+@param offset		Offset of @a data within this format's clipboard data
+@param data			Memory area containing the next piece of clipboard data
+@param size			Size of @a data
+**/
+typedef void		(*uSynergyClipboardChunkCallback)(uSynergyCookie cookie, enum uSynergyClipboardFormat format, uint32_t totalSize, uint32_t offset, const uint8_t *data, uint32_t size);
+
+
+
 //---------------------------------------------------------------------------------------------------------------------
 //	Context
 //---------------------------------------------------------------------------------------------------------------------
@@ -355,6 +382,20 @@ typedef struct
 	uSynergyBool					m_mouseButtonMiddle;							/* Mouse middle button */
 	int8_t							m_joystickSticks[USYNERGY_NUM_JOYSTICKS][4];	/* Joystick stick position in 2 axes for 2 sticks */
 	uint16_t						m_joystickButtons[USYNERGY_NUM_JOYSTICKS];		/* Joystick button state */
+
+	/* Added after version 1.0.0, kept last so the fields above don't move */
+	uSynergyClipboardChunkCallback	m_clipboardChunkCallback;						/* Optional, callback for streamed clipboard data (can be NULL) */
+	uSynergyBool					m_polling;										/* Are we inside uSynergyPoll()? */
+	uSynergyBool					m_mouseMovePending;								/* Has the mouse moved since the last mouse callback? */
+	uSynergyBool					m_noopPending;									/* Do we owe the server a CNOP? */
+	uint32_t						m_receiveSkip;									/* Bytes of an oversized packet still to come */
+	int								m_clipboardState;								/* Where we are in a streamed clipboard message */
+	uint8_t							m_clipboardHeader[24];							/* Header bytes of a streamed clipboard message */
+	uint32_t						m_clipboardHeaderSize;							/* Number of bytes in m_clipboardHeader */
+	uint32_t						m_clipboardFormats;								/* Formats still to come in the streamed clipboard */
+	uint32_t						m_clipboardFormat;								/* Format currently being streamed */
+	uint32_t						m_clipboardSize;								/* Size of the format being streamed */
+	uint32_t						m_clipboardOffset;								/* Bytes of the format streamed so far */
 } uSynergyContext;
 
 
@@ -398,6 +439,25 @@ extern void		uSynergyUpdate(uSynergyContext *context);
 
 
 
+/**
+@brief Poll uSynergy
+
+This function is the non-blocking alternative to uSynergyUpdate, for clients that run their own event loop. It
+connects if needed, then processes all data that m_receiveFunc has available without waiting for more and
+returns. It never sleeps, so m_receiveFunc must not block either (see uSynergyReceiveFunc).
+
+Call it whenever the connection becomes readable, and at least a few times per USYNERGY_IDLE_TIMEOUT so a dead
+connection is noticed. Mouse moves received in one call are combined into a single mouse callback with the last
+position, made before any other callback so the order of events is kept. The server is sent one CNOP per call
+instead of one per message.
+
+@param context	Context to be polled
+@returns		USYNERGY_TRUE if the client is connected after the call
+**/
+extern uSynergyBool	uSynergyPoll(uSynergyContext *context);
+
+
+
 /**
 @brief Send clipboard data
 
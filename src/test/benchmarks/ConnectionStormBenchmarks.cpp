@@ -0,0 +1,262 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/synergy/MockScreen.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "server/Server.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "io/CryptoOptions.h"
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "arch/XArch.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+#include "base/TMethodJob.h"
+
+#include "test/global/gtest.h"
+
+#include <vector>
+#if SYSAPI_UNIX
+#include <sys/resource.h>
+#endif
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+
+static const int		kPort      = 24803;
+static const int		kStormSize = 1000;
+
+static void
+getScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+	x = 0;
+	y = 0;
+	w = 1;
+	h = 1;
+}
+
+static void
+getCursorPos(SInt32& x, SInt32& y)
+{
+	x = 0;
+	y = 0;
+}
+
+// opens a storm of connections that never say hello while watching
+// how long the event loop stalls, then lets a real client in
+class CConnectionStorm {
+public:
+	CConnectionStorm(IEventQueue* events, const CNetworkAddress& address,
+							CClientListener* listener, CClient* client) :
+		m_events(events),
+		m_address(address),
+		m_listener(listener),
+		m_client(client),
+		m_thread(NULL),
+		m_maxGap(0.0),
+		m_closed(false),
+		m_clientStarted(false),
+		m_clientConnected(false)
+	{
+		m_events->adoptHandler(m_events->forCClientListener().connected(),
+							m_listener,
+							new TMethodEventJob<CConnectionStorm>(this,
+								&CConnectionStorm::handleClientConnected));
+		m_events->adoptHandler(m_events->forCClient().connected(),
+							m_client->getEventTarget(),
+							new TMethodEventJob<CConnectionStorm>(this,
+								&CConnectionStorm::handleConnected));
+	}
+
+	~CConnectionStorm()
+	{
+		m_events->removeHandler(m_events->forCClientListener().connected(),
+							m_listener);
+		m_events->removeHandler(m_events->forCClient().connected(),
+							m_client->getEventTarget());
+		for (size_t i = 0; i < m_sockets.size(); ++i) {
+			ARCH->closeSocket(m_sockets[i]);
+		}
+	}
+
+	// returns the longest the event loop went without running a timer
+	double				run()
+	{
+		CEventQueueTimer* tick    = m_events->newTimer(0.05, NULL);
+		CEventQueueTimer* timeout = m_events->newOneShotTimer(20.0, NULL);
+		m_events->adoptHandler(CEvent::kTimer, tick,
+							new TMethodEventJob<CConnectionStorm>(this,
+								&CConnectionStorm::handleTick));
+		m_events->adoptHandler(CEvent::kTimer, timeout,
+							new TMethodEventJob<CConnectionStorm>(this,
+								&CConnectionStorm::handleTimeout));
+		m_tick.reset();
+		m_thread = new CThread(new TMethodJob<CConnectionStorm>(this,
+								&CConnectionStorm::stormThread));
+		m_events->loop();
+		m_events->removeHandler(CEvent::kTimer, timeout);
+		m_events->deleteTimer(timeout);
+		m_events->removeHandler(CEvent::kTimer, tick);
+		m_events->deleteTimer(tick);
+		m_thread->wait();
+		delete m_thread;
+		m_thread = NULL;
+		return m_maxGap;
+	}
+
+	bool				isClientConnected() const { return m_clientConnected; }
+
+private:
+	void				stormThread(void*)
+	{
+		for (int i = 0; i < kStormSize; ++i) {
+			CArchSocket socket = ARCH->newSocket(IArchNetwork::kINET,
+							IArchNetwork::kSTREAM);
+			try {
+				ARCH->connectSocket(socket, m_address.getAddress());
+			}
+			catch (XArchNetwork&) {
+				ARCH->closeSocket(socket);
+				continue;
+			}
+			m_sockets.push_back(socket);
+		}
+	}
+
+	void				handleTick(const CEvent&, void*)
+	{
+		double gap = m_tick.getTime();
+		m_tick.reset();
+		if (gap > m_maxGap) {
+			m_maxGap = gap;
+		}
+
+		if (!m_closed) {
+			// once the storm is over the stalled connections go away
+			if (m_thread->wait(0.0)) {
+				for (size_t i = 0; i < m_sockets.size(); ++i) {
+					ARCH->closeSocket(m_sockets[i]);
+				}
+				m_sockets.clear();
+				m_closed = true;
+			}
+		}
+		else if (!m_clientStarted && m_listener->getNumPendingClients() == 0) {
+			// and a real client gets in
+			m_clientStarted = true;
+			m_client->connect();
+		}
+	}
+
+	void				handleClientConnected(const CEvent&, void*)
+	{
+		CClientProxy* client = m_listener->getNextClient();
+		if (client != NULL) {
+			m_listener->getServer()->adoptClient(client);
+		}
+	}
+
+	void				handleConnected(const CEvent&, void*)
+	{
+		m_clientConnected = true;
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+private:
+	IEventQueue*		m_events;
+	CNetworkAddress		m_address;
+	CClientListener*	m_listener;
+	CClient*			m_client;
+	CThread*			m_thread;
+	std::vector<CArchSocket>	m_sockets;
+	CStopwatch			m_tick;
+	double				m_maxGap;
+	bool				m_closed;
+	bool				m_clientStarted;
+	bool				m_clientConnected;
+};
+
+TEST(CConnectionStormBenchmarks, listener_idleConnections)
+{
+#if SYSAPI_UNIX
+	// both ends of the storm live in this process
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#endif
+
+	CEventQueue events;
+	CNetworkAddress address("127.0.0.1", kPort);
+	CCryptoOptions cryptoOptions;
+	address.resolve();
+
+	// server
+	CSocketMultiplexer serverMultiplexer;
+	CClientListener listener(address,
+							new CTCPSocketFactory(&events, &serverMultiplexer),
+							NULL, cryptoOptions, &events);
+	NiceMock<CMockScreen> serverScreen;
+	NiceMock<CMockPrimaryClient> primaryClient;
+	NiceMock<CMockConfig> serverConfig;
+	NiceMock<CMockInputFilter> serverInputFilter;
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	CServer server(serverConfig, &primaryClient, &serverScreen, &events, true);
+	server.m_mock = true;
+	listener.setServer(&server);
+
+	// client, which connects once the storm has passed
+	NiceMock<CMockScreen> clientScreen;
+	ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getScreenShape));
+	ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getCursorPos));
+	CSocketMultiplexer clientMultiplexer;
+	CClient client(&events, "stub", address,
+							new CTCPSocketFactory(&events, &clientMultiplexer),
+							NULL, &clientScreen, cryptoOptions, true);
+
+	double maxGap;
+	bool connected;
+	{
+		CConnectionStorm storm(&events, address, &listener, &client);
+		maxGap    = storm.run();
+		connected = storm.isClientConnected();
+	}
+
+	LOG((CLOG_INFO "connection storm: longest stall %.3f s", maxGap));
+	EXPECT_TRUE(connected);
+	EXPECT_LT(maxGap, 0.5);
+}
@@ -0,0 +1,115 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/benchmarks/InputReplay.h"
+#include "synergy/IPrimaryScreen.h"
+#include "base/EventQueue.h"
+#include "base/EventDataPool.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+// moves the mouse one event at a time, like a screen without an input
+// channel, with a few motion events waiting in the queue all the time
+class CMouseMover {
+public:
+	CMouseMover(IEventQueue* events) :
+		m_events(events),
+		m_sent(0),
+		m_wanted(0)
+	{
+		m_events->adoptHandler(m_events->forIPrimaryScreen().motionOnSecondary(),
+							this,
+							new TMethodEventJob<CMouseMover>(this,
+								&CMouseMover::handleMotion));
+	}
+
+	~CMouseMover()
+	{
+		m_events->removeHandler(m_events->forIPrimaryScreen().motionOnSecondary(),
+							this);
+	}
+
+	void
+	run(UInt32 n, UInt32 inFlight)
+	{
+		m_sent   = 0;
+		m_wanted = n;
+		while (m_sent < inFlight) {
+			send();
+		}
+		m_events->loop();
+	}
+
+private:
+	void
+	send()
+	{
+		++m_sent;
+		m_events->addEvent(CEvent(m_events->forIPrimaryScreen().motionOnSecondary(),
+							this, IPrimaryScreen::CMotionInfo::alloc(1, -1)));
+	}
+
+	void
+	handleMotion(const CEvent&, void*)
+	{
+		if (m_sent < m_wanted) {
+			send();
+		}
+		else if (m_events->isEmpty()) {
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+private:
+	IEventQueue*		m_events;
+	UInt32				m_sent;
+	UInt32				m_wanted;
+};
+
+TEST(CEventQueueBenchmarks, motionEvents_steadyState)
+{
+	static const UInt32 kEvents   = 200000;
+	static const UInt32 kInFlight = 16;
+
+	CEventQueue events;
+	CMouseMover mover(&events);
+
+	// the event table and the queue buffer grow to what's in flight
+	mover.run(1000, kInFlight);
+
+	long allocations = g_allocations;
+#ifndef NDEBUG
+	UInt32 heapAllocations = CEventDataPool::getHeapAllocations();
+#endif
+	CStopwatch timer;
+	mover.run(kEvents, kInFlight);
+	double elapsed = timer.getTime();
+	allocations = g_allocations - allocations;
+#ifndef NDEBUG
+	allocations += CEventDataPool::getHeapAllocations() - heapAllocations;
+#endif
+
+	LOG((CLOG_INFO "motion events: %.0f events/s, %.0f allocations/s, %.4f allocations per event",
+		kEvents / elapsed, allocations / elapsed,
+		static_cast<double>(allocations) / kEvents));
+
+	// the queue buffer's deque allocates a block every hundred or so
+	EXPECT_LT(allocations, static_cast<long>(kEvents / 50));
+}
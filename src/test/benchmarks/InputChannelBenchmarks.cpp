@@ -0,0 +1,142 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/InputChannel.h"
+#include "synergy/IPrimaryScreen.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+// takes input the way CServer does, either from an input channel or
+// as one motionOnPrimary event each, and quits the event loop once it
+// has had the expected amount
+class CInputReceiver {
+public:
+	CInputReceiver(IEventQueue* events, CInputChannel* channel) :
+		m_events(events),
+		m_channel(channel),
+		m_wanted(0)
+	{
+		m_events->adoptHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_channel->getEventTarget(),
+							new TMethodEventJob<CInputReceiver>(this,
+								&CInputReceiver::handleInputReady));
+		m_events->adoptHandler(m_events->forIPrimaryScreen().motionOnPrimary(),
+							this,
+							new TMethodEventJob<CInputReceiver>(this,
+								&CInputReceiver::handleMotion));
+	}
+
+	~CInputReceiver()
+	{
+		m_events->removeHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_channel->getEventTarget());
+		m_events->removeHandler(m_events->forIPrimaryScreen().motionOnPrimary(),
+							this);
+	}
+
+	// run the event loop until \p count more inputs have come in
+	void				run(size_t count)
+	{
+		m_wanted = m_received.size() + count;
+		m_events->loop();
+	}
+
+private:
+	void				handleInputReady(const CEvent& event, void*)
+	{
+		CInputChannel::CInput input;
+		while (m_channel->receive(input)) {
+			onInput(input.m_x);
+		}
+		const CInputChannel::CInput* overflow =
+			m_channel->receiveOverflow(event);
+		if (overflow != NULL) {
+			onInput(overflow->m_x);
+		}
+	}
+
+	void				handleMotion(const CEvent& event, void*)
+	{
+		IPrimaryScreen::CMotionInfo* info =
+			static_cast<IPrimaryScreen::CMotionInfo*>(event.getData());
+		onInput(info->m_x);
+	}
+
+	void				onInput(SInt32 x)
+	{
+		m_received.push_back(x);
+		if (m_received.size() == m_wanted) {
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+public:
+	IEventQueue*		m_events;
+	CInputChannel*		m_channel;
+	size_t				m_wanted;
+	std::vector<SInt32>	m_received;
+};
+
+TEST(CInputChannelBenchmarks, send_burstOfMotion_fasterThanEvents)
+{
+	static const SInt32 kBursts    = 400;
+	static const SInt32 kBurstSize = 256;
+
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	CEventQueue events;
+	CInputChannel channel(&events);
+	CInputReceiver receiver(&events, &channel);
+
+	// one event per motion, like the screens used to send
+	CStopwatch timer;
+	for (SInt32 burst = 0; burst < kBursts; ++burst) {
+		for (SInt32 i = 0; i < kBurstSize; ++i) {
+			events.addEvent(CEvent(events.forIPrimaryScreen().motionOnPrimary(),
+							&receiver, IPrimaryScreen::CMotionInfo::alloc(i, 0)));
+		}
+		receiver.run(kBurstSize);
+	}
+	double eventTime = timer.getTime();
+
+	// the same through the channel
+	timer.reset();
+	for (SInt32 burst = 0; burst < kBursts; ++burst) {
+		for (SInt32 i = 0; i < kBurstSize; ++i) {
+			channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, i, 0);
+		}
+		receiver.run(kBurstSize);
+	}
+	double channelTime = timer.getTime();
+
+	CLOG->setFilter(filter);
+
+	ASSERT_EQ(static_cast<size_t>(2 * kBursts * kBurstSize),
+							receiver.m_received.size());
+	double n = static_cast<double>(kBursts * kBurstSize);
+	LOG((CLOG_INFO "motion: %.0f ns per event, %.0f ns through the input channel",
+							1.0e+9 * eventTime / n, 1.0e+9 * channelTime / n));
+
+	// each event is a payload to allocate, a lock and a handler lookup
+	EXPECT_LT(channelTime, eventTime);
+}
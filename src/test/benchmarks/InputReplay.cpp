@@ -0,0 +1,622 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/benchmarks/InputReplay.h"
+#include "server/Server.h"
+#include "server/ClientProxy1_8.h"
+#include "client/ServerProxy.h"
+#include "synergy/PacketStreamFilter.h"
+#include "synergy/ProtocolUtil.h"
+#include "synergy/Clipboard.h"
+#include "synergy/protocol_types.h"
+#include "synergy/option_types.h"
+#include "base/IEventQueue.h"
+#include "base/TMethodEventJob.h"
+#include "arch/Arch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::SaveArg;
+
+// how much of the trace the server gets to see at a time.  about what
+// piles up in the input channel between two passes through the event
+// loop at a thousand mouse reports a second.
+static const double		kStepTime = 0.001;
+
+// how long runRealTime() waits after the last record for the server's
+// timers to send what it's still holding on to
+static const double		kRealTimeTail = 0.1;
+
+// the client's screen
+static const SInt32		kScreenWidth  = 1920;
+static const SInt32		kScreenHeight = 1080;
+
+//
+// made up session
+//
+
+static
+void
+addInput(CInputTrace::CRecordList& records, double time,
+				CInputChannel::CInput::EType type, SInt32 x, SInt32 y,
+				ButtonID button, KeyID key, KeyButton keyButton)
+{
+	CInputTrace::CRecord record;
+	record.m_type              = CInputTrace::CRecord::kInput;
+	record.m_time              = time;
+	record.m_id                = 0;
+	record.m_count             = 0;
+	record.m_input.m_type      = type;
+	record.m_input.m_x         = x;
+	record.m_input.m_y         = y;
+	record.m_input.m_button    = button;
+	record.m_input.m_key       = key;
+	record.m_input.m_mask      = 0;
+	record.m_input.m_keyButton = keyButton;
+	record.m_input.m_count     = 1;
+	record.m_input.m_time      = 0.0;
+	records.push_back(record);
+}
+
+static
+void
+addData(CInputTrace::CRecordList& records, double time,
+				CInputTrace::CRecord::EType type, UInt32 count,
+				const CString& data)
+{
+	CInputTrace::CRecord record;
+	record.m_type  = type;
+	record.m_time  = time;
+	record.m_id    = kClipboardClipboard;
+	record.m_count = count;
+	record.m_data  = data;
+	records.push_back(record);
+}
+
+static
+CString
+makeClipboard(UInt32 size, char fill)
+{
+	CClipboard clipboard;
+	clipboard.open(0);
+	clipboard.add(IClipboard::kText, CString(size, fill));
+	clipboard.close();
+	return clipboard.marshall();
+}
+
+static
+bool
+isEarlier(const CInputTrace::CRecord& a, const CInputTrace::CRecord& b)
+{
+	return (a.m_time < b.m_time);
+}
+
+void
+makeInputSession(CInputTrace::CRecordList& records)
+{
+	typedef CInputChannel::CInput CInput;
+	static const int kMilliseconds = 5000;
+
+	// the same session every time
+	UInt32 random = 12345;
+	for (int ms = 0; ms < kMilliseconds; ++ms) {
+		double t = 0.001 * ms;
+
+		// the pointer wanders about a little every millisecond
+		random = random * 1103515245 + 12345;
+		SInt32 dx = static_cast<SInt32>((random >> 16) % 9) - 4;
+		SInt32 dy = static_cast<SInt32>((random >> 24) % 9) - 4;
+		addInput(records, t, CInput::kMotionOnSecondary, dx, dy,
+								kButtonNone, kKeyNone, 0);
+
+		// a word every quarter of a second
+		if (ms % 250 == 100) {
+			for (int i = 0; i < 6; ++i) {
+				KeyID key = 'a' + (random >> (i + 8)) % 26;
+				double down = t + 0.030 * i;
+				addInput(records, down, CInput::kKeyDown, 0, 0,
+								kButtonNone, key, 38 + i);
+				addInput(records, down + 0.015, CInput::kKeyUp, 0, 0,
+								kButtonNone, key, 38 + i);
+			}
+		}
+
+		// a click every second
+		if (ms % 1000 == 500) {
+			addInput(records, t, CInput::kButtonDown, 0, 0,
+								kButtonLeft, kKeyNone, 0);
+			addInput(records, t + 0.080, CInput::kButtonUp, 0, 0,
+								kButtonLeft, kKeyNone, 0);
+		}
+
+		// half a second of scrolling
+		if (ms >= 2000 && ms < 2500 && ms % 10 == 0) {
+			addInput(records, t, CInput::kWheel, 0, -120,
+								kButtonNone, kKeyNone, 0);
+		}
+	}
+
+	// some text copied, once a lot of it, and a file dragged over
+	addData(records, 1.5, CInputTrace::CRecord::kClipboard, 0,
+								makeClipboard(1000, 'x'));
+	addData(records, 3.5, CInputTrace::CRecord::kClipboard, 0,
+								makeClipboard(256 * 1024, 'y'));
+	addData(records, 4.0, CInputTrace::CRecord::kDragInfo, 1,
+								"/home/user/report.pdf,1048576,");
+
+	std::stable_sort(records.begin(), records.end(), &isEarlier);
+}
+
+
+//
+// CMemoryStream
+//
+
+CMemoryStream::CMemoryStream(IEventQueue* events) :
+	m_bytes(0),
+	m_events(events),
+	m_offset(0),
+	m_peer(NULL)
+{
+	// do nothing
+}
+
+void
+CMemoryStream::push(const CString& data)
+{
+	m_input.erase(0, m_offset);
+	m_offset = 0;
+	m_input += data;
+	m_events->addEvent(CEvent(m_events->forIStream().inputReady(),
+								getEventTarget()));
+}
+
+void
+CMemoryStream::setPeer(CMemoryStream* peer)
+{
+	m_peer = peer;
+}
+
+UInt32
+CMemoryStream::read(void* buffer, UInt32 n)
+{
+	UInt32 available = static_cast<UInt32>(m_input.size()) - m_offset;
+	if (n > available) {
+		n = available;
+	}
+	if (buffer != NULL) {
+		memcpy(buffer, m_input.data() + m_offset, n);
+	}
+	m_offset += n;
+	return n;
+}
+
+void
+CMemoryStream::write(const void* buffer, UInt32 n)
+{
+	m_writes.push_back(CString(static_cast<const char*>(buffer), n));
+	m_bytes += n;
+	if (m_peer != NULL) {
+		m_peer->push(m_writes.back());
+	}
+}
+
+void*
+CMemoryStream::getEventTarget() const
+{
+	return const_cast<void*>(static_cast<const void*>(this));
+}
+
+bool
+CMemoryStream::isReady() const
+{
+	return (getSize() != 0);
+}
+
+UInt32
+CMemoryStream::getSize() const
+{
+	return static_cast<UInt32>(m_input.size()) - m_offset;
+}
+
+
+//
+// CReplayClient
+//
+
+CReplayClient::CReplayClient() :
+	m_faked(0),
+	m_keys(0),
+	m_buttons(0),
+	m_clipboards(0),
+	m_timeMotion(false)
+{
+	// do nothing
+}
+
+void
+CReplayClient::getShape(SInt32& x, SInt32& y,
+				SInt32& width, SInt32& height) const
+{
+	x      = 0;
+	y      = 0;
+	width  = kScreenWidth;
+	height = kScreenHeight;
+}
+
+void
+CReplayClient::getCursorPos(SInt32& x, SInt32& y) const
+{
+	x = kScreenWidth / 2;
+	y = kScreenHeight / 2;
+}
+
+void
+CReplayClient::setClipboard(ClipboardID, const IClipboard*)
+{
+	++m_clipboards;
+}
+
+void
+CReplayClient::keyDown(KeyID, KeyModifierMask, KeyButton)
+{
+	++m_faked;
+	++m_keys;
+}
+
+void
+CReplayClient::keyRepeat(KeyID, KeyModifierMask, SInt32, KeyButton)
+{
+	++m_faked;
+	++m_keys;
+}
+
+void
+CReplayClient::keyUp(KeyID, KeyModifierMask, KeyButton)
+{
+	++m_faked;
+	++m_keys;
+}
+
+void
+CReplayClient::mouseDown(ButtonID)
+{
+	++m_faked;
+	++m_buttons;
+}
+
+void
+CReplayClient::mouseUp(ButtonID)
+{
+	++m_faked;
+	++m_buttons;
+}
+
+void
+CReplayClient::mouseMove(SInt32, SInt32)
+{
+	++m_faked;
+	if (m_timeMotion) {
+		m_motionTimes.push_back(ARCH->time());
+	}
+}
+
+void
+CReplayClient::mouseRelativeMove(SInt32, SInt32)
+{
+	++m_faked;
+	if (m_timeMotion) {
+		m_motionTimes.push_back(ARCH->time());
+	}
+}
+
+void
+CReplayClient::mouseWheel(SInt32, SInt32)
+{
+	++m_faked;
+}
+
+
+//
+// CServerReplay
+//
+
+CServerReplay::CServerReplay(IEventQueue* events, UInt32 mouseSendInterval) :
+	m_events(events),
+	m_stepEvent(CEvent::kUnknown),
+	m_inputFilter(events),
+	m_stream(events),
+	m_channel(NULL),
+	m_server(NULL),
+	m_proxy(NULL),
+	m_setup(0),
+	m_start(0),
+	m_records(NULL),
+	m_next(0),
+	m_clipboardSeqNum(0),
+	m_realTime(false),
+	m_finishing(false),
+	m_startTime(0.0),
+	m_stepTimer(NULL)
+{
+	m_events->registerTypeOnce(m_stepEvent, "CServerReplay::step");
+	m_events->adoptHandler(m_stepEvent, this,
+							new TMethodEventJob<CServerReplay>(this,
+								&CServerReplay::handleStep));
+
+	ON_CALL(m_config, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(m_config, getInputFilter()).WillByDefault(Return(&m_inputFilter));
+	ON_CALL(m_primaryClient, getEventTarget()).WillByDefault(Return(&m_primaryClient));
+	ON_CALL(m_primaryClient, leave()).WillByDefault(Return(true));
+	ON_CALL(m_primaryClient, getClipboard(_, _)).WillByDefault(
+							Invoke(this, &CServerReplay::getClipboard));
+	ON_CALL(m_screen, setInputChannel(_)).WillByDefault(SaveArg<0>(&m_channel));
+	if (mouseSendInterval != 0) {
+		m_config.addOption("", kOptionMouseSendInterval, mouseSendInterval);
+	}
+
+	// without drag and drop, the server would ask the mock screen for
+	// the file being dragged on every mouse up
+	m_server = new CServer(m_config, &m_primaryClient, &m_screen,
+							m_events, false);
+	m_server->m_mock = true;
+
+	// the client answers the proxy's query for its screen, the server
+	// takes the client and the cursor goes over to it
+	m_proxy = new CClientProxy1_8("stub",
+							new CPacketStreamFilter(m_events, &m_stream, false),
+							m_server, m_events);
+	CString info;
+	CProtocolUtil::appendf(info, kMsgDInfo, 0, 0, kScreenWidth, kScreenHeight,
+							0, kScreenWidth / 2, kScreenHeight / 2);
+	UInt8 size[4];
+	size[0] = static_cast<UInt8>(info.size() >> 24);
+	size[1] = static_cast<UInt8>(info.size() >> 16);
+	size[2] = static_cast<UInt8>(info.size() >>  8);
+	size[3] = static_cast<UInt8>(info.size());
+	m_stream.push(CString(reinterpret_cast<char*>(size), 4) + info);
+	runLoop();
+
+	m_server->adoptClient(m_proxy);
+	m_events->addEvent(CEvent(m_events->forCServer().switchToScreen(),
+							&m_inputFilter,
+							CServer::CSwitchToScreenInfo::alloc("stub")));
+	runLoop();
+	m_setup = m_stream.m_writes.size();
+	m_start = m_setup;
+}
+
+CServerReplay::~CServerReplay()
+{
+	// the mock server leaves its clients alone
+	delete m_proxy;
+	delete m_server;
+	m_events->removeHandler(m_stepEvent, this);
+}
+
+void
+CServerReplay::run(const CInputTrace::CRecordList& records)
+{
+	m_records = &records;
+	m_next    = 0;
+	m_start   = m_stream.m_writes.size();
+	runLoop();
+}
+
+void
+CServerReplay::runRealTime(const CInputTrace::CRecordList& records)
+{
+	m_records   = &records;
+	m_next      = 0;
+	m_start     = m_stream.m_writes.size();
+	m_realTime  = true;
+	m_finishing = false;
+	m_inputTimes.clear();
+	m_inputTimes.reserve(records.size());
+	m_startTime = ARCH->time() - records.front().m_time;
+	runLoop();
+	m_realTime  = false;
+}
+
+void
+CServerReplay::connect(CClientReplay& client)
+{
+	m_stream.setPeer(client.getStream());
+}
+
+void
+CServerReplay::getSetup(std::vector<CString>& writes) const
+{
+	writes.assign(m_stream.m_writes.begin(),
+							m_stream.m_writes.begin() + m_setup);
+}
+
+void
+CServerReplay::getReplay(std::vector<CString>& writes) const
+{
+	writes.assign(m_stream.m_writes.begin() + m_start,
+							m_stream.m_writes.end());
+}
+
+void
+CServerReplay::runLoop()
+{
+	m_events->addEvent(CEvent(m_stepEvent, this));
+	m_events->loop();
+}
+
+void
+CServerReplay::startStepTimer(double timeout)
+{
+	m_stepTimer = m_events->newOneShotTimer(timeout, NULL);
+	m_events->adoptHandler(CEvent::kTimer, m_stepTimer,
+							new TMethodEventJob<CServerReplay>(this,
+								&CServerReplay::handleStep));
+}
+
+void
+CServerReplay::handleStep(const CEvent&, void*)
+{
+	if (m_stepTimer != NULL) {
+		m_events->removeHandler(CEvent::kTimer, m_stepTimer);
+		m_events->deleteTimer(m_stepTimer);
+		m_stepTimer = NULL;
+	}
+
+	if (m_realTime && m_next == m_records->size()) {
+		// the queue is never empty for long in real time.  give the
+		// server's timers a moment and stop.
+		if (m_finishing) {
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+		else {
+			m_finishing = true;
+			startStepTimer(kRealTimeTail);
+		}
+		return;
+	}
+	if (m_records == NULL || m_next == m_records->size()) {
+		// done once everything the trace caused has been handled
+		if (m_events->isEmpty()) {
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+		else {
+			m_events->addEvent(CEvent(m_stepEvent, this));
+		}
+		return;
+	}
+
+	const CInputTrace::CRecordList& records = *m_records;
+	double end = records[m_next].m_time + kStepTime;
+	if (m_realTime) {
+		// everything that's due
+		end = ARCH->time() - m_startTime;
+	}
+	for (; m_next < records.size() && records[m_next].m_time < end; ++m_next) {
+		const CInputTrace::CRecord& record = records[m_next];
+		switch (record.m_type) {
+		case CInputTrace::CRecord::kInput:
+			if (m_realTime) {
+				m_inputTimes.push_back(ARCH->time());
+			}
+			m_channel->send(record.m_input);
+			break;
+
+		case CInputTrace::CRecord::kClipboard: {
+			// the primary screen grabs the clipboard and then has new
+			// data, which getClipboard() returns
+			m_clipboard = record.m_data;
+			++m_clipboardSeqNum;
+			CEvent::Type types[] = {
+				m_events->forIScreen().clipboardGrabbed(),
+				m_events->forCClientProxy().clipboardChanged()
+			};
+			for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+				IScreen::CClipboardInfo* info = (IScreen::CClipboardInfo*)
+									malloc(sizeof(IScreen::CClipboardInfo));
+				info->m_id             = record.m_id;
+				info->m_sequenceNumber = m_clipboardSeqNum;
+				m_events->addEvent(CEvent(types[i],
+									m_primaryClient.getEventTarget(), info));
+			}
+			break;
+		}
+
+		case CInputTrace::CRecord::kDragInfo:
+			m_proxy->sendDragInfo(record.m_count, record.m_data.data(),
+								record.m_data.size());
+			break;
+		}
+	}
+	double timeout = 0.0;
+	if (m_realTime && m_next < records.size()) {
+		timeout = records[m_next].m_time - (ARCH->time() - m_startTime);
+	}
+	if (timeout > 0.0) {
+		// wait for the next record
+		startStepTimer(timeout);
+	}
+	else {
+		m_events->addEvent(CEvent(m_stepEvent, this));
+	}
+}
+
+bool
+CServerReplay::getClipboard(ClipboardID, IClipboard* clipboard)
+{
+	IClipboard::unmarshall(clipboard, m_clipboard, 0);
+	return true;
+}
+
+
+//
+// CClientReplay
+//
+
+CClientReplay::CClientReplay(IEventQueue* events) :
+	m_events(events),
+	m_stepEvent(CEvent::kUnknown),
+	m_stream(events),
+	m_packetStream(NULL),
+	m_proxy(NULL),
+	m_writes(NULL),
+	m_next(0)
+{
+	m_events->registerTypeOnce(m_stepEvent, "CClientReplay::step");
+	m_events->adoptHandler(m_stepEvent, this,
+							new TMethodEventJob<CClientReplay>(this,
+								&CClientReplay::handleStep));
+
+	m_packetStream = new CPacketStreamFilter(m_events, &m_stream, false);
+	m_proxy        = new CServerProxy(&m_client, m_packetStream, m_events);
+}
+
+CClientReplay::~CClientReplay()
+{
+	delete m_proxy;
+	delete m_packetStream;
+	m_events->removeHandler(m_stepEvent, this);
+}
+
+void
+CClientReplay::run(const std::vector<CString>& writes)
+{
+	m_writes = &writes;
+	m_next   = 0;
+	m_events->addEvent(CEvent(m_stepEvent, this));
+	m_events->loop();
+}
+
+void
+CClientReplay::handleStep(const CEvent&, void*)
+{
+	if (m_next < m_writes->size()) {
+		m_stream.push((*m_writes)[m_next++]);
+		m_events->addEvent(CEvent(m_stepEvent, this));
+	}
+	else if (m_events->isEmpty()) {
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+	else {
+		m_events->addEvent(CEvent(m_stepEvent, this));
+	}
+}
@@ -0,0 +1,246 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/synergy/MockScreen.h"
+#include "server/InputFilter.h"
+#include "client/Client.h"
+#include "synergy/InputTrace.h"
+#include "io/IStream.h"
+#include "base/String.h"
+#include "common/stdvector.h"
+
+class CServer;
+class CClientProxy;
+class CServerProxy;
+class CClientReplay;
+class CEventQueueTimer;
+class IEventQueue;
+
+//! Trace to replay, from --trace, or empty for the made up session
+extern CString			g_inputTraceFile;
+
+//! Number of times operator new has been called
+extern volatile long	g_allocations;
+
+//! Make up a session
+/*!
+A few seconds of someone working on a client:  a thousand mouse
+reports a second, typing, scrolling, clicking, copying text now and
+then and dragging a file over.
+*/
+void					makeInputSession(CInputTrace::CRecordList& records);
+
+//! Stream in memory
+/*!
+Keeps everything written to it, and hands out what's push()ed into it
+with an inputReady event, like a socket would.
+*/
+class CMemoryStream : public synergy::IStream {
+public:
+	CMemoryStream(IEventQueue* events);
+
+	//! Make \p data available to read
+	void				push(const CString& data);
+
+	//! Pass on writes
+	/*!
+	Everything written from now on is also push()ed into \p peer, or
+	nowhere else if it's NULL.
+	*/
+	void				setPeer(CMemoryStream* peer);
+
+	// IStream overrides
+	virtual void		close() { }
+	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual void		write(const void* buffer, UInt32 n);
+	virtual void		flush() { }
+	virtual void		shutdownInput() { }
+	virtual void		shutdownOutput() { }
+	virtual void*		getEventTarget() const;
+	virtual bool		isReady() const;
+	virtual UInt32		getSize() const;
+
+public:
+	//! Everything written, one entry per write()
+	std::vector<CString>	m_writes;
+	UInt32				m_bytes;
+
+private:
+	IEventQueue*		m_events;
+	CString				m_input;
+	UInt32				m_offset;
+	CMemoryStream*		m_peer;
+};
+
+//! Client counting what it's told to do
+/*!
+Stands in for a client and its screen.  Every call that would fake
+input on the screen is counted instead.
+*/
+class CReplayClient : public CClient {
+public:
+	CReplayClient();
+
+	// IClient overrides
+	virtual void		getShape(SInt32& x, SInt32& y,
+							SInt32& width, SInt32& height) const;
+	virtual void		getCursorPos(SInt32& x, SInt32& y) const;
+	virtual void		enter(SInt32 xAbs, SInt32 yAbs,
+							UInt32 seqNum, KeyModifierMask mask,
+							bool forScreensaver) { }
+	virtual bool		leave() { return true; }
+	virtual void		setClipboard(ClipboardID, const IClipboard*);
+	virtual void		grabClipboard(ClipboardID) { }
+	virtual void		setClipboardDirty(ClipboardID, bool) { }
+	virtual void		keyDown(KeyID, KeyModifierMask, KeyButton);
+	virtual void		keyRepeat(KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+	virtual void		keyUp(KeyID, KeyModifierMask, KeyButton);
+	virtual void		mouseDown(ButtonID);
+	virtual void		mouseUp(ButtonID);
+	virtual void		mouseMove(SInt32 xAbs, SInt32 yAbs);
+	virtual void		mouseRelativeMove(SInt32 xRel, SInt32 yRel);
+	virtual void		mouseWheel(SInt32 xDelta, SInt32 yDelta);
+	virtual void		screensaver(bool activate) { }
+	virtual void		resetOptions() { }
+	virtual void		setOptions(const COptionsList& options) { }
+	virtual void		handshakeComplete() { }
+	virtual void		flushFakeInput() { }
+
+public:
+	UInt32				m_faked;
+	UInt32				m_keys;
+	UInt32				m_buttons;
+	UInt32				m_clipboards;
+
+	//! When each mouse move was faked, if m_timeMotion is set
+	std::vector<double>	m_motionTimes;
+	bool				m_timeMotion;
+};
+
+//! Server replay
+/*!
+A CServer with mock screens and one client, "stub", whose proxy writes
+to a CMemoryStream.  Replaying a trace hands its input to the server
+through its input channel, and its clipboards through the primary
+screen's clipboard events, in steps of a millisecond of the trace.
+Dragged files are sent to the proxy directly since the server only
+learns of them from the platform screen.  \p mouseSendInterval is the
+server's mouseSendInterval option, in milliseconds.
+*/
+class CServerReplay {
+public:
+	CServerReplay(IEventQueue* events, UInt32 mouseSendInterval = 0);
+	~CServerReplay();
+
+	//! Replay \p records as fast as possible
+	void				run(const CInputTrace::CRecordList& records);
+
+	//! Replay \p records as they happened
+	/*!
+	Hands each record to the server at its time in the trace, and lets
+	the server's timers run in between.  Returns a while after the last
+	one.
+	*/
+	void				runRealTime(const CInputTrace::CRecordList& records);
+
+	//! Pass what the client gets on to \p client
+	/*!
+	Call it after \p client has been run() with getSetup().
+	*/
+	void				connect(CClientReplay& client);
+
+	//! When each input was sent by runRealTime()
+	const std::vector<double>&	getInputTimes() const { return m_inputTimes; }
+
+	//! What the client got while setting up
+	void				getSetup(std::vector<CString>& writes) const;
+
+	//! What the client got from run()
+	void				getReplay(std::vector<CString>& writes) const;
+
+private:
+	void				runLoop();
+	void				startStepTimer(double timeout);
+	void				handleStep(const CEvent&, void*);
+	bool				getClipboard(ClipboardID, IClipboard*);
+
+private:
+	IEventQueue*		m_events;
+	CEvent::Type		m_stepEvent;
+	testing::NiceMock<CMockConfig>			m_config;
+	testing::NiceMock<CMockPrimaryClient>	m_primaryClient;
+	testing::NiceMock<CMockScreen>			m_screen;
+	CInputFilter		m_inputFilter;
+	CMemoryStream		m_stream;
+	CInputChannel*		m_channel;
+	CServer*			m_server;
+	CClientProxy*		m_proxy;
+	size_t				m_setup;
+	size_t				m_start;
+
+	const CInputTrace::CRecordList*	m_records;
+	size_t				m_next;
+	UInt32				m_clipboardSeqNum;
+	CString				m_clipboard;
+
+	// runRealTime() state
+	bool				m_realTime;
+	bool				m_finishing;
+	double				m_startTime;
+	CEventQueueTimer*	m_stepTimer;
+	std::vector<double>	m_inputTimes;
+};
+
+//! Client replay
+/*!
+A CServerProxy for a CReplayClient, reading from a CMemoryStream.
+Replaying hands it what the server wrote, one write at a time.
+*/
+class CClientReplay {
+public:
+	CClientReplay(IEventQueue* events);
+	~CClientReplay();
+
+	//! Hand \p writes to the server proxy as fast as possible
+	void				run(const std::vector<CString>& writes);
+
+	//! Get the stream the server proxy reads
+	CMemoryStream*		getStream() { return &m_stream; }
+
+private:
+	void				handleStep(const CEvent&, void*);
+
+public:
+	CReplayClient		m_client;
+
+private:
+	IEventQueue*		m_events;
+	CEvent::Type		m_stepEvent;
+	CMemoryStream		m_stream;
+	synergy::IStream*	m_packetStream;
+	CServerProxy*		m_proxy;
+
+	const std::vector<CString>*	m_writes;
+	size_t				m_next;
+};
@@ -0,0 +1,167 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/benchmarks/InputReplay.h"
+#include "base/EventQueue.h"
+#include "base/LatencyStats.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+// the trace from --trace, or the made up session
+static
+void
+getSession(CInputTrace::CRecordList& records)
+{
+	if (g_inputTraceFile.empty()) {
+		makeInputSession(records);
+	}
+	else {
+		ASSERT_TRUE(CInputTrace::load(g_inputTraceFile, records));
+	}
+	ASSERT_FALSE(records.empty());
+}
+
+static
+UInt32
+countInput(const CInputTrace::CRecordList& records,
+				CInputChannel::CInput::EType first,
+				CInputChannel::CInput::EType last)
+{
+	UInt32 n = 0;
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (records[i].m_type == CInputTrace::CRecord::kInput &&
+			records[i].m_input.m_type >= first &&
+			records[i].m_input.m_type <= last) {
+			++n;
+		}
+	}
+	return n;
+}
+
+static
+UInt32
+countRecords(const CInputTrace::CRecordList& records,
+				CInputTrace::CRecord::EType type)
+{
+	UInt32 n = 0;
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (records[i].m_type == type) {
+			++n;
+		}
+	}
+	return n;
+}
+
+static
+UInt32
+countBytes(const std::vector<CString>& writes)
+{
+	UInt32 n = 0;
+	for (size_t i = 0; i < writes.size(); ++i) {
+		n += static_cast<UInt32>(writes[i].size());
+	}
+	return n;
+}
+
+static
+void
+report(const char* stage, size_t records, double elapsed,
+				long allocations, UInt32 bytes)
+{
+	LOG((CLOG_INFO "%s: %u records in %.3f ms, %.0f records/s, %.2f allocations per record, %u bytes to the client",
+		stage, static_cast<UInt32>(records), 1.0e+3 * elapsed,
+		records / elapsed,
+		static_cast<double>(allocations) / records, bytes));
+	LOG((CLOG_INFO "%s latency:\n%s", stage, CLatencyStats::format().c_str()));
+}
+
+TEST(CInputTraceBenchmarks, serverPipeline)
+{
+	CInputTrace::CRecordList records;
+	getSession(records);
+	if (HasFatalFailure()) {
+		return;
+	}
+
+	CEventQueue events;
+	CServerReplay server(&events);
+
+	CLatencyStats::reset();
+	long allocations = g_allocations;
+	CStopwatch timer;
+	server.run(records);
+	double elapsed = timer.getTime();
+	allocations = g_allocations - allocations;
+
+	std::vector<CString> writes;
+	server.getReplay(writes);
+	report("server", records.size(), elapsed, allocations, countBytes(writes));
+
+	// keeps up with the person on the other end
+	EXPECT_LT(elapsed, records.back().m_time);
+	EXPECT_FALSE(writes.empty());
+}
+
+TEST(CInputTraceBenchmarks, clientPipeline)
+{
+	CInputTrace::CRecordList records;
+	getSession(records);
+	if (HasFatalFailure()) {
+		return;
+	}
+
+	// what the server sends for the trace, not measured
+	std::vector<CString> setup, writes;
+	{
+		CEventQueue events;
+		CServerReplay server(&events);
+		server.run(records);
+		server.getSetup(setup);
+		server.getReplay(writes);
+	}
+
+	CEventQueue events;
+	CClientReplay client(&events);
+	client.run(setup);
+	client.m_client.m_faked      = 0;
+	client.m_client.m_keys       = 0;
+	client.m_client.m_buttons    = 0;
+	client.m_client.m_clipboards = 0;
+
+	CLatencyStats::reset();
+	long allocations = g_allocations;
+	CStopwatch timer;
+	client.run(writes);
+	double elapsed = timer.getTime();
+	allocations = g_allocations - allocations;
+
+	report("client", records.size(), elapsed, allocations, countBytes(writes));
+
+	// the client was told everything that was typed, clicked and copied
+	EXPECT_EQ(countInput(records, CInputChannel::CInput::kKeyDown,
+							CInputChannel::CInput::kKeyRepeat),
+							client.m_client.m_keys);
+	EXPECT_EQ(countInput(records, CInputChannel::CInput::kButtonDown,
+							CInputChannel::CInput::kButtonUp),
+							client.m_client.m_buttons);
+	EXPECT_EQ(countRecords(records, CInputTrace::CRecord::kClipboard),
+							client.m_client.m_clipboards);
+	EXPECT_LT(0u, client.m_client.m_faked);
+	EXPECT_LT(elapsed, records.back().m_time);
+}
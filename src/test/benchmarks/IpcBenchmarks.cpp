@@ -0,0 +1,255 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ipc/IpcServer.h"
+#include "ipc/IpcClient.h"
+#include "ipc/IpcMessage.h"
+#include "ipc/Ipc.h"
+#include "net/SocketMultiplexer.h"
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/String.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+#include "base/TMethodJob.h"
+
+#include "test/global/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#define TEST_IPC_PORT 24802
+#define TEST_IPC_PATH "/tmp/synergy-ipc-benchmark"
+
+// log lines streamed, in chunks like CIpcLogOutputter's
+static const int		kLogLineChunks    = 2000;
+static const int		kLogLinesPerChunk = 100;
+
+// streams log lines from the server to the client the way the daemon
+// streams them to the gui
+class CLogLineRate {
+public:
+	CLogLineRate(IEventQueue* events, CIpcServer* server, CIpcClient* client) :
+		m_events(events),
+		m_server(server),
+		m_client(client),
+		m_producer(NULL),
+		m_time(0.0),
+		m_received(0),
+		m_inOrder(true),
+		m_logRing(false)
+	{
+		// the producer starts when the client says hello
+		m_events->adoptHandler(m_events->forCIpcServer().messageReceived(),
+							m_server,
+							new TMethodEventJob<CLogLineRate>(this,
+								&CLogLineRate::handleServerMessage));
+		m_events->adoptHandler(m_events->forCIpcClient().messageReceived(),
+							m_client,
+							new TMethodEventJob<CLogLineRate>(this,
+								&CLogLineRate::handleClientMessage));
+	}
+
+	~CLogLineRate()
+	{
+		m_events->removeHandler(m_events->forCIpcServer().messageReceived(),
+							m_server);
+		m_events->removeHandler(m_events->forCIpcClient().messageReceived(),
+							m_client);
+	}
+
+	// returns log lines per second or 0 if they didn't all arrive
+	double				run()
+	{
+		CEventQueueTimer* timeout = m_events->newOneShotTimer(60.0, NULL);
+		m_events->adoptHandler(CEvent::kTimer, timeout,
+							new TMethodEventJob<CLogLineRate>(this,
+								&CLogLineRate::handleTimeout));
+		m_client->connect();
+		m_events->loop();
+		m_events->removeHandler(CEvent::kTimer, timeout);
+		m_events->deleteTimer(timeout);
+
+		if (m_producer != NULL) {
+			m_producer->wait();
+			delete m_producer;
+			m_producer = NULL;
+		}
+		m_logRing = m_client->isLogRingOpen();
+		m_client->disconnect();
+
+		if (m_received < kLogLineChunks * kLogLinesPerChunk || m_time <= 0.0) {
+			return 0.0;
+		}
+		return m_received / m_time;
+	}
+
+	bool				isInOrder() const { return m_inOrder; }
+	bool				usedLogRing() const { return m_logRing; }
+
+private:
+	void				produce(void*)
+	{
+		std::vector<CString> chunks(kLogLineChunks);
+		CString padding(60, '.');
+		for (int i = 0; i < kLogLineChunks; ++i) {
+			for (int j = 0; j < kLogLinesPerChunk; ++j) {
+				chunks[i] += synergy::string::sprintf("%d %s\n",
+								i * kLogLinesPerChunk + j, padding.c_str());
+			}
+		}
+
+		// give a local client time to take up the log ring
+		ARCH->sleep(0.2);
+
+		m_timer.reset();
+		for (int i = 0; i < kLogLineChunks; ++i) {
+			CIpcLogLineMessage message(chunks[i]);
+			m_server->send(message, kIpcClientNode);
+		}
+	}
+
+	void				handleServerMessage(const CEvent& e, void*)
+	{
+		CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+		if (m->type() == kIpcHello && m_producer == NULL) {
+			m_producer = new CThread(new TMethodJob<CLogLineRate>(this,
+								&CLogLineRate::produce));
+		}
+	}
+
+	void				handleClientMessage(const CEvent& e, void*)
+	{
+		CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+		if (m->type() != kIpcLogLine) {
+			return;
+		}
+
+		CString chunk = static_cast<CIpcLogLineMessage*>(m)->logLine();
+		if (atoi(chunk.c_str()) != m_received) {
+			m_inOrder = false;
+		}
+		m_received += static_cast<int>(
+							std::count(chunk.begin(), chunk.end(), '\n'));
+		if (m_received >= kLogLineChunks * kLogLinesPerChunk) {
+			m_time = m_timer.getTime();
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+private:
+	IEventQueue*		m_events;
+	CIpcServer*			m_server;
+	CIpcClient*			m_client;
+	CThread*			m_producer;
+	CStopwatch			m_timer;
+	double				m_time;
+	int					m_received;
+	bool				m_inOrder;
+	bool				m_logRing;
+};
+
+TEST(CIpcBenchmarks, logLineRate_tcp)
+{
+	// per-message logging would swamp what we're measuring
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CIpcServer server(&events, &multiplexer, TEST_IPC_PORT);
+	server.listen();
+	CIpcClient client(&events, &multiplexer, TEST_IPC_PORT);
+
+	double rate;
+	bool inOrder;
+	{
+		CLogLineRate benchmark(&events, &server, &client);
+		rate    = benchmark.run();
+		inOrder = benchmark.isInOrder();
+	}
+
+	CLOG->setFilter(filter);
+	LOG((CLOG_INFO "log lines per second over tcp: %.0f", rate));
+	EXPECT_GT(rate, 0.0);
+	EXPECT_TRUE(inOrder);
+}
+
+#if SYSAPI_UNIX
+
+TEST(CIpcBenchmarks, logLineRate_localSocket)
+{
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CIpcServer server(&events, &multiplexer, TEST_IPC_PORT);
+	server.listenLocal(TEST_IPC_PATH);
+	CIpcClient client(&events, &multiplexer, TEST_IPC_PATH, false);
+
+	double rate;
+	bool inOrder;
+	{
+		CLogLineRate benchmark(&events, &server, &client);
+		rate    = benchmark.run();
+		inOrder = benchmark.isInOrder();
+	}
+
+	CLOG->setFilter(filter);
+	LOG((CLOG_INFO "log lines per second over a local socket: %.0f", rate));
+	EXPECT_GT(rate, 0.0);
+	EXPECT_TRUE(inOrder);
+}
+
+TEST(CIpcBenchmarks, logLineRate_logRing)
+{
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CIpcServer server(&events, &multiplexer, TEST_IPC_PORT);
+	server.listenLocal(TEST_IPC_PATH);
+	CIpcClient client(&events, &multiplexer, TEST_IPC_PATH);
+
+	double rate;
+	bool inOrder;
+	bool logRing;
+	{
+		CLogLineRate benchmark(&events, &server, &client);
+		rate    = benchmark.run();
+		inOrder = benchmark.isInOrder();
+		logRing = benchmark.usedLogRing();
+	}
+
+	CLOG->setFilter(filter);
+	LOG((CLOG_INFO "log lines per second through shared memory: %.0f", rate));
+	EXPECT_GT(rate, 0.0);
+	EXPECT_TRUE(inOrder);
+	EXPECT_TRUE(logRing);
+}
+
+#endif // SYSAPI_UNIX
@@ -0,0 +1,138 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/mock/server/MockServer.h"
+#include "test/mock/synergy/MockEventQueue.h"
+#include "server/ClientProxy1_6.h"
+#include "server/KeyBroadcast.h"
+#include "synergy/IKeyState.h"
+#include "io/IStream.h"
+#include "base/Log.h"
+#include "base/Stopwatch.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::NiceMock;
+using ::testing::ReturnRef;
+
+// keeps everything a proxy writes, without the cost of a mock
+class CCaptureStream : public synergy::IStream {
+public:
+	CCaptureStream() : m_writes(0) { }
+
+	virtual void		close() { }
+	virtual UInt32		read(void*, UInt32) { return 0; }
+	virtual void		write(const void* buffer, UInt32 n)
+	{
+		++m_writes;
+		m_data.append(static_cast<const char*>(buffer), n);
+	}
+	virtual void		flush() { }
+	virtual void		shutdownInput() { }
+	virtual void		shutdownOutput() { }
+	virtual void*		getEventTarget() const { return const_cast<CCaptureStream*>(this); }
+	virtual bool		isReady() const { return false; }
+	virtual UInt32		getSize() const { return 0; }
+
+	UInt32				m_writes;
+	CString				m_data;
+};
+
+// types 1000 keys to 16 clients the way the server broadcasts them.
+// either every client is looked up in the screen list and encodes the
+// key itself or the key goes out through a CKeyBroadcast.  returns the
+// time per key and what the last client got.
+static double
+broadcastTyping(bool shared, CString& wire)
+{
+	static const UInt32 kClients = 16;
+	static const UInt32 kKeys    = 1000;
+
+	NiceMock<CMockEventQueue> eventQueue;
+	NiceMock<CMockServer> server;
+	IStreamEvents streamEvents;
+	CClientProxyEvents clientProxyEvents;
+	streamEvents.setEvents(&eventQueue);
+	clientProxyEvents.setEvents(&eventQueue);
+	ON_CALL(eventQueue, forIStream()).WillByDefault(ReturnRef(streamEvents));
+	ON_CALL(eventQueue, forCClientProxy()).WillByDefault(ReturnRef(clientProxyEvents));
+
+	CString screens(":");
+	std::vector<CString> names;
+	std::vector<CCaptureStream*> streams;
+	std::vector<CClientProxy*> clients;
+	for (UInt32 i = 0; i < kClients; ++i) {
+		names.push_back(synergy::string::sprintf("screen%d", i));
+		screens += names.back() + ":";
+		streams.push_back(new CCaptureStream);
+		clients.push_back(new CClientProxy1_6(names.back(),
+							streams.back(), &server, &eventQueue));
+		streams.back()->m_data.clear();
+	}
+
+	// don't measure the debug log
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	CStopwatch timer;
+	for (UInt32 n = 0; n < kKeys; ++n) {
+		KeyID id = 'a' + n % 26;
+		for (int press = 1; press >= 0; --press) {
+			if (shared) {
+				CKeyBroadcast key(press != 0, id, 0, 38);
+				for (UInt32 i = 0; i < kClients; ++i) {
+					clients[i]->sendKey(key);
+				}
+			}
+			else {
+				for (UInt32 i = 0; i < kClients; ++i) {
+					if (IKeyState::CKeyInfo::contains(screens.c_str(), names[i])) {
+						if (press) {
+							clients[i]->keyDown(id, 0, 38);
+						}
+						else {
+							clients[i]->keyUp(id, 0, 38);
+						}
+					}
+				}
+			}
+		}
+	}
+	double elapsed = timer.getTime();
+
+	CLOG->setFilter(filter);
+	wire = streams.back()->m_data;
+	for (UInt32 i = 0; i < kClients; ++i) {
+		delete clients[i];
+	}
+	return elapsed / (2 * kKeys);
+}
+
+TEST(CKeyBroadcastBenchmarks, sendKey_broadcastTo16Clients)
+{
+	CString regularWire, sharedWire;
+	double regular = broadcastTyping(false, regularWire);
+	double shared  = broadcastTyping(true, sharedWire);
+
+	LOG((CLOG_INFO "key broadcast to 16 clients: %.3f us per key encoding per client, %.3f us encoding once",
+		1.0e+6 * regular, 1.0e+6 * shared));
+
+	// the clients can't tell the difference, but it's quicker
+	EXPECT_TRUE(regularWire == sharedWire);
+	EXPECT_LT(shared, regular);
+}
@@ -0,0 +1,119 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/KeyMap.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+#include <vector>
+
+static const KeyButton	kShiftButton		= 50;
+static const KeyButton	kSpaceButton		= 65;
+static const KeyButton	kFirstLetterButton	= 10;
+static const KeyID		kCyrillicSmallA		= 0x0430;
+static const KeyID		kCyrillicCapitalA	= 0x0410;
+
+static void
+addKey(CKeyMap& keyMap, KeyID id, SInt32 group, KeyButton button,
+				KeyModifierMask required, KeyModifierMask sensitive,
+				KeyModifierMask generates = 0)
+{
+	CKeyMap::KeyItem item;
+	item.m_id        = id;
+	item.m_group     = group;
+	item.m_button    = button;
+	item.m_required  = required;
+	item.m_sensitive = sensitive;
+	item.m_generates = generates;
+	item.m_dead      = false;
+	item.m_lock      = false;
+	item.m_client    = 0;
+	keyMap.addKeyEntry(item);
+}
+
+// a latin layout in group 0 and a cyrillic one in group 1, sharing
+// the shift and space keys
+static void
+buildTwoGroupKeyMap(CKeyMap& keyMap)
+{
+	for (SInt32 group = 0; group < 2; ++group) {
+		addKey(keyMap, kKeyShift_L, group, kShiftButton, 0, 0,
+							KeyModifierShift);
+		addKey(keyMap, ' ', group, kSpaceButton, 0, 0);
+	}
+	for (KeyID i = 0; i < 26; ++i) {
+		KeyButton button = static_cast<KeyButton>(kFirstLetterButton + i);
+		addKey(keyMap, 'a' + i, 0, button, 0, KeyModifierShift);
+		addKey(keyMap, 'A' + i, 0, button, KeyModifierShift, KeyModifierShift);
+	}
+	for (KeyID i = 0; i < 32; ++i) {
+		KeyButton button = static_cast<KeyButton>(kFirstLetterButton + i);
+		addKey(keyMap, kCyrillicSmallA + i, 1, button, 0, KeyModifierShift);
+		addKey(keyMap, kCyrillicCapitalA + i, 1, button,
+							KeyModifierShift, KeyModifierShift);
+	}
+	keyMap.finish();
+}
+
+TEST(CKeyMapBenchmarks, mapKey_mixedLayoutText)
+{
+	CKeyMap keyMap;
+	buildTwoGroupKeyMap(keyMap);
+
+	// 10k characters of words alternating between the layouts, each
+	// typed with the group of its own layout active and some of them
+	// capitalized
+	std::vector<std::pair<KeyID, SInt32> > text;
+	UInt32 seed = 1;
+	while (text.size() < 10000) {
+		seed = seed * 1103515245 + 12345;
+		bool cyrillic = ((seed >> 16) & 1) != 0;
+		bool capital  = ((seed >> 17) & 7) == 0;
+		size_t length = 2 + ((seed >> 20) & 7);
+		for (size_t i = 0; i < length; ++i) {
+			seed = seed * 1103515245 + 12345;
+			KeyID id = cyrillic ? kCyrillicSmallA + ((seed >> 16) % 32) :
+									'a' + ((seed >> 16) % 26);
+			if (capital && i == 0) {
+				id -= cyrillic ? (kCyrillicSmallA - kCyrillicCapitalA) :
+									('a' - 'A');
+			}
+			text.push_back(std::make_pair(id, cyrillic ? 1 : 0));
+		}
+		text.push_back(std::make_pair(static_cast<KeyID>(' '), 0));
+	}
+
+	CKeyMap::Keystrokes keys;
+	CKeyMap::ModifierToKeys activeModifiers;
+	KeyModifierMask currentState = 0;
+	size_t unmapped = 0;
+	CStopwatch timer;
+	for (size_t i = 0; i < text.size(); ++i) {
+		keys.clear();
+		if (keyMap.mapKey(keys, text[i].first, text[i].second,
+							activeModifiers, currentState, 0, false) == NULL) {
+			++unmapped;
+		}
+	}
+	double elapsed = timer.getTime();
+
+	LOG((CLOG_INFO "mapKey: %.3f us per character",
+							1.0e+6 * elapsed / text.size()));
+	EXPECT_EQ(0, unmapped);
+}
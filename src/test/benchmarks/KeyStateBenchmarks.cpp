@@ -0,0 +1,77 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ * Copyright (C) 2011 Nick Bolton
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/unittests/synergy/KeyStateTests.h"
+
+#include "test/mock/synergy/MockEventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+#include "test/global/gmock.h"
+
+using ::testing::Return;
+
+TEST(CKeyStateBenchmarks, updateKeyState_largeKeyMap)
+{
+	// a large keyboard map:  thousands of ordinary keys and a couple
+	// of keys for each modifier in each of four groups.
+	static const KeyID s_modifiers[] = {
+		kKeyShift_L, kKeyShift_R, kKeyControl_L, kKeyControl_R,
+		kKeyAlt_L, kKeyAlt_R, kKeySuper_L, kKeyCapsLock, kKeyNumLock
+	};
+	CKeyMap keyMap;
+	CKeyMap::KeyItem item;
+	item.m_required  = 0;
+	item.m_sensitive = KeyModifierShift;
+	item.m_dead      = false;
+	item.m_client    = 0;
+	for (SInt32 g = 0; g < 4; ++g) {
+		item.m_group = g;
+		for (KeyID id = 0x20; id < 0x1020; ++id) {
+			item.m_id     = id;
+			item.m_button = static_cast<KeyButton>(1 + id % 0x1f0);
+			CKeyMap::initModifierKey(item);
+			keyMap.addKeyEntry(item);
+		}
+		for (size_t i = 0; i < sizeof(s_modifiers) /
+								sizeof(s_modifiers[0]); ++i) {
+			item.m_id     = s_modifiers[i];
+			item.m_button = static_cast<KeyButton>(0x1f1 + i);
+			CKeyMap::initModifierKey(item);
+			keyMap.addKeyEntry(item);
+		}
+	}
+	keyMap.finish();
+
+	CMockEventQueue eventQueue;
+	CKeyStateImpl keyState(eventQueue, &keyMap);
+	const KeyModifierMask mask = KeyModifierShift | KeyModifierControl;
+	ON_CALL(keyState, pollActiveModifiers()).WillByDefault(Return(mask));
+
+	// leavePrimary() does this on every switch to a secondary screen
+	const int n = 1000;
+	CStopwatch timer;
+	for (int i = 0; i < n; ++i) {
+		keyState.updateKeyState();
+	}
+	double elapsed = timer.getTime();
+
+	LOG((CLOG_INFO "updateKeyState: %.3f us per call", 1.0e+6 * elapsed / n));
+	ASSERT_EQ(mask, keyState.getActiveModifiers());
+}
@@ -0,0 +1,49 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LatencyStats.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+TEST(CLatencyStatsBenchmarks, record_cost)
+{
+	static const int kRecords = 1000000;
+
+	CLatencyHistogram histogram;
+	CStopwatch timer;
+	for (int i = 0; i < kRecords; ++i) {
+		histogram.record(1.0e-9 * (i & 0xfffff));
+	}
+	double recordTime = timer.getTime();
+
+	timer.reset();
+	for (int i = 0; i < kRecords; ++i) {
+		CLatencyTimer stage(CLatencyStats::kRouting);
+	}
+	double timerTime = timer.getTime();
+	CLatencyStats::reset();
+
+	LOG((CLOG_INFO "latency stats: %.0f ns per record, %.0f ns per stage timer",
+							1.0e+9 * recordTime / kRecords,
+							1.0e+9 * timerTime / kRecords));
+
+	// cheap enough to leave on for every input
+	EXPECT_EQ(static_cast<UInt32>(kRecords), histogram.getCount());
+	EXPECT_LT(timerTime / kRecords, 1.0e-6);
+}
@@ -0,0 +1,95 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/benchmarks/InputReplay.h"
+#include "mt/Atomic.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#if SYSAPI_WIN32
+#include "arch/win32/ArchMiscWindows.h"
+#endif
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+CString					g_inputTraceFile;
+volatile long			g_allocations = 0;
+
+// count every allocation the benchmarks cause
+void*
+operator new(size_t size) throw(std::bad_alloc)
+{
+	atomicAdd(&g_allocations, 1);
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void*
+operator new[](size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+void
+operator delete(void* p) throw()
+{
+	free(p);
+}
+
+void
+operator delete[](void* p) throw()
+{
+	free(p);
+}
+
+int
+main(int argc, char **argv)
+{
+#if SYSAPI_WIN32
+	// HACK: shouldn't be needed, but logging fails without this.
+	CArchMiscWindows::setInstanceWin32(GetModuleHandle(NULL));
+#endif
+
+	CArch arch;
+	arch.init();
+
+	// anything chattier than this and the benchmarks measure the log
+	CLog log;
+	log.setFilter(kINFO);
+
+	testing::InitGoogleTest(&argc, argv);
+
+	// replay a recorded trace instead of the made up one
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			g_inputTraceFile = argv[++i];
+		}
+		else {
+			LOG((CLOG_PRINT "usage: %s [gtest options] [--trace <pathname>]", argv[0]));
+			return 1;
+		}
+	}
+
+	return (RUN_ALL_TESTS() == 1) ? 1 : 0;
+}
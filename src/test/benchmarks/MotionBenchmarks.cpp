@@ -0,0 +1,173 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/benchmarks/InputReplay.h"
+#include "base/EventQueue.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+#include <algorithm>
+
+// the mouse moves for a while, a thousand reports a second, then rests
+static const UInt32		kBursts        = 8;
+static const UInt32		kBurstReports  = 150;
+static const double		kRestTime      = 0.100;
+static const double		kReportTime    = 0.001;
+
+static
+void
+makeMotion(CInputTrace::CRecordList& records)
+{
+	double t = 0.0;
+	for (UInt32 burst = 0; burst < kBursts; ++burst) {
+		// back and forth so the pointer stays well away from the edges
+		SInt32 dx = ((burst & 1) == 0) ? 1 : -1;
+		for (UInt32 i = 0; i < kBurstReports; ++i) {
+			CInputTrace::CRecord record;
+			record.m_type              = CInputTrace::CRecord::kInput;
+			record.m_time              = t;
+			record.m_id                = 0;
+			record.m_count             = 0;
+			record.m_input.m_type      = CInputChannel::CInput::kMotionOnSecondary;
+			record.m_input.m_x         = dx;
+			record.m_input.m_y         = 0;
+			record.m_input.m_button    = kButtonNone;
+			record.m_input.m_key       = kKeyNone;
+			record.m_input.m_mask      = 0;
+			record.m_input.m_keyButton = 0;
+			record.m_input.m_count     = 0;
+			record.m_input.m_time      = 0.0;
+			records.push_back(record);
+			t += kReportTime;
+		}
+		t += kRestTime;
+	}
+}
+
+class CMotionResult {
+public:
+	double				m_duration;
+	UInt32				m_packets;
+	UInt32				m_moves;
+	UInt32				m_unseen;
+	std::vector<double>	m_latency;
+	double				m_afterRest;
+};
+
+// replay the motion in real time from the server to the client and see
+// when the client moves the mouse for each report
+static
+void
+runMotion(UInt32 mouseSendInterval, CMotionResult& result)
+{
+	CInputTrace::CRecordList records;
+	makeMotion(records);
+
+	CEventQueue events;
+	CClientReplay client(&events);
+	CServerReplay server(&events, mouseSendInterval);
+	std::vector<CString> setup;
+	server.getSetup(setup);
+	client.run(setup);
+	server.connect(client);
+	client.m_client.m_timeMotion = true;
+
+	server.runRealTime(records);
+
+	const std::vector<double>& sent  = server.getInputTimes();
+	const std::vector<double>& moved = client.m_client.m_motionTimes;
+	std::vector<CString> writes;
+	server.getReplay(writes);
+
+	result.m_duration  = records.back().m_time + kReportTime;
+	result.m_packets   = static_cast<UInt32>(writes.size());
+	result.m_moves     = static_cast<UInt32>(moved.size());
+	result.m_unseen    = 0;
+	result.m_afterRest = 0.0;
+	result.m_latency.clear();
+
+	// a report has arrived with the first move the client makes after
+	// it was sent.  the loop hands moves to the client before it takes
+	// the next report so an earlier move can't be mistaken for it.
+	std::vector<double>::const_iterator move = moved.begin();
+	for (size_t i = 0; i < sent.size(); ++i) {
+		move = std::lower_bound(move, moved.end(), sent[i]);
+		if (move == moved.end()) {
+			++result.m_unseen;
+			continue;
+		}
+		double latency = *move - sent[i];
+		result.m_latency.push_back(latency);
+		if (i % kBurstReports == 0 && latency > result.m_afterRest) {
+			result.m_afterRest = latency;
+		}
+	}
+	std::sort(result.m_latency.begin(), result.m_latency.end());
+}
+
+static
+double
+percentile(const std::vector<double>& sorted, double p)
+{
+	if (sorted.empty()) {
+		return 0.0;
+	}
+	size_t i = static_cast<size_t>(p * (sorted.size() - 1));
+	return sorted[i];
+}
+
+static
+void
+report(UInt32 mouseSendInterval, const CMotionResult& result)
+{
+	LOG((CLOG_INFO "mouseSendInterval %u ms: %.0f packets/s, %.0f moves/s, latency median %.3f ms, 99%% %.3f ms, max %.3f ms, after a rest %.3f ms",
+		mouseSendInterval,
+		result.m_packets / result.m_duration,
+		result.m_moves / result.m_duration,
+		1.0e+3 * percentile(result.m_latency, 0.5),
+		1.0e+3 * percentile(result.m_latency, 0.99),
+		1.0e+3 * percentile(result.m_latency, 1.0),
+		1.0e+3 * result.m_afterRest));
+}
+
+TEST(CMotionBenchmarks, mouseSendInterval_packetsAndLatency)
+{
+	static const UInt32 kInterval = 10;
+
+	CMotionResult eachPass;
+	runMotion(0, eachPass);
+	report(0, eachPass);
+
+	CMotionResult limited;
+	runMotion(kInterval, limited);
+	report(kInterval, limited);
+
+	// the client hears about every report
+	EXPECT_EQ(0u, eachPass.m_unseen);
+	EXPECT_EQ(0u, limited.m_unseen);
+
+	// one move when the mouse starts moving, one per interval while it
+	// moves, and one for what's left when it stops
+	double burstTime = kBurstReports * kReportTime;
+	EXPECT_LE(limited.m_moves,
+		static_cast<UInt32>(kBursts * (burstTime / (1.0e-3 * kInterval) + 2)));
+	EXPECT_LT(limited.m_moves, eachPass.m_moves);
+
+	// the first move after a rest doesn't wait for the interval
+	EXPECT_LT(limited.m_afterRest, 1.0e-3 * kInterval);
+}
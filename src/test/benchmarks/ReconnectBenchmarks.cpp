@@ -0,0 +1,201 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/synergy/MockScreen.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "server/Server.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "synergy/ClientApp.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "io/CryptoOptions.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+
+static const int		kPort = 24803;
+
+static void
+getScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+	x = 0;
+	y = 0;
+	w = 1;
+	h = 1;
+}
+
+static void
+getCursorPos(SInt32& x, SInt32& y)
+{
+	x = 0;
+	y = 0;
+}
+
+// drops the client's connection once it's up and times how long the
+// client app takes to get it usable again
+class CReconnect {
+public:
+	CReconnect(IEventQueue* events, CClientListener* listener,
+							CClient* client) :
+		m_events(events),
+		m_listener(listener),
+		m_client(client),
+		m_connections(0),
+		m_elapsed(-1.0)
+	{
+		m_events->adoptHandler(m_events->forCClientListener().connected(),
+							m_listener,
+							new TMethodEventJob<CReconnect>(this,
+								&CReconnect::handleClientConnected));
+	}
+
+	~CReconnect()
+	{
+		m_events->removeHandler(m_events->forCClientListener().connected(),
+							m_listener);
+	}
+
+	// connect, drop and wait until usable again.  returns the time that
+	// took or a negative number if it never happened.
+	double				run()
+	{
+		CEventQueueTimer* timer = m_events->newOneShotTimer(10.0, NULL);
+		m_events->adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CReconnect>(this,
+								&CReconnect::handleTimeout));
+		m_client->connect();
+		m_events->loop();
+		m_events->removeHandler(CEvent::kTimer, timer);
+		m_events->deleteTimer(timer);
+		return m_elapsed;
+	}
+
+	// the client screen is enabled each time the handshake completes
+	void				enable()
+	{
+		if (++m_connections == 1) {
+			// let the session token arrive before dropping the link
+			CEventQueueTimer* timer = m_events->newOneShotTimer(0.1, NULL);
+			m_events->adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CReconnect>(this,
+								&CReconnect::handleDropTimer, timer));
+		}
+		else {
+			m_elapsed = m_timer.getTime();
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+private:
+	void				handleClientConnected(const CEvent&, void*)
+	{
+		CClientProxy* client = m_listener->getNextClient();
+		if (client != NULL) {
+			m_listener->getServer()->adoptClient(client);
+		}
+	}
+
+	void				handleDropTimer(const CEvent&, void* vtimer)
+	{
+		CEventQueueTimer* timer = reinterpret_cast<CEventQueueTimer*>(vtimer);
+		m_events->removeHandler(CEvent::kTimer, timer);
+		m_events->deleteTimer(timer);
+
+		// the client app sees the disconnect and restarts the client
+		m_timer.reset();
+		m_client->disconnect(NULL);
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+private:
+	IEventQueue*		m_events;
+	CClientListener*	m_listener;
+	CClient*			m_client;
+	int					m_connections;
+	CStopwatch			m_timer;
+	double				m_elapsed;
+};
+
+TEST(CReconnectBenchmarks, clientApp_afterDrop)
+{
+	CEventQueue events;
+	CNetworkAddress address("127.0.0.1", kPort);
+	CCryptoOptions cryptoOptions;
+	address.resolve();
+
+	// server
+	CSocketMultiplexer serverMultiplexer;
+	CClientListener listener(address,
+							new CTCPSocketFactory(&events, &serverMultiplexer),
+							NULL, cryptoOptions, &events);
+	NiceMock<CMockScreen> serverScreen;
+	NiceMock<CMockPrimaryClient> primaryClient;
+	NiceMock<CMockConfig> serverConfig;
+	NiceMock<CMockInputFilter> serverInputFilter;
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	CServer server(serverConfig, &primaryClient, &serverScreen, &events, true);
+	server.m_mock = true;
+	listener.setServer(&server);
+
+	// client, restarted by the app
+	NiceMock<CMockScreen> clientScreen;
+	ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getScreenShape));
+	ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getCursorPos));
+	CSocketMultiplexer clientMultiplexer;
+	CClientApp clientApp(&events, NULL);
+	clientApp.setSocketMultiplexer(&clientMultiplexer);
+	CClient* client = clientApp.openClient("stub", address, &clientScreen, cryptoOptions);
+	clientApp.setClient(client, &clientScreen);
+
+	double elapsed;
+	{
+		CReconnect reconnect(&events, &listener, client);
+		ON_CALL(clientScreen, enable()).WillByDefault(
+							Invoke(&reconnect, &CReconnect::enable));
+		elapsed = reconnect.run();
+	}
+
+	clientApp.closeClient(client);
+	clientApp.setClient(NULL, NULL);
+
+	ASSERT_GE(elapsed, 0.0);
+	LOG((CLOG_INFO "usable again %.3f ms after the connection dropped",
+							1000.0 * elapsed));
+
+	// the client used to wait a full second before reconnecting
+	EXPECT_LT(elapsed, 1.0);
+}
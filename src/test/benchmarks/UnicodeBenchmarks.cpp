@@ -0,0 +1,73 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/Unicode.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+// latin, cyrillic, CJK and a character outside the BMP
+static const char* s_mixed =
+	"plain ascii text, "
+	"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+	"\xe4\xbd\xa0\xe5\xa5\xbd "
+	"\xf0\x9f\x98\x80\n";
+
+static CString
+makeText(size_t size)
+{
+	CString text;
+	text.reserve(size + 64);
+	while (text.size() < size) {
+		text += s_mixed;
+	}
+	return text;
+}
+
+static void
+benchmarkTranscoding(size_t size)
+{
+	CString utf8 = makeText(size);
+
+	CStopwatch timer;
+	CString utf16 = CUnicode::UTF8ToUTF16(utf8);
+	double toUTF16 = timer.getTime();
+	CString back = CUnicode::UTF16ToUTF8(utf16);
+	double toUTF8 = timer.getTime() - toUTF16;
+
+	LOG((CLOG_INFO "%u MB: UTF-8 to UTF-16 %.3f ms, UTF-16 to UTF-8 %.3f ms",
+							static_cast<unsigned int>(size >> 20),
+							1000.0 * toUTF16, 1000.0 * toUTF8));
+	EXPECT_EQ(utf8, back);
+}
+
+TEST(CUnicodeBenchmarks, transcode_1MB)
+{
+	benchmarkTranscoding(1 << 20);
+}
+
+TEST(CUnicodeBenchmarks, transcode_10MB)
+{
+	benchmarkTranscoding(10 << 20);
+}
+
+// needs a few hundred MB;  run with --gtest_also_run_disabled_tests
+TEST(CUnicodeBenchmarks, DISABLED_transcode_100MB)
+{
+	benchmarkTranscoding(100 << 20);
+}
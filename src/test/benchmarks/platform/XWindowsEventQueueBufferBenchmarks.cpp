@@ -0,0 +1,114 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// these need an X server and do nothing without one;  run under Xvfb on
+// headless machines, e.g. `Xvfb :99 & DISPLAY=:99 benchmarks`
+
+#include "test/mock/synergy/MockEventQueue.h"
+#include "platform/XWindowsEventQueueBuffer.h"
+#include "base/EventTypes.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+#include <ctime>
+
+class CXWindowsEventQueueBufferBenchmarks : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_display = XOpenDisplay(NULL);
+		if (m_display != NULL) {
+			m_window = XCreateSimpleWindow(m_display,
+							DefaultRootWindow(m_display),
+							0, 0, 1, 1, 0, 0, 0);
+		}
+		else {
+			LOG((CLOG_INFO "no X display, skipping"));
+		}
+	}
+
+	virtual void TearDown()
+	{
+		if (m_display != NULL) {
+			XDestroyWindow(m_display, m_window);
+			XCloseDisplay(m_display);
+		}
+	}
+
+	Display*			m_display;
+	Window				m_window;
+	CMockEventQueue		m_eventQueue;
+};
+
+TEST_F(CXWindowsEventQueueBufferBenchmarks, waitForEvent_idle)
+{
+	if (m_display == NULL) {
+		return;
+	}
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	// wait like CEventQueue does, until a 1 second timer would expire
+	const double duration = 1.0;
+	clock_t cpuStart = clock();
+	CStopwatch timer;
+	while (buffer.isEmpty() && timer.getTime() < duration) {
+		buffer.waitForEvent(duration - timer.getTime());
+	}
+	double cpu = static_cast<double>(clock() - cpuStart) / CLOCKS_PER_SEC;
+
+	LOG((CLOG_INFO "idle wait: %.3f ms cpu per second", 1000.0 * cpu));
+
+	// the buffer must sleep rather than poll
+	EXPECT_LT(cpu, 0.05);
+}
+
+TEST_F(CXWindowsEventQueueBufferBenchmarks, waitForEvent_timeout)
+{
+	if (m_display == NULL) {
+		return;
+	}
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	CStopwatch timer;
+	buffer.waitForEvent(0.0105);
+	double elapsed = timer.getTime();
+
+	LOG((CLOG_INFO "10.5 ms timeout: woke after %.3f ms", 1000.0 * elapsed));
+	EXPECT_LT(elapsed, 0.5);
+}
+
+TEST_F(CXWindowsEventQueueBufferBenchmarks, addEvent_wakeup)
+{
+	if (m_display == NULL) {
+		return;
+	}
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	buffer.addEvent(42);
+
+	CStopwatch timer;
+	buffer.waitForEvent(5.0);
+	double elapsed = timer.getTime();
+
+	LOG((CLOG_INFO "user event: woke after %.3f ms", 1000.0 * elapsed));
+	EXPECT_FALSE(buffer.isEmpty());
+	EXPECT_LT(elapsed, 1.0);
+}
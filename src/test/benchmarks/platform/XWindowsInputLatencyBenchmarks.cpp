@@ -0,0 +1,238 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// this needs an X server and does nothing without one;  run under Xvfb
+// on headless machines, e.g. `Xvfb :99 & DISPLAY=:99 benchmarks`
+
+#define TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "test/mock/synergy/MockScreen.h"
+#include "platform/XWindowsScreen.h"
+#include "server/Server.h"
+#include "server/PrimaryClient.h"
+#include "server/ClientListener.h"
+#include "server/ClientProxy.h"
+#include "client/Client.h"
+#include "synergy/Screen.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/TCPSocketFactory.h"
+#include "io/CryptoOptions.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+#include <X11/extensions/XTest.h>
+#include <algorithm>
+#include <vector>
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+
+static const int		kPort  = 24803;
+static const int		kMoves = 200;
+
+static void
+getScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+	// big enough that the primary's cursor position is on it
+	x = 0;
+	y = 0;
+	w = 8192;
+	h = 8192;
+}
+
+static void
+getCursorPos(SInt32& x, SInt32& y)
+{
+	x = 0;
+	y = 0;
+}
+
+// a client that stops the event loop when a mouse move arrives
+class CLatencyClient : public CClient {
+public:
+	CLatencyClient(IEventQueue* events, const CNetworkAddress& address,
+							CSocketMultiplexer* multiplexer, CScreen* screen,
+							const CCryptoOptions& crypto) :
+		CClient(events, "stub", address,
+							new CTCPSocketFactory(events, multiplexer),
+							NULL, screen, crypto, false),
+		m_events(events),
+		m_moves(0) { }
+
+	virtual void		mouseMove(SInt32, SInt32)
+	{
+		++m_moves;
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+	int					getMoves() const { return m_moves; }
+
+private:
+	IEventQueue*		m_events;
+	int					m_moves;
+};
+
+// connects the client and stops the event loop once it's usable
+class CLatencySetup {
+public:
+	CLatencySetup(IEventQueue* events, CClientListener* listener,
+							CClient* client) :
+		m_events(events),
+		m_listener(listener),
+		m_client(client),
+		m_proxy(NULL),
+		m_connected(false)
+	{
+		m_events->adoptHandler(m_events->forCClientListener().connected(),
+							m_listener,
+							new TMethodEventJob<CLatencySetup>(this,
+								&CLatencySetup::handleClientConnected));
+		m_events->adoptHandler(m_events->forCClient().connected(),
+							m_client->getEventTarget(),
+							new TMethodEventJob<CLatencySetup>(this,
+								&CLatencySetup::handleConnected));
+	}
+
+	~CLatencySetup()
+	{
+		m_events->removeHandler(m_events->forCClientListener().connected(),
+							m_listener);
+		m_events->removeHandler(m_events->forCClient().connected(),
+							m_client->getEventTarget());
+	}
+
+	void				handleClientConnected(const CEvent&, void*)
+	{
+		m_proxy = m_listener->getNextClient();
+		if (m_proxy != NULL) {
+			m_listener->getServer()->adoptClient(m_proxy);
+		}
+	}
+
+	void				handleConnected(const CEvent&, void*)
+	{
+		m_connected = true;
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+public:
+	IEventQueue*		m_events;
+	CClientListener*	m_listener;
+	CClient*			m_client;
+	CClientProxy*		m_proxy;
+	bool				m_connected;
+};
+
+TEST(CXWindowsInputLatencyBenchmarks, xtestMotion_toClient)
+{
+	// moves the mouse like a user would, through its own connection
+	Display* injector = XOpenDisplay(NULL);
+	if (injector == NULL) {
+		LOG((CLOG_INFO "no X display, skipping"));
+		return;
+	}
+
+	CEventQueue events;
+	CNetworkAddress address("127.0.0.1", kPort);
+	CCryptoOptions cryptoOptions;
+	address.resolve();
+
+	// server on the X display
+	CSocketMultiplexer serverMultiplexer;
+	CClientListener listener(address,
+							new CTCPSocketFactory(&events, &serverMultiplexer),
+							NULL, cryptoOptions, &events);
+	CScreen screen(new CXWindowsScreen(NULL, true, false, 0, &events),
+							&events);
+	CPrimaryClient primaryClient("primary", &screen);
+	NiceMock<CMockConfig> serverConfig;
+	NiceMock<CMockInputFilter> serverInputFilter;
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	CServer server(serverConfig, &primaryClient, &screen, &events, false);
+	listener.setServer(&server);
+
+	// client
+	NiceMock<CMockScreen> clientScreen;
+	ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getScreenShape));
+	ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getCursorPos));
+	CSocketMultiplexer clientMultiplexer;
+	CLatencyClient client(&events, address, &clientMultiplexer,
+							&clientScreen, cryptoOptions);
+
+	CLatencySetup setup(&events, &listener, &client);
+	CEventQueueTimer* timeout = events.newOneShotTimer(10.0, NULL);
+	events.adoptHandler(CEvent::kTimer, timeout,
+							new TMethodEventJob<CLatencySetup>(&setup,
+								&CLatencySetup::handleTimeout));
+	client.connect();
+	events.loop();
+	ASSERT_TRUE(setup.m_connected);
+	ASSERT_TRUE(setup.m_proxy != NULL);
+
+	// the mouse is now on the client's screen
+	server.setActive(setup.m_proxy);
+	ASSERT_TRUE(primaryClient.leave());
+
+	// one move at a time, from XTest to the client reading it off
+	// its socket
+	std::vector<double> latencies;
+	CStopwatch timer;
+	for (int i = 0; i < kMoves; ++i) {
+		int moves = client.getMoves();
+		events.removeHandler(CEvent::kTimer, timeout);
+		events.deleteTimer(timeout);
+		timeout = events.newOneShotTimer(1.0, NULL);
+		events.adoptHandler(CEvent::kTimer, timeout,
+							new TMethodEventJob<CLatencySetup>(&setup,
+								&CLatencySetup::handleTimeout));
+
+		timer.reset();
+		XTestFakeRelativeMotionEvent(injector, (i & 1) ? -1 : 1, 0,
+							CurrentTime);
+		XFlush(injector);
+		events.loop();
+		if (client.getMoves() != moves) {
+			latencies.push_back(timer.getTime());
+		}
+	}
+	events.removeHandler(CEvent::kTimer, timeout);
+	events.deleteTimer(timeout);
+
+	server.setActive(&primaryClient);
+	XCloseDisplay(injector);
+
+	ASSERT_FALSE(latencies.empty());
+	std::sort(latencies.begin(), latencies.end());
+	LOG((CLOG_INFO "XTest motion to client: %d of %d moves arrived, median %.1f us, worst %.1f us",
+							static_cast<int>(latencies.size()), kMoves,
+							1.0e+6 * latencies[latencies.size() / 2],
+							1.0e+6 * latencies.back()));
+}
@@ -29,17 +29,27 @@
 #include "ipc/IpcClientProxy.h"
 #include "ipc/Ipc.h"
 #include "net/SocketMultiplexer.h"
+#include "net/XSocket.h"
 #include "mt/Thread.h"
 #include "arch/Arch.h"
 #include "base/TMethodJob.h"
 #include "base/String.h"
 #include "base/Log.h"
 #include "base/EventQueue.h"
+#include "base/Stopwatch.h"
 #include "base/TMethodEventJob.h"
 
 #include "test/global/gtest.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 #define TEST_IPC_PORT 24802
+#define TEST_IPC_PATH "/tmp/synergy-ipc-test"
+
+// log lines streamed by the benchmark, in chunks like CIpcLogOutputter's
+static const int		kLogLineChunks = 2000;
+static const int		kLogLinesPerChunk = 100;
 
 class CIpcTests : public ::testing::Test
 {
@@ -51,6 +61,13 @@ public:
 	void				sendMessageToServer_serverHandleMessageReceived(const CEvent&, void*);
 	void				sendMessageToClient_serverHandleClientConnected(const CEvent&, void*);
 	void				sendMessageToClient_clientHandleMessageReceived(const CEvent&, void*);
+	double				logLineRate_measure(CIpcServer& server, CIpcClient& client);
+	void				logLineRate_produce(void*);
+	void				logLineRate_serverHandleMessageReceived(const CEvent&, void*);
+	void				logLineRate_clientHandleMessageReceived(const CEvent&, void*);
+	void				statsRequest_clientHandleConnected(const CEvent&, void*);
+	void				statsRequest_serverHandleMessageReceived(const CEvent&, void*);
+	void				statsRequest_clientHandleMessageReceived(const CEvent&, void*);
 
 public:
 	CSocketMultiplexer	m_multiplexer;
@@ -61,6 +78,16 @@ public:
 	CString				m_sendMessageToClient_receivedString;
 	CIpcClient*			m_sendMessageToServer_client;
 	CIpcServer*			m_sendMessageToClient_server;
+	CIpcServer*			m_logLineRate_server;
+	CThread*			m_logLineRate_producer;
+	CStopwatch			m_logLineRate_timer;
+	double				m_logLineRate_time;
+	int					m_logLineRate_received;
+	bool				m_logLineRate_inOrder;
+	bool				m_logLineRate_logRing;
+	CIpcServer*			m_statsRequest_server;
+	CIpcClient*			m_statsRequest_client;
+	CString				m_statsRequest_receivedStats;
 	CTestEventQueue		m_events;
 
 };
@@ -143,12 +170,138 @@ TEST_F(CIpcTests, sendMessageToClient)
 	EXPECT_EQ("test", m_sendMessageToClient_receivedString);
 }
 
+TEST_F(CIpcTests, statsRequest_fromTool_statsReturned)
+{
+	CSocketMultiplexer socketMultiplexer;
+	CIpcServer server(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+	server.listen();
+	m_statsRequest_server = &server;
+
+	// the server answers for synergys/c like the daemon passes it on
+	m_events.adoptHandler(
+		m_events.forCIpcServer().messageReceived(), &server,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::statsRequest_serverHandleMessageReceived));
+
+	CIpcClient client(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+	client.setClientType(kIpcClientTool);
+	m_statsRequest_client = &client;
+
+	m_events.adoptHandler(
+		m_events.forCIpcClient().connected(), &client,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::statsRequest_clientHandleConnected));
+	m_events.adoptHandler(
+		m_events.forCIpcClient().messageReceived(), &client,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::statsRequest_clientHandleMessageReceived));
+	client.connect();
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(m_events.forCIpcServer().messageReceived(), &server);
+	m_events.removeHandler(m_events.forCIpcClient().connected(), &client);
+	m_events.removeHandler(m_events.forCIpcClient().messageReceived(), &client);
+	m_events.cleanupQuitTimeout();
+	client.disconnect();
+
+	EXPECT_EQ("routing 1\nencode 2\n", m_statsRequest_receivedStats);
+}
+
+TEST_F(CIpcTests, logLineRate_bulk_allInOrder)
+{
+	// per-message logging would swamp what we're measuring
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	double rate;
+	{
+		CSocketMultiplexer socketMultiplexer;
+		CIpcServer server(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+		CIpcClient client(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+		rate = logLineRate_measure(server, client);
+	}
+	EXPECT_TRUE(m_logLineRate_inOrder);
+	EXPECT_FALSE(m_logLineRate_logRing);
+
+	CLOG->setFilter(filter);
+	LOG((CLOG_INFO "log lines per second: %.0f", rate));
+}
+
+#if SYSAPI_UNIX
+
+TEST_F(CIpcTests, sendMessageToClient_localSocket)
+{
+	CSocketMultiplexer socketMultiplexer;
+	CIpcServer server(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+	server.listenLocal(TEST_IPC_PATH);
+	m_sendMessageToClient_server = &server;
+
+	m_events.adoptHandler(
+		m_events.forCIpcServer().messageReceived(), &server,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::sendMessageToClient_serverHandleClientConnected));
+
+	CIpcClient client(&m_events, &socketMultiplexer, TEST_IPC_PATH);
+	client.connect();
+	
+	m_events.adoptHandler(
+		m_events.forCIpcClient().messageReceived(), &client,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::sendMessageToClient_clientHandleMessageReceived));
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(m_events.forCIpcServer().messageReceived(), &server);
+	m_events.removeHandler(m_events.forCIpcClient().messageReceived(), &client);
+	m_events.cleanupQuitTimeout();
+	client.disconnect();
+
+	EXPECT_EQ("test", m_sendMessageToClient_receivedString);
+}
+
+TEST_F(CIpcTests, connect_noLocalServer_throws)
+{
+	// the apps fall back to tcp on this
+	CSocketMultiplexer socketMultiplexer;
+	CIpcClient client(&m_events, &socketMultiplexer, TEST_IPC_PATH);
+	EXPECT_THROW(client.connect(), XSocketConnect);
+}
+
+TEST_F(CIpcTests, logLineRate_logRing_allInOrder)
+{
+	int filter = CLOG->getFilter();
+	CLOG->setFilter(kINFO);
+
+	{
+		CSocketMultiplexer socketMultiplexer;
+		CIpcServer server(&m_events, &socketMultiplexer, TEST_IPC_PORT);
+		server.listenLocal(TEST_IPC_PATH);
+		CIpcClient client(&m_events, &socketMultiplexer, TEST_IPC_PATH);
+		logLineRate_measure(server, client);
+	}
+	EXPECT_TRUE(m_logLineRate_inOrder);
+	EXPECT_TRUE(m_logLineRate_logRing);
+
+	CLOG->setFilter(filter);
+}
+
+#endif // SYSAPI_UNIX
+
 CIpcTests::CIpcTests() :
 m_connectToServer_helloMessageReceived(false),
 m_connectToServer_hasClientNode(false),
 m_connectToServer_server(nullptr),
 m_sendMessageToClient_server(nullptr),
-m_sendMessageToServer_client(nullptr)
+m_sendMessageToServer_client(nullptr),
+m_logLineRate_server(nullptr),
+m_logLineRate_producer(nullptr),
+m_logLineRate_time(0.0),
+m_logLineRate_received(0),
+m_logLineRate_inOrder(true),
+m_logLineRate_logRing(false),
+m_statsRequest_server(nullptr),
+m_statsRequest_client(nullptr)
 {
 }
 
@@ -208,4 +361,126 @@ CIpcTests::sendMessageToClient_clientHandleMessageReceived(const CEvent& e, void
 	}
 }
 
+void
+CIpcTests::statsRequest_clientHandleConnected(const CEvent&, void*)
+{
+	m_statsRequest_client->send(CIpcStatsRequestMessage());
+}
+
+void
+CIpcTests::statsRequest_serverHandleMessageReceived(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->type() == kIpcStatsRequest) {
+		CIpcStatsMessage stats("routing 1\nencode 2\n");
+		m_statsRequest_server->send(stats, kIpcClientTool);
+	}
+}
+
+void
+CIpcTests::statsRequest_clientHandleMessageReceived(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->type() == kIpcStats) {
+		CIpcStatsMessage* sm = static_cast<CIpcStatsMessage*>(m);
+		m_statsRequest_receivedStats = sm->stats();
+		m_events.raiseQuitEvent();
+	}
+}
+
+double
+CIpcTests::logLineRate_measure(CIpcServer& server, CIpcClient& client)
+{
+	m_logLineRate_server   = &server;
+	m_logLineRate_producer = nullptr;
+	m_logLineRate_time     = 0.0;
+	m_logLineRate_received = 0;
+	m_logLineRate_inOrder  = true;
+	m_logLineRate_logRing  = false;
+
+	// the producer starts when the client says hello
+	m_events.adoptHandler(
+		m_events.forCIpcServer().messageReceived(), &server,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::logLineRate_serverHandleMessageReceived));
+	m_events.adoptHandler(
+		m_events.forCIpcClient().messageReceived(), &client,
+		new TMethodEventJob<CIpcTests>(
+		this, &CIpcTests::logLineRate_clientHandleMessageReceived));
+
+	server.listen();
+	client.connect();
+
+	m_events.initQuitTimeout(60);
+	m_events.loop();
+	m_events.removeHandler(m_events.forCIpcServer().messageReceived(), &server);
+	m_events.removeHandler(m_events.forCIpcClient().messageReceived(), &client);
+	m_events.cleanupQuitTimeout();
+
+	if (m_logLineRate_producer != nullptr) {
+		m_logLineRate_producer->wait();
+		delete m_logLineRate_producer;
+	}
+	m_logLineRate_logRing = client.isLogRingOpen();
+	client.disconnect();
+
+	EXPECT_EQ(kLogLineChunks * kLogLinesPerChunk, m_logLineRate_received);
+	if (m_logLineRate_time <= 0.0) {
+		return 0.0;
+	}
+	return m_logLineRate_received / m_logLineRate_time;
+}
+
+void
+CIpcTests::logLineRate_produce(void*)
+{
+	std::vector<CString> chunks(kLogLineChunks);
+	CString padding(60, '.');
+	for (int i = 0; i < kLogLineChunks; ++i) {
+		for (int j = 0; j < kLogLinesPerChunk; ++j) {
+			chunks[i] += synergy::string::sprintf("%d %s\n",
+							i * kLogLinesPerChunk + j, padding.c_str());
+		}
+	}
+
+	// give a local client time to take up the log ring
+	ARCH->sleep(0.2);
+
+	m_logLineRate_timer.reset();
+	for (int i = 0; i < kLogLineChunks; ++i) {
+		CIpcLogLineMessage message(chunks[i]);
+		m_logLineRate_server->send(message, kIpcClientNode);
+	}
+}
+
+void
+CIpcTests::logLineRate_serverHandleMessageReceived(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->type() == kIpcHello && m_logLineRate_producer == nullptr) {
+		m_logLineRate_producer = new CThread(new TMethodJob<CIpcTests>(
+			this, &CIpcTests::logLineRate_produce));
+	}
+}
+
+void
+CIpcTests::logLineRate_clientHandleMessageReceived(const CEvent& e, void*)
+{
+	CIpcMessage* m = static_cast<CIpcMessage*>(e.getDataObject());
+	if (m->type() != kIpcLogLine) {
+		return;
+	}
+
+	CString chunk = static_cast<CIpcLogLineMessage*>(m)->logLine();
+	if (atoi(chunk.c_str()) != m_logLineRate_received) {
+		m_logLineRate_inOrder = false;
+	}
+	m_logLineRate_received += static_cast<int>(
+							std::count(chunk.begin(), chunk.end(), '\n'));
+	if (m_logLineRate_received >= kLogLineChunks * kLogLinesPerChunk) {
+		m_logLineRate_time = m_logLineRate_timer.getTime();
+		m_events.raiseQuitEvent();
+	}
+}
+
 #endif // WINAPI_CARBON
@@ -28,15 +28,19 @@
 #include "server/Server.h"
 #include "server/ClientListener.h"
 #include "client/Client.h"
+#include "synergy/ClientApp.h"
 #include "synergy/FileChunker.h"
 #include "net/SocketMultiplexer.h"
 #include "net/NetworkAddress.h"
 #include "net/TCPSocketFactory.h"
 #include "io/CryptoOptions.h"
 #include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "arch/XArch.h"
 #include "base/TMethodEventJob.h"
 #include "base/TMethodJob.h"
 #include "base/Log.h"
+#include "base/Stopwatch.h"
 #include "common/stdexcept.h"
 
 #include "test/global/gtest.h"
@@ -44,6 +48,9 @@
 #include <fstream>
 #include <iostream>
 #include <stdio.h>
+#if SYSAPI_UNIX
+#include <sys/resource.h>
+#endif
 
 using namespace std;
 using ::testing::_;
@@ -58,6 +65,7 @@ const size_t kMockDataSize = 1024 * 1024 * 10; // 10MB
 const UInt16 kMockDataChunkIncrement = 1024; // 1KB
 const char* kMockFilename = "NetworkTests.mock";
 const size_t kMockFileSize = 1024 * 1024 * 10; // 10MB
+const int kStormSize = 1000;
 
 void getScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h);
 void getCursorPos(SInt32& x, SInt32& y);
@@ -71,7 +79,20 @@ public:
 	NetworkTests() :
 		m_mockData(NULL),
 		m_mockDataSize(0),
-		m_mockFileSize(0)
+		m_mockFileSize(0),
+		m_connections(0),
+		m_reconnectClient(NULL),
+		m_reconnectPrimary(NULL),
+		m_reconnectSaver(false),
+		m_stormListener(NULL),
+		m_stormClient(NULL),
+		m_stormThread(NULL),
+		m_stormOpened(0),
+		m_stormTime(0.0),
+		m_stormMaxPending(0),
+		m_stormMaxGap(0.0),
+		m_stormClosed(false),
+		m_stormClientStarted(false)
 	{
 		m_mockData = newMockData(kMockDataSize);
 		createFile(m_mockFile, kMockFilename, kMockFileSize);
@@ -96,6 +117,16 @@ public:
 
 	void				sendToServer_mockFile_handleClientConnected(const CEvent&, void* vlistener);
 	void				sendToServer_mockFile_fileRecieveCompleted(const CEvent& event, void*);
+
+	void				reconnect_afterDrop_handleClientConnected(const CEvent&, void* vlistener);
+	void				reconnect_afterDrop_enable();
+	void				reconnect_afterDrop_screensaver(bool activate);
+	void				reconnect_afterDrop_handleDropTimer(const CEvent&, void*);
+
+	void				connectionStorm_stormThread(void*);
+	void				connectionStorm_handleTick(const CEvent&, void*);
+	void				connectionStorm_handleClientConnected(const CEvent&, void* vlistener);
+	void				connectionStorm_handleConnected(const CEvent&, void*);
 	
 public:
 	CTestEventQueue		m_events;
@@ -103,6 +134,23 @@ public:
 	size_t				m_mockDataSize;
 	fstream				m_mockFile;
 	size_t				m_mockFileSize;
+	int					m_connections;
+	CStopwatch			m_reconnectTimer;
+	CClient*			m_reconnectClient;
+	CMockPrimaryClient*	m_reconnectPrimary;
+	bool				m_reconnectSaver;
+	CNetworkAddress		m_stormAddress;
+	CClientListener*	m_stormListener;
+	CClient*			m_stormClient;
+	CThread*			m_stormThread;
+	std::vector<CArchSocket>	m_stormSockets;
+	size_t				m_stormOpened;
+	double				m_stormTime;
+	size_t				m_stormMaxPending;
+	double				m_stormMaxGap;
+	CStopwatch			m_stormTick;
+	bool				m_stormClosed;
+	bool				m_stormClientStarted;
 };
 
 TEST_F(NetworkTests, sendToClient_mockData)
@@ -317,6 +365,157 @@ TEST_F(NetworkTests, sendToServer_mockFile)
 	m_events.cleanupQuitTimeout();
 }
 
+TEST_F(NetworkTests, reconnect_afterDrop_resumesSession)
+{
+	// server and client
+	CNetworkAddress serverAddress(TEST_HOST, TEST_PORT);
+	CCryptoOptions cryptoOptions;
+	
+	serverAddress.resolve();
+	
+	// server
+	CSocketMultiplexer serverSocketMultiplexer;
+	CTCPSocketFactory* serverSocketFactory = new CTCPSocketFactory(&m_events, &serverSocketMultiplexer);
+	CClientListener listener(serverAddress, serverSocketFactory, NULL, cryptoOptions, &m_events);
+	NiceMock<CMockScreen> serverScreen;
+	NiceMock<CMockPrimaryClient> primaryClient;
+	NiceMock<CMockConfig> serverConfig;
+	NiceMock<CMockInputFilter> serverInputFilter;
+	
+	m_events.adoptHandler(
+		m_events.forCClientListener().connected(), &listener,
+		new TMethodEventJob<NetworkTests>(
+			this, &NetworkTests::reconnect_afterDrop_handleClientConnected, &listener));
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	
+	CServer server(serverConfig, &primaryClient, &serverScreen, &m_events, true);
+	server.m_mock = true;
+	listener.setServer(&server);
+
+	// client, restarted by the app when its connection drops
+	NiceMock<CMockScreen> clientScreen;
+	CSocketMultiplexer clientSocketMultiplexer;
+	CClientApp clientApp(&m_events, NULL);
+	clientApp.setSocketMultiplexer(&clientSocketMultiplexer);
+	
+	ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getScreenShape));
+	ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getCursorPos));
+	ON_CALL(clientScreen, enable()).WillByDefault(
+		Invoke(this, &NetworkTests::reconnect_afterDrop_enable));
+
+	// the screen saver started while the client was gone
+	EXPECT_CALL(clientScreen, screensaver(true)).WillOnce(
+		Invoke(this, &NetworkTests::reconnect_afterDrop_screensaver));
+
+	CClient* client = clientApp.openClient("stub", serverAddress, &clientScreen, cryptoOptions);
+	clientApp.setClient(client, &clientScreen);
+	m_reconnectClient  = client;
+	m_reconnectPrimary = &primaryClient;
+
+	client->connect();
+
+	m_events.initQuitTimeout(10);
+	m_events.loop();
+	m_events.removeHandler(m_events.forCClientListener().connected(), &listener);
+	m_events.cleanupQuitTimeout();
+
+	clientApp.closeClient(client);
+	clientApp.setClient(NULL, NULL);
+
+	EXPECT_EQ(2, m_connections);
+	EXPECT_TRUE(m_reconnectSaver);
+}
+
+TEST_F(NetworkTests, connectionStorm_staysBounded)
+{
+#if SYSAPI_UNIX
+	// both ends of the storm live in this process
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#endif
+
+	// server and client
+	CNetworkAddress serverAddress(TEST_HOST, TEST_PORT);
+	CCryptoOptions cryptoOptions;
+	
+	serverAddress.resolve();
+	m_stormAddress = serverAddress;
+	
+	// server
+	CSocketMultiplexer serverSocketMultiplexer;
+	CTCPSocketFactory* serverSocketFactory = new CTCPSocketFactory(&m_events, &serverSocketMultiplexer);
+	CClientListener listener(serverAddress, serverSocketFactory, NULL, cryptoOptions, &m_events);
+	NiceMock<CMockScreen> serverScreen;
+	NiceMock<CMockPrimaryClient> primaryClient;
+	NiceMock<CMockConfig> serverConfig;
+	NiceMock<CMockInputFilter> serverInputFilter;
+	
+	m_events.adoptHandler(
+		m_events.forCClientListener().connected(), &listener,
+		new TMethodEventJob<NetworkTests>(
+			this, &NetworkTests::connectionStorm_handleClientConnected, &listener));
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	
+	CServer server(serverConfig, &primaryClient, &serverScreen, &m_events, true);
+	server.m_mock = true;
+	listener.setServer(&server);
+
+	// client, which connects once the storm has passed
+	NiceMock<CMockScreen> clientScreen;
+	CSocketMultiplexer clientSocketMultiplexer;
+	CTCPSocketFactory* clientSocketFactory = new CTCPSocketFactory(&m_events, &clientSocketMultiplexer);
+	
+	ON_CALL(clientScreen, getShape(_, _, _, _)).WillByDefault(Invoke(getScreenShape));
+	ON_CALL(clientScreen, getCursorPos(_, _)).WillByDefault(Invoke(getCursorPos));
+
+	CClient client(&m_events, "stub", serverAddress, clientSocketFactory, NULL, &clientScreen, cryptoOptions, true);
+
+	m_events.adoptHandler(
+		m_events.forCClient().connected(), client.getEventTarget(),
+		new TMethodEventJob<NetworkTests>(
+			this, &NetworkTests::connectionStorm_handleConnected));
+
+	// watch the listener and the event loop while the storm rages
+	m_stormListener = &listener;
+	m_stormClient   = &client;
+	CEventQueueTimer* tick = m_events.newTimer(0.05, NULL);
+	m_events.adoptHandler(CEvent::kTimer, tick,
+		new TMethodEventJob<NetworkTests>(
+			this, &NetworkTests::connectionStorm_handleTick));
+	m_stormTick.reset();
+	m_stormThread = new CThread(new TMethodJob<NetworkTests>(
+			this, &NetworkTests::connectionStorm_stormThread));
+
+	m_events.initQuitTimeout(20);
+	m_events.loop();
+	m_events.removeHandler(m_events.forCClientListener().connected(), &listener);
+	m_events.removeHandler(m_events.forCClient().connected(), client.getEventTarget());
+	m_events.removeHandler(CEvent::kTimer, tick);
+	m_events.deleteTimer(tick);
+	m_events.cleanupQuitTimeout();
+
+	m_stormThread->wait();
+	delete m_stormThread;
+	for (size_t i = 0; i < m_stormSockets.size(); ++i) {
+		ARCH->closeSocket(m_stormSockets[i]);
+	}
+
+	LOG((CLOG_INFO "opened %d connections in %.3f s, at most %d handshakes pending, longest stall %.3f s",
+		static_cast<int>(m_stormOpened), m_stormTime,
+		static_cast<int>(m_stormMaxPending), m_stormMaxGap));
+	EXPECT_TRUE(m_stormClientStarted);
+	// every connection comes from the loopback address, so the limit on
+	// handshakes from one host is the one that holds them back
+	EXPECT_LE(m_stormMaxPending, 32u);
+}
+
 void 
 NetworkTests::sendToClient_mockData_handleClientConnected(const CEvent&, void* vlistener)
 {
@@ -403,6 +602,152 @@ NetworkTests::sendToServer_mockFile_fileRecieveCompleted(const CEvent& event, vo
 	m_events.raiseQuitEvent();
 }
 
+void 
+NetworkTests::reconnect_afterDrop_handleClientConnected(const CEvent&, void* vlistener)
+{
+	CClientListener* listener = reinterpret_cast<CClientListener*>(vlistener);
+	CServer* server = listener->getServer();
+
+	CClientProxy* client = listener->getNextClient();
+	if (client == NULL) {
+		throw runtime_error("client is null");
+	}
+
+	CBaseClientProxy* bcp = reinterpret_cast<CBaseClientProxy*>(client);
+	if (m_connections == 0) {
+		EXPECT_TRUE(bcp->getResumeToken().empty());
+		server->adoptClient(bcp);
+
+		// pretend the client is up to date with every clipboard
+		for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+			bcp->setClipboardDirty(id, false);
+		}
+	}
+	else {
+		EXPECT_FALSE(bcp->getResumeToken().empty());
+		server->adoptClient(bcp);
+
+		// nothing changed while it was gone so nothing is resent
+		for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+			EXPECT_FALSE(bcp->isClipboardDirty(id));
+		}
+	}
+}
+
+void 
+NetworkTests::reconnect_afterDrop_enable()
+{
+	if (++m_connections == 1) {
+		// give the session token time to arrive then drop the link
+		CEventQueueTimer* timer = m_events.newOneShotTimer(0.1, NULL);
+		m_events.adoptHandler(CEvent::kTimer, timer,
+			new TMethodEventJob<NetworkTests>(
+				this, &NetworkTests::reconnect_afterDrop_handleDropTimer));
+		return;
+	}
+
+	LOG((CLOG_INFO "usable again %.3f ms after the connection dropped",
+		1000.0 * m_reconnectTimer.getTime()));
+	if (m_reconnectSaver) {
+		m_events.raiseQuitEvent();
+	}
+}
+
+void 
+NetworkTests::reconnect_afterDrop_screensaver(bool)
+{
+	m_reconnectSaver = true;
+	if (m_connections == 2) {
+		m_events.raiseQuitEvent();
+	}
+}
+
+void 
+NetworkTests::reconnect_afterDrop_handleDropTimer(const CEvent& event, void*)
+{
+	CEventQueueTimer* timer = reinterpret_cast<CEventQueueTimer*>(event.getTarget());
+	m_events.removeHandler(CEvent::kTimer, timer);
+	m_events.deleteTimer(timer);
+
+	// the screen saver starts while the client is gone.  the app sees
+	// the client disconnect and restarts it.
+	m_reconnectTimer.reset();
+	m_events.addEvent(CEvent(m_events.forIPrimaryScreen().screensaverActivated(),
+							m_reconnectPrimary->getEventTarget()));
+	m_reconnectClient->disconnect(NULL);
+}
+
+void
+NetworkTests::connectionStorm_stormThread(void*)
+{
+	// open connections as fast as we can and sit on them without
+	// saying a word
+	CStopwatch timer;
+	for (int i = 0; i < kStormSize; ++i) {
+		CArchSocket socket = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+		try {
+			ARCH->connectSocket(socket, m_stormAddress.getAddress());
+		}
+		catch (XArchNetwork&) {
+			ARCH->closeSocket(socket);
+			continue;
+		}
+		m_stormSockets.push_back(socket);
+	}
+	m_stormTime   = timer.getTime();
+	m_stormOpened = m_stormSockets.size();
+}
+
+void
+NetworkTests::connectionStorm_handleTick(const CEvent&, void*)
+{
+	double gap = m_stormTick.getTime();
+	m_stormTick.reset();
+	if (gap > m_stormMaxGap) {
+		m_stormMaxGap = gap;
+	}
+	size_t pending = m_stormListener->getNumPendingClients();
+	if (pending > m_stormMaxPending) {
+		m_stormMaxPending = pending;
+	}
+
+	if (!m_stormClosed) {
+		// once the storm is over the stalled connections go away
+		if (m_stormThread->wait(0.0)) {
+			for (size_t i = 0; i < m_stormSockets.size(); ++i) {
+				ARCH->closeSocket(m_stormSockets[i]);
+			}
+			m_stormSockets.clear();
+			m_stormClosed = true;
+		}
+	}
+	else if (!m_stormClientStarted && pending == 0) {
+		// and a real client gets straight in
+		m_stormClientStarted = true;
+		m_stormClient->connect();
+	}
+}
+
+void 
+NetworkTests::connectionStorm_handleClientConnected(const CEvent&, void* vlistener)
+{
+	CClientListener* listener = reinterpret_cast<CClientListener*>(vlistener);
+	CServer* server = listener->getServer();
+
+	CClientProxy* client = listener->getNextClient();
+	if (client == NULL) {
+		throw runtime_error("client is null");
+	}
+
+	server->adoptClient(reinterpret_cast<CBaseClientProxy*>(client));
+}
+
+void 
+NetworkTests::connectionStorm_handleConnected(const CEvent&, void*)
+{
+	m_events.raiseQuitEvent();
+}
+
 void 
 NetworkTests::sendMockData(void* eventTarget)
 {
@@ -0,0 +1,165 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// these need an X server;  run under Xvfb on headless machines, e.g.
+// `Xvfb :99 & DISPLAY=:99 integtests --gtest_filter=CXWindows*`
+
+// gtest must come before Xlib, which defines None
+#include "test/global/gtest.h"
+
+#include "platform/XWindowsClipboard.h"
+#include "platform/XWindowsUtil.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+static const size_t		kNumRequestors = 5;
+
+class CXWindowsClipboardINCRTests : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_display = XOpenDisplay(NULL);
+		ASSERT_TRUE(m_display != NULL);
+		m_owner = createWindow();
+	}
+
+	virtual void TearDown()
+	{
+		XDestroyWindow(m_display, m_owner);
+		XCloseDisplay(m_display);
+	}
+
+	Window createWindow()
+	{
+		Window window = XCreateSimpleWindow(m_display,
+							DefaultRootWindow(m_display),
+							0, 0, 1, 1, 0, 0, 0);
+		XSelectInput(m_display, window, PropertyChangeMask);
+		return window;
+	}
+
+	Display*			m_display;
+	Window				m_owner;
+};
+
+// a requestor following the ICCCM, including INCR transfers
+class CRequestor {
+public:
+	CRequestor() : m_window(None), m_incremental(false),
+		m_done(false), m_failed(false), m_received(0) { }
+
+	Window				m_window;
+	bool				m_incremental;
+	bool				m_done;
+	bool				m_failed;
+	size_t				m_received;
+};
+
+TEST_F(CXWindowsClipboardINCRTests, fiveRequestors50MB_benchmark)
+{
+	const size_t size = 50 << 20;
+	CXWindowsClipboard clipboard(m_display, m_owner, kClipboardClipboard);
+	::Time time = CXWindowsUtil::getCurrentTime(m_display, m_owner);
+	ASSERT_TRUE(clipboard.open(time));
+	ASSERT_TRUE(clipboard.empty());
+	clipboard.add(IClipboard::kText, CString(size, 'x'));
+	clipboard.close();
+
+	Atom target   = XInternAtom(m_display, "UTF8_STRING", False);
+	Atom property = XInternAtom(m_display, "SYNERGY_TEST", False);
+	Atom incr     = XInternAtom(m_display, "INCR", False);
+
+	CRequestor requestors[kNumRequestors];
+	for (size_t i = 0; i < kNumRequestors; ++i) {
+		requestors[i].m_window = createWindow();
+		XConvertSelection(m_display, clipboard.getSelection(), target,
+							property, requestors[i].m_window, time);
+	}
+
+	// play both the owner and the requestors until all are done
+	CStopwatch timer;
+	size_t remaining = kNumRequestors;
+	while (remaining > 0 && timer.getTime() < 60.0) {
+		XEvent xevent;
+		XNextEvent(m_display, &xevent);
+		if (xevent.type == SelectionRequest) {
+			clipboard.addRequest(xevent.xselectionrequest.owner,
+							xevent.xselectionrequest.requestor,
+							xevent.xselectionrequest.target,
+							xevent.xselectionrequest.time,
+							xevent.xselectionrequest.property);
+			continue;
+		}
+		if (xevent.type == PropertyNotify &&
+			xevent.xproperty.state == PropertyDelete) {
+			clipboard.processRequest(xevent.xproperty.window,
+							xevent.xproperty.time, xevent.xproperty.atom);
+			continue;
+		}
+
+		// find the requestor
+		CRequestor* requestor = NULL;
+		for (size_t i = 0; i < kNumRequestors; ++i) {
+			if (requestors[i].m_window == xevent.xany.window) {
+				requestor = requestors + i;
+			}
+		}
+		if (requestor == NULL || requestor->m_done) {
+			continue;
+		}
+
+		CString data;
+		Atom type;
+		if (xevent.type == SelectionNotify) {
+			if (xevent.xselection.property == None ||
+				!CXWindowsUtil::getWindowProperty(m_display,
+							requestor->m_window, property,
+							&data, &type, NULL, true)) {
+				requestor->m_failed = true;
+				requestor->m_done   = true;
+			}
+			else if (type == incr) {
+				requestor->m_incremental = true;
+			}
+			else {
+				requestor->m_received = data.size();
+				requestor->m_done     = true;
+			}
+		}
+		else if (xevent.type == PropertyNotify &&
+				xevent.xproperty.atom == property &&
+				requestor->m_incremental) {
+			CXWindowsUtil::getWindowProperty(m_display, requestor->m_window,
+							property, &data, &type, NULL, true);
+			requestor->m_received += data.size();
+			requestor->m_done      = data.empty();
+		}
+		if (requestor->m_done) {
+			--remaining;
+		}
+	}
+	double elapsed = timer.getTime();
+
+	LOG((CLOG_INFO "%d requestors pulled %d MB each in %.3f s",
+							static_cast<int>(kNumRequestors),
+							static_cast<int>(size >> 20), elapsed));
+	for (size_t i = 0; i < kNumRequestors; ++i) {
+		EXPECT_FALSE(requestors[i].m_failed);
+		EXPECT_EQ(size, requestors[i].m_received);
+		XDestroyWindow(m_display, requestors[i].m_window);
+	}
+}
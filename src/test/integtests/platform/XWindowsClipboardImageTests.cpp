@@ -0,0 +1,130 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// these need an X server;  run under Xvfb on headless machines, e.g.
+// `Xvfb :99 & DISPLAY=:99 integtests --gtest_filter=CXWindows*`
+
+// gtest must come before Xlib, which defines None
+#include "test/global/gtest.h"
+
+#include "platform/XWindowsClipboardBMPConverter.h"
+#include "platform/XWindowsClipboardPNGConverter.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+// a 5K screenshot as 32 bit BMP
+static const UInt32		kWidth  = 5120;
+static const UInt32		kHeight = 2880;
+
+static void
+appendLE32(CString& dst, UInt32 x)
+{
+	dst += static_cast<char>(x & 0xff);
+	dst += static_cast<char>((x >>  8) & 0xff);
+	dst += static_cast<char>((x >> 16) & 0xff);
+	dst += static_cast<char>((x >> 24) & 0xff);
+}
+
+// makes kBitmap data:  a BMP info header followed by the pixels
+static CString
+makeBitmap(UInt32 w, UInt32 h)
+{
+	CString bmp;
+	bmp.reserve(40 + 4 * w * h);
+	appendLE32(bmp, 40);
+	appendLE32(bmp, w);
+	appendLE32(bmp, h);
+	appendLE32(bmp, 1 | (32 << 16));
+	appendLE32(bmp, 0);
+	appendLE32(bmp, 4 * w * h);
+	appendLE32(bmp, 2834);
+	appendLE32(bmp, 2834);
+	appendLE32(bmp, 0);
+	appendLE32(bmp, 0);
+	for (UInt32 i = 0; i < w * h; ++i) {
+		appendLE32(bmp, i * 2654435761u);
+	}
+	return bmp;
+}
+
+class CXWindowsClipboardImageTests : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_display = XOpenDisplay(NULL);
+		ASSERT_TRUE(m_display != NULL);
+	}
+
+	virtual void TearDown()
+	{
+		XCloseDisplay(m_display);
+	}
+
+	Display*			m_display;
+};
+
+TEST_F(CXWindowsClipboardImageTests, bmp_roundTrip_unchanged)
+{
+	CXWindowsClipboardBMPConverter converter(m_display);
+	CString bmp = makeBitmap(7, 3);
+
+	CString file = converter.fromIClipboard(bmp);
+
+	ASSERT_EQ(14 + bmp.size(), file.size());
+	EXPECT_EQ('B', file[0]);
+	EXPECT_EQ('M', file[1]);
+	EXPECT_EQ(bmp, converter.toIClipboard(file));
+}
+
+TEST_F(CXWindowsClipboardImageTests, bmp_badPixelOffset_rejected)
+{
+	CXWindowsClipboardBMPConverter converter(m_display);
+	CString file = converter.fromIClipboard(makeBitmap(7, 3));
+	file[10] = '\xff';
+	file[11] = '\xff';
+
+	EXPECT_TRUE(converter.toIClipboard(file).empty());
+}
+
+TEST_F(CXWindowsClipboardImageTests, png_passthrough_unchanged)
+{
+	CXWindowsClipboardPNGConverter converter(m_display);
+	CString png("\x89PNG\r\n\x1a\n\0\0\0\rIHDR", 16);
+
+	EXPECT_EQ(IClipboard::kPNG, converter.getFormat());
+	EXPECT_EQ(png, converter.toIClipboard(png));
+	EXPECT_EQ(png, converter.fromIClipboard(png));
+	EXPECT_TRUE(converter.toIClipboard("GIF89a not a png").empty());
+}
+
+TEST_F(CXWindowsClipboardImageTests, bmp_5kScreenshot_benchmark)
+{
+	CXWindowsClipboardBMPConverter converter(m_display);
+	CString bmp = makeBitmap(kWidth, kHeight);
+
+	CStopwatch timer;
+	CString file = converter.fromIClipboard(bmp);
+	double from = timer.getTime();
+	CString back = converter.toIClipboard(file);
+	double to = timer.getTime() - from;
+
+	double mb = bmp.size() / 1048576.0;
+	LOG((CLOG_INFO "bmp: to X %.3f MB/s, from X %.3f MB/s",
+							mb / from, mb / to));
+	EXPECT_EQ(bmp.size(), back.size());
+	EXPECT_LT(from + to, 5.0);
+}
@@ -0,0 +1,129 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// these need an X server;  run under Xvfb on headless machines, e.g.
+// `Xvfb :99 & DISPLAY=:99 integtests --gtest_filter=CXWindows*`
+
+#include "test/mock/synergy/MockEventQueue.h"
+#include "platform/XWindowsEventQueueBuffer.h"
+#include "base/EventTypes.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+#include <X11/Xatom.h>
+#include <cstring>
+
+class CXWindowsEventQueueBufferTests : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_display = XOpenDisplay(NULL);
+		ASSERT_TRUE(m_display != NULL);
+		m_window  = XCreateSimpleWindow(m_display,
+							DefaultRootWindow(m_display),
+							0, 0, 1, 1, 0, 0, 0);
+	}
+
+	virtual void TearDown()
+	{
+		XDestroyWindow(m_display, m_window);
+		XCloseDisplay(m_display);
+	}
+
+	Display*			m_display;
+	Window				m_window;
+	CMockEventQueue		m_eventQueue;
+};
+
+TEST_F(CXWindowsEventQueueBufferTests, waitForEvent_idle_noBusyWakeups)
+{
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	// wait like CEventQueue does, until a 1 second timer would expire
+	const double duration = 1.0;
+	int wakeups = 0;
+	CStopwatch timer;
+	while (buffer.isEmpty() && timer.getTime() < duration) {
+		buffer.waitForEvent(duration - timer.getTime());
+		++wakeups;
+	}
+
+	EXPECT_GE(timer.getTime(), duration);
+	EXPECT_LE(wakeups, 2);
+}
+
+TEST_F(CXWindowsEventQueueBufferTests, waitForEvent_timeout_notEarly)
+{
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	CStopwatch timer;
+	buffer.waitForEvent(0.0105);
+
+	EXPECT_GE(timer.getTime(), 0.0105);
+}
+
+TEST_F(CXWindowsEventQueueBufferTests, addEvent_thenWait_returnsUserEvent)
+{
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	buffer.addEvent(42);
+
+	buffer.waitForEvent(5.0);
+	ASSERT_FALSE(buffer.isEmpty());
+
+	CEvent event;
+	UInt32 dataID = 0;
+	ASSERT_EQ(IEventQueueBuffer::kUser, buffer.getEvent(event, dataID));
+	EXPECT_EQ(42, dataID);
+	EXPECT_TRUE(buffer.isEmpty());
+}
+
+TEST_F(CXWindowsEventQueueBufferTests, getEvent_xEventsTakenByHandler_returnsUserEvent)
+{
+	CXWindowsEventQueueBuffer buffer(m_display, m_window, &m_eventQueue);
+	XSync(m_display, True);
+
+	// three X events arrive, then a user event
+	for (int i = 0; i < 3; ++i) {
+		XEvent xevent;
+		memset(&xevent, 0, sizeof(xevent));
+		xevent.xclient.type         = ClientMessage;
+		xevent.xclient.window       = m_window;
+		xevent.xclient.message_type = XA_INTEGER;
+		xevent.xclient.format       = 32;
+		XSendEvent(m_display, m_window, False, 0, &xevent);
+	}
+	XSync(m_display, False);
+	ASSERT_EQ(3, QLength(m_display));
+	buffer.addEvent(7);
+
+	CEvent event;
+	UInt32 dataID = 0;
+	ASSERT_EQ(IEventQueueBuffer::kSystem, buffer.getEvent(event, dataID));
+
+	// the handler takes the other two, like motion coalescing does
+	XEvent xevent;
+	while (XCheckTypedWindowEvent(m_display, m_window, ClientMessage, &xevent)) {
+		// discard
+	}
+
+	ASSERT_EQ(IEventQueueBuffer::kUser, buffer.getEvent(event, dataID));
+	EXPECT_EQ(7, dataID);
+}
@@ -16,10 +16,18 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define TEST_ENV
+
 #include "test/mock/synergy/MockEventQueue.h"
+#include "test/global/TestEventQueue.h"
 #include "platform/XWindowsScreen.h"
+#include "synergy/InputChannel.h"
+#include "arch/Arch.h"
+#include "base/TMethodEventJob.h"
 
 #include "test/global/gtest.h"
+#include <X11/extensions/XTest.h>
+#include <cstring>
 
 using ::testing::_;
 
@@ -39,3 +47,226 @@ TEST(CXWindowsScreenTests, fakeMouseMove_nonPrimary_getCursorPosValuesCorrect)
 	ASSERT_EQ(10, x);
 	ASSERT_EQ(20, y);
 }
+
+TEST(CXWindowsScreenTests, fakeKeyDown_typingBurst_sentOnFlush)
+{
+	CMockEventQueue eventQueue;
+	EXPECT_CALL(eventQueue, adoptHandler(_, _, _)).Times(2);
+	EXPECT_CALL(eventQueue, adoptBuffer(_)).Times(2);
+	EXPECT_CALL(eventQueue, removeHandler(_, _)).Times(2);
+	CXWindowsScreen screen(
+		":0.0", false, false, 0, &eventQueue);
+	screen.updateKeyMap();
+	screen.updateKeyState();
+
+	// a second connection sees what the server has done
+	Display* observer = XOpenDisplay(":0.0");
+	ASSERT_TRUE(observer != NULL);
+	char before[32];
+	XQueryKeymap(observer, before);
+
+	// press keys the way the client does for one read from the server
+	static const char s_burst[] = "synergy";
+	for (UInt32 i = 0; s_burst[i] != '\0'; ++i) {
+		screen.fakeKeyDown(static_cast<KeyID>(s_burst[i]), 0,
+							static_cast<KeyButton>(i + 1));
+	}
+
+	// nothing has reached the server yet
+	char during[32];
+	XQueryKeymap(observer, during);
+	EXPECT_EQ(0, memcmp(before, during, sizeof(before)));
+
+	// until the batch is flushed.  the server may handle the observer's
+	// query before the flushed requests so give it a few tries.
+	screen.flushFakeInput();
+	char after[32];
+	for (int i = 0; i < 100; ++i) {
+		XQueryKeymap(observer, after);
+		if (memcmp(before, after, sizeof(before)) != 0) {
+			break;
+		}
+		ARCH->sleep(0.01);
+	}
+	EXPECT_NE(0, memcmp(before, after, sizeof(before)));
+
+	screen.fakeAllKeysUp();
+	screen.flushFakeInput();
+	XCloseDisplay(observer);
+}
+
+#ifdef HAVE_XI2
+
+// moves the mouse through its own display connection the way a real
+// mouse would, while a primary screen is off screen
+class CXWindowsScreenRawMotionTests : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_injector = XOpenDisplay(":0.0");
+		ASSERT_TRUE(m_injector != NULL);
+		int opcode, event, error;
+		m_xi2 = XQueryExtension(m_injector, "XInputExtension",
+							&opcode, &event, &error);
+
+		// without acceleration raw and cooked motion are the same
+		XGetPointerControl(m_injector, &m_accelNumerator,
+							&m_accelDenominator, &m_threshold);
+		XChangePointerControl(m_injector, True, True, 1, 1, 0);
+		XSync(m_injector, False);
+	}
+
+	virtual void TearDown()
+	{
+		if (m_injector != NULL) {
+			XChangePointerControl(m_injector, True, True,
+							m_accelNumerator, m_accelDenominator, m_threshold);
+			XCloseDisplay(m_injector);
+		}
+	}
+
+	// the device XTest input comes from
+	int					getXTestPointer()
+	{
+		int id = -1, n;
+		XIDeviceInfo* info = XIQueryDevice(m_injector, XIAllDevices, &n);
+		for (int i = 0; i < n; ++i) {
+			if (info[i].use == XISlavePointer &&
+				strstr(info[i].name, "XTEST") != NULL) {
+				id = info[i].deviceid;
+			}
+		}
+		XIFreeDeviceInfo(info);
+		return id;
+	}
+
+	void				moveBy(int dx, int dy)
+	{
+		XTestFakeRelativeMotionEvent(m_injector, dx, dy, CurrentTime);
+		XSync(m_injector, False);
+	}
+
+	int					getPointerX()
+	{
+		Window root, child;
+		int x, y, xWindow, yWindow;
+		unsigned int mask;
+		XQueryPointer(m_injector, DefaultRootWindow(m_injector),
+							&root, &child, &x, &y, &xWindow, &yWindow, &mask);
+		return x;
+	}
+
+	// let the screen handle its X events for a while
+	void				pump(CTestEventQueue& events)
+	{
+		CEventQueueTimer* timer = events.newOneShotTimer(0.2, NULL);
+		events.adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CXWindowsScreenRawMotionTests>(
+								this, &CXWindowsScreenRawMotionTests::handlePump,
+								&events));
+		events.loop();
+		events.removeHandler(CEvent::kTimer, timer);
+		events.deleteTimer(timer);
+	}
+
+	void				handlePump(const CEvent&, void* vevents)
+	{
+		reinterpret_cast<CTestEventQueue*>(vevents)->raiseQuitEvent();
+	}
+
+	// sum the motion on the secondary screen sent to the server
+	void				receiveMotion(CInputChannel& channel,
+							SInt32& dx, SInt32& dy, int& other)
+	{
+		dx = dy = other = 0;
+		CInputChannel::CInput input;
+		while (channel.receive(input)) {
+			if (input.m_type == CInputChannel::CInput::kMotionOnSecondary) {
+				dx += input.m_x;
+				dy += input.m_y;
+			}
+			else {
+				++other;
+			}
+		}
+	}
+
+	Display*			m_injector;
+	bool				m_xi2;
+	int					m_accelNumerator;
+	int					m_accelDenominator;
+	int					m_threshold;
+};
+
+TEST_F(CXWindowsScreenRawMotionTests, leave_relativeMotion_sentAsDeltas)
+{
+	if (!m_xi2) {
+		SUCCEED() << "XInput2 extension not installed";
+		return;
+	}
+
+	CTestEventQueue events;
+	CXWindowsScreen screen(":0.0", true, false, 0, &events);
+	CInputChannel channel(&events);
+	screen.setInputChannel(&channel);
+	screen.enable();
+	ASSERT_TRUE(screen.leave());
+	pump(events);
+	SInt32 dx, dy;
+	int other;
+	receiveMotion(channel, dx, dy, other);
+	int center = getPointerX();
+
+	moveBy(100, 0);
+	pump(events);
+
+	// the deltas go to the secondary and the mouse isn't warped back
+	receiveMotion(channel, dx, dy, other);
+	EXPECT_EQ(100, dx);
+	EXPECT_EQ(0, dy);
+	EXPECT_EQ(0, other);
+	EXPECT_EQ(center + 100, getPointerX());
+
+	screen.setInputChannel(NULL);
+	screen.disable();
+}
+
+TEST_F(CXWindowsScreenRawMotionTests, leave_absoluteDevice_rawMotionIgnored)
+{
+	if (!m_xi2) {
+		SUCCEED() << "XInput2 extension not installed";
+		return;
+	}
+	int device = getXTestPointer();
+	ASSERT_NE(-1, device);
+
+	CTestEventQueue events;
+	CXWindowsScreen screen(":0.0", true, false, 0, &events);
+	CInputChannel channel(&events);
+	screen.setInputChannel(&channel);
+	screen.enable();
+	ASSERT_TRUE(screen.leave());
+	pump(events);
+	SInt32 dx, dy;
+	int other;
+	receiveMotion(channel, dx, dy, other);
+	int center = getPointerX();
+
+	// Xvfb has no tablet so pretend the XTest pointer is one.  its raw
+	// values are then positions, not deltas.
+	screen.setRelativeDevice(device, false);
+	moveBy(100, 0);
+	pump(events);
+
+	// the motion comes from MotionNotify instead, which warps the
+	// mouse back to the center
+	receiveMotion(channel, dx, dy, other);
+	EXPECT_EQ(100, dx);
+	EXPECT_EQ(0, dy);
+	EXPECT_EQ(center, getPointerX());
+
+	screen.setInputChannel(NULL);
+	screen.disable();
+}
+
+#endif
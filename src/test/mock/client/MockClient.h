@@ -31,7 +31,9 @@ class CMockClient : public CClient
 public:
 	CMockClient() : CClient() { }
 	MOCK_METHOD2(mouseMove, void(SInt32, SInt32));
+	MOCK_METHOD3(keyDown, void(KeyID, KeyModifierMask, KeyButton));
 	MOCK_METHOD1(setOptions, void(const COptionsList&));
 	MOCK_METHOD0(handshakeComplete, void());
 	MOCK_METHOD1(setDecryptIv, void(const UInt8*));
+	MOCK_METHOD0(flushFakeInput, void());
 };
@@ -30,6 +30,9 @@ public:
 	MOCK_CONST_METHOD0(getEventTarget, void*());
 	MOCK_CONST_METHOD2(getCursorPos, void(SInt32&, SInt32&));
 	MOCK_CONST_METHOD2(setJumpCursorPos, void(SInt32, SInt32));
+	MOCK_CONST_METHOD2(getClipboard, bool(ClipboardID, IClipboard*));
+	MOCK_METHOD5(enter, void(SInt32, SInt32, UInt32, KeyModifierMask, bool));
+	MOCK_METHOD0(leave, bool());
 	MOCK_METHOD1(reconfigure, void(UInt32));
 	MOCK_METHOD0(resetOptions, void());
 	MOCK_METHOD1(setOptions, void(const COptionsList&));
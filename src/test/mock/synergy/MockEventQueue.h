@@ -50,6 +50,7 @@ public:
 	MOCK_METHOD0(forCIpcServer, CIpcServerEvents&());
 	MOCK_METHOD0(forCIpcServerProxy, CIpcServerProxyEvents&());
 	MOCK_METHOD0(forIDataSocket, IDataSocketEvents&());
+	MOCK_METHOD0(forCAddressResolver, CAddressResolverEvents&());
 	MOCK_METHOD0(forIListenSocket, IListenSocketEvents&());
 	MOCK_METHOD0(forISocket, ISocketEvents&());
 	MOCK_METHOD0(forCOSXScreen, COSXScreenEvents&());
@@ -28,6 +28,8 @@ public:
 	MOCK_METHOD1(swap, void(CKeyMap&));
 	MOCK_METHOD0(finish, void());
 	MOCK_METHOD2(foreachKey, void(ForeachKeyCallback, void*));
+	MOCK_CONST_METHOD3(collectActiveModifiers, void(
+		SInt32, KeyModifierMask, ModifierToKeys&));
 	MOCK_METHOD1(addHalfDuplexModifier, void(KeyID));
 	MOCK_CONST_METHOD2(isHalfDuplex, bool(KeyID, KeyButton));
 	MOCK_CONST_METHOD7(mapKey, const CKeyMap::KeyItem*(
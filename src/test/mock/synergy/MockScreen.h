@@ -32,5 +32,8 @@ public:
 	MOCK_CONST_METHOD2(getCursorPos, void(SInt32&, SInt32&));
 	MOCK_METHOD0(resetOptions, void());
 	MOCK_METHOD1(setOptions, void(const COptionsList&));
+	MOCK_METHOD1(screensaver, void(bool));
 	MOCK_METHOD0(enable, void());
+	MOCK_METHOD0(flushFakeInput, void());
+	MOCK_METHOD1(setInputChannel, void(CInputChannel*));
 };
@@ -0,0 +1,63 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventDataPool.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+
+TEST(CEventDataPoolTests, alloc_freed_reused)
+{
+	void* a = CEventDataPool::alloc(8);
+	CEventDataPool::free(a);
+	void* b = CEventDataPool::alloc(12);
+	EXPECT_EQ(a, b);
+	CEventDataPool::free(b);
+}
+
+TEST(CEventDataPoolTests, alloc_usedUp_fromHeap)
+{
+	// more blocks than a pool has, all usable at once
+	std::vector<char*> blocks;
+	for (int i = 0; i < 1000; ++i) {
+		char* block = static_cast<char*>(CEventDataPool::alloc(40));
+		memset(block, i, 40);
+		blocks.push_back(block);
+	}
+	for (int i = 0; i < 1000; ++i) {
+		EXPECT_EQ(static_cast<char>(i), blocks[i][39]);
+		CEventDataPool::free(blocks[i]);
+	}
+}
+
+TEST(CEventDataPoolTests, free_mallocData_released)
+{
+#ifndef NDEBUG
+	UInt32 heapAllocations = CEventDataPool::getHeapAllocations();
+#endif
+	CEventDataPool::free(CEventDataPool::alloc(4096));
+#ifndef NDEBUG
+	EXPECT_EQ(heapAllocations + 1, CEventDataPool::getHeapAllocations());
+#endif
+
+	// data from anywhere else, like most events used to have
+	CEventDataPool::free(malloc(16));
+	CEventDataPool::free(NULL);
+}
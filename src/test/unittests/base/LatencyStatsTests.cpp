@@ -0,0 +1,83 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/LatencyStats.h"
+
+#include "test/global/gtest.h"
+
+TEST(CLatencyHistogramTests, getPercentile_empty_zero)
+{
+	CLatencyHistogram histogram;
+
+	EXPECT_EQ(0U, histogram.getCount());
+	EXPECT_EQ(0.0, histogram.getPercentile(50.0));
+}
+
+TEST(CLatencyHistogramTests, getPercentile_smallValues_exact)
+{
+	CLatencyHistogram histogram;
+	for (int i = 1; i <= 20; ++i) {
+		histogram.record(1.0e-9 * i + 1.0e-12);
+	}
+
+	EXPECT_EQ(20U, histogram.getCount());
+	EXPECT_NEAR(10.0e-9, histogram.getPercentile(50.0), 1.0e-12);
+	EXPECT_NEAR(20.0e-9, histogram.getPercentile(100.0), 1.0e-12);
+}
+
+TEST(CLatencyHistogramTests, getPercentile_spreadOfValues_withinBucket)
+{
+	// 1 to 1000 microseconds
+	CLatencyHistogram histogram;
+	for (int i = 1; i <= 1000; ++i) {
+		histogram.record(1.0e-6 * i);
+	}
+
+	// the percentile is the top of a bucket, at most 1/16th over
+	static const double percents[] = { 50.0, 90.0, 99.0, 99.9 };
+	for (size_t i = 0; i < sizeof(percents) / sizeof(percents[0]); ++i) {
+		double expected = 1.0e-8 * percents[i] * 1000.0;
+		double actual   = histogram.getPercentile(percents[i]);
+		EXPECT_LE(expected * 0.999, actual);
+		EXPECT_GE(expected * (1.0 + 1.0 / 16.0), actual);
+	}
+}
+
+TEST(CLatencyHistogramTests, record_outOfRange_clamped)
+{
+	CLatencyHistogram histogram;
+	histogram.record(-1.0);
+	histogram.record(3600.0);
+
+	EXPECT_EQ(2U, histogram.getCount());
+	EXPECT_EQ(0.0, histogram.getPercentile(50.0));
+	EXPECT_NEAR(4.295, histogram.getPercentile(100.0), 0.001);
+}
+
+TEST(CLatencyStatsTests, format_recordedStage_countShown)
+{
+	CLatencyStats::reset();
+	CLatencyStats::record(CLatencyStats::kRouting, 25.0e-6);
+
+	CString stats = CLatencyStats::format();
+
+	EXPECT_NE(CString::npos, stats.find("routing"));
+	EXPECT_NE(CString::npos, stats.find("socket write"));
+	EXPECT_EQ(1U, CLatencyStats::get(CLatencyStats::kRouting).getCount());
+	EXPECT_EQ(0U, CLatencyStats::get(CLatencyStats::kInject).getCount());
+	CLatencyStats::reset();
+}
@@ -0,0 +1,137 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/Unicode.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+
+// latin, cyrillic, CJK and a character outside the BMP
+static const char* s_mixed =
+	"plain ascii text, "
+	"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 "
+	"\xe4\xbd\xa0\xe5\xa5\xbd "
+	"\xf0\x9f\x98\x80\n";
+
+static CString
+makeText(size_t size)
+{
+	CString text;
+	text.reserve(size + 64);
+	while (text.size() < size) {
+		text += s_mixed;
+	}
+	return text;
+}
+
+static UInt16
+getUTF16(const CString& utf16, size_t i)
+{
+	UInt16 c;
+	memcpy(&c, utf16.data() + 2 * i, 2);
+	return c;
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_asciiAllLengths_roundTrips)
+{
+	// cover the vector and scalar parts of the ASCII fast path
+	for (size_t n = 0; n < 70; ++n) {
+		CString ascii;
+		for (size_t i = 0; i < n; ++i) {
+			ascii += static_cast<char>('!' + i % 90);
+		}
+
+		bool errors = true;
+		CString utf16 = CUnicode::UTF8ToUTF16(ascii, &errors);
+		EXPECT_FALSE(errors);
+		ASSERT_EQ(2 * n, utf16.size());
+		for (size_t i = 0; i < n; ++i) {
+			EXPECT_EQ(static_cast<UInt16>(ascii[i]), getUTF16(utf16, i));
+		}
+		EXPECT_EQ(ascii, CUnicode::UTF16ToUTF8(utf16));
+		EXPECT_EQ(ascii, CUnicode::UCS4ToUTF8(CUnicode::UTF8ToUCS4(ascii)));
+	}
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_mixedScripts_roundTrips)
+{
+	CString utf8 = makeText(200);
+
+	bool errors = true;
+	CString utf16 = CUnicode::UTF8ToUTF16(utf8, &errors);
+	EXPECT_FALSE(errors);
+	EXPECT_EQ(utf8, CUnicode::UTF16ToUTF8(utf16, &errors));
+	EXPECT_FALSE(errors);
+	EXPECT_EQ(utf8, CUnicode::UTF32ToUTF8(CUnicode::UTF8ToUTF32(utf8)));
+	EXPECT_TRUE(CUnicode::isUTF8(utf8));
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_nonBMP_surrogatePair)
+{
+	CString utf16 = CUnicode::UTF8ToUTF16("\xf0\x9f\x98\x80");
+
+	ASSERT_EQ(4, utf16.size());
+	EXPECT_EQ(0xd83d, getUTF16(utf16, 0));
+	EXPECT_EQ(0xde00, getUTF16(utf16, 1));
+}
+
+TEST(CUnicodeTests, UTF8ToUCS2_nonBMP_replacedWithError)
+{
+	bool errors = false;
+	CString ucs2 = CUnicode::UTF8ToUCS2("a\xf0\x9f\x98\x80", &errors);
+
+	EXPECT_TRUE(errors);
+	ASSERT_EQ(4, ucs2.size());
+	EXPECT_EQ('a', getUTF16(ucs2, 0));
+	EXPECT_EQ(0xfffd, getUTF16(ucs2, 1));
+}
+
+TEST(CUnicodeTests, UTF8ToUTF16_invalidByte_replacedWithoutError)
+{
+	bool errors = true;
+	CString utf16 = CUnicode::UTF8ToUTF16("a\x80z", &errors);
+
+	EXPECT_FALSE(errors);
+	ASSERT_EQ(6, utf16.size());
+	EXPECT_EQ(0xfffd, getUTF16(utf16, 1));
+	EXPECT_FALSE(CUnicode::isUTF8("a\x80z"));
+}
+
+TEST(CUnicodeTests, UTF16ToUTF8_byteSwapped_decoded)
+{
+	// byte order mark, then "ab" and U+0416, all byte swapped
+	CString utf16("\xfe\xff\x00\x61\x00\x62\x04\x16", 8);
+	bool isLittleEndian = (getUTF16(CString("\x01\x00", 2), 0) == 1);
+	if (!isLittleEndian) {
+		utf16 = CString("\xff\xfe\x61\x00\x62\x00\x16\x04", 8);
+	}
+
+	EXPECT_EQ("ab\xd0\x96", CUnicode::UTF16ToUTF8(utf16));
+}
+
+TEST(CUnicodeTests, UTF16ToUTF8_loneSurrogate_replacedWithError)
+{
+	UInt16 words[] = { 'a', 0xdc00, 'b' };
+	CString utf16(reinterpret_cast<const char*>(words), sizeof(words));
+
+	bool errors = false;
+	CString utf8 = CUnicode::UTF16ToUTF8(utf16, &errors);
+
+	EXPECT_TRUE(errors);
+	EXPECT_EQ("a\xef\xbf\xbd" "b", utf8);
+}
@@ -0,0 +1,208 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "test/mock/synergy/MockScreen.h"
+#include "client/Client.h"
+#include "net/AddressResolver.h"
+#include "net/TCPSocket.h"
+#include "net/TCPListenSocket.h"
+#include "net/SocketMultiplexer.h"
+#include "net/ISocketFactory.h"
+#include "net/NetworkAddress.h"
+#include "io/CryptoOptions.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::NiceMock;
+
+static const int		kPort     = 24803;
+static const int		kLivePort = 24804;
+static const int		kDeadPort = 24805;
+
+// resolves every host name to a server that never answers followed by
+// one that does
+class CRaceResolver : public CAddressResolver {
+public:
+	CRaceResolver(IEventQueue* events) : CAddressResolver(events) { }
+
+protected:
+	virtual std::vector<CNetworkAddress>
+						lookup(const CNetworkAddress&)
+	{
+		std::vector<CNetworkAddress> addresses;
+		addresses.push_back(
+			CNetworkAddress("127.0.0.1", kDeadPort).resolveAll()[0]);
+		addresses.push_back(
+			CNetworkAddress("127.0.0.1", kLivePort).resolveAll()[0]);
+		return addresses;
+	}
+};
+
+// a socket that drops its connect on the floor when it's for the dead
+// server, like a SYN into a firewall
+class CRaceSocket : public CTCPSocket {
+public:
+	CRaceSocket(IEventQueue* events, CSocketMultiplexer* multiplexer) :
+		CTCPSocket(events, multiplexer),
+		m_dead(false) { }
+
+	~CRaceSocket()
+	{
+		if (m_dead) {
+			++s_deadDeleted;
+		}
+	}
+
+	virtual void		connect(const CNetworkAddress& address)
+	{
+		if (address.getPort() == kDeadPort) {
+			m_dead = true;
+			++s_deadCreated;
+			return;
+		}
+		++s_liveCreated;
+		CTCPSocket::connect(address);
+	}
+
+public:
+	static int			s_deadCreated;
+	static int			s_deadDeleted;
+	static int			s_liveCreated;
+
+private:
+	bool				m_dead;
+};
+
+int CRaceSocket::s_deadCreated = 0;
+int CRaceSocket::s_deadDeleted = 0;
+int CRaceSocket::s_liveCreated = 0;
+
+class CRaceSocketFactory : public ISocketFactory {
+public:
+	CRaceSocketFactory(IEventQueue* events, CSocketMultiplexer* multiplexer) :
+		m_events(events),
+		m_multiplexer(multiplexer) { }
+
+	virtual IDataSocket*	create() const
+	{
+		return new CRaceSocket(m_events, m_multiplexer);
+	}
+
+	virtual IListenSocket*	createListen() const
+	{
+		return new CTCPListenSocket(m_events, m_multiplexer);
+	}
+
+private:
+	IEventQueue*		m_events;
+	CSocketMultiplexer*	m_multiplexer;
+};
+
+// waits for the client to settle on a server address
+class CRaceWatcher {
+public:
+	CRaceWatcher(IEventQueue* events, CClient* client) :
+		m_events(events),
+		m_client(client),
+		m_elapsed(-1.0) { }
+
+	double				run()
+	{
+		CEventQueueTimer* tick    = m_events->newTimer(0.01, NULL);
+		CEventQueueTimer* timeout = m_events->newOneShotTimer(10.0, NULL);
+		m_events->adoptHandler(CEvent::kTimer, tick,
+							new TMethodEventJob<CRaceWatcher>(this,
+								&CRaceWatcher::handleTick));
+		m_events->adoptHandler(CEvent::kTimer, timeout,
+							new TMethodEventJob<CRaceWatcher>(this,
+								&CRaceWatcher::handleTimeout));
+		m_timer.reset();
+		m_client->connect();
+		m_events->loop();
+		m_events->removeHandler(CEvent::kTimer, timeout);
+		m_events->deleteTimer(timeout);
+		m_events->removeHandler(CEvent::kTimer, tick);
+		m_events->deleteTimer(tick);
+		return m_elapsed;
+	}
+
+private:
+	void				handleTick(const CEvent&, void*)
+	{
+		if (m_client->getServerAddress().getPort() == kLivePort) {
+			m_elapsed = m_timer.getTime();
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+private:
+	IEventQueue*		m_events;
+	CClient*			m_client;
+	CStopwatch			m_timer;
+	double				m_elapsed;
+};
+
+TEST(CClientTests, connect_deadAndLiveServer_liveWinsAfterStagger)
+{
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CCryptoOptions cryptoOptions;
+	NiceMock<CMockScreen> screen;
+
+	CTCPListenSocket listener(&events, &multiplexer);
+	CNetworkAddress liveAddress("127.0.0.1", kLivePort);
+	liveAddress.resolve();
+	listener.bind(liveAddress);
+
+	CRaceSocket::s_deadCreated = 0;
+	CRaceSocket::s_deadDeleted = 0;
+	CRaceSocket::s_liveCreated = 0;
+
+	double elapsed;
+	{
+		CClient client(&events, "stub", CNetworkAddress("race", kPort),
+							new CRaceSocketFactory(&events, &multiplexer),
+							NULL, &screen, cryptoOptions, false);
+		client.setResolver(new CRaceResolver(&events));
+
+		CRaceWatcher watcher(&events, &client);
+		elapsed = watcher.run();
+
+		// the dead server was tried first and, once the live one
+		// connected, given up on
+		EXPECT_EQ(1, CRaceSocket::s_deadCreated);
+		EXPECT_EQ(1, CRaceSocket::s_liveCreated);
+		EXPECT_EQ(1, CRaceSocket::s_deadDeleted);
+	}
+
+	// the live server was only tried once the dead one had its chance
+	ASSERT_GE(elapsed, 0.0);
+	EXPECT_GE(elapsed, 0.25);
+
+	IDataSocket* accepted = listener.accept(NULL);
+	delete accepted;
+}
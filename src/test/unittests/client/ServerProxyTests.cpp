@@ -32,8 +32,8 @@ using ::testing::NiceMock;
 using ::testing::AnyNumber;
 using ::testing::ReturnRef;
 
-const UInt8 g_mouseMove_bufferLen = 16;
-UInt8 g_mouseMove_buffer[g_mouseMove_bufferLen];
+UInt32 g_mouseMove_bufferLen;
+UInt8 g_mouseMove_buffer[32];
 UInt32 g_mouseMove_bufferIndex;
 UInt32 mouseMove_mockRead(void* buffer, UInt32 n);
 
@@ -60,6 +60,36 @@ TEST(CServerProxyTests, mouseMove)
 	EXPECT_CALL(client, mouseMove(1, 2)).Times(1);
 	
 	const char data[] = "DSOP\0\0\0\0DMMV\0\1\0\2";
+	g_mouseMove_bufferLen = sizeof(data) - 1;
+	memcpy(g_mouseMove_buffer, data, g_mouseMove_bufferLen);
+
+	CServerProxy serverProxy(&client, &stream, &eventQueue);
+	serverProxy.handleDataForTest();
+}
+
+TEST(CServerProxyTests, compactInput)
+{
+	g_mouseMove_bufferIndex = 0;
+
+	NiceMock<CMockEventQueue> eventQueue;
+	NiceMock<CMockStream> stream;
+	NiceMock<CMockClient> client;
+	IStreamEvents streamEvents;
+	streamEvents.setEvents(&eventQueue);
+	
+	ON_CALL(eventQueue, forIStream()).WillByDefault(ReturnRef(streamEvents));
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(mouseMove_mockRead));
+
+	// coordinates beyond 16 bits, then a delta, then a 17 bit key id
+	EXPECT_CALL(client, mouseMove(70000, 2)).Times(1);
+	EXPECT_CALL(client, mouseMove(69999, 5)).Times(1);
+	EXPECT_CALL(client, keyDown(0x1000f, 0, 38)).Times(1);
+	
+	const char data[] = "DSOP\0\0\0\0"
+						"\001\340\305\010\004"
+						"\002\001\006"
+						"\005\217\200\004\000\046";
+	g_mouseMove_bufferLen = sizeof(data) - 1;
 	memcpy(g_mouseMove_buffer, data, g_mouseMove_bufferLen);
 
 	CServerProxy serverProxy(&client, &stream, &eventQueue);
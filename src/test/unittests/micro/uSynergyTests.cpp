@@ -0,0 +1,232 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "micro/uSynergy.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+// a server stream fed to the client a network packet at a time, and
+// what the client made of it
+class CFeed {
+public:
+	CFeed() :
+		m_offset(0),
+		m_chunk(1460),
+		m_connects(0),
+		m_x(0),
+		m_y(0),
+		m_clipboardBytes(0),
+		m_clipboardErrors(0),
+		m_clipboardPiece(0),
+		m_xAtClipboard(0)
+	{
+	}
+
+	void				addMessage(const char* code, const std::vector<uint8_t>& body)
+	{
+		uint32_t length = 4 + static_cast<uint32_t>(body.size());
+		addUInt32(length);
+		m_data.insert(m_data.end(), code, code + 4);
+		m_data.insert(m_data.end(), body.begin(), body.end());
+	}
+
+	void				addUInt32(uint32_t value)
+	{
+		m_data.push_back(static_cast<uint8_t>(value >> 24));
+		m_data.push_back(static_cast<uint8_t>(value >> 16));
+		m_data.push_back(static_cast<uint8_t>(value >> 8));
+		m_data.push_back(static_cast<uint8_t>(value));
+	}
+
+	void				addMoves(int first, int count)
+	{
+		for (int i = first; i < first + count; ++i) {
+			std::vector<uint8_t> body;
+			body.push_back(static_cast<uint8_t>(i >> 8));
+			body.push_back(static_cast<uint8_t>(i));
+			body.push_back(static_cast<uint8_t>((2 * i) >> 8));
+			body.push_back(static_cast<uint8_t>(2 * i));
+			addMessage("DMMV", body);
+		}
+	}
+
+	// a clipboard with \p text as text and \p htmlSize bytes of
+	// pattern as html
+	void				addClipboard(const char* text, uint32_t htmlSize)
+	{
+		uint32_t textSize = static_cast<uint32_t>(strlen(text));
+		uint32_t stringSize = 4 + 8 + textSize + 8 + htmlSize;
+		uint32_t length = 4 + 1 + 4 + 4 + stringSize;
+		addUInt32(length);
+		m_data.insert(m_data.end(), "DCLP", "DCLP" + 4);
+		m_data.push_back(0);
+		addUInt32(0);
+		addUInt32(stringSize);
+		addUInt32(2);
+		addUInt32(USYNERGY_CLIPBOARD_FORMAT_TEXT);
+		addUInt32(textSize);
+		m_data.insert(m_data.end(), text, text + textSize);
+		addUInt32(USYNERGY_CLIPBOARD_FORMAT_HTML);
+		addUInt32(htmlSize);
+		for (uint32_t i = 0; i < htmlSize; ++i) {
+			m_data.push_back(pattern(i));
+		}
+	}
+
+	static uint8_t		pattern(uint32_t i) { return static_cast<uint8_t>(i * 31 + (i >> 16)); }
+
+	std::vector<uint8_t>	m_data;
+	size_t				m_offset;
+	size_t				m_chunk;
+	int					m_connects;
+	int					m_x, m_y;
+	std::string			m_text;
+	uint32_t			m_clipboardBytes;
+	uint32_t			m_clipboardErrors;
+	uint32_t			m_clipboardPiece;
+	int					m_xAtClipboard;
+	std::vector<uint32_t>	m_completed;
+};
+
+static uSynergyBool
+feedConnect(uSynergyCookie cookie)
+{
+	return ++reinterpret_cast<CFeed*>(cookie)->m_connects == 1;
+}
+
+static uSynergyBool
+feedSend(uSynergyCookie, const uint8_t*, int)
+{
+	return USYNERGY_TRUE;
+}
+
+static uSynergyBool
+feedReceive(uSynergyCookie cookie, uint8_t* buffer, int maxLength, int* outLength)
+{
+	CFeed* feed = reinterpret_cast<CFeed*>(cookie);
+	size_t n = feed->m_data.size() - feed->m_offset;
+	if (n > feed->m_chunk) {
+		n = feed->m_chunk;
+	}
+	if (n > static_cast<size_t>(maxLength)) {
+		n = static_cast<size_t>(maxLength);
+	}
+	if (n != 0) {
+		memcpy(buffer, &feed->m_data[feed->m_offset], n);
+	}
+	feed->m_offset += n;
+	*outLength = static_cast<int>(n);
+	return USYNERGY_TRUE;
+}
+
+static uint32_t
+feedGetTime()
+{
+	return 0;
+}
+
+static void
+feedMouse(uSynergyCookie cookie, uint16_t x, uint16_t y, int16_t, int16_t,
+				uSynergyBool, uSynergyBool, uSynergyBool)
+{
+	CFeed* feed = reinterpret_cast<CFeed*>(cookie);
+	feed->m_x = x;
+	feed->m_y = y;
+}
+
+static void
+feedClipboard(uSynergyCookie cookie, enum uSynergyClipboardFormat format,
+				uint32_t totalSize, uint32_t offset, const uint8_t* data, uint32_t size)
+{
+	CFeed* feed = reinterpret_cast<CFeed*>(cookie);
+	if (format == USYNERGY_CLIPBOARD_FORMAT_TEXT) {
+		feed->m_text.append(reinterpret_cast<const char*>(data), size);
+	}
+	else {
+		if (offset == 0 && size != 0) {
+			feed->m_xAtClipboard = feed->m_x;
+		}
+		for (uint32_t i = 0; i < size; ++i) {
+			if (data[i] != CFeed::pattern(offset + i)) {
+				++feed->m_clipboardErrors;
+			}
+		}
+		feed->m_clipboardBytes += size;
+		if (size > feed->m_clipboardPiece) {
+			feed->m_clipboardPiece = size;
+		}
+	}
+	if (offset + size == totalSize) {
+		feed->m_completed.push_back(totalSize);
+	}
+}
+
+TEST(uSynergyTests, poll_hugeClipboardBetweenMoves_streamedInPieces)
+{
+	static const uint32_t kClipboardSize = 10 * 1024 * 1024;
+
+	CFeed feed;
+	std::vector<uint8_t> hello;
+	hello.push_back('r');
+	hello.push_back('g');
+	hello.push_back('y');
+	hello.push_back(0);
+	hello.push_back(1);
+	hello.push_back(0);
+	hello.push_back(4);
+	feed.addMessage("Syne", hello);
+	feed.addMessage("CINN", std::vector<uint8_t>(10, 0));
+	feed.addMoves(1, 100);
+	feed.addClipboard("big", kClipboardSize);
+	feed.addMoves(101, 100);
+	feed.addClipboard("hello", 0);
+	feed.addMoves(201, 100);
+
+	uSynergyContext context;
+	uSynergyInit(&context);
+	context.m_connectFunc             = &feedConnect;
+	context.m_sendFunc                = &feedSend;
+	context.m_receiveFunc             = &feedReceive;
+	context.m_getTimeFunc             = &feedGetTime;
+	context.m_clientName              = "micro";
+	context.m_cookie                  = reinterpret_cast<uSynergyCookie>(&feed);
+	context.m_mouseCallback           = &feedMouse;
+	context.m_clipboardChunkCallback  = &feedClipboard;
+
+	while (feed.m_offset < feed.m_data.size()) {
+		ASSERT_TRUE(uSynergyPoll(&context));
+	}
+
+	// the clipboard came through whole, in pieces no bigger than what
+	// the client could receive at once
+	EXPECT_EQ(1, feed.m_connects);
+	EXPECT_EQ(kClipboardSize, feed.m_clipboardBytes);
+	EXPECT_EQ(0u, feed.m_clipboardErrors);
+	EXPECT_LE(feed.m_clipboardPiece, static_cast<uint32_t>(USYNERGY_RECEIVE_BUFFER_SIZE));
+	EXPECT_EQ("bighello", feed.m_text);
+	ASSERT_EQ(4u, feed.m_completed.size());
+	EXPECT_EQ(kClipboardSize, feed.m_completed[1]);
+	EXPECT_EQ(0u, feed.m_completed[3]);
+
+	// and the moves on either side weren't lost or held back
+	EXPECT_EQ(100, feed.m_xAtClipboard);
+	EXPECT_EQ(300, feed.m_x);
+	EXPECT_EQ(600, feed.m_y);
+}
@@ -0,0 +1,208 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012 Bolton Software Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/mock/synergy/MockEventQueue.h"
+#include "net/AddressResolver.h"
+#include "net/XSocket.h"
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "arch/Arch.h"
+#include "base/EventTypes.h"
+#include "base/Stopwatch.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::ReturnRef;
+
+static const int		kPort = 24800;
+
+// a name server that takes its time.  "slow" resolves to two loopback
+// addresses, anything else is unknown.
+class CStubResolver : public CAddressResolver {
+public:
+	CStubResolver(IEventQueue* events, double delay, double ttl = 60.0) :
+		CAddressResolver(events, ttl),
+		m_delay(delay),
+		m_lookups(0) { }
+
+	int					getLookups() const { return m_lookups; }
+
+protected:
+	virtual std::vector<CNetworkAddress>
+						lookup(const CNetworkAddress& address)
+	{
+		++m_lookups;
+		ARCH->sleep(m_delay);
+		if (address.getHostname() != "slow") {
+			throw XSocketAddress(XSocketAddress::kNotFound,
+								address.getHostname(), address.getPort());
+		}
+		std::vector<CNetworkAddress> addresses;
+		addresses.push_back(
+			CNetworkAddress("127.0.0.1", address.getPort()).resolveAll()[0]);
+		addresses.push_back(
+			CNetworkAddress("127.0.0.2", address.getPort()).resolveAll()[0]);
+		return addresses;
+	}
+
+private:
+	double				m_delay;
+	int					m_lookups;
+};
+
+// collects the events the resolver sends from its thread
+class CEventSink {
+public:
+	CEventSink() : m_mutex(), m_ready(&m_mutex, false) { }
+
+	void				addEvent(const CEvent& event)
+	{
+		CLock lock(&m_mutex);
+		m_targets.push_back(event.getTarget());
+		m_ready.broadcast();
+	}
+
+	// waits for the next event and returns its target, or NULL
+	void*				waitForEvent(double timeout)
+	{
+		CLock lock(&m_mutex);
+		CStopwatch timer;
+		while (m_targets.empty() && timer.getTime() < timeout) {
+			m_ready.wait(timer, timeout);
+		}
+		if (m_targets.empty()) {
+			return NULL;
+		}
+		void* target = m_targets.front();
+		m_targets.erase(m_targets.begin());
+		return target;
+	}
+
+private:
+	CMutex				m_mutex;
+	CCondVar<bool>		m_ready;
+	std::vector<void*>	m_targets;
+};
+
+class CAddressResolverTests : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		m_resolverEvents.setEvents(&m_eventQueue);
+		ON_CALL(m_eventQueue, forCAddressResolver())
+			.WillByDefault(ReturnRef(m_resolverEvents));
+		ON_CALL(m_eventQueue, addEvent(_))
+			.WillByDefault(Invoke(&m_sink, &CEventSink::addEvent));
+	}
+
+	NiceMock<CMockEventQueue>	m_eventQueue;
+	CAddressResolverEvents		m_resolverEvents;
+	CEventSink					m_sink;
+};
+
+TEST_F(CAddressResolverTests, resolve_slowNameServer_doesNotBlock)
+{
+	CStubResolver resolver(&m_eventQueue, 0.5);
+
+	CStopwatch timer;
+	CAddressResolver::CRequest* request =
+		resolver.resolve(CNetworkAddress("slow", kPort));
+
+	// the lookup is still going on
+	std::vector<CNetworkAddress> addresses;
+	CString error;
+	EXPECT_FALSE(resolver.takeResult(request, addresses, error));
+
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	EXPECT_GE(timer.getTime(), 0.5);
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	ASSERT_EQ(2, addresses.size());
+	EXPECT_EQ(kPort, addresses[0].getPort());
+	EXPECT_EQ("127.0.0.1", ARCH->addrToString(addresses[0].getAddress()));
+	EXPECT_EQ("127.0.0.2", ARCH->addrToString(addresses[1].getAddress()));
+}
+
+TEST_F(CAddressResolverTests, resolve_again_usesCache)
+{
+	CStubResolver resolver(&m_eventQueue, 0.2);
+	CNetworkAddress address("slow", kPort);
+	std::vector<CNetworkAddress> addresses;
+	CString error;
+
+	CAddressResolver::CRequest* request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+
+	request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	EXPECT_EQ(2, addresses.size());
+	EXPECT_EQ(1, resolver.getLookups());
+}
+
+TEST_F(CAddressResolverTests, resolve_afterTTL_looksUpAgain)
+{
+	CStubResolver resolver(&m_eventQueue, 0.0, 0.1);
+	CNetworkAddress address("slow", kPort);
+	std::vector<CNetworkAddress> addresses;
+	CString error;
+
+	CAddressResolver::CRequest* request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	ARCH->sleep(0.2);
+
+	request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	EXPECT_EQ(2, resolver.getLookups());
+}
+
+TEST_F(CAddressResolverTests, resolve_unknownHost_failsAndIsNotCached)
+{
+	CStubResolver resolver(&m_eventQueue, 0.0);
+	CNetworkAddress address("unknown", kPort);
+	std::vector<CNetworkAddress> addresses;
+	CString error;
+
+	CAddressResolver::CRequest* request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	EXPECT_TRUE(addresses.empty());
+	EXPECT_FALSE(error.empty());
+
+	request = resolver.resolve(address);
+	ASSERT_EQ(request, m_sink.waitForEvent(5.0));
+	ASSERT_TRUE(resolver.takeResult(request, addresses, error));
+	EXPECT_EQ(2, resolver.getLookups());
+}
+
+TEST_F(CAddressResolverTests, cancel_duringLookup_noEvent)
+{
+	CStubResolver resolver(&m_eventQueue, 0.2);
+
+	CAddressResolver::CRequest* request =
+		resolver.resolve(CNetworkAddress("slow", kPort));
+	ARCH->sleep(0.05);
+	resolver.cancel(request);
+
+	EXPECT_TRUE(m_sink.waitForEvent(0.5) == NULL);
+}
@@ -0,0 +1,158 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/TCPSocket.h"
+#include "net/TCPListenSocket.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "synergy/PacketStreamFilter.h"
+#include "arch/Arch.h"
+#include "base/EventQueue.h"
+#include "base/Stopwatch.h"
+#include "base/LatencyStats.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+static const int		kPort = 24803;
+
+// bounces packets between two sockets, like a server and a client
+// exchanging input and replies
+class CPingPong {
+public:
+	CPingPong(IEventQueue* events, CPacketStreamFilter* client,
+							CPacketStreamFilter* server) :
+		m_events(events),
+		m_client(client),
+		m_server(server),
+		m_received(0),
+		m_wanted(0)
+	{
+		m_events->adoptHandler(m_events->forIStream().inputReady(),
+							m_server->getEventTarget(),
+							new TMethodEventJob<CPingPong>(this,
+								&CPingPong::handleServerData));
+		m_events->adoptHandler(m_events->forIStream().inputReady(),
+							m_client->getEventTarget(),
+							new TMethodEventJob<CPingPong>(this,
+								&CPingPong::handleClientData));
+	}
+
+	~CPingPong()
+	{
+		m_events->removeHandler(m_events->forIStream().inputReady(),
+							m_server->getEventTarget());
+		m_events->removeHandler(m_events->forIStream().inputReady(),
+							m_client->getEventTarget());
+	}
+
+	// send \p count messages from the client one after the other
+	bool				run(UInt32 count)
+	{
+		m_received = 0;
+		m_wanted   = count;
+		CEventQueueTimer* timer = m_events->newOneShotTimer(10.0, NULL);
+		m_events->adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CPingPong>(this,
+								&CPingPong::handleTimeout));
+		m_client->write(kMessage, sizeof(kMessage));
+		m_events->loop();
+		m_events->removeHandler(CEvent::kTimer, timer);
+		m_events->deleteTimer(timer);
+		return (m_received == count);
+	}
+
+private:
+	void				handleServerData(const CEvent&, void*)
+	{
+		// echo
+		UInt32 size;
+		const UInt8* packet;
+		while ((packet = m_server->peekPacket(size)) != NULL) {
+			m_server->write(packet, size);
+			m_server->popPacket();
+		}
+	}
+
+	void				handleClientData(const CEvent&, void*)
+	{
+		UInt32 size;
+		while (m_client->peekPacket(size) != NULL) {
+			m_client->popPacket();
+			if (++m_received < m_wanted) {
+				m_client->write(kMessage, sizeof(kMessage));
+			}
+			else {
+				m_events->addEvent(CEvent(CEvent::kQuit));
+			}
+		}
+	}
+
+	void				handleTimeout(const CEvent&, void*)
+	{
+		m_events->addEvent(CEvent(CEvent::kQuit));
+	}
+
+public:
+	static const UInt8	kMessage[8];
+
+	IEventQueue*		m_events;
+	CPacketStreamFilter*	m_client;
+	CPacketStreamFilter*	m_server;
+	UInt32				m_received;
+	UInt32				m_wanted;
+};
+
+// a mouse move
+const UInt8 CPingPong::kMessage[8] = { 'D', 'M', 'M', 'V', 0, 1, 0, 2 };
+
+TEST(CTCPSocketTests, write_recordWriteLatency_onlyWhenSet)
+{
+	CEventQueue events;
+	CSocketMultiplexer multiplexer;
+	CNetworkAddress address("127.0.0.1", kPort);
+	address.resolve();
+
+	CTCPListenSocket listener(&events, &multiplexer);
+	listener.bind(address);
+	CTCPSocket client(&events, &multiplexer);
+	client.connect(address);
+
+	IDataSocket* server = NULL;
+	CStopwatch timer;
+	while ((server = listener.accept(NULL)) == NULL && timer.getTime() < 5.0) {
+		ARCH->sleep(0.01);
+	}
+	ASSERT_TRUE(server != NULL);
+
+	const CLatencyHistogram& writes =
+		CLatencyStats::get(CLatencyStats::kSocketWrite);
+	{
+		CPacketStreamFilter clientStream(&events, &client, false);
+		CPacketStreamFilter serverStream(&events, server, false);
+		CPingPong pingPong(&events, &clientStream, &serverStream);
+
+		CLatencyStats::reset();
+		ASSERT_TRUE(pingPong.run(10));
+		EXPECT_EQ(0u, writes.getCount());
+
+		client.setRecordWriteLatency(true);
+		ASSERT_TRUE(pingPong.run(10));
+		EXPECT_LT(0u, writes.getCount());
+	}
+	delete server;
+}
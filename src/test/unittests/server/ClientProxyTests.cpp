@@ -20,6 +20,12 @@
 #include "test/mock/io/MockCryptoStream.h"
 #include "test/mock/synergy/MockEventQueue.h"
 #include "server/ClientProxy1_4.h"
+#include "server/ClientProxy1_7.h"
+#include "server/ClientProxy1_8.h"
+#include "server/KeyBroadcast.h"
+#include "synergy/PacketStreamFilter.h"
+#include "synergy/IKeyState.h"
+#include "base/Log.h"
 
 #include "test/global/gtest.h"
 
@@ -36,6 +42,84 @@ UInt32 g_cryptoIvWrite_readBufferIndex;
 void cryptoIv_mockWrite(const void* in, UInt32 n);
 UInt8 cryptoIv_mockRead(void* out, UInt32 n);
 
+// counts what a proxy puts on the wire
+class CWriteCounter {
+public:
+	CWriteCounter() : m_writes(0), m_bytes(0) { }
+
+	void				write(const void*, UInt32 n) { ++m_writes; m_bytes += n; }
+
+	UInt32				m_writes;
+	UInt32				m_bytes;
+};
+
+// keeps everything a proxy writes, without the cost of a mock
+class CCaptureStream : public synergy::IStream {
+public:
+	CCaptureStream() : m_writes(0) { }
+
+	virtual void		close() { }
+	virtual UInt32		read(void*, UInt32) { return 0; }
+	virtual void		write(const void* buffer, UInt32 n)
+	{
+		++m_writes;
+		m_data.append(static_cast<const char*>(buffer), n);
+	}
+	virtual void		flush() { }
+	virtual void		shutdownInput() { }
+	virtual void		shutdownOutput() { }
+	virtual void*		getEventTarget() const { return const_cast<CCaptureStream*>(this); }
+	virtual bool		isReady() const { return false; }
+	virtual UInt32		getSize() const { return 0; }
+
+	UInt32				m_writes;
+	CString				m_data;
+};
+
+// a burst of input as the server sends it:  many passes through the
+// event queue, each with a few mouse moves and now and then a key.
+// returns what went on the wire.
+template <class T>
+static CWriteCounter
+sendInputBurst(bool flushEachPass)
+{
+	NiceMock<CMockEventQueue> eventQueue;
+	NiceMock<CMockStream> innerStream;
+	NiceMock<CMockServer> server;
+	IStreamEvents streamEvents;
+	CClientProxyEvents clientProxyEvents;
+	streamEvents.setEvents(&eventQueue);
+	clientProxyEvents.setEvents(&eventQueue);
+	CWriteCounter counter;
+
+	ON_CALL(eventQueue, forIStream()).WillByDefault(ReturnRef(streamEvents));
+	ON_CALL(eventQueue, forCClientProxy()).WillByDefault(ReturnRef(clientProxyEvents));
+	ON_CALL(innerStream, write(_, _)).WillByDefault(Invoke(&counter, &CWriteCounter::write));
+
+	T clientProxy("stub",
+		new CPacketStreamFilter(&eventQueue, &innerStream, false),
+		&server, &eventQueue);
+	clientProxy.enter(2000, 500, 0, 0, false);
+	counter = CWriteCounter();
+
+	SInt32 x = 2000, y = 500;
+	for (int pass = 0; pass < 100; ++pass) {
+		for (int i = 0; i < 10; ++i) {
+			x += 3;
+			y -= 2;
+			clientProxy.mouseMove(x, y);
+		}
+		if (pass % 10 == 0) {
+			clientProxy.keyDown('a', 0, 38);
+			clientProxy.keyUp('a', 0, 38);
+		}
+		if (flushEachPass) {
+			static_cast<CClientProxy1_8&>(clientProxy).flushInputForTest();
+		}
+	}
+	return counter;
+}
+
 TEST(CClientProxyTests, cryptoIvWrite)
 {
 	g_cryptoIvWrite_writeBufferIndex = 0;
@@ -117,6 +201,95 @@ TEST(CClientProxyTests, cryptoIvWrite)
 	EXPECT_EQ('P', buffer[3]);
 }
 
+TEST(CClientProxyTests, compactInput_fewerBytesAndPackets)
+{
+	CWriteCounter regular = sendInputBurst<CClientProxy1_7>(false);
+	CWriteCounter compact = sendInputBurst<CClientProxy1_8>(true);
+
+	LOG((CLOG_INFO "1000 moves, 20 keys: 1.7 %d bytes in %d packets, 1.8 %d bytes in %d packets",
+		regular.m_bytes, regular.m_writes, compact.m_bytes, compact.m_writes));
+
+	// one packet per message versus one per pass
+	EXPECT_EQ(1020, regular.m_writes);
+	EXPECT_EQ(100, compact.m_writes);
+
+	// 12 bytes per move versus 3
+	EXPECT_LT(compact.m_bytes * 3, regular.m_bytes);
+}
+
+// types 1000 keys to 16 clients the way the server broadcasts them.
+// either every client is looked up in the screen list and encodes the
+// key itself or the key goes out through a CKeyBroadcast.  returns what
+// the last client got.
+static CString
+broadcastTyping(bool shared)
+{
+	static const UInt32 kClients = 16;
+	static const UInt32 kKeys    = 1000;
+
+	NiceMock<CMockEventQueue> eventQueue;
+	NiceMock<CMockServer> server;
+	IStreamEvents streamEvents;
+	CClientProxyEvents clientProxyEvents;
+	streamEvents.setEvents(&eventQueue);
+	clientProxyEvents.setEvents(&eventQueue);
+	ON_CALL(eventQueue, forIStream()).WillByDefault(ReturnRef(streamEvents));
+	ON_CALL(eventQueue, forCClientProxy()).WillByDefault(ReturnRef(clientProxyEvents));
+
+	CString screens(":");
+	std::vector<CString> names;
+	std::vector<CCaptureStream*> streams;
+	std::vector<CClientProxy*> clients;
+	for (UInt32 i = 0; i < kClients; ++i) {
+		names.push_back(synergy::string::sprintf("screen%d", i));
+		screens += names.back() + ":";
+		streams.push_back(new CCaptureStream);
+		clients.push_back(new CClientProxy1_6(names.back(),
+							streams.back(), &server, &eventQueue));
+		streams.back()->m_data.clear();
+	}
+
+	for (UInt32 n = 0; n < kKeys; ++n) {
+		KeyID id = 'a' + n % 26;
+		for (int press = 1; press >= 0; --press) {
+			if (shared) {
+				CKeyBroadcast key(press != 0, id, 0, 38);
+				for (UInt32 i = 0; i < kClients; ++i) {
+					clients[i]->sendKey(key);
+				}
+			}
+			else {
+				for (UInt32 i = 0; i < kClients; ++i) {
+					if (IKeyState::CKeyInfo::contains(screens.c_str(), names[i])) {
+						if (press) {
+							clients[i]->keyDown(id, 0, 38);
+						}
+						else {
+							clients[i]->keyUp(id, 0, 38);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	CString wire = streams.back()->m_data;
+	for (UInt32 i = 0; i < kClients; ++i) {
+		delete clients[i];
+	}
+	return wire;
+}
+
+TEST(CClientProxyTests, sendKey_broadcastTo16Clients_sameWire)
+{
+	CString regularWire = broadcastTyping(false);
+	CString sharedWire  = broadcastTyping(true);
+
+	// the clients can't tell the difference
+	EXPECT_EQ(2000u * 10, sharedWire.size());
+	EXPECT_TRUE(regularWire == sharedWire);
+}
+
 void
 cryptoIv_mockWrite(const void* in, UInt32 n)
 {
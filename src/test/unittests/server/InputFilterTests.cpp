@@ -0,0 +1,95 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "server/InputFilter.h"
+#include "synergy/IKeyState.h"
+#include "synergy/IPrimaryScreen.h"
+#include "base/EventQueue.h"
+#include "base/EventDataPool.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+
+// counts the events the filter passes on to the server
+class CPassCounter {
+public:
+	CPassCounter() : m_count(0) { }
+
+	void				handle(const CEvent&, void*) { ++m_count; }
+
+	UInt32				m_count;
+};
+
+// sends keys and mouse buttons through a filter with \p numRules mouse
+// button rules, none of which match most of the input.  returns how
+// many events were passed on.
+static UInt32
+filterInput(UInt32 numRules)
+{
+	CEventQueue events;
+	CInputFilter filter(&events);
+	for (UInt32 i = 0; i < numRules; ++i) {
+		// every rule has a different button and modifier combination
+		filter.addFilterRule(CInputFilter::CRule(
+			new CInputFilter::CMouseButtonCondition(&events,
+							static_cast<ButtonID>(1 + i % 8), i / 8)));
+	}
+
+	CPassCounter counter;
+	CEvent::Type types[] = {
+		events.forIKeyState().keyDown(),
+		events.forIKeyState().keyUp(),
+		events.forIPrimaryScreen().buttonDown(),
+		events.forIPrimaryScreen().buttonDown()
+	};
+	for (size_t i = 0; i < 3; ++i) {
+		events.adoptHandler(types[i], &filter,
+							new TMethodEventJob<CPassCounter>(&counter,
+								&CPassCounter::handle));
+	}
+
+	// the last button matches the rule for button 2 with shift, if
+	// there is one.  caps lock doesn't count for mouse buttons.
+	void* data[] = {
+		IKeyState::CKeyInfo::alloc('a', 0, 38, 1),
+		IKeyState::CKeyInfo::alloc('a', 0, 38, 1),
+		IPrimaryScreen::CButtonInfo::alloc(1, KeyModifierShift |
+							KeyModifierControl | KeyModifierAlt |
+							KeyModifierMeta | KeyModifierSuper),
+		IPrimaryScreen::CButtonInfo::alloc(2, KeyModifierShift |
+							KeyModifierCapsLock)
+	};
+	for (size_t i = 0; i < 4; ++i) {
+		filter.handleEventForTest(CEvent(types[i], NULL, data[i]));
+	}
+
+	for (size_t i = 0; i < 4; ++i) {
+		CEventDataPool::free(data[i]);
+	}
+	return counter.m_count;
+}
+
+TEST(CInputFilterTests, handleEvent_indexedRules_onlyMatchingCaught)
+{
+	// only the button with shift gets caught, and only if there's a rule
+	EXPECT_EQ(4, filterInput(0));
+	EXPECT_EQ(3, filterInput(10));
+	EXPECT_EQ(3, filterInput(200));
+}
@@ -0,0 +1,144 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/InputChannel.h"
+#include "synergy/IPrimaryScreen.h"
+#include "base/EventQueue.h"
+#include "base/TMethodEventJob.h"
+#include "common/stdvector.h"
+
+#include "test/global/gtest.h"
+
+// takes input the way CServer does, either from an input channel or
+// as one motionOnPrimary event each, and quits the event loop once it
+// has had the expected amount
+class CInputReceiver {
+public:
+	CInputReceiver(IEventQueue* events, CInputChannel* channel) :
+		m_events(events),
+		m_channel(channel),
+		m_wanted(0)
+	{
+		m_events->adoptHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_channel->getEventTarget(),
+							new TMethodEventJob<CInputReceiver>(this,
+								&CInputReceiver::handleInputReady));
+		m_events->adoptHandler(m_events->forIPrimaryScreen().motionOnPrimary(),
+							this,
+							new TMethodEventJob<CInputReceiver>(this,
+								&CInputReceiver::handleMotion));
+	}
+
+	~CInputReceiver()
+	{
+		m_events->removeHandler(m_events->forIPrimaryScreen().inputReady(),
+							m_channel->getEventTarget());
+		m_events->removeHandler(m_events->forIPrimaryScreen().motionOnPrimary(),
+							this);
+	}
+
+	// run the event loop until \p count more inputs have come in
+	void				run(size_t count)
+	{
+		m_wanted = m_received.size() + count;
+		m_events->loop();
+	}
+
+private:
+	void				handleInputReady(const CEvent& event, void*)
+	{
+		CInputChannel::CInput input;
+		while (m_channel->receive(input)) {
+			onInput(input.m_x);
+		}
+		const CInputChannel::CInput* overflow =
+			m_channel->receiveOverflow(event);
+		if (overflow != NULL) {
+			onInput(overflow->m_x);
+		}
+	}
+
+	void				handleMotion(const CEvent& event, void*)
+	{
+		IPrimaryScreen::CMotionInfo* info =
+			static_cast<IPrimaryScreen::CMotionInfo*>(event.getData());
+		onInput(info->m_x);
+	}
+
+	void				onInput(SInt32 x)
+	{
+		m_received.push_back(x);
+		if (m_received.size() == m_wanted) {
+			m_events->addEvent(CEvent(CEvent::kQuit));
+		}
+	}
+
+public:
+	IEventQueue*		m_events;
+	CInputChannel*		m_channel;
+	size_t				m_wanted;
+	std::vector<SInt32>	m_received;
+};
+
+TEST(CInputChannelTests, send_moreThanFits_receivedInOrder)
+{
+	CEventQueue events;
+	CInputChannel channel(&events, 4);
+	CInputReceiver receiver(&events, &channel);
+
+	// the first four go in the ring and the rest go through the event
+	// queue.  once the receiver has caught up the ring is used again.
+	for (SInt32 i = 0; i < 10; ++i) {
+		channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, i, 0);
+	}
+	receiver.run(10);
+	for (SInt32 i = 10; i < 13; ++i) {
+		channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, i, 0);
+	}
+	receiver.run(3);
+
+	ASSERT_EQ(13U, receiver.m_received.size());
+	for (SInt32 i = 0; i < 13; ++i) {
+		EXPECT_EQ(i, receiver.m_received[i]);
+	}
+}
+
+TEST(CInputChannelTests, addEvent_betweenInput_keepsItsPlace)
+{
+	CEventQueue events;
+	CInputChannel channel(&events);
+	CInputReceiver receiver(&events, &channel);
+
+	// the event lands behind the inputReady event for the first motion
+	// but mustn't let the second one overtake it
+	channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, 0, 0);
+	channel.addEvent(CEvent(events.forIPrimaryScreen().motionOnPrimary(),
+							&receiver, IPrimaryScreen::CMotionInfo::alloc(1, 0)));
+	channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, 2, 0);
+	receiver.run(3);
+
+	// and with nothing waiting it just goes in the queue
+	channel.addEvent(CEvent(events.forIPrimaryScreen().motionOnPrimary(),
+							&receiver, IPrimaryScreen::CMotionInfo::alloc(3, 0)));
+	channel.sendMotion(CInputChannel::CInput::kMotionOnPrimary, 4, 0);
+	receiver.run(2);
+
+	ASSERT_EQ(5U, receiver.m_received.size());
+	for (SInt32 i = 0; i < 5; ++i) {
+		EXPECT_EQ(i, receiver.m_received[i]);
+	}
+}
@@ -0,0 +1,144 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/InputTrace.h"
+#include "common/stdsstream.h"
+#include "common/stdfstream.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdio>
+#if SYSAPI_UNIX
+#	include <sys/stat.h>
+#endif
+
+static
+CInputTrace::CRecord
+makeInput(double time, CInputChannel::CInput::EType type)
+{
+	CInputTrace::CRecord record;
+	record.m_type              = CInputTrace::CRecord::kInput;
+	record.m_time              = time;
+	record.m_id                = 0;
+	record.m_count             = 0;
+	record.m_input.m_type      = type;
+	record.m_input.m_x         = 0;
+	record.m_input.m_y         = 0;
+	record.m_input.m_button    = kButtonNone;
+	record.m_input.m_key       = kKeyNone;
+	record.m_input.m_mask      = 0;
+	record.m_input.m_keyButton = 0;
+	record.m_input.m_count     = 0;
+	record.m_input.m_time      = 0.0;
+	return record;
+}
+
+TEST(CInputTraceTests, write_read_sameRecords)
+{
+	CInputTrace::CRecordList records;
+	records.push_back(makeInput(0.001, CInputChannel::CInput::kMotionOnSecondary));
+	records.back().m_input.m_x = -3;
+	records.back().m_input.m_y = 4;
+	records.push_back(makeInput(0.002, CInputChannel::CInput::kButtonDown));
+	records.back().m_input.m_button = kButtonRight;
+	records.back().m_input.m_mask   = KeyModifierShift;
+	records.push_back(makeInput(0.5, CInputChannel::CInput::kKeyRepeat));
+	records.back().m_input.m_key       = 0xe000;
+	records.back().m_input.m_mask      = KeyModifierControl;
+	records.back().m_input.m_keyButton = 300;
+	records.back().m_input.m_count     = 3;
+
+	CInputTrace::CRecord clipboard;
+	clipboard.m_type  = CInputTrace::CRecord::kClipboard;
+	clipboard.m_time  = 1.25;
+	clipboard.m_id    = kClipboardSelection;
+	clipboard.m_count = 0;
+	clipboard.m_data  = CString("\0\xff text", 7);
+	records.push_back(clipboard);
+
+	CInputTrace::CRecord drag = clipboard;
+	drag.m_type  = CInputTrace::CRecord::kDragInfo;
+	drag.m_id    = 0;
+	drag.m_count = 1;
+	drag.m_data  = "/tmp/a b.txt,10,";
+	records.push_back(drag);
+
+	std::stringstream trace;
+	trace << "# a comment\n\n";
+	for (size_t i = 0; i < records.size(); ++i) {
+		CInputTrace::write(trace, records[i]);
+	}
+
+	CInputTrace::CRecordList read;
+	ASSERT_TRUE(CInputTrace::read(trace, read));
+	ASSERT_EQ(records.size(), read.size());
+	for (size_t i = 0; i < records.size(); ++i) {
+		const CInputTrace::CRecord& a = records[i];
+		const CInputTrace::CRecord& b = read[i];
+		EXPECT_EQ(a.m_type, b.m_type);
+		EXPECT_DOUBLE_EQ(a.m_time, b.m_time);
+		EXPECT_EQ(a.m_id, b.m_id);
+		EXPECT_EQ(a.m_count, b.m_count);
+		EXPECT_EQ(a.m_data, b.m_data);
+		if (a.m_type == CInputTrace::CRecord::kInput) {
+			EXPECT_EQ(a.m_input.m_type, b.m_input.m_type);
+			EXPECT_EQ(a.m_input.m_x, b.m_input.m_x);
+			EXPECT_EQ(a.m_input.m_y, b.m_input.m_y);
+			EXPECT_EQ(a.m_input.m_button, b.m_input.m_button);
+			EXPECT_EQ(a.m_input.m_key, b.m_input.m_key);
+			EXPECT_EQ(a.m_input.m_mask, b.m_input.m_mask);
+			EXPECT_EQ(a.m_input.m_keyButton, b.m_input.m_keyButton);
+			EXPECT_EQ(a.m_input.m_count, b.m_input.m_count);
+		}
+	}
+}
+
+TEST(CInputTraceTests, read_badRecord_false)
+{
+	std::istringstream unknown("0.1 move 1 2\n0.2 teleport 1 2\n");
+	CInputTrace::CRecordList records;
+	EXPECT_FALSE(CInputTrace::read(unknown, records));
+
+	std::istringstream badHex("0.1 clipboard 0 0g\n");
+	EXPECT_FALSE(CInputTrace::read(badHex, records));
+
+	std::istringstream badClipboard("0.1 clipboard 9 00\n");
+	EXPECT_FALSE(CInputTrace::read(badClipboard, records));
+}
+
+#if SYSAPI_UNIX
+
+TEST(CInputTraceTests, open_existingFile_onlyUserMayRead)
+{
+	const char* filename = "input-trace-test.txt";
+	{
+		std::ofstream older(filename);
+		older << "older trace\n";
+	}
+	chmod(filename, 0644);
+
+	CInputTrace trace;
+	ASSERT_TRUE(trace.open(filename));
+	trace.close();
+
+	struct stat info;
+	ASSERT_EQ(0, stat(filename, &info));
+	EXPECT_EQ(0600, static_cast<int>(info.st_mode & 0777));
+	remove(filename);
+}
+
+#endif
@@ -206,14 +206,56 @@ TEST(CKeyStateTests, updateKeyState_activeModifiers_keyMapGotModifers)
 	CMockEventQueue eventQueue;
 	CKeyStateImpl keyState(eventQueue, keyMap);
 	ON_CALL(keyState, pollActiveModifiers()).WillByDefault(Return(1));
-	ON_CALL(keyMap, foreachKey(_, _)).WillByDefault(Invoke(assertMaskIsOne));
 
-	// key map gets new modifiers via foreachKey()
-	EXPECT_CALL(keyMap, foreachKey(_, _));
+	// key map gets new modifiers via its modifier index
+	EXPECT_CALL(keyMap, collectActiveModifiers(_, 1, _));
+	EXPECT_CALL(keyMap, foreachKey(_, _)).Times(0);
 
 	keyState.updateKeyState();
 }
 
+TEST(CKeyStateTests, updateKeyState_largeKeyMap_maskSet)
+{
+	// a large keyboard map:  thousands of ordinary keys and a couple
+	// of keys for each modifier in each of four groups.
+	static const KeyID s_modifiers[] = {
+		kKeyShift_L, kKeyShift_R, kKeyControl_L, kKeyControl_R,
+		kKeyAlt_L, kKeyAlt_R, kKeySuper_L, kKeyCapsLock, kKeyNumLock
+	};
+	CKeyMap keyMap;
+	CKeyMap::KeyItem item;
+	item.m_required  = 0;
+	item.m_sensitive = KeyModifierShift;
+	item.m_dead      = false;
+	item.m_client    = 0;
+	for (SInt32 g = 0; g < 4; ++g) {
+		item.m_group = g;
+		for (KeyID id = 0x20; id < 0x1020; ++id) {
+			item.m_id     = id;
+			item.m_button = static_cast<KeyButton>(1 + id % 0x1f0);
+			CKeyMap::initModifierKey(item);
+			keyMap.addKeyEntry(item);
+		}
+		for (size_t i = 0; i < sizeof(s_modifiers) /
+								sizeof(s_modifiers[0]); ++i) {
+			item.m_id     = s_modifiers[i];
+			item.m_button = static_cast<KeyButton>(0x1f1 + i);
+			CKeyMap::initModifierKey(item);
+			keyMap.addKeyEntry(item);
+		}
+	}
+	keyMap.finish();
+
+	CMockEventQueue eventQueue;
+	CKeyStateImpl keyState(eventQueue, &keyMap);
+	const KeyModifierMask mask = KeyModifierShift | KeyModifierControl;
+	ON_CALL(keyState, pollActiveModifiers()).WillByDefault(Return(mask));
+
+	keyState.updateKeyState();
+
+	ASSERT_EQ(mask, keyState.getActiveModifiers());
+}
+
 TEST(CKeyStateTests, setHalfDuplexMask_capsLock_halfDuplexCapsLockAdded)
 {
 	CMockKeyMap keyMap;
@@ -453,12 +495,6 @@ stubPollPressedKeys(IKeyState::KeyButtonSet& pressedKeys)
 	pressedKeys.insert(1);
 }
 
-void
-assertMaskIsOne(ForeachKeyCallback cb, void* userData)
-{
-	ASSERT_EQ(1, ((CKeyState::CAddActiveModifierContext*)userData)->m_mask);
-}
-
 const CKeyMap::KeyItem*
 stubMapKey(
 	CKeyMap::Keystrokes& keys, KeyID id, SInt32 group,
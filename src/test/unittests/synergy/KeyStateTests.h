@@ -40,6 +40,11 @@ public:
 	{
 	}
 
+	CMockKeyState(const CMockEventQueue& eventQueue, CKeyMap* keyMap) :
+		CKeyState((IEventQueue*)&eventQueue, *keyMap)
+	{
+	}
+
 	MOCK_CONST_METHOD0(pollActiveGroup, SInt32());
 	MOCK_CONST_METHOD0(pollActiveModifiers, KeyModifierMask());
 	MOCK_METHOD0(fakeCtrlAltDel, bool());
@@ -58,9 +63,6 @@ typedef void (*ForeachKeyCallback)(
 void
 stubPollPressedKeys(IKeyState::KeyButtonSet& pressedKeys);
 
-void
-assertMaskIsOne(ForeachKeyCallback cb, void* userData);
-
 const CKeyMap::KeyItem*
 stubMapKey(
 	CKeyMap::Keystrokes& keys, KeyID id, SInt32 group,
@@ -0,0 +1,140 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Carlo Wood
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/PacketStreamFilter.h"
+#include "synergy/PacketReader.h"
+#include "synergy/ProtocolUtil.h"
+#include "synergy/protocol_types.h"
+#include "io/IStream.h"
+#include "base/EventQueue.h"
+
+#include "test/global/gtest.h"
+
+// hands out what it's been given, like a socket would
+class CMemoryStream : public synergy::IStream {
+public:
+	CMemoryStream() : m_offset(0) { }
+
+	virtual void		close() { }
+	virtual UInt32		read(void* buffer, UInt32 n)
+	{
+		UInt32 left = static_cast<UInt32>(m_data.size()) - m_offset;
+		if (n > left) {
+			n = left;
+		}
+		memcpy(buffer, m_data.data() + m_offset, n);
+		m_offset += n;
+		return n;
+	}
+	virtual void		write(const void*, UInt32) { }
+	virtual void		flush() { }
+	virtual void		shutdownInput() { }
+	virtual void		shutdownOutput() { }
+	virtual void*		getEventTarget() const { return const_cast<CMemoryStream*>(this); }
+	virtual bool		isReady() const { return m_offset < m_data.size(); }
+	virtual UInt32		getSize() const { return static_cast<UInt32>(m_data.size()) - m_offset; }
+
+	CString				m_data;
+	UInt32				m_offset;
+};
+
+// appends a packet with one message
+static void
+appendPacket(CString& packets, const CString& message)
+{
+	CProtocolUtil::appendf(packets, "%4i", message.size());
+	packets += message;
+}
+
+// has the filter take in all of \p packets
+static void
+receive(CEventQueue& events, CMemoryStream& socket, const CString& packets)
+{
+	socket.m_data   = packets;
+	socket.m_offset = 0;
+	events.addEvent(CEvent(events.forIStream().inputReady(),
+							socket.getEventTarget(), NULL,
+							CEvent::kDeliverImmediately));
+}
+
+TEST(CPacketStreamFilterTests, peekPacket_mouseMoveAndClipboard_sameAsStream)
+{
+	static const UInt32 kMoves      = 100;
+	static const UInt32 kClipboards = 2;
+
+	CEventQueue events;
+	CMemoryStream* socket = new CMemoryStream;
+	CPacketStreamFilter stream(&events, socket, true);
+
+	CString moves;
+	for (UInt32 i = 0; i < kMoves; ++i) {
+		CString message;
+		CProtocolUtil::appendf(message, kMsgDMouseMove, i & 0x7fff, 1);
+		appendPacket(moves, message);
+	}
+	CString clipboards;
+	CString data(64 * 1024, 'x');
+	for (UInt32 i = 0; i < kClipboards; ++i) {
+		CString message;
+		CProtocolUtil::appendf(message, kMsgDClipboard, 0, i, &data);
+		appendPacket(clipboards, message);
+	}
+
+	// field by field through the stream
+	UInt32 streamSum = 0, streamBytes = 0;
+	receive(events, *socket, moves);
+	UInt8 code[4];
+	while (stream.read(code, 4) == 4) {
+		SInt16 x, y;
+		CProtocolUtil::readf(&stream, kMsgDMouseMove + 4, &x, &y);
+		streamSum += x + y;
+	}
+	receive(events, *socket, clipboards);
+	while (stream.read(code, 4) == 4) {
+		UInt8 id;
+		UInt32 seqNum;
+		CString s;
+		CProtocolUtil::readf(&stream, kMsgDClipboard + 4, &id, &seqNum, &s);
+		streamBytes += static_cast<UInt32>(s.size());
+	}
+
+	// a packet at a time, in place
+	UInt32 inPlaceSum = 0, inPlaceBytes = 0;
+	receive(events, *socket, moves);
+	UInt32 size;
+	const UInt8* packet;
+	while ((packet = stream.peekPacket(size)) != NULL) {
+		SInt16 x, y;
+		CPacketReader(packet, size).readf(kMsgDMouseMove, &x, &y);
+		inPlaceSum += x + y;
+		stream.popPacket();
+	}
+	receive(events, *socket, clipboards);
+	while ((packet = stream.peekPacket(size)) != NULL) {
+		UInt8 id;
+		UInt32 seqNum;
+		CStringRef s;
+		CPacketReader(packet, size).readf("DCLP%1i%4i%r", &id, &seqNum, &s);
+		inPlaceBytes += s.size();
+		stream.popPacket();
+	}
+
+	// both decode the same
+	EXPECT_EQ(streamSum, inPlaceSum);
+	EXPECT_EQ(kClipboards * data.size(), streamBytes);
+	EXPECT_EQ(streamBytes, inPlaceBytes);
+}